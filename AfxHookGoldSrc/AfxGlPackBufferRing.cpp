@@ -0,0 +1,134 @@
+#include "stdafx.h"
+
+#include "AfxGlPackBufferRing.h"
+
+#include "mirv_glext.h"
+
+// AfxGlPackBufferRing::ContextScope ///////////////////////////////////////////
+
+AfxGlPackBufferRing::ContextScope::ContextScope(AfxGlPackBufferRing & ring)
+: m_OldDC(wglGetCurrentDC())
+, m_OldGLRC(wglGetCurrentContext())
+, m_Restore(false)
+, m_IsCurrent(true)
+{
+	if(m_OldGLRC != ring.m_GLRC)
+	{
+		m_Restore = true;
+		m_IsCurrent = 0 != ring.m_GLRC && FALSE != wglMakeCurrent(ring.m_DC, ring.m_GLRC);
+	}
+}
+
+AfxGlPackBufferRing::ContextScope::~ContextScope()
+{
+	if(m_Restore)
+		wglMakeCurrent(m_OldDC, m_OldGLRC);
+}
+
+// AfxGlPackBufferRing /////////////////////////////////////////////////////////
+
+AfxGlPackBufferRing::AfxGlPackBufferRing()
+: m_First(0)
+, m_Count(0)
+, m_DC(0)
+, m_GLRC(0)
+{
+}
+
+AfxGlPackBufferRing::~AfxGlPackBufferRing()
+{
+	Delete();
+}
+
+bool AfxGlPackBufferRing::Create(unsigned int count)
+{
+	Delete();
+
+	if(count < 1 || !Install_GL_ARB_pixel_buffer_object())
+		return false;
+
+	m_Buffers.resize(count, 0);
+	m_Reads.resize(count);
+	m_DC = wglGetCurrentDC();
+	m_GLRC = wglGetCurrentContext();
+
+	glGenBuffersARB((GLsizei)count, &(m_Buffers[0]));
+
+	return true;
+}
+
+void AfxGlPackBufferRing::Delete()
+{
+	if(!m_Buffers.empty())
+	{
+		ContextScope scope(*this);
+
+		// If the context is gone, then it took the buffers with it:
+		if(scope.IsCurrent())
+			glDeleteBuffersARB((GLsizei)m_Buffers.size(), &(m_Buffers[0]));
+
+		m_Buffers.clear();
+		m_Reads.clear();
+	}
+
+	m_First = 0;
+	m_Count = 0;
+	m_DC = 0;
+	m_GLRC = 0;
+}
+
+bool AfxGlPackBufferRing::IsEmpty()
+{
+	return 0 == m_Count;
+}
+
+bool AfxGlPackBufferRing::IsFull()
+{
+	return m_Buffers.size() <= m_Count;
+}
+
+bool AfxGlPackBufferRing::BeginRead(CMdt_Media_RAWGLPIC * pic, Params const & params, int x, int y, int width, int height, GLenum format, GLenum type)
+{
+	if(IsFull())
+		return false;
+
+	unsigned int index = (m_First +m_Count) % m_Buffers.size();
+
+	glBindBufferARB(GL_PIXEL_PACK_BUFFER_ARB, m_Buffers[index]);
+	bool ok = pic->DoGlReadPixelsToPackBuffer(x, y, width, height, format, type);
+	glBindBufferARB(GL_PIXEL_PACK_BUFFER_ARB, 0);
+
+	if(!ok)
+		return false;
+
+	Read & read = m_Reads[index];
+	read.CaptureParams = params;
+	read.Width = width;
+	read.Height = height;
+	read.Format = format;
+	read.Type = type;
+
+	++m_Count;
+
+	return true;
+}
+
+bool AfxGlPackBufferRing::EndRead(CMdt_Media_RAWGLPIC * pic, bool bRepack, Params & outParams)
+{
+	if(IsEmpty())
+		return false;
+
+	unsigned int index = m_First;
+	Read & read = m_Reads[index];
+
+	outParams = read.CaptureParams;
+
+	glBindBufferARB(GL_PIXEL_PACK_BUFFER_ARB, m_Buffers[index]);
+	bool ok = pic->DoGlMapPackBuffer(read.Width, read.Height, read.Format, read.Type, bRepack);
+	glBindBufferARB(GL_PIXEL_PACK_BUFFER_ARB, 0);
+
+	m_First = (m_First +1) % m_Buffers.size();
+	--m_Count;
+
+	return ok;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "mdt_media.h"
+
+#include <vector>
+
+/// <summary>
+///   Ring of GL_ARB_pixel_buffer_object pack buffers:<br />
+///   glReadPixels is done into the next buffer and returns without draining the GL pipeline,
+///   the result is mapped when the buffer comes round again, that is count -1 reads later.
+/// </summary>
+class AfxGlPackBufferRing
+{
+public:
+	/// <summary>State of the capture a read belongs to, handed back by EndRead.</summary>
+	/// <remarks>Processing happens count -1 captures later, when these might have changed already.</remarks>
+	struct Params
+	{
+		double Time;
+		float SpsHint;
+		GLdouble ZNear;
+		GLdouble ZFar;
+	};
+
+	/// <summary>Makes the context the ring was created in current for the lifetime of the object (if it isn't already).</summary>
+	class ContextScope
+	{
+	public:
+		ContextScope(AfxGlPackBufferRing & ring);
+		~ContextScope();
+
+		/// <returns>false if the context could not be made current (i.e. it has been destroyed already).</returns>
+		bool IsCurrent() { return m_IsCurrent; }
+
+	private:
+		HDC m_OldDC;
+		HGLRC m_OldGLRC;
+		bool m_Restore;
+		bool m_IsCurrent;
+	};
+
+	AfxGlPackBufferRing();
+
+	~AfxGlPackBufferRing();
+
+	/// <returns>false if pixel buffer objects are not supported (use the synchronous path then), otherwise true.</returns>
+	/// <remarks>Requires the GL context to be current, the ring remembers it.</remarks>
+	bool Create(unsigned int count);
+
+	/// <remarks>Pending reads are lost. Makes the context from Create current if required.</remarks>
+	void Delete();
+
+	bool IsEmpty();
+
+	bool IsFull();
+
+	/// <summary>Starts reading into the next free buffer, the ring must not be full.</summary>
+	/// <param name="pic">Used to set up the format, it's data is not touched.</param>
+	/// <param name="params">Returned by EndRead for this read.</param>
+	bool BeginRead(CMdt_Media_RAWGLPIC * pic, Params const & params, int x, int y, int width, int height, GLenum format, GLenum type);
+
+	/// <summary>Finishes the oldest read into pic, the ring must not be empty.</summary>
+	/// <param name="outParams">params given to BeginRead, set even if the read failed.</param>
+	bool EndRead(CMdt_Media_RAWGLPIC * pic, bool bRepack, Params & outParams);
+
+private:
+	struct Read
+	{
+		Params CaptureParams;
+		int Width;
+		int Height;
+		GLenum Format;
+		GLenum Type;
+	};
+
+	std::vector<GLuint> m_Buffers;
+	std::vector<Read> m_Reads;
+	unsigned int m_First;
+	unsigned int m_Count;
+	HDC m_DC;
+	HGLRC m_GLRC;
+};
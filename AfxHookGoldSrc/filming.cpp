@@ -84,6 +84,7 @@ REGISTER_CVAR(movie_filename, "untitled_rec", 0);
 REGISTER_CVAR(movie_fps, "30", 0);
 REGISTER_CVAR(movie_hidepanels, "0", 0);
 REGISTER_CVAR(movie_playdemostop,"0",0);
+REGISTER_CVAR(movie_readbuffers, "3", 0);
 REGISTER_CVAR(movie_separate_hud, "0", 0);
 REGISTER_CVAR(movie_simulate, "0", 0);
 REGISTER_CVAR(movie_simulate_delay, "0", 0);
@@ -95,8 +96,12 @@ REGISTER_CVAR(movie_stereo_yawdegrees,"0.0",0);
 REGISTER_CVAR(movie_splitstreams, "0", 0);
 REGISTER_CVAR(movie_wireframe, "0", 0);
 REGISTER_CVAR(movie_wireframesize, "1", 0);
+REGISTER_CVAR(movie_writer_drop, "0", 0);
+REGISTER_CVAR(movie_writer_frames, "8", 0);
+REGISTER_CVAR(movie_writer_threads, "2", 0);
 REGISTER_CVAR(sample_enable, "0", 0);
 REGISTER_CVAR(sample_exposure, "1.0", 0);
+REGISTER_CVAR(sample_kernels, "0", 0); // 0 = auto, 1 = scalar, 2 = sse2, 3 = avx2
 REGISTER_CVAR(sample_sps, "180", 0);
 
 
@@ -484,6 +489,7 @@ Filming::Filming()
 {
 	m_bInWireframe = false;
 	m_EnableStereoMode = false;
+	m_FrameWriter = 0;
 
 		_cameraofs.right = 0;
 		_cameraofs.up = 0;
@@ -730,6 +736,16 @@ void Filming::Start()
 	// indicate sound export if requested:
 	_bExportingSound = !_bSimulate2 && (movie_export_sound->value!=0.0f);	
 
+	// Prepare frame writer (movie_writer_threads 0 writes on the render thread):
+	if(!_bSimulate2 && 1 <= (int)movie_writer_threads->value)
+	{
+		m_FrameWriter = new CAfxFrameWriter(
+			(size_t)max(1, (int)movie_writer_frames->value),
+			(size_t)movie_writer_threads->value,
+			0 != movie_writer_drop->value ? CAfxFrameWriter::Policy_Drop : CAfxFrameWriter::Policy_Block
+		);
+	}
+
 	// Prepare streams:
 	{
 		double samplingFrameDuration = enableSampling ? 1.0 / (double)(max(movie_fps->value, 1.0f)) : 0.0;
@@ -952,6 +968,22 @@ void Filming::Stop()
 	if(g_Filming_Stream[FS_hudalpha]) delete g_Filming_Stream[FS_hudalpha];
 	if(g_Filming_Stream[FS_debug]) delete g_Filming_Stream[FS_debug];
 
+	// finish writing frames:
+	if(m_FrameWriter)
+	{
+		m_FrameWriter->Flush();
+
+		pEngfuncs->Con_Printf("Frame writer: %u frames written, %u failed, %u dropped, max. %u queued.\n",
+			(unsigned int)m_FrameWriter->GetWrittenCount(),
+			(unsigned int)m_FrameWriter->GetFailedCount(),
+			(unsigned int)m_FrameWriter->GetDroppedCount(),
+			(unsigned int)m_FrameWriter->GetMaxQueued()
+		);
+
+		delete m_FrameWriter;
+		m_FrameWriter = 0;
+	}
+
 	//
 
 	if (_pSupportRender)
@@ -1843,6 +1875,21 @@ FilmingStream::FilmingStream(
 
 	m_Pitch = CalcPitch(m_Width, m_BytesPerPixel, m_Bmp ? 4 : 1);
 
+	EasySamplerKernels::Kind kernels;
+	switch((int)sample_kernels->value) {
+	case 1:
+		kernels = EasySamplerKernels::EK_Scalar;
+		break;
+	case 2:
+		kernels = EasySamplerKernels::EK_Sse2;
+		break;
+	case 3:
+		kernels = EasySamplerKernels::EK_Avx2;
+		break;
+	default:
+		kernels = EasySamplerKernels::EK_Auto;
+	};
+
 	if(0 < samplingFrameDuration && (FB_COLOR == buffer || FB_ALPHA == buffer))
 	{
 		// activate sampling.
@@ -1853,7 +1900,8 @@ FilmingStream::FilmingStream(
 			samplingFrameDuration,
 			0,
 			sample_exposure->value,
-			sample_frame_strength->value
+			sample_frame_strength->value,
+			kernels
 		);
 
 		m_Sampler = new EasyByteSampler(
@@ -1876,7 +1924,8 @@ FilmingStream::FilmingStream(
 			samplingFrameDuration,
 			0,
 			sample_exposure->value,
-			sample_frame_strength->value
+			sample_frame_strength->value,
+			kernels
 		);
 
 		m_SamplerFloat = new EasyFloatSampler(
@@ -1887,10 +1936,41 @@ FilmingStream::FilmingStream(
 	else
 		m_SamplerFloat = 0;
 
+	// Asynchronous reads through pixel buffer objects.
+	// Not for m_Sampler, since deciding if a capture can be skipped requires the sampler to be up to date.
+	m_PackBufferRing = 0;
+
+	if(0 == m_Sampler && 1 <= (int)movie_readbuffers->value)
+	{
+		m_PackBufferRing = new AfxGlPackBufferRing();
+
+		if(!m_PackBufferRing->Create((unsigned int)movie_readbuffers->value))
+		{
+			// not supported, fall back to glReadPixels into client memory.
+			delete m_PackBufferRing;
+			m_PackBufferRing = 0;
+		}
+	}
 }
 
 FilmingStream::~FilmingStream()
 {
+	if(m_PackBufferRing)
+	{
+		{
+			AfxGlPackBufferRing::ContextScope scope(*m_PackBufferRing);
+
+			// process the reads still pending (if the context still exists):
+			if(scope.IsCurrent())
+			{
+				while(!m_PackBufferRing->IsEmpty())
+					FinishPackBufferRead();
+			}
+		}
+
+		delete m_PackBufferRing;
+	}
+
 	if(m_Sampler) delete m_Sampler;
 }
 
@@ -1907,12 +1987,47 @@ void FilmingStream::Capture(double time, CMdt_Media_RAWGLPIC * usePic, float sps
 		return;
 	}
 
+	if(m_PackBufferRing)
+	{
+		AfxGlPackBufferRing::Params params;
+		params.Time = time;
+		params.SpsHint = spsHint;
+		params.ZNear = g_Filming.GetZNear();
+		params.ZFar = g_Filming.GetZFar();
+
+		if(m_PackBufferRing->IsFull())
+			FinishPackBufferRead();
+
+		if (!m_PackBufferRing->BeginRead(&m_PackBufferPic, params, m_X, m_Y, m_Width, m_Height, m_GlBuffer, m_GlType))
+			pEngfuncs->Con_Printf("MDT ERROR: failed to capture a frame (%d).\n", m_PackBufferPic.GetLastUnhandledError());
+
+		return;
+	}
+
 	if (!usePic->DoGlReadPixels(m_X, m_Y, m_Width, m_Height, m_GlBuffer, m_GlType, !m_Bmp))
 	{
 		pEngfuncs->Con_Printf("MDT ERROR: failed to capture a frame (%d).\n", usePic->GetLastUnhandledError());
 		return;
 	}
 
+	Process(time, usePic, spsHint, g_Filming.GetZNear(), g_Filming.GetZFar());
+}
+
+void FilmingStream::FinishPackBufferRead(void)
+{
+	AfxGlPackBufferRing::Params params;
+
+	if (!m_PackBufferRing->EndRead(&m_PackBufferPic, !m_Bmp, params))
+	{
+		pEngfuncs->Con_Printf("MDT ERROR: failed to capture a frame (%d).\n", m_PackBufferPic.GetLastUnhandledError());
+		return;
+	}
+
+	Process(params.Time, &m_PackBufferPic, params.SpsHint, params.ZNear, params.ZFar);
+}
+
+void FilmingStream::Process(double time, CMdt_Media_RAWGLPIC * usePic, float spsHint, GLdouble zNear, GLdouble zFar)
+{
 	// apply postprocessing to the depthbuffer:
 	// the following code should be replaced completly later, cause it's rather dependent
 	// on sizes of unsigned int and float and stuff, although it should be somewhat
@@ -1926,15 +2041,15 @@ void FilmingStream::Capture(double time, CMdt_Media_RAWGLPIC * usePic, float sps
 
 		if(0 != m_SamplerFloat)
 		{
-			LinearizeFloatDepthBuffer((GLfloat *)pBuffer, uiCount, g_Filming.GetZNear(), g_Filming.GetZFar());
+			LinearizeFloatDepthBuffer((GLfloat *)pBuffer, uiCount, zNear, zFar);
 		}
 		else
 		{
 			if(FD_LINEAR == m_DepthFn || FD_LOG == m_DepthFn)
-				LinearizeFloatDepthBuffer((GLfloat *)pBuffer, uiCount, g_Filming.GetZNear(), g_Filming.GetZFar());
+				LinearizeFloatDepthBuffer((GLfloat *)pBuffer, uiCount, zNear, zFar);
 
 			if(FD_LOG == m_DepthFn)
-				LogarithmizeDepthBuffer((GLfloat *)pBuffer, uiCount, g_Filming.GetZNear(), g_Filming.GetZFar());
+				LogarithmizeDepthBuffer((GLfloat *)pBuffer, uiCount, zNear, zFar);
 
 			if(m_DepthDebug)
 				DebugDepthBuffer((GLfloat *)pBuffer, uiCount);
@@ -2039,13 +2154,40 @@ void FilmingStream::Print(unsigned char const * data)
 	
 	std::wostringstream os;
 	os << m_Path << L"\\" << setfill(L'0') << setw(5) << m_FrameCount << setw(0) << (m_Bmp ? L".bmp" : L".tga");
-	
+
+	// The frame number is used up even if the frame is dropped, so the numbering stays in sync with the time.
+	m_FrameCount++;
+
+	if(CAfxFrameWriter * frameWriter = g_Filming.GetFrameWriter())
+	{
+		if(CAfxFrameWriter::CFrame * frame = frameWriter->AquireFrame(m_Pitch * m_Height))
+		{
+			memcpy(frame->Data, data, frame->Bytes);
+
+			std::wstring fileName(os.str());
+			bool bmp = m_Bmp;
+			unsigned short width = m_Width;
+			unsigned short height = m_Height;
+			unsigned char bpp = m_BytesPerPixel<<3;
+			int pitch = m_Pitch;
+
+			frame->Write = [fileName, bmp, bColor, width, height, bpp, pitch](CAfxFrameWriter::CFrame const & frame) {
+				if(bmp)
+					return WriteRawBitmap(frame.Data, fileName.c_str(), width, height, bpp, pitch);
+
+				return WriteRawTarga(frame.Data, fileName.c_str(), width, height, bpp, !bColor, pitch);
+			};
+
+			frameWriter->Submit(frame);
+		}
+
+		return;
+	}
+
 	if( m_Bmp )
 		WriteRawBitmap(data, os.str().c_str(), m_Width, m_Height, m_BytesPerPixel<<3, m_Pitch); // align is still 4 byte probably
 	else
 		WriteRawTarga(data, os.str().c_str(), m_Width, m_Height, m_BytesPerPixel<<3, !bColor, m_Pitch);
-
-	m_FrameCount++;
 }
 
 
@@ -8,6 +8,8 @@
 #include <string>
 
 #include <shared/EasySampler.h>
+#include <shared/AfxFrameWriter.h>
+#include "AfxGlPackBufferRing.h"
 #include "film_sound.h"
 #include "mdt_media.h"
 #include "supportrender.h"
@@ -47,6 +49,7 @@ public:
 	);
 	~FilmingStream();
 
+	/// <remarks>If the stream uses pixel buffer objects (movie_readbuffers), the frame is processed some captures later.</remarks>
 	void Capture(double time, CMdt_Media_RAWGLPIC * usePic, float spsHint);
 
 private:
@@ -72,6 +75,16 @@ private:
 	bool m_TASMode;
 	CMdt_Media_RAWGLPIC m_PreviousFrame;
 	double m_NextFrameIsAt;
+	AfxGlPackBufferRing * m_PackBufferRing;
+	CMdt_Media_RAWGLPIC m_PackBufferPic;
+
+	/// <summary>Maps the oldest pack buffer of m_PackBufferRing and processes it.</summary>
+	void FinishPackBufferRead(void);
+
+	/// <summary>Postprocesses and outputs a read frame.</summary>
+	/// <param name="zNear">Near plane at the time of the capture.</param>
+	/// <param name="zFar">Far plane at the time of the capture.</param>
+	void Process(double time, CMdt_Media_RAWGLPIC * usePic, float spsHint, GLdouble zNear, GLdouble zFar);
 
 	void WriteFrame(CMdt_Media_RAWGLPIC& frame, double time);
 
@@ -112,6 +125,9 @@ public:
 	MATTE_METHOD GetMatteMethod();
 	CFilmSound * GetFilmSound() { return &_FilmSound; }
 
+	/// <returns>0 if frames are to be written synchronously, otherwise the frame writer of the current recording.</returns>
+	CAfxFrameWriter * GetFrameWriter() { return m_FrameWriter; }
+
 	void On_CL_Disconnect(void);
 
 	void SupplySupportRenderer(CHlaeSupportRender *pSupportRender)
@@ -211,6 +227,7 @@ private:
 	bool m_EnableStereoMode;
 	bool m_FovOverride;
 	double m_FovValue;
+	CAfxFrameWriter * m_FrameWriter;
 	int m_Height;
 	unsigned int m_HostFrameCount;
 	bool m_HudDrawnInFrame;
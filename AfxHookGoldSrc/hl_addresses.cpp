@@ -2,7 +2,12 @@
 
 #include "hl_addresses.h"
 
+#include "hlaeFolder.h"
+
 #include <shared/binutils.h>
+#include <shared/vcpp/AfxAddrCache.h>
+
+#include <string>
 
 using namespace Afx::BinUtils;
 
@@ -94,8 +99,11 @@ void Addresses_InitHlExe(AfxAddr hlExe)
 	AFXADDR_SET(hlExe, hlExe);
 }
 
+unsigned int g_ErrorBoxCount = 0;
+
 void ErrorBox(char const * messageText)
 {
+	++g_ErrorBoxCount;
 	MessageBox(0, messageText, "AfxHookGoldSrc Error", MB_OK | MB_ICONERROR);
 }
 
@@ -103,7 +111,7 @@ void ErrorBox(char const * messageText)
 #define STRINGIZE2(x) #x
 #define MkErrStr(file,line) "Problem in " file ":" STRINGIZE(line)
 
-void Addresses_InitHwDll(AfxAddr hwDll)
+void Addresses_ScanHwDll(AfxAddr hwDll)
 {
 	AFXADDR_SET(hwDll, hwDll);
 
@@ -133,6 +141,26 @@ void Addresses_InitHwDll(AfxAddr hwDll)
 		else ErrorBox(MkErrStr(__FILE__, __LINE__));
 	}
 
+	// Independent patterns searching the whole text section, found in a single pass:
+	enum TextPattern_e
+	{
+		TP_UnkDrawHud,
+		TP_R_PushDlights,
+		TP_R_DrawSkyBoxEx,
+		TP_g_fov,
+		TP_SND_PickChannel,
+		TP_COUNT
+	};
+	char const * const textPatterns[TP_COUNT] = {
+		"E8 ?? ?? ?? ?? A1 ?? ?? ?? ?? BF 05 00 00 00 3B C7 75 39 83 3D ?? ?? ?? ?? 02 75 30 A1 ?? ?? ?? ?? 88 5D FC 83 F8 01 75 04 C6 45 FC 01 53 E8 ?? ?? ?? ?? 8B 4D FC 81 E1 FF 00 00 00 51 E8 ?? ?? ?? ?? 6A 01 E8 ?? ?? ?? ?? 83 C4 0C 39 1D ?? ?? ?? ?? 75 16 83 3D ?? ?? ?? ?? 01 75 08 39 1D ?? ?? ?? ?? 74 05 E8 ?? ?? ?? ?? E8 ?? ?? ?? ?? 39 3D ?? ?? ?? ?? 75 0E 83 3D ?? ?? ?? ?? 02 75 05 E8 ?? ?? ?? ?? E8 ?? ?? ?? ??", // TP_UnkDrawHud
+		"D9 05 ?? ?? ?? ?? D8 1D ?? ?? ?? ?? DF E0 F6 C4 44 7A 61 A1 ?? ?? ?? ?? 56 40 57 A3 ?? ?? ?? ?? 33 F6 BF ?? ?? ?? ??", // TP_R_PushDlights
+		"55 8B EC 83 EC 1C A1 ?? ?? ?? ?? 53 56 BB 00 00 80 3F 57 C7 45 F8 00 00 00 00 85 C0", // TP_R_DrawSkyBoxEx
+		"51 FF D0 83 C4 08 85 C0 74 23 8B 55 E8 8B 45 EC 8B 4D F0 89 15 ?? ?? ?? ?? 8B 55 F8 A3 ?? ?? ?? ?? 89 0D ?? ?? ?? ?? 89 15 ?? ?? ?? ??", // TP_g_fov
+		"55 8B EC 53 8B 5D 0C 56 83 FB 05 57 75 17 8B 45 10 50 E8 ?? ?? ?? ?? 83 C4 04 85 C0 74 07 5F 5E 33 C0 5B 5D C3 83 CF FF C7 45 10 FF FF FF 7F BE 04 00 00 00" // TP_SND_PickChannel
+	};
+	MemRange textResults[TP_COUNT];
+	FindPatternStrings(textRange, TP_COUNT, textPatterns, textResults);
+
 	// pEngfuncs // [5] // Checked: 2018-10-06
 	// ppmove // [5] // Checked: 2018-10-06
 	// pstudio // [5] // Checked: 2018-10-06
@@ -373,7 +401,7 @@ void Addresses_InitHwDll(AfxAddr hwDll)
 
 	// UnkDrawHud* // [7] // Checked 2018-09-08
 	{
-		MemRange r1 = FindPatternString(textRange, "E8 ?? ?? ?? ?? A1 ?? ?? ?? ?? BF 05 00 00 00 3B C7 75 39 83 3D ?? ?? ?? ?? 02 75 30 A1 ?? ?? ?? ?? 88 5D FC 83 F8 01 75 04 C6 45 FC 01 53 E8 ?? ?? ?? ?? 8B 4D FC 81 E1 FF 00 00 00 51 E8 ?? ?? ?? ?? 6A 01 E8 ?? ?? ?? ?? 83 C4 0C 39 1D ?? ?? ?? ?? 75 16 83 3D ?? ?? ?? ?? 01 75 08 39 1D ?? ?? ?? ?? 74 05 E8 ?? ?? ?? ?? E8 ?? ?? ?? ?? 39 3D ?? ?? ?? ?? 75 0E 83 3D ?? ?? ?? ?? 02 75 05 E8 ?? ?? ?? ?? E8 ?? ?? ?? ??");
+		MemRange r1 = textResults[TP_UnkDrawHud];
 
 		if (!r1.IsEmpty())
 		{
@@ -390,7 +418,7 @@ void Addresses_InitHwDll(AfxAddr hwDll)
 
 	// R_PushDlights // [7] // Checked 2018-09-08
 	{
-		MemRange r1 = FindPatternString(textRange, "D9 05 ?? ?? ?? ?? D8 1D ?? ?? ?? ?? DF E0 F6 C4 44 7A 61 A1 ?? ?? ?? ?? 56 40 57 A3 ?? ?? ?? ?? 33 F6 BF ?? ?? ?? ??");
+		MemRange r1 = textResults[TP_R_PushDlights];
 
 		if (!r1.IsEmpty())
 		{
@@ -487,7 +515,7 @@ void Addresses_InitHwDll(AfxAddr hwDll)
 	// R_DrawSkyBoxEx // [11] // Checked: 2018-09-08
 	// skytextures // [11] // Checked: 2018-09-08
 	{
-		MemRange r1 = FindPatternString(textRange, "55 8B EC 83 EC 1C A1 ?? ?? ?? ?? 53 56 BB 00 00 80 3F 57 C7 45 F8 00 00 00 00 85 C0");
+		MemRange r1 = textResults[TP_R_DrawSkyBoxEx];
 		if (!r1.IsEmpty())
 		{
 			AFXADDR_SET(R_DrawSkyBoxEx, r1.Start);
@@ -525,7 +553,7 @@ void Addresses_InitHwDll(AfxAddr hwDll)
 
 	// g_fov // [17] // Checked 2018-09-19
 	{
-		MemRange r1 = FindPatternString(textRange, "51 FF D0 83 C4 08 85 C0 74 23 8B 55 E8 8B 45 EC 8B 4D F0 89 15 ?? ?? ?? ?? 8B 55 F8 A3 ?? ?? ?? ?? 89 0D ?? ?? ?? ?? 89 15 ?? ?? ?? ??");
+		MemRange r1 = textResults[TP_g_fov];
 
 		if (!r1.IsEmpty())
 		{
@@ -625,7 +653,7 @@ void Addresses_InitHwDll(AfxAddr hwDll)
 	
 	// SND_PickChannel // [6] // Checked 2018-0922
 	{
-		MemRange r1 = FindPatternString(textRange, "55 8B EC 53 8B 5D 0C 56 83 FB 05 57 75 17 8B 45 10 50 E8 ?? ?? ?? ?? 83 C4 04 85 C0 74 07 5F 5E 33 C0 5B 5D C3 83 CF FF C7 45 10 FF FF FF 7F BE 04 00 00 00");
+		MemRange r1 = textResults[TP_SND_PickChannel];
 
 		if (!r1.IsEmpty()) {
 
@@ -680,8 +708,7 @@ void Addresses_InitHwDll(AfxAddr hwDll)
 	}
 }
 
-/// <remarks>Not called when no client.dll is loaded.</remarks>
-void Addresses_InitClientDll(AfxAddr clientDll, const char * gamedir)
+void Addresses_ScanClientDll(AfxAddr clientDll, const char * gamedir)
 {
 	AFXADDR_SET(clientDll, clientDll);
 
@@ -886,3 +913,54 @@ void Addresses_InitClientDll(AfxAddr clientDll, const char * gamedir)
 		}
 	}
 }
+
+/// <summary>Resolves the addresses of module with scan, unless they are in the cache (from an earlier launch) already.</summary>
+void Addresses_Resolve(char const * key, AfxAddr module, std::function<void(void)> const & scan)
+{
+	static CAfxAddrCache cache(__DATE__ " " __TIME__);
+	static bool cacheLoaded = false;
+
+	std::string fileName(GetHlaeFolder());
+	fileName.append("AfxHookGoldSrc_addresses.cache");
+
+	if (!cacheLoaded)
+	{
+		cacheLoaded = true;
+
+		if (FILE * file = fopen(fileName.c_str(), "rb"))
+		{
+			cache.Load(file);
+			fclose(file);
+		}
+	}
+
+	bool cached = cache.Resolve(key, module, [&scan]()
+	{
+		unsigned int errorBoxCount = g_ErrorBoxCount;
+		scan();
+		return errorBoxCount == g_ErrorBoxCount;
+	});
+
+	if (!cached && cache.GetDirty())
+	{
+		if (FILE * file = fopen(fileName.c_str(), "wb"))
+		{
+			cache.Save(file);
+			fclose(file);
+		}
+	}
+}
+
+void Addresses_InitHwDll(AfxAddr hwDll)
+{
+	Addresses_Resolve("hw.dll", hwDll, [hwDll]() { Addresses_ScanHwDll(hwDll); });
+}
+
+/// <remarks>Not called when no client.dll is loaded.</remarks>
+void Addresses_InitClientDll(AfxAddr clientDll, const char * gamedir)
+{
+	std::string key("client.dll/");
+	key.append(gamedir);
+
+	Addresses_Resolve(key.c_str(), clientDll, [clientDll, gamedir]() { Addresses_ScanClientDll(clientDll, gamedir); });
+}
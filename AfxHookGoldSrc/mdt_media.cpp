@@ -2,6 +2,8 @@
 
 #include "mdt_media.h"
 
+#include "mirv_glext.h"
+
 #include <algorithm>
 
 //#define MDT_DEBUG
@@ -231,13 +233,9 @@ CMdt_Media_RAWGLPIC& CMdt_Media_RAWGLPIC::operator=(CMdt_Media_RAWGLPIC rhs)
 	return *this;
 }
 
-// DoGlReadPixels:
-bool CMdt_Media_RAWGLPIC::DoGlReadPixels(int iXofs, int iYofs, int iWidth, int iHeight, GLenum eGLformat, GLenum eGLtype, bool bRepack)
+// _prepareFormat:
+bool CMdt_Media_RAWGLPIC::_prepareFormat(int iWidth, int iHeight, GLenum eGLformat, GLenum eGLtype, unsigned int & outRowSize, unsigned int & outRowPackSize)
 {
-#ifdef MDT_DEBUG
-	static char sztmp[2000];
-#endif
-
 	// calcualte data required to know the size of a pixel (if possible / known):
 	if (_eGLformat!=eGLformat)
 		if (!_CalcNumComponents(eGLformat,&_ucNumComponents))
@@ -266,17 +264,55 @@ bool CMdt_Media_RAWGLPIC::DoGlReadPixels(int iXofs, int iYofs, int iWidth, int i
 	_uiSize      = _iWidth * ((unsigned int)_uiPixelSize);
 
 	// check for problems with GL_PIXEL_ALIGNMENT == 4
-	unsigned int uiRowSize = _uiSize;
+	outRowSize = _uiSize;
 
 	if (_uiSize & 0x03)
 		// is not divideable by 4 (has remainder)
 		_uiSize = (1+ (_uiSize >> 2))<<2; // fill up to 4
 
-	unsigned int uiRowPackSize = _uiSize;
+	outRowPackSize = _uiSize;
 
 	_uiSize = _iHeight * _uiSize;
 
-	if (!_adjustMemory(_uiSize,true))  // we only want enlarging the memory if required and no compacting to keep memory access low
+	return _adjustMemory(_uiSize,true);  // we only want enlarging the memory if required and no compacting to keep memory access low
+}
+
+// _repack:
+void CMdt_Media_RAWGLPIC::_repack(unsigned int uiRowSize, unsigned int uiRowPackSize)
+{
+	if (uiRowSize != uiRowPackSize)
+	{
+		// postprocess (it would be better to post process it when outputting, since  this way we have overhead)
+		unsigned char* pTsrc=_pBuffer+uiRowPackSize;
+		unsigned char* pTdst=_pBuffer+uiRowSize;
+		int iT=1;
+
+		while (iT<_iHeight)
+		{
+			unsigned int uR = 0;
+			while(uR < uiRowSize)
+			{
+				pTdst[uR] = pTsrc[uR];
+				uR++;
+			}
+			pTsrc+=uiRowPackSize;
+			pTdst+=uiRowSize;
+			iT++;
+		}
+	}
+}
+
+// DoGlReadPixels:
+bool CMdt_Media_RAWGLPIC::DoGlReadPixels(int iXofs, int iYofs, int iWidth, int iHeight, GLenum eGLformat, GLenum eGLtype, bool bRepack)
+{
+#ifdef MDT_DEBUG
+	static char sztmp[2000];
+#endif
+
+	unsigned int uiRowSize;
+	unsigned int uiRowPackSize;
+
+	if (!_prepareFormat(iWidth, iHeight, eGLformat, eGLtype, uiRowSize, uiRowPackSize))
 		return false;
 
 #ifdef MDT_DEBUG
@@ -307,27 +343,60 @@ bool CMdt_Media_RAWGLPIC::DoGlReadPixels(int iXofs, int iYofs, int iWidth, int i
 	MessageBox(0,sztmp,"glReadPixels DEBUG",MB_OK);
 #endif
 
-	if (bRepack && (uiRowSize != uiRowPackSize))
+	if (bRepack) _repack(uiRowSize, uiRowPackSize);
+
+	_bHasConsistentData=true;
+	return true;
+}
+
+// DoGlReadPixelsToPackBuffer:
+bool CMdt_Media_RAWGLPIC::DoGlReadPixelsToPackBuffer(int iXofs, int iYofs, int iWidth, int iHeight, GLenum eGLformat, GLenum eGLtype)
+{
+	unsigned int uiRowSize;
+	unsigned int uiRowPackSize;
+
+	if (!_prepareFormat(iWidth, iHeight, eGLformat, eGLtype, uiRowSize, uiRowPackSize))
+		return false;
+
+	// (re-)specify the storage, this also orphans the old storage, so we don't have to wait for it:
+	glBufferDataARB(GL_PIXEL_PACK_BUFFER_ARB, _uiSize, NULL, GL_STREAM_READ_ARB);
+
+	// with a pack buffer bound the pointer is an offset into the buffer:
+	glReadPixels(iXofs, iYofs, _iWidth, _iHeight, _eGLformat, _eGLtype, 0);
+
+	_bHasConsistentData	= false; // the data is in the pack buffer, not in our memory
+	return true;
+}
+
+// DoGlMapPackBuffer:
+bool CMdt_Media_RAWGLPIC::DoGlMapPackBuffer(int iWidth, int iHeight, GLenum eGLformat, GLenum eGLtype, bool bRepack)
+{
+	unsigned int uiRowSize;
+	unsigned int uiRowPackSize;
+
+	if (!_prepareFormat(iWidth, iHeight, eGLformat, eGLtype, uiRowSize, uiRowPackSize))
+		return false;
+
+	void * pMapped = glMapBufferARB(GL_PIXEL_PACK_BUFFER_ARB, GL_READ_ONLY_ARB);
+
+	if (!pMapped)
 	{
-		// postprocess (it would be better to post process it when outputting, since  this way we have overhead)
-		unsigned char* pTsrc=_pBuffer+uiRowPackSize;
-		unsigned char* pTdst=_pBuffer+uiRowSize;
-		int iT=1;
+		_bHasConsistentData	= false;
+		_OnErrorHandler(MDT_MEDIA_ERROR_GLMAP);
+		return false;
+	}
 
-		while (iT<_iHeight)
-		{
-			unsigned int uR = 0;
-			while(uR < uiRowSize)
-			{
-				pTdst[uR] = pTsrc[uR];
-				uR++;
-			}
-			pTsrc+=uiRowPackSize;
-			pTdst+=uiRowSize;
-			iT++;
-		}
+	if (_pBuffer) memcpy(_pBuffer, pMapped, _uiSize);
+
+	if (!glUnmapBufferARB(GL_PIXEL_PACK_BUFFER_ARB))
+	{
+		// data store got corrupted (i.e. screen mode change)
+		_bHasConsistentData	= false;
+		_OnErrorHandler(MDT_MEDIA_ERROR_GLMAP);
+		return false;
 	}
 
+	if (bRepack) _repack(uiRowSize, uiRowPackSize);
 
 	_bHasConsistentData=true;
 	return true;
@@ -15,6 +15,7 @@
 #define MDT_MEDIA_ERROR_UNSUPPORTED		4 // the operation you requested is not supported (with the options you gave)
 #define MDT_MEDIA_ERROR_GLFORMAT		5 // the GL format you choosed is not supported in the current mode
 #define MDT_MEDIA_ERROR_GLTYPE			6 // the GL type you choosed is not supported in the current mode
+#define MDT_MEDIA_ERROR_GLMAP			7 // mapping a GL buffer failed or it's data store got lost while mapped
 
 ////////////////////////////////////////////////////////////////////////////////
 // Stuff that has to do with on the fly runtime error handling:
@@ -88,6 +89,12 @@ public:
 
 	// bRepack - DoGlReadPixels assumes GL_PACKALIGNMENT to be 4. if true, it will repack the data in memory and remove spaces (good 4 tga raw output, bad 4 raw bitmap)
 	bool			DoGlReadPixels(int iXofs, int iYofs, int iWidth, int iHeight, GLenum eGLformat, GLenum eGLtype, bool bRepack);
+
+	// Asynchronous variant of DoGlReadPixels (requires GL_ARB_pixel_buffer_object, see mirv_glext.h):
+	// DoGlReadPixelsToPackBuffer reads into the currently bound GL_PIXEL_PACK_BUFFER_ARB (re-specifying it's storage) and returns without waiting for the GPU,
+	// DoGlMapPackBuffer later maps the currently bound GL_PIXEL_PACK_BUFFER_ARB and copies the data into this picture, the params must match the ones given before.
+	bool			DoGlReadPixelsToPackBuffer(int iXofs, int iYofs, int iWidth, int iHeight, GLenum eGLformat, GLenum eGLtype);
+	bool			DoGlMapPackBuffer(int iWidth, int iHeight, GLenum eGLformat, GLenum eGLtype, bool bRepack);
 //	void			RepeatGlReadPixels();				  // equals DoGlReadPixels(0,0)
 //	void			RepeatGlReadPixels(int iXofs, int iYofs); // performfs glReadPixels with an optional offset and the params you have set when this class was created
 
@@ -131,6 +138,9 @@ private:
 	bool			_CalcSizeComponent (GLenum eGLtype, unsigned char* outSizeComponent, bool* outIsSigned);	// returns the size of one component in bytes if result is true, false if unknown, also used by constructor
 	bool			_CalcNumComponents (GLenum eGLformat, unsigned char* outNumComponents);	// returns false if unknown otherwise true and the number of components per pixel
 
+	bool			_prepareFormat(int iWidth, int iHeight, GLenum eGLformat, GLenum eGLtype, unsigned int & outRowSize, unsigned int & outRowPackSize); // sets up format and memory for a read, calls errorhandler if it fails
+	void			_repack(unsigned int uiRowSize, unsigned int uiRowPackSize);	// removes the GL_PACK_ALIGNMENT == 4 padding between rows
+
 	bool			_adjustMemory(unsigned int iNewSize,bool bOnlyWhenGreater); // expands the memory if needed, returns true on succes, calls errorhandler if it fails, tries to Compact instantly if  bOnlyWhenGreater==false;
 	bool			_compactMemory();						// tries to free memory if not everything is used, calls errorhandler if it fails
 	void			_freeAndClean();						// frees memory and cleans up structures
@@ -2,9 +2,36 @@
 
 #include "mirv_glext.h"
 
+#include <string.h>
+
 //
 //
 
+/// <returns>If name is one of the space separated names in extensions.</returns>
+/// <remarks>Compares whole names, a strstr would match prefixes of other names and miss the last name in the string.</remarks>
+static bool HasGlExtension(char const * extensions, char const * name)
+{
+	if(!extensions)
+		return false;
+
+	size_t nameLen = strlen(name);
+
+	while(*extensions)
+	{
+		while(' ' == *extensions)
+			++extensions;
+
+		size_t len = strcspn(extensions, " ");
+
+		if(len == nameLen && 0 == strncmp(extensions, name, len))
+			return true;
+
+		extensions += len;
+	}
+
+	return false;
+}
+
 bool g_Has_All_Gl_Extensions = false;
 
 bool Install_All_Gl_Extensions()
@@ -19,6 +46,8 @@ bool Install_All_Gl_Extensions()
 		//&& Install_GL_ARB_texture_env_combine()
 	;
 
+	Install_GL_ARB_pixel_buffer_object(); // optional
+
 	return g_Has_All_Gl_Extensions;
 }
 
@@ -37,7 +66,7 @@ bool Install_GL_ARB_texture_env_combine()
 
 	char *pExtStr = (char *)(glGetString( GL_EXTENSIONS ));
 
-	if (pExtStr && strstr( pExtStr, "GL_ARB_texture_env_combine " ))
+	if (HasGlExtension( pExtStr, "GL_ARB_texture_env_combine" ))
 	{
 		g_Has_GL_ARB_texture_env_combine = true
 		;
@@ -64,7 +93,7 @@ bool Install_GL_ARB_multitexture()
 
 	char *pExtStr = (char *)(glGetString( GL_EXTENSIONS ));
 
-	if (pExtStr && strstr( pExtStr, "GL_ARB_multitexture " ))
+	if (HasGlExtension( pExtStr, "GL_ARB_multitexture" ))
 	{
 		glActiveTextureARB = (PFNGLACTIVETEXTUREARBPROC)wglGetProcAddress("glActiveTextureARB");
 
@@ -76,3 +105,48 @@ bool Install_GL_ARB_multitexture()
 	return g_Has_GL_ARB_multitexture;
 }
 
+
+//
+// GL_ARB_pixel_buffer_object Extension
+
+bool g_Has_GL_ARB_pixel_buffer_object = false;
+
+PFNGLBINDBUFFERARBPROC glBindBufferARB = 0;
+PFNGLBUFFERDATAARBPROC glBufferDataARB = 0;
+PFNGLDELETEBUFFERSARBPROC glDeleteBuffersARB = 0;
+PFNGLGENBUFFERSARBPROC glGenBuffersARB = 0;
+PFNGLMAPBUFFERARBPROC glMapBufferARB = 0;
+PFNGLUNMAPBUFFERARBPROC glUnmapBufferARB = 0;
+
+
+bool Install_GL_ARB_pixel_buffer_object()
+{
+	static bool bTried = false;
+	if(bTried)
+		return g_Has_GL_ARB_pixel_buffer_object;
+	bTried = true;
+
+	char *pExtStr = (char *)(glGetString( GL_EXTENSIONS ));
+
+	// the buffer functions come from GL_ARB_vertex_buffer_object:
+	if (HasGlExtension( pExtStr, "GL_ARB_pixel_buffer_object" ) && HasGlExtension( pExtStr, "GL_ARB_vertex_buffer_object" ))
+	{
+		glBindBufferARB = (PFNGLBINDBUFFERARBPROC)wglGetProcAddress("glBindBufferARB");
+		glBufferDataARB = (PFNGLBUFFERDATAARBPROC)wglGetProcAddress("glBufferDataARB");
+		glDeleteBuffersARB = (PFNGLDELETEBUFFERSARBPROC)wglGetProcAddress("glDeleteBuffersARB");
+		glGenBuffersARB = (PFNGLGENBUFFERSARBPROC)wglGetProcAddress("glGenBuffersARB");
+		glMapBufferARB = (PFNGLMAPBUFFERARBPROC)wglGetProcAddress("glMapBufferARB");
+		glUnmapBufferARB = (PFNGLUNMAPBUFFERARBPROC)wglGetProcAddress("glUnmapBufferARB");
+
+		g_Has_GL_ARB_pixel_buffer_object = true
+			&& glBindBufferARB
+			&& glBufferDataARB
+			&& glDeleteBuffersARB
+			&& glGenBuffersARB
+			&& glMapBufferARB
+			&& glUnmapBufferARB
+		;
+	}
+
+	return g_Has_GL_ARB_pixel_buffer_object;
+}
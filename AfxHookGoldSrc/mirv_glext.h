@@ -23,3 +23,16 @@ bool Install_GL_ARB_multitexture();
 
 extern PFNGLACTIVETEXTUREARBPROC glActiveTextureARB;
 
+
+//
+// GL_ARB_pixel_buffer_object Extension (optional, not part of Install_All_Gl_Extensions result)
+
+extern bool g_Has_GL_ARB_pixel_buffer_object;
+bool Install_GL_ARB_pixel_buffer_object();
+
+extern PFNGLBINDBUFFERARBPROC glBindBufferARB;
+extern PFNGLBUFFERDATAARBPROC glBufferDataARB;
+extern PFNGLDELETEBUFFERSARBPROC glDeleteBuffersARB;
+extern PFNGLGENBUFFERSARBPROC glGenBuffersARB;
+extern PFNGLMAPBUFFERARBPROC glMapBufferARB;
+extern PFNGLUNMAPBUFFERARBPROC glUnmapBufferARB;
@@ -0,0 +1,64 @@
+#include "stdafx.h"
+
+#include "AfxCapturePipeline.h"
+
+#include "SourceInterfaces.h"
+
+// CAfxCapturePipeline /////////////////////////////////////////////////////////
+
+CAfxCapturePipeline::CAfxCapturePipeline()
+	: Convert("convert", 2, 3)
+	, Sample("sample", 2, 3)
+	, Output("output", 4, 3)
+{
+}
+
+void CAfxCapturePipeline::Wait(void)
+{
+	// Stages only queue on later stages, so this order catches everything:
+
+	Convert.Wait();
+	Sample.Wait();
+	Output.Wait();
+}
+
+void CAfxCapturePipeline::Shutdown(void)
+{
+	Convert.Shutdown();
+	Sample.Shutdown();
+	Output.Shutdown();
+}
+
+void CAfxCapturePipeline::ResetStats(void)
+{
+	Convert.ResetStats();
+	Sample.ResetStats();
+	Output.ResetStats();
+}
+
+void CAfxCapturePipeline::PrintStats(void)
+{
+	CAfxCaptureStage * stages[3] = { &Convert, &Sample, &Output };
+
+	Tier0_Msg("stage: workers, queued, maxQueued, done, stalls, stallMs\n");
+
+	for (int i = 0; i < 3; ++i)
+	{
+		CAfxCaptureStage * stage = stages[i];
+
+		unsigned long long stallCount;
+		double stallSeconds;
+
+		stage->GetStalls(stallCount, stallSeconds);
+
+		Tier0_Msg("%s: %u, %u, %u, %llu, %llu, %.1f\n"
+			, stage->GetName()
+			, (unsigned int)stage->GetWorkerCount()
+			, (unsigned int)stage->GetQueued()
+			, (unsigned int)stage->GetMaxQueued()
+			, stage->GetDone()
+			, stallCount
+			, 1000.0 * stallSeconds
+		);
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <shared/AfxCaptureStage.h>
+
+/// <summary>
+/// The stages captured frames pass through after readback on the render thread:
+/// conversion (and combining of sub-streams), sampling and output (encoding and writing).
+/// </summary>
+class CAfxCapturePipeline
+{
+public:
+	CAfxCaptureStage Convert;
+	CAfxCaptureStage Sample;
+	CAfxCaptureStage Output;
+
+	CAfxCapturePipeline();
+
+	/// <summary>Waits until all frames queued so far have left the pipeline.</summary>
+	void Wait(void);
+
+	void Shutdown(void);
+
+	void PrintStats(void);
+
+	void ResetStats(void);
+};
@@ -52,6 +52,8 @@ bool CAfxMaterialKey::operator < (const CAfxMaterialKey & y) const
 
 std::map<SOURCESDK::IMaterial_csgo *, CAfxTrackedMaterial *> CAfxTrackedMaterial::m_Trackeds;
 std::shared_timed_mutex CAfxTrackedMaterial::m_TrackedsMutex;
+std::vector<int> CAfxTrackedMaterial::m_FreeSlots;
+int CAfxTrackedMaterial::m_NextSlot = 0;
 
 CAfxTrackedMaterial * CAfxTrackedMaterial::TrackMaterial(SOURCESDK::IMaterial_csgo * material)
 {
@@ -171,6 +173,17 @@ void CAfxTrackedMaterial::HooKVtable(SOURCESDK::IMaterial_csgo * orgMaterial)
 CAfxTrackedMaterial::CAfxTrackedMaterial(SOURCESDK::IMaterial_csgo * material)
 	: CAfxMaterialKey(material)
 {
+	// Constructed and destructed with m_TrackedsMutex held exclusively.
+
+	if (m_FreeSlots.empty())
+	{
+		m_Slot = m_NextSlot++;
+	}
+	else
+	{
+		m_Slot = m_FreeSlots.back();
+		m_FreeSlots.pop_back();
+	}
 }
 
 CAfxTrackedMaterial::~CAfxTrackedMaterial()
@@ -186,6 +199,8 @@ CAfxTrackedMaterial::~CAfxTrackedMaterial()
 		m_ThisNotifyees.erase(it);
 		notifyee->AfxMaterialFree(this);
 	}
+
+	m_FreeSlots.push_back(m_Slot);
 }
 
 void CAfxTrackedMaterial::AddNotifyee(IAfxMaterialFree * notifyee)
@@ -5,6 +5,7 @@
 
 #include <set>
 #include <map>
+#include <vector>
 #include <atomic>
 #include <mutex>
 #include <shared_mutex>
@@ -80,6 +81,15 @@ public:
 	void AddNotifyee(IAfxMaterialFree * notifyee);
 	void RemoveNotifyee(IAfxMaterialFree * notifyee);
 
+	/// <summary>
+	/// Dense index that is unique among the currently tracked materials,
+	/// it is re-used after the material has been freed (and its notifyees have been called).
+	/// </summary>
+	int GetSlot(void) const
+	{
+		return m_Slot;
+	}
+
 	SOURCESDK::IMaterial_csgo * GetReplacement(void)
 	{
 		return m_Replacement;
@@ -99,6 +109,10 @@ private:
 	static std::map<SOURCESDK::IMaterial_csgo *, CAfxTrackedMaterial *> m_Trackeds;
 	static std::shared_timed_mutex m_TrackedsMutex;
 
+	// Guarded by m_TrackedsMutex.
+	static std::vector<int> m_FreeSlots;
+	static int m_NextSlot;
+
 	static std::map<int *, CMaterialDetours> m_VtableMap;
 	static std::shared_timed_mutex m_VtableMapMutex;
 
@@ -110,4 +124,5 @@ private:
 
 	std::set<IAfxMaterialFree *> m_ThisNotifyees;
 	SOURCESDK::IMaterial_csgo * m_Replacement = 0;
+	int m_Slot;
 };
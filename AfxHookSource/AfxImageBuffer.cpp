@@ -4,57 +4,226 @@
 
 #include "SourceInterfaces.h"
 
+#include <malloc.h>
+#include <chrono>
+
+#include <shared/AfxImageKernels.h>
+
 // CAfxImageBufferPool /////////////////////////////////////////////////////////
 
-CAfxImageBufferPool::CAfxImageBufferPool()
+size_t CAfxImageBufferPool::GetBucketSize(size_t bytes)
 {
-	for (int i = 0; i < 3; ++i)
-	{
-		m_Buffers.push(new CAfxImageBuffer(this));
-	}
+	const size_t minBytes = 64 * 1024;
+
+	if (bytes <= minBytes) return minBytes;
+
+	// Steps of a quarter of the highest power of two in bytes:
 
-	m_BufferAvailableCondition.notify_one();
+	size_t step = minBytes;
+	while (step <= bytes / 2) step *= 2;
+	step /= 4;
+
+	return (bytes + step - 1) / step * step;
+}
+
+CAfxImageBufferPool::CAfxImageBufferPool()
+	: m_Budget(512 * 1024 * 1024)
+{
 }
 
 CAfxImageBufferPool::~CAfxImageBufferPool()
 {
-	while (!m_Buffers.empty())
+	while (!m_FreeBuffers.empty())
 	{
-		delete m_Buffers.top();
-		m_Buffers.pop();
+		DeleteBuffer(m_FreeBuffers.begin());
 	}
 }
 
-CAfxImageBuffer * CAfxImageBufferPool::AquireBuffer(void)
+CAfxImageBuffer * CAfxImageBufferPool::AquireBuffer(size_t bytes, bool wait)
 {
-	std::unique_lock<std::mutex> lock(m_BuffersMutex);
+	size_t bucketBytes = GetBucketSize(bytes);
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	CAfxImageBuffer * result = nullptr;
+
+	bool stalled = false;
+	std::chrono::steady_clock::time_point stallStart;
+
+	while (true)
+	{
+		auto it = m_FreeBuffers.lower_bound(bucketBytes);
+
+		if (it != m_FreeBuffers.end())
+		{
+			result = it->second;
+			m_FreeBuffers.erase(it);
+			break;
+		}
+
+		if (0 == m_Budget || m_Bytes + bucketBytes <= m_Budget)
+			break;
+
+		if (!m_FreeBuffers.empty())
+		{
+			// All free ones are too small, drop the smallest to make room:
+			DeleteBuffer(m_FreeBuffers.begin());
+			continue;
+		}
+
+		if (wait)
+		{
+			if (!stalled)
+			{
+				stalled = true;
+				stallStart = std::chrono::steady_clock::now();
+			}
 
-	m_BufferAvailableCondition.wait(lock, [this]() { return !m_Buffers.empty(); });
+			unsigned long long releases = m_Releases;
 
-	CAfxImageBuffer * result = m_Buffers.top();
+			m_ReleasedCondition.wait_for(lock, std::chrono::milliseconds(100), [this, releases]() { return releases != m_Releases; });
 
-	m_Buffers.pop();
+			if (releases != m_Releases)
+				continue;
+		}
 
-	bool available = !m_Buffers.empty();
+		// Nothing is coming back (or we must not wait), so exceed the budget:
+		++m_OverBudgetCount;
+		break;
+	}
+
+	if (stalled)
+	{
+		++m_StallCount;
+		m_StallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - stallStart).count();
+	}
 
-	if (available)
+	if (nullptr == result)
 	{
+		result = new CAfxImageBuffer(this);
+
+		++m_Buffers;
+		if (m_MaxBuffers < m_Buffers) m_MaxBuffers = m_Buffers;
+
+		// Reserve the bytes before unlocking, so concurrent calls see them in the budget:
+		AddBytes(bucketBytes);
+
 		lock.unlock();
-		m_BufferAvailableCondition.notify_one();
+
+		bool allocated = result->Allocate(bucketBytes);
+
+		lock.lock();
+
+		if (!allocated)
+		{
+			m_Bytes -= bucketBytes;
+			--m_Buffers;
+
+			lock.unlock();
+
+			delete result;
+
+			Tier0_Warning("AFXERROR: CAfxImageBufferPool::AquireBuffer: Could not allocate %u bytes.\n", (unsigned int)bucketBytes);
+
+			return nullptr;
+		}
 	}
 
+	++m_BuffersUsed;
+	if (m_MaxBuffersUsed < m_BuffersUsed) m_MaxBuffersUsed = m_BuffersUsed;
+
+	result->m_RefCount = 1;
+
 	return result;
 }
 
 void CAfxImageBufferPool::ImageBuffer_Done(CAfxImageBuffer * buffer)
 {
 	{
-		std::unique_lock<std::mutex> lock(m_BuffersMutex);
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		m_FreeBuffers.emplace(buffer->m_BufferBytesAllocated, buffer);
+
+		--m_BuffersUsed;
+		++m_Releases;
+	}
+
+	m_ReleasedCondition.notify_all();
+}
+
+void CAfxImageBufferPool::SetBudget(size_t bytes)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	m_Budget = bytes;
 
-		m_Buffers.push(buffer);
+	while (0 != m_Budget && m_Budget < m_Bytes && !m_FreeBuffers.empty())
+	{
+		DeleteBuffer(m_FreeBuffers.begin());
 	}
+}
+
+size_t CAfxImageBufferPool::GetBudget(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	return m_Budget;
+}
+
+void CAfxImageBufferPool::Console_PrintStats(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	const double toMiB = 1.0 / (1024 * 1024);
+
+	Tier0_Msg("buffers: %u (max %u), in use: %u (max %u), MiB: %.1f (max %.1f), budget MiB: %.1f\n"
+		, (unsigned int)m_Buffers, (unsigned int)m_MaxBuffers
+		, (unsigned int)m_BuffersUsed, (unsigned int)m_MaxBuffersUsed
+		, toMiB * m_Bytes, toMiB * m_MaxBytes
+		, toMiB * m_Budget
+	);
+	Tier0_Msg("buffer stalls: %llu, stallMs: %.1f, over budget: %llu\n"
+		, m_StallCount, 1000.0 * m_StallSeconds
+		, m_OverBudgetCount
+	);
+}
+
+void CAfxImageBufferPool::ResetStats(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	m_MaxBuffers = m_Buffers;
+	m_MaxBuffersUsed = m_BuffersUsed;
+	m_MaxBytes = m_Bytes;
+	m_StallCount = 0;
+	m_StallSeconds = 0.0;
+	m_OverBudgetCount = 0;
+}
+
+void CAfxImageBufferPool::DeleteBuffer(std::multimap<size_t, CAfxImageBuffer *>::iterator it)
+{
+	CAfxImageBuffer * buffer = it->second;
+
+	m_FreeBuffers.erase(it);
+
+	m_Bytes -= buffer->m_BufferBytesAllocated;
+	--m_Buffers;
+
+	delete buffer;
+}
+
+void CAfxImageBufferPool::AddBytes(size_t bytes)
+{
+	m_Bytes += bytes;
+	if (m_MaxBytes < m_Bytes) m_MaxBytes = m_Bytes;
+}
+
+void CAfxImageBufferPool::OnBufferResized(size_t oldBytes, size_t newBytes)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
 
-	m_BufferAvailableCondition.notify_one();
+	m_Bytes -= oldBytes;
+	AddBytes(newBytes);
 }
 
 // CAfxImageBuffer /////////////////////////////////////////////////////////////
@@ -63,17 +232,54 @@ CAfxImageBuffer::CAfxImageBuffer(CAfxImageBufferPool * pool)
 	: Buffer(0)
 	, m_BufferBytesAllocated(0)
 	, m_Pool(pool)
+	, m_RefCount(0)
 {
 }
 
 CAfxImageBuffer::~CAfxImageBuffer()
 {
-	free(Buffer);
+	_aligned_free(Buffer);
+}
+
+void CAfxImageBuffer::AddRef(void)
+{
+	++m_RefCount;
 }
 
 void CAfxImageBuffer::Release(void)
 {
-	m_Pool->ImageBuffer_Done(this);
+	if (0 == --m_RefCount) m_Pool->ImageBuffer_Done(this);
+}
+
+bool CAfxImageBuffer::Allocate(size_t bucketBytes)
+{
+	Buffer = _aligned_malloc(bucketBytes, CAfxImageBufferPool::Alignment);
+
+	if (nullptr == Buffer)
+		return false;
+
+	m_BufferBytesAllocated = bucketBytes;
+
+	return true;
+}
+
+bool CAfxImageBuffer::Grow(size_t bytes)
+{
+	size_t bucketBytes = CAfxImageBufferPool::GetBucketSize(bytes);
+
+	void * newBuffer = Buffer
+		? _aligned_realloc(Buffer, bucketBytes, CAfxImageBufferPool::Alignment)
+		: _aligned_malloc(bucketBytes, CAfxImageBufferPool::Alignment);
+
+	if (nullptr == newBuffer)
+		return false;
+
+	m_Pool->OnBufferResized(m_BufferBytesAllocated, bucketBytes);
+
+	Buffer = newBuffer;
+	m_BufferBytesAllocated = bucketBytes;
+
+	return true;
 }
 
 bool CAfxImageBuffer::AutoRealloc(const CAfxImageFormat & format)
@@ -103,25 +309,23 @@ bool CAfxImageBuffer::AutoRealloc(const CAfxImageFormat & format)
 
 	if (!Buffer || m_BufferBytesAllocated < imageBytes)
 	{
-		Buffer = realloc(Buffer, imageBytes);
-		if (Buffer)
-		{
-			m_BufferBytesAllocated = imageBytes;
-		}
+		if (!Grow(imageBytes))
+			return false;
 	}
 
-	m_BufferBytesAllocated = imageBytes;
 	Format.PixelFormat = format.PixelFormat;
 	Format.Width = format.Width;
 	Format.Height = format.Height;
 	Format.Pitch = pitch;
 	Format.Bytes = imageBytes;
 
-	return 0 != Buffer;
+	return true;
 }
 
 bool CAfxImageBuffer::BgrMergeBlueToRgba(CAfxImageBuffer const * alphaBuffer)
 {
+	int bgrPitch = Format.Pitch;
+
 	bool ok = alphaBuffer
 		&& Format.Width == alphaBuffer->Format.Width
 		&& Format.Height == alphaBuffer->Format.Height
@@ -135,21 +339,9 @@ bool CAfxImageBuffer::BgrMergeBlueToRgba(CAfxImageBuffer const * alphaBuffer)
 	{
 		// interleave B as alpha into A:
 
-		for (int y = Format.Height - 1; y >= 0; --y)
-		{
-			for (int x = Format.Width - 1; x >= 0; --x)
-			{
-				unsigned char b = ((unsigned char *)Buffer)[y*Format.Pitch + x * 3 + 0];
-				unsigned char g = ((unsigned char *)Buffer)[y*Format.Pitch + x * 3 + 1];
-				unsigned char r = ((unsigned char *)Buffer)[y*Format.Pitch + x * 3 + 2];
-				unsigned char a = ((unsigned char *)alphaBuffer->Buffer)[y*alphaBuffer->Format.Pitch + x * 3 + 0];
-
-				((unsigned char *)Buffer)[y*Format.Pitch + x * 4 + 0] = b;
-				((unsigned char *)Buffer)[y*Format.Pitch + x * 4 + 1] = g;
-				((unsigned char *)Buffer)[y*Format.Pitch + x * 4 + 2] = r;
-				((unsigned char *)Buffer)[y*Format.Pitch + x * 4 + 3] = a;
-			}
-		}
+		AfxImageKernels::Get(AfxImageKernels::EK_Auto)->BgrMergeBlueToBgra(
+			(unsigned char *)Buffer, Format.Width, Format.Height, bgrPitch, Format.Pitch,
+			(unsigned char const *)alphaBuffer->Buffer, alphaBuffer->Format.Pitch);
 	}
 	else
 	{
@@ -1,9 +1,10 @@
 #pragma once
 
 #include <string>
-#include <stack>
+#include <map>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
 
 struct CAfxImageFormat
 {
@@ -48,22 +49,78 @@ struct CAfxImageFormat
 
 class CAfxImageBuffer;
 
+/// <summary>
+/// Pool of image buffers, free buffers are bucketed by their size.
+/// The pool grows on demand up to a memory budget.
+/// </summary>
 class CAfxImageBufferPool
 {
 public:
+	/// <summary>Alignment of the buffer memory (suitable for SIMD).</summary>
+	static const size_t Alignment = 64;
+
+	/// <returns>Size of the bucket for bytes, at most 25 % more.</returns>
+	static size_t GetBucketSize(size_t bytes);
+
 	CAfxImageBufferPool();
 
 	/// <remarks>Must not be called until all buffers are done.</remarks>
 	~CAfxImageBufferPool();
 
-	CAfxImageBuffer * AquireBuffer(void);
+	/// <summary>
+	/// Returns a buffer with room for at least bytes and a reference count of 1.
+	/// If there is no free buffer that is big enough, a new one is created,
+	/// free buffers that are too small are dropped if that is needed to stay in budget.
+	/// </summary>
+	/// <returns>nullptr if the memory could not be allocated.</returns>
+	/// <param name="wait">
+	/// If to wait for buffers to be released, while over budget.
+	/// If nothing is released for a while the budget is exceeded anyway,
+	/// so this can't dead-lock with a caller that is holding buffers itself.
+	/// </param>
+	CAfxImageBuffer * AquireBuffer(size_t bytes, bool wait);
 
 	void ImageBuffer_Done(CAfxImageBuffer * buffer);
 
+	/// <param name="bytes">0 means no limit.</param>
+	void SetBudget(size_t bytes);
+
+	size_t GetBudget(void);
+
+	void Console_PrintStats(void);
+
+	void ResetStats(void);
+
 private:
-	std::stack<CAfxImageBuffer *> m_Buffers;
-	std::mutex m_BuffersMutex;
-	std::condition_variable m_BufferAvailableCondition;
+	friend class CAfxImageBuffer;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_ReleasedCondition;
+
+	/// <summary>Free buffers by capacity.</summary>
+	std::multimap<size_t, CAfxImageBuffer *> m_FreeBuffers;
+
+	size_t m_Budget;
+
+	size_t m_Buffers = 0;
+	size_t m_BuffersUsed = 0;
+	size_t m_Bytes = 0;
+	unsigned long long m_Releases = 0;
+
+	size_t m_MaxBuffers = 0;
+	size_t m_MaxBuffersUsed = 0;
+	size_t m_MaxBytes = 0;
+	unsigned long long m_StallCount = 0;
+	double m_StallSeconds = 0.0;
+	unsigned long long m_OverBudgetCount = 0;
+
+	/// <remarks>m_Mutex must be locked.</remarks>
+	void DeleteBuffer(std::multimap<size_t, CAfxImageBuffer *>::iterator it);
+
+	/// <remarks>m_Mutex must be locked.</remarks>
+	void AddBytes(size_t bytes);
+
+	void OnBufferResized(size_t oldBytes, size_t newBytes);
 };
 
 class CAfxImageBuffer
@@ -76,9 +133,13 @@ public:
 	CAfxImageBuffer(CAfxImageBufferPool * pool);
 	~CAfxImageBuffer();
 
-	/// <summary>Releases the buffer back to the pool (it may not be used anymore until being aquired from the pool again).</summary>
+	/// <summary>Adds a reference, so the buffer can be handed on to another thread.</summary>
+	void AddRef(void);
+
+	/// <summary>Releases a reference, the last one releases the buffer back to the pool (it may not be used anymore until being aquired from the pool again).</summary>
 	void Release(void);
 
+	/// <summary>Sets the format, grows the memory if needed (keeping the contents), never shrinks it.</summary>
 	bool AutoRealloc(const CAfxImageFormat & format);
 
 	/// <summary>
@@ -89,7 +150,15 @@ public:
 	bool BgrMergeBlueToRgba(CAfxImageBuffer const * alphaBuffer);
 
 private:
+	friend class CAfxImageBufferPool;
+
 	size_t m_BufferBytesAllocated;
 	CAfxImageBufferPool * m_Pool;
-};
+	std::atomic_int m_RefCount;
 
+	/// <summary>Allocates the memory of a new buffer, the pool has accounted for bucketBytes already.</summary>
+	bool Allocate(size_t bucketBytes);
+
+	/// <summary>Grows the memory to the bucket size of bytes, keeping the contents.</summary>
+	bool Grow(size_t bytes);
+};
@@ -14,6 +14,7 @@
 
 #include <set>
 #include <queue>
+#include <vector>
 
 #include <mutex>
 #include <atomic>
@@ -27,7 +28,7 @@ extern SOURCESDK::IVRenderView_csgo * g_pVRenderView_csgo;
 
 namespace AfxInterop {
 
-	const INT32 m_Version = 5;
+	const INT32 m_Version = 6;
 
 	bool Connect();
 	void Disconnect();
@@ -108,6 +109,15 @@ namespace AfxInterop {
 			EngineMessage_AfterTranslucent = 12
 		};
 
+		enum CalcType {
+			CalcType_Handle = 0,
+			CalcType_VecAng = 1,
+			CalcType_Cam = 2,
+			CalcType_Fov = 3,
+			CalcType_Bool = 4,
+			CalcType_Int = 5
+		};
+
 		class CConsole
 		{
 		public:
@@ -340,8 +350,63 @@ namespace AfxInterop {
 
 		if (!Flush(EngineThread::m_hPipe)) { errorLine = __LINE__; goto locked_error; }
 
+		{
+			// Resolve calc names to ids (0 if not found), so they don't need to be sent and looked up by name each frame:
+
+			UINT32 numResolves;
+
+			if (!ReadCompressedUInt32(EngineThread::m_hPipe, numResolves)) { errorLine = __LINE__; goto locked_error; }
+
+			if (0 < numResolves)
+			{
+				std::vector<INT32> ids(numResolves);
+				std::string calcName;
+
+				for (UINT32 i = 0; i < numResolves; ++i)
+				{
+					UINT32 calcType;
+
+					if (!ReadCompressedUInt32(EngineThread::m_hPipe, calcType)) { errorLine = __LINE__; goto locked_error; }
+					if (!ReadStringUTF8(EngineThread::m_hPipe, calcName)) { errorLine = __LINE__; goto locked_error; }
+
+					switch (calcType)
+					{
+					case EngineThread::CalcType_Handle:
+						ids[i] = g_MirvHandleCalcs.GetId(calcName.c_str());
+						break;
+					case EngineThread::CalcType_VecAng:
+						ids[i] = g_MirvVecAngCalcs.GetId(calcName.c_str());
+						break;
+					case EngineThread::CalcType_Cam:
+						ids[i] = g_MirvCamCalcs.GetId(calcName.c_str());
+						break;
+					case EngineThread::CalcType_Fov:
+						ids[i] = g_MirvFovCalcs.GetId(calcName.c_str());
+						break;
+					case EngineThread::CalcType_Bool:
+						ids[i] = g_MirvBoolCalcs.GetId(calcName.c_str());
+						break;
+					case EngineThread::CalcType_Int:
+						ids[i] = g_MirvIntCalcs.GetId(calcName.c_str());
+						break;
+					default:
+						ids[i] = 0;
+						break;
+					}
+				}
+
+				for (UINT32 i = 0; i < numResolves; ++i)
+				{
+					if (!WriteCompressedInt32(EngineThread::m_hPipe, ids[i])) { errorLine = __LINE__; goto locked_error; }
+				}
+
+				if (!Flush(EngineThread::m_hPipe)) { errorLine = __LINE__; goto locked_error; }
+			}
+		}
+
 		{
 			UINT32 numCalcs;
+			INT32 calcId;
 			std::string calcName;
 
 			std::queue<HandleCalcResult *> handleCalcResults;
@@ -357,9 +422,11 @@ namespace AfxInterop {
 
 			for (UINT32 i = 0; i < numCalcs; ++i)
 			{
-				if(!ReadStringUTF8(EngineThread::m_hPipe, calcName)) { errorLine = __LINE__; goto locked_error; }
+				// calc id or 0 followed by the calc name:
+				if (!ReadCompressedInt32(EngineThread::m_hPipe, calcId)) { errorLine = __LINE__; goto locked_error; }
+				if (0 == calcId && !ReadStringUTF8(EngineThread::m_hPipe, calcName)) { errorLine = __LINE__; goto locked_error; }
 
-				if (IMirvHandleCalc * calc = g_MirvHandleCalcs.GetByName(calcName.c_str()))
+				if (IMirvHandleCalc * calc = 0 != calcId ? g_MirvHandleCalcs.GetById(calcId) : g_MirvHandleCalcs.GetByName(calcName.c_str()))
 				{
 					SOURCESDK::CSGO::CBaseHandle handle;
 
@@ -378,9 +445,11 @@ namespace AfxInterop {
 
 			for (UINT32 i = 0; i < numCalcs; ++i)
 			{
-				if (!ReadStringUTF8(EngineThread::m_hPipe, calcName)) { errorLine = __LINE__; goto locked_error; }
+				// calc id or 0 followed by the calc name:
+				if (!ReadCompressedInt32(EngineThread::m_hPipe, calcId)) { errorLine = __LINE__; goto locked_error; }
+				if (0 == calcId && !ReadStringUTF8(EngineThread::m_hPipe, calcName)) { errorLine = __LINE__; goto locked_error; }
 
-				if (IMirvVecAngCalc * calc = g_MirvVecAngCalcs.GetByName(calcName.c_str()))
+				if (IMirvVecAngCalc * calc = 0 != calcId ? g_MirvVecAngCalcs.GetById(calcId) : g_MirvVecAngCalcs.GetByName(calcName.c_str()))
 				{
 					SOURCESDK::Vector vector;
 					SOURCESDK::QAngle qangle;
@@ -400,9 +469,11 @@ namespace AfxInterop {
 
 			for (UINT32 i = 0; i < numCalcs; ++i)
 			{
-				if (!ReadStringUTF8(EngineThread::m_hPipe, calcName)) { errorLine = __LINE__; goto locked_error; }
+				// calc id or 0 followed by the calc name:
+				if (!ReadCompressedInt32(EngineThread::m_hPipe, calcId)) { errorLine = __LINE__; goto locked_error; }
+				if (0 == calcId && !ReadStringUTF8(EngineThread::m_hPipe, calcName)) { errorLine = __LINE__; goto locked_error; }
 
-				if (IMirvCamCalc * calc = g_MirvCamCalcs.GetByName(calcName.c_str()))
+				if (IMirvCamCalc * calc = 0 != calcId ? g_MirvCamCalcs.GetById(calcId) : g_MirvCamCalcs.GetByName(calcName.c_str()))
 				{
 					SOURCESDK::Vector vector;
 					SOURCESDK::QAngle qangle;
@@ -423,9 +494,11 @@ namespace AfxInterop {
 
 			for (UINT32 i = 0; i < numCalcs; ++i)
 			{
-				if (!ReadStringUTF8(EngineThread::m_hPipe, calcName)) { errorLine = __LINE__; goto locked_error; }
+				// calc id or 0 followed by the calc name:
+				if (!ReadCompressedInt32(EngineThread::m_hPipe, calcId)) { errorLine = __LINE__; goto locked_error; }
+				if (0 == calcId && !ReadStringUTF8(EngineThread::m_hPipe, calcName)) { errorLine = __LINE__; goto locked_error; }
 
-				if (IMirvFovCalc * calc = g_MirvFovCalcs.GetByName(calcName.c_str()))
+				if (IMirvFovCalc * calc = 0 != calcId ? g_MirvFovCalcs.GetById(calcId) : g_MirvFovCalcs.GetByName(calcName.c_str()))
 				{
 					float fov;
 
@@ -444,9 +517,11 @@ namespace AfxInterop {
 
 			for (UINT32 i = 0; i < numCalcs; ++i)
 			{
-				if (!ReadStringUTF8(EngineThread::m_hPipe, calcName)) { errorLine = __LINE__; goto locked_error; }
+				// calc id or 0 followed by the calc name:
+				if (!ReadCompressedInt32(EngineThread::m_hPipe, calcId)) { errorLine = __LINE__; goto locked_error; }
+				if (0 == calcId && !ReadStringUTF8(EngineThread::m_hPipe, calcName)) { errorLine = __LINE__; goto locked_error; }
 
-				if (IMirvBoolCalc * calc = g_MirvBoolCalcs.GetByName(calcName.c_str()))
+				if (IMirvBoolCalc * calc = 0 != calcId ? g_MirvBoolCalcs.GetById(calcId) : g_MirvBoolCalcs.GetByName(calcName.c_str()))
 				{
 					bool result;
 
@@ -465,9 +540,11 @@ namespace AfxInterop {
 
 			for (UINT32 i = 0; i < numCalcs; ++i)
 			{
-				if (!ReadStringUTF8(EngineThread::m_hPipe, calcName)) { errorLine = __LINE__; goto locked_error; }
+				// calc id or 0 followed by the calc name:
+				if (!ReadCompressedInt32(EngineThread::m_hPipe, calcId)) { errorLine = __LINE__; goto locked_error; }
+				if (0 == calcId && !ReadStringUTF8(EngineThread::m_hPipe, calcName)) { errorLine = __LINE__; goto locked_error; }
 
-				if (IMirvIntCalc * calc = g_MirvIntCalcs.GetByName(calcName.c_str()))
+				if (IMirvIntCalc * calc = 0 != calcId ? g_MirvIntCalcs.GetById(calcId) : g_MirvIntCalcs.GetByName(calcName.c_str()))
 				{
 					int result;
 
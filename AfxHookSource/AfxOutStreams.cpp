@@ -213,6 +213,11 @@ CAfxOutFFMPEGVideoStream::CAfxOutFFMPEGVideoStream(const CAfxImageFormat & image
 		}
 
 		// Create a pipe for the child process's STDIN. 
+		// The buffer should hold at least a full frame, so ffmpeg can read a
+		// frame while the next one is being written.
+
+		DWORD pipeBufferSize = 256 * 1024;
+		if (pipeBufferSize < imageFormat.Bytes) pipeBufferSize = imageFormat.Bytes < 64 * 1024 * 1024 ? (DWORD)imageFormat.Bytes : 64 * 1024 * 1024;
 
 		std::ostringstream stdInPipeNameStream;
 		stdInPipeNameStream << "\\\\.\\pipe\\AfxHookSource_FFMPEG_In_" << GetCurrentProcessId() << "_" << (void *)this;
@@ -224,7 +229,7 @@ CAfxOutFFMPEGVideoStream::CAfxOutFFMPEGVideoStream(const CAfxImageFormat & image
 			PIPE_ACCESS_OUTBOUND | FILE_FLAG_OVERLAPPED,
 			PIPE_TYPE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
 			1,
-			256 * 1024,
+			pipeBufferSize,
 			0,
 			20000,
 			&saAttr)))
@@ -297,6 +302,21 @@ CAfxOutFFMPEGVideoStream::CAfxOutFFMPEGVideoStream(const CAfxImageFormat & image
 		}
 		if (m_Okay)
 		{
+			// Close our copies of the child's ends, so the reads end when ffmpeg exits:
+
+			CloseHandle(m_hChildStd_IN_Rd);
+			m_hChildStd_IN_Rd = INVALID_HANDLE_VALUE;
+			CloseHandle(m_hChildStd_OUT_Wr);
+			m_hChildStd_OUT_Wr = INVALID_HANDLE_VALUE;
+			CloseHandle(m_hChildStd_ERR_Wr);
+			m_hChildStd_ERR_Wr = INVALID_HANDLE_VALUE;
+
+			m_StdOutThread = std::thread(&CAfxOutFFMPEGVideoStream::ReadPipeThread, m_hChildStd_OUT_Rd, false);
+			m_StdErrThread = std::thread(&CAfxOutFFMPEGVideoStream::ReadPipeThread, m_hChildStd_ERR_Rd, true);
+
+			m_PipeWriter = new CAfxPipeWriter(3, [this](void const * data, size_t bytes) {
+				return WritePipe(data, bytes);
+			});
 		}
 		else
 		{
@@ -308,6 +328,13 @@ CAfxOutFFMPEGVideoStream::CAfxOutFFMPEGVideoStream(const CAfxImageFormat & image
 
 void CAfxOutFFMPEGVideoStream::Close()
 {
+	if (m_PipeWriter)
+	{
+		m_PipeWriter->Finish();
+		delete m_PipeWriter;
+		m_PipeWriter = nullptr;
+	}
+
 	if (INVALID_HANDLE_VALUE != m_hChildStd_IN_Wr)
 	{
 		CloseHandle(m_hChildStd_IN_Wr);
@@ -316,19 +343,7 @@ void CAfxOutFFMPEGVideoStream::Close()
 
 	if (FALSE != m_Okay)
 	{
-		DWORD waitCode = WAIT_TIMEOUT;
-		//for (int i = 0; i < 20000 && WAIT_TIMEOUT == waitCode; ++i)
-		while(WAIT_TIMEOUT == waitCode)
-		{
-			if (HandleOutAndErr())
-			{
-				waitCode = WaitForSingleObject(m_ProcessInfo.hProcess, 1);
-
-			}
-			else waitCode = WAIT_FAILED;
-		}
-
-		if (WAIT_OBJECT_0 != waitCode)
+		if (WAIT_OBJECT_0 != WaitForSingleObject(m_ProcessInfo.hProcess, INFINITE))
 		{
 			Tier0_Warning("AFXERROR: CAfxOutFFMPEGVideoStream::Close.\n");
 		}
@@ -339,6 +354,9 @@ void CAfxOutFFMPEGVideoStream::Close()
 		m_Okay = FALSE;
 	}
 
+	if (m_StdOutThread.joinable()) m_StdOutThread.join();
+	if (m_StdErrThread.joinable()) m_StdErrThread.join();
+
 	if (INVALID_HANDLE_VALUE != m_hChildStd_IN_Rd)
 	{
 		CloseHandle(m_hChildStd_IN_Rd);
@@ -383,199 +401,289 @@ bool CAfxOutFFMPEGVideoStream::SupplyVideoData(const CAfxImageBuffer & buffer)
 		return false;
 	}
 
-	//DWORD lastTickCount = GetTickCount();
+	// The buffer is not modified here, it's only kept alive until written:
+	CAfxImageBuffer * frameBuffer = const_cast<CAfxImageBuffer *>(&buffer);
+
+	frameBuffer->AddRef();
+
+	return m_PipeWriter->Queue(frameBuffer->Buffer, frameBuffer->Format.Bytes, [frameBuffer]() {
+		frameBuffer->Release();
+	});
+}
+
+CAfxOutFFMPEGVideoStream::~CAfxOutFFMPEGVideoStream()
+{
+	Close();
+}
 
-	DWORD offset = 0;
-	DWORD length = (DWORD)buffer.Format.Bytes;
+bool CAfxOutFFMPEGVideoStream::WritePipe(void const * data, size_t bytes)
+{
+	char const * pData = (char const *)data;
 
-	while (true)
+	while (0 < bytes)
 	{
 		DWORD bytesWritten = 0;
-		DWORD bytesToWrite = length;
+		DWORD bytesToWrite = bytes < 0x40000000 ? (DWORD)bytes : 0x40000000;
 
-		if (!WriteFile(m_hChildStd_IN_Wr, (LPVOID)&(((char *)buffer.Buffer)[offset]), bytesToWrite, NULL, &m_OverlappedWrite))
+		if (!WriteFile(m_hChildStd_IN_Wr, (LPCVOID)pData, bytesToWrite, NULL, &m_OverlappedWrite) && ERROR_IO_PENDING != GetLastError())
 		{
-			if (ERROR_IO_PENDING == GetLastError())
-			{
-				bool completed = false;
-
-				while (!completed)
-				{
-					DWORD result = WaitForSingleObject(m_OverlappedWrite.hEvent, 0);
-					switch (result)
-					{
-					case WAIT_OBJECT_0:
-						completed = true;
-						break;
-					case WAIT_TIMEOUT:
-						{
-							//DWORD curTickCount = GetTickCount();
-							//if (curTickCount - lastTickCount > 20000) return false;
-							//lastTickCount = curTickCount;
-							if (!HandleOutAndErr()) return false;
-						}
-						break;
-					default:
-						return false;
-					}
-				}
-			}
-			else
-			{
-				return false;
-			}
+			Tier0_Warning("AFXERROR: CAfxOutFFMPEGVideoStream::WritePipe: WriteFile.\n");
+			return false;
 		}
 
-		if (!GetOverlappedResult(m_hChildStd_IN_Wr, &m_OverlappedWrite, &bytesWritten, FALSE))
+		if (!GetOverlappedResult(m_hChildStd_IN_Wr, &m_OverlappedWrite, &bytesWritten, TRUE))
 		{
+			Tier0_Warning("AFXERROR: CAfxOutFFMPEGVideoStream::WritePipe: GetOverlappedResult.\n");
 			return false;
 		}
 
-		offset += bytesWritten;
-		length -= bytesWritten;
-
-		if (0 == length)
-			break;
+		pData += bytesWritten;
+		bytes -= bytesWritten;
 	}
 
 	return true;
 }
 
-CAfxOutFFMPEGVideoStream::~CAfxOutFFMPEGVideoStream()
+void CAfxOutFFMPEGVideoStream::ReadPipeThread(HANDLE hPipe, bool isStdErr)
 {
-	Close();
+	CHAR chBuf[251];
+	DWORD dwBytesRead;
+
+	// Ends when ffmpeg closes its end (exits):
+	while (ReadFile(hPipe, chBuf, 250, &dwBytesRead, NULL) && 0 < dwBytesRead)
+	{
+		chBuf[dwBytesRead] = 0;
+
+		if (isStdErr) Tier0_Warning("%s", chBuf);
+		else Tier0_Msg("%s", chBuf);
+	}
 }
 
-bool CAfxOutFFMPEGVideoStream::HandleOutAndErr()
+// CAfxOutStageVideoStream /////////////////////////////////////////////////////
+
+CAfxOutStageVideoStream::CAfxOutStageVideoStream(const CAfxImageFormat & imageFormat, CAfxCaptureStage & stage, CAfxOutVideoStream * outVideoStream)
+	: CAfxOutVideoStream(imageFormat)
+	, m_Stage(stage)
+	, m_Queue(stage.CreateQueue())
+	, m_OutVideoStream(outVideoStream)
+	, m_Failed(false)
 {
-	if (!m_Okay) return false;
+	if (m_OutVideoStream) m_OutVideoStream->AddRef();
+}
 
-	CHAR chBuf[251];
-	DWORD bytesAvail;
+CAfxOutStageVideoStream::~CAfxOutStageVideoStream()
+{
+	m_Stage.DeleteQueue(m_Queue);
+
+	if (m_OutVideoStream) m_OutVideoStream->Release();
+}
+
+bool CAfxOutStageVideoStream::SupplyVideoData(const CAfxImageBuffer & buffer)
+{
+	if (nullptr == m_OutVideoStream) return false;
+
+	// The buffer is not modified here, it's only kept alive until the job is done:
+	CAfxImageBuffer * jobBuffer = const_cast<CAfxImageBuffer *>(&buffer);
 
-	if (PeekNamedPipe(m_hChildStd_ERR_Rd, NULL, 0, NULL, &bytesAvail, NULL))
+	jobBuffer->AddRef();
+	this->AddRef();
+
+	m_Stage.Queue(m_Queue, [this, jobBuffer]() {
+		if (!m_OutVideoStream->SupplyVideoData(*jobBuffer)) m_Failed = true;
+
+		jobBuffer->Release();
+		this->Release();
+	});
+
+	return !m_Failed.exchange(false);
+}
+
+// CAfxOutSamplingStream ///////////////////////////////////////////////////////
+
+CAfxOutSamplingStream::CAfxOutSamplingStream(const CAfxImageFormat & imageFormat, CAfxOutVideoStream * outVideoStream, float frameRate, EasySamplerSettings::Method method, double frameDuration, double exposure, float frameStrength, int threads, EasySamplerKernels::Kind kernels)
+	: CAfxOutVideoStream(imageFormat)
+	, m_Method(method)
+	, m_FrameDuration(frameDuration)
+	, m_Exposure(exposure)
+	, m_FrameStrength(frameStrength)
+	, m_Kernels(kernels)
+	, m_OutVideoStream(outVideoStream)
+	, m_Time(0.0)
+	, m_InputFrameDuration(frameRate ? 1.0 / frameRate : 0.0)
+{
+	if(m_OutVideoStream) m_OutVideoStream->AddRef();
+
+	switch (imageFormat.PixelFormat)
 	{
-		while (0 < bytesAvail)
-		{
-			DWORD dwBytesRead;
-			if (ReadFile(m_hChildStd_ERR_Rd, chBuf, min(bytesAvail, 250), &dwBytesRead, NULL))
-			{
-				chBuf[dwBytesRead] = 0;
-				Tier0_Warning("%s", chBuf);
-				bytesAvail -= dwBytesRead;
-			}
-			else
-			{
-				Tier0_Warning("AFXERROR: CAfxOutFFMPEGVideoStream::HandleOutAndErr: StdErr ReadFile.\n");
-				return false;
-			}
-		}
+	case CAfxImageFormat::PF_BGR:
+	case CAfxImageFormat::PF_BGRA:
+	case CAfxImageFormat::PF_A:
+	case CAfxImageFormat::PF_ZFloat:
+		break;
+	default:
+		Tier0_Warning("AFXERROR: CAfxOutSamplingStream::CAfxOutSamplingStream: Unspoported image format.");
+		return;
 	}
-	else
+
+	if (threads < 1) threads = (int)std::thread::hardware_concurrency();
+	if (threads > imageFormat.Height) threads = imageFormat.Height;
+	if (threads < 1) threads = 1;
+
+	for (int i = 0; i < threads; ++i)
+	{
+		int row = (int)((long long)imageFormat.Height * i / threads);
+		int nextRow = (int)((long long)imageFormat.Height * (i + 1) / threads);
+
+		m_Bands.push_back(new CBand(this, row, nextRow - row));
+	}
+
+	if (1 < threads) m_WorkerPool = new CAfxWorkerPool(threads - 1);
+}
+
+CAfxOutSamplingStream::~CAfxOutSamplingStream()
+{
+	delete m_WorkerPool;
+
+	for (auto it = m_Bands.begin(); it != m_Bands.end(); ++it)
+	{
+		delete *it;
+	}
+
+	for (auto it = m_Frames.begin(); it != m_Frames.end(); ++it)
 	{
-		Tier0_Warning("AFXERROR: CAfxOutFFMPEGVideoStream::HandleOutAndErr: StdErr PeekNamedPipe.\n");
+		free(*it);
+	}
+
+	if (m_OutVideoStream) m_OutVideoStream->Release();
+}
+
+bool CAfxOutSamplingStream::SupplyVideoData(const CAfxImageBuffer & buffer)
+{
+	if (nullptr == m_OutVideoStream) return false;
+
+	if (!(buffer.Format == m_ImageFormat))
+	{
+		Tier0_Warning("AFXERROR: CAfxOutSamplingStream::SupplyVideoData: Format mismatch.\n");
 		return false;
 	}
 
-	if (PeekNamedPipe(m_hChildStd_OUT_Rd, NULL, 0, NULL, &bytesAvail, NULL))
+	if (m_Bands.empty()) return false;
+
+	double time = m_Time;
+
+	if (m_WorkerPool)
 	{
-		while (0 < bytesAvail)
-		{
-			DWORD dwBytesRead;
-			if (ReadFile(m_hChildStd_OUT_Rd, chBuf, min(bytesAvail, 250), &dwBytesRead, NULL))
-			{
-				chBuf[dwBytesRead] = 0;
-				Tier0_Msg("%s", chBuf);
-				bytesAvail -= dwBytesRead;
-			}
-			else
-			{
-				Tier0_Warning("AFXERROR: CAfxOutFFMPEGVideoStream::HandleOutAndErr: StdOut ReadFile.\n");
-				return false;
-			}
-		}
+		m_WorkerPool->Run(m_Bands.size(), [this, &buffer, time](size_t index) {
+			m_Bands[index]->Sample(buffer, time);
+		});
 	}
 	else
 	{
-		Tier0_Warning("AFXERROR: CAfxOutFFMPEGVideoStream::HandleOutAndErr: StdOut PeekNamedPipe.\n");
-		return false;
+		m_Bands[0]->Sample(buffer, time);
+	}
+
+	m_Time += m_InputFrameDuration;
+
+	// All bands have printed the same number of frames, since they see the same times
+	// (with a single band it has supplied them already):
+
+	size_t printCount = m_Bands[0]->GetPrintCount();
+
+	for (auto it = m_Bands.begin(); it != m_Bands.end(); ++it)
+	{
+		(*it)->ResetPrintCount();
 	}
 
-	// Check if FFMPEG exited:
-	if (WAIT_TIMEOUT != WaitForSingleObject(m_ProcessInfo.hProcess, 0))
+	for (size_t i = 0; i < printCount; ++i)
 	{
-		return false;
+		SupplyFrame(m_Frames[i]);
 	}
 
 	return true;
 }
 
-// CAfxOutSamplingStream ///////////////////////////////////////////////////////
+void CAfxOutSamplingStream::SupplyFrame(void const * data)
+{
+	if (CAfxImageBuffer * buffer = g_AfxStreams.ImageBufferPool.AquireBuffer(m_ImageFormat.Bytes, false))
+	{
+		if (buffer->AutoRealloc(m_ImageFormat))
+		{
+			memcpy(buffer->Buffer, data, buffer->Format.Bytes);
+			m_OutVideoStream->SupplyVideoData(*buffer);
+		}
+		else
+			Tier0_Warning("AFXERROR: CAfxOutSamplingStream::SupplyFrame: AutoRealloc failed.\n");
+		buffer->Release();
+	}
+}
 
-CAfxOutSamplingStream::CAfxOutSamplingStream(const CAfxImageFormat & imageFormat, CAfxOutVideoStream * outVideoStream, float frameRate, EasySamplerSettings::Method method, double frameDuration, double exposure, float frameStrength)
-	: CAfxOutVideoStream(imageFormat)
-	, m_OutVideoStream(outVideoStream)
-	, m_Time(0.0)
-	, m_InputFrameDuration(frameRate ? 1.0 / frameRate : 0.0)
+unsigned char * CAfxOutSamplingStream::GetFrame(size_t printIndex)
 {
-	if(m_OutVideoStream) m_OutVideoStream->AddRef();
+	std::unique_lock<std::mutex> lock(m_FramesMutex);
+
+	while (m_Frames.size() <= printIndex)
+	{
+		m_Frames.push_back((unsigned char *)malloc(m_ImageFormat.Bytes));
+	}
+
+	return m_Frames[printIndex];
+}
 
-	unsigned int bytesPerPixel = 1;
+// CAfxOutSamplingStream::CBand ////////////////////////////////////////////////
+
+CAfxOutSamplingStream::CBand::CBand(CAfxOutSamplingStream * stream, int row, int rows)
+	: m_Stream(stream)
+	, m_Row(row)
+	, m_Rows(rows)
+{
+	const CAfxImageFormat & imageFormat = stream->m_ImageFormat;
+
+	int byteWidth = imageFormat.Width;
 
 	switch (imageFormat.PixelFormat)
 	{
 	case CAfxImageFormat::PF_BGR:
-		m_EasySampler.Byte = new EasyByteSampler(EasySamplerSettings(
-			imageFormat.Width * 3,
-			imageFormat.Height,
-			method,
-			frameDuration,
-			m_Time,
-			exposure,
-			frameStrength
-		), (int)imageFormat.Pitch, this);
+		byteWidth *= 3;
 		break;
 	case CAfxImageFormat::PF_BGRA:
-		m_EasySampler.Byte = new EasyByteSampler(EasySamplerSettings(
-			imageFormat.Width * 4,
-			imageFormat.Height,
-			method,
-			frameDuration,
-			m_Time,
-			exposure,
-			frameStrength
-		), (int)imageFormat.Pitch, this);
+		byteWidth *= 4;
 		break;
+	}
+
+	switch (imageFormat.PixelFormat)
+	{
+	case CAfxImageFormat::PF_BGR:
+	case CAfxImageFormat::PF_BGRA:
 	case CAfxImageFormat::PF_A:
 		m_EasySampler.Byte = new EasyByteSampler(EasySamplerSettings(
-			imageFormat.Width * 1,
-			imageFormat.Height,
-			method,
-			frameDuration,
-			m_Time,
-			exposure,
-			frameStrength
+			byteWidth,
+			rows,
+			stream->m_Method,
+			stream->m_FrameDuration,
+			stream->m_Time,
+			stream->m_Exposure,
+			stream->m_FrameStrength,
+			stream->m_Kernels
 		), (int)imageFormat.Pitch, this);
 		break;
 	case CAfxImageFormat::PF_ZFloat:
 		m_EasySampler.Float = new EasyFloatSampler(EasySamplerSettings(
 			imageFormat.Width,
-			imageFormat.Height,
-			method,
-			frameDuration,
-			m_Time,
-			exposure,
-			frameStrength
+			rows,
+			stream->m_Method,
+			stream->m_FrameDuration,
+			stream->m_Time,
+			stream->m_Exposure,
+			stream->m_FrameStrength,
+			stream->m_Kernels
 		), this);
 		break;
-	default:
-		Tier0_Warning("AFXERROR: CAfxOutSamplingStream::CAfxOutSamplingStream: Unspoported image format.");
 	}
 }
 
-CAfxOutSamplingStream::~CAfxOutSamplingStream()
+CAfxOutSamplingStream::CBand::~CBand()
 {
-	switch (m_ImageFormat.PixelFormat)
+	switch (m_Stream->m_ImageFormat.PixelFormat)
 	{
 	case CAfxImageFormat::PF_BGR:
 	case CAfxImageFormat::PF_BGRA:
@@ -585,54 +693,50 @@ CAfxOutSamplingStream::~CAfxOutSamplingStream()
 	case CAfxImageFormat::PF_ZFloat:
 		delete m_EasySampler.Float;
 	};
-
-	if (m_OutVideoStream) m_OutVideoStream->Release();
 }
 
-bool CAfxOutSamplingStream::SupplyVideoData(const CAfxImageBuffer & buffer)
+void CAfxOutSamplingStream::CBand::Sample(const CAfxImageBuffer & buffer, double time)
 {
-	if (nullptr == m_OutVideoStream) return false;
-
-	if (!(buffer.Format == m_ImageFormat))
-	{
-		Tier0_Warning("AFXERROR: CAfxOutSamplingStream::SupplyVideoData: Format mismatch.\n");
-		return false;
-	}
+	unsigned char const * data = (unsigned char const *)buffer.Buffer + m_Row * buffer.Format.Pitch;
 
-	switch (m_ImageFormat.PixelFormat)
+	switch (buffer.Format.PixelFormat)
 	{
 	case CAfxImageFormat::PF_BGR:
 	case CAfxImageFormat::PF_BGRA:
 	case CAfxImageFormat::PF_A:
-		m_EasySampler.Byte->Sample((const unsigned char*)buffer.Buffer, m_Time);
+		m_EasySampler.Byte->Sample(data, time);
 		break;
 	case CAfxImageFormat::PF_ZFloat:
-		m_EasySampler.Float->Sample((const float*)buffer.Buffer, m_Time);
+		m_EasySampler.Float->Sample((const float *)data, time);
 	};
-
-	m_Time += m_InputFrameDuration;
-
-	return true;
 }
 
-void CAfxOutSamplingStream::Print(unsigned char const * data)
+void CAfxOutSamplingStream::CBand::Print(unsigned char const * data)
 {
-	if (CAfxImageBuffer * buffer = g_AfxStreams.ImageBufferPool.AquireBuffer())
+	if (nullptr == m_Stream->m_WorkerPool)
 	{
-		buffer->AutoRealloc(m_ImageFormat);
-		memcpy(buffer->Buffer, data, buffer->Format.Bytes);
-		m_OutVideoStream->SupplyVideoData(*buffer);
-		buffer->Release();
+		m_Stream->SupplyFrame(data);
+		return;
 	}
+
+	size_t pitch = m_Stream->m_ImageFormat.Pitch;
+
+	memcpy(m_Stream->GetFrame(m_PrintCount) + m_Row * pitch, data, m_Rows * pitch);
+
+	++m_PrintCount;
 }
 
-void CAfxOutSamplingStream::Print(float const * data)
+void CAfxOutSamplingStream::CBand::Print(float const * data)
 {
-	if (CAfxImageBuffer * buffer = g_AfxStreams.ImageBufferPool.AquireBuffer())
+	if (nullptr == m_Stream->m_WorkerPool)
 	{
-		buffer->AutoRealloc(m_ImageFormat);
-		memcpy(buffer->Buffer, data, buffer->Format.Bytes);
-		m_OutVideoStream->SupplyVideoData(*buffer);
-		buffer->Release();
+		m_Stream->SupplyFrame(data);
+		return;
 	}
+
+	size_t pitch = m_Stream->m_ImageFormat.Pitch;
+
+	memcpy(m_Stream->GetFrame(m_PrintCount) + m_Row * pitch, data, m_Rows * pitch);
+
+	++m_PrintCount;
 }
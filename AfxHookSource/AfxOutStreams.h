@@ -2,11 +2,17 @@
 
 #include "AfxThreadedRefCounted.h"
 #include "AfxImageBuffer.h"
+#include "AfxWorkerPool.h"
+#include "AfxCapturePipeline.h"
 #include <shared/EasySampler.h>
+#include <shared/AfxPipeWriter.h>
 #include <string>
 #include <Windows.h>
 
 #include <list>
+#include <vector>
+#include <atomic>
+#include <thread>
 
 class CAfxOutStream : public CAfxThreadedRefCounted
 {
@@ -70,7 +76,29 @@ protected:
 
 	}
 
-	const CAfxImageFormat & m_ImageFormat;
+	const CAfxImageFormat m_ImageFormat;
+};
+
+/// <summary>
+/// Supplies the video data to outVideoStream on a worker of stage, in the order supplied.
+/// The buffer is referenced until outVideoStream is done with it.
+/// </summary>
+class CAfxOutStageVideoStream : public CAfxOutVideoStream
+{
+public:
+	CAfxOutStageVideoStream(const CAfxImageFormat & imageFormat, CAfxCaptureStage & stage, CAfxOutVideoStream * outVideoStream);
+
+	/// <returns>false if outVideoStream failed on a frame supplied earlier.</returns>
+	virtual bool SupplyVideoData(const CAfxImageBuffer & buffer) override;
+
+protected:
+	virtual ~CAfxOutStageVideoStream() override;
+
+private:
+	CAfxCaptureStage & m_Stage;
+	CAfxCaptureStage::CQueue * m_Queue;
+	CAfxOutVideoStream * m_OutVideoStream;
+	std::atomic_bool m_Failed;
 };
 
 class CAfxOutImageStream : public CAfxOutVideoStream
@@ -100,6 +128,13 @@ private:
 	bool CreateCapturePath(const char * fileExtension, std::wstring &outPath);
 };
 
+/// <summary>
+/// Pipes raw frames into an ffmpeg process.
+/// Frames are written from a dedicated thread (without copying them, the
+/// buffers are referenced until written) and ffmpeg's stdout / stderr are
+/// drained by threads of their own, so the caller only blocks when ffmpeg
+/// falls behind by more than the ring of queued frames.
+/// </summary>
 class CAfxOutFFMPEGVideoStream : public CAfxOutVideoStream
 {
 public:
@@ -122,10 +157,16 @@ private:
 	HANDLE m_hChildStd_ERR_Rd = NULL;
 	HANDLE m_hChildStd_ERR_Wr = NULL;
 	OVERLAPPED m_OverlappedWrite = {};
+	CAfxPipeWriter * m_PipeWriter = nullptr;
+	std::thread m_StdOutThread;
+	std::thread m_StdErrThread;
 
 	void Close();
 
-	bool HandleOutAndErr();
+	/// <remarks>Called from the writer thread.</remarks>
+	bool WritePipe(void const * data, size_t bytes);
+
+	static void ReadPipeThread(HANDLE hPipe, bool isStdErr);
 };
 
 
@@ -133,30 +174,77 @@ private:
 // - optimize shutter to allow skipping (capturing of) frames.
 // - think about error propagation, though not entirely applicable.
 // - RGBA smapling might not be accurate, since it doesn't take alpha into account?
+//
+// With more than one thread the image is split into bands of rows that are
+// sampled by one sampler each. Since the samplers work per pixel and all see
+// the same times, the result is identical to sampling with one thread.
 class CAfxOutSamplingStream : public CAfxOutVideoStream
-	, public IFramePrinter
-	, public IFloatFramePrinter
 {
 public:
-	CAfxOutSamplingStream(const CAfxImageFormat & imageFormat, CAfxOutVideoStream * outVideoStream, float frameRate, EasySamplerSettings::Method method, double frameDuration, double exposure, float frameStrength);
+	/// <param name="threads">Number of threads to sample with, 0 means number of logical processors.</param>
+	/// <param name="kernels">Inner loops to sample with, see EasySamplerKernels.</param>
+	CAfxOutSamplingStream(const CAfxImageFormat & imageFormat, CAfxOutVideoStream * outVideoStream, float frameRate, EasySamplerSettings::Method method, double frameDuration, double exposure, float frameStrength, int threads = 1, EasySamplerKernels::Kind kernels = EasySamplerKernels::EK_Auto);
 
 	virtual bool SupplyVideoData(const CAfxImageBuffer & buffer) override;
 
-	virtual void Print(unsigned char const * data) override;
-	virtual void Print(float const * data) override;
-
 protected:
 	virtual ~CAfxOutSamplingStream() override;
 
 private:
-	union {
-		EasyByteSampler * Byte;
-		EasyFloatSampler * Float;
-	} m_EasySampler;
+	class CBand : public IFramePrinter
+		, public IFloatFramePrinter
+	{
+	public:
+		CBand(CAfxOutSamplingStream * stream, int row, int rows);
+		~CBand();
+
+		void Sample(const CAfxImageBuffer & buffer, double time);
+
+		size_t GetPrintCount() const
+		{
+			return m_PrintCount;
+		}
+
+		void ResetPrintCount()
+		{
+			m_PrintCount = 0;
+		}
+
+		virtual void Print(unsigned char const * data) override;
+		virtual void Print(float const * data) override;
+
+	private:
+		CAfxOutSamplingStream * m_Stream;
+		int m_Row;
+		int m_Rows;
+		union {
+			EasyByteSampler * Byte;
+			EasyFloatSampler * Float;
+		} m_EasySampler;
+		size_t m_PrintCount = 0;
+	};
+
+	std::vector<CBand *> m_Bands;
+	CAfxWorkerPool * m_WorkerPool = nullptr;
+
+	std::mutex m_FramesMutex;
+	std::vector<unsigned char *> m_Frames;
+
+	EasySamplerSettings::Method m_Method;
+	double m_FrameDuration;
+	double m_Exposure;
+	float m_FrameStrength;
+	EasySamplerKernels::Kind m_Kernels;
+
 	CAfxOutVideoStream * m_OutVideoStream;
 	double m_Time;
 
 	double m_InputFrameDuration;
+
+	/// <summary>Returns memory for the output frame with index printIndex (of the current SupplyVideoData call).</summary>
+	unsigned char * GetFrame(size_t printIndex);
+
+	void SupplyFrame(void const * data);
 };
 
 class CAfxOutMultiVideoStream : public CAfxOutVideoStream
@@ -198,4 +286,4 @@ protected:
 
 private:
 	std::list<CAfxOutVideoStream *> m_OutStreams;
-};
\ No newline at end of file
+};
\ No newline at end of file
@@ -26,6 +26,7 @@
 
 #include <shared/StringTools.h>
 #include <shared/FileTools.h>
+#include <shared/AfxImageKernels.h>
 
 #include <Windows.h>
 
@@ -627,7 +628,14 @@ void CAfxRenderViewStream::Capture(CAfxRecordStream * captureTarget, size_t stre
 
 	bool isDepthF = m_StreamCaptureType == CAfxRenderViewStream::SCT_DepthF || m_StreamCaptureType == CAfxRenderViewStream::SCT_DepthFZIP;
 
-	CAfxImageBuffer * buffer = g_AfxStreams.ImageBufferPool.AquireBuffer();
+	// Room for the biggest format (BGRA / ZFloat), so a buffer from the pool never needs to grow:
+	CAfxImageBuffer * buffer = g_AfxStreams.ImageBufferPool.AquireBuffer((size_t)4 * width * height, true);
+
+	if(nullptr == buffer)
+	{
+		Tier0_Warning("CAfxRenderViewStream::Capture: Failed to aquire buffer.\n");
+		return;
+	}
 
 	if(isDepthF)
 	{
@@ -642,7 +650,7 @@ void CAfxRenderViewStream::Capture(CAfxRecordStream * captureTarget, size_t stre
 				SOURCESDK::IMAGE_FORMAT_R32F
 			);
 
-			// Post process buffer:
+			// Post process buffer (on the convert stage):
 
 			float depthScale = 1.0f;
 			float depthOfs = 0.0f;
@@ -653,21 +661,9 @@ void CAfxRenderViewStream::Capture(CAfxRecordStream * captureTarget, size_t stre
 				depthOfs = baseFx->DepthVal_get();
 			}
 
-			for(int y=0; y < height; ++y)
-			{
-				for(int x=0; x < width; ++x)
-				{
-					float depth = *(float *)((unsigned char *)pBuffer +y*imagePitch +x*sizeof(float));
-
-					depth *= depthScale;
-					depth += depthOfs;
-
-					*(float *)((unsigned char *)pBuffer +y*imagePitch +x*sizeof(float))
-						= depth;
-				}
-			}
-
-			captureTarget->OnImageBufferCaptured(streamIndex, buffer);
+			captureTarget->OnImageBufferCaptured(streamIndex, buffer, [buffer, height, imagePitch, depthScale, depthOfs]() {
+				AfxImageKernels::Get(AfxImageKernels::EK_Auto)->DepthAffine((float *)buffer->Buffer, depthScale, depthOfs, (size_t)height * imagePitch / sizeof(float));
+			});
 		}
 		else
 		{
@@ -700,33 +696,14 @@ void CAfxRenderViewStream::Capture(CAfxRecordStream * captureTarget, size_t stre
 
 			int oldImagePitch =  imagePitch;
 
-			// make the 24bit RGB into a float buffer:
+			// make the 24bit RGB into a float buffer (converted on the convert stage):
 			if(buffer->AutoRealloc(CAfxImageFormat(CAfxImageFormat::PF_ZFloat, width, height)))
 			{
-				unsigned char * pBuffer = (unsigned char*)buffer->Buffer;
 				int imagePitch = buffer->Format.Pitch;
 
-				for(int y = height-1; y >= 0; --y)
-				{
-					for(int x = width-1; x >= 0; --x)
-					{
-						unsigned char r = ((unsigned char *)pBuffer)[y*oldImagePitch +3*x +0];
-						unsigned char g = ((unsigned char *)pBuffer)[y*oldImagePitch +3*x +1];
-						unsigned char b = ((unsigned char *)pBuffer)[y*oldImagePitch +3*x +2];
-
-						float depth;
-
-						depth = (1.0f/16777215.0f)*r +(256.0f/16777215.0f)*g +(65536.0f/16777215.0f)*b;
-
-						depth *= depthScale;
-						depth += depthOfs;
-
-						*(float *)((unsigned char *)pBuffer +y*imagePitch +x*sizeof(float))
-							= depth;
-					}
-				}
-
-				captureTarget->OnImageBufferCaptured(streamIndex, buffer);
+				captureTarget->OnImageBufferCaptured(streamIndex, buffer, [buffer, width, height, oldImagePitch, imagePitch, depthScale, depthOfs]() {
+					AfxImageKernels::Get(AfxImageKernels::EK_Auto)->Depth24ToFloat((unsigned char *)buffer->Buffer, width, height, oldImagePitch, imagePitch, depthScale, depthOfs);
+				});
 			}
 			else
 			{
@@ -736,33 +713,11 @@ void CAfxRenderViewStream::Capture(CAfxRecordStream * captureTarget, size_t stre
 		}
 		else
 		{
-			// (back) transform to MDT native format:
+			// (back) transform to MDT native format (on the convert stage):
 
-			int lastLine = height >> 1;
-			if(height & 0x1) ++lastLine;
-
-			for(int y=0;y<lastLine;++y)
-			{
-				int srcLine = y;
-				int dstLine = height -1 -y;
-
-				for(int x=0;x<width;++x)
-				{
-					unsigned char r = ((unsigned char *)pBuffer)[dstLine*imagePitch +3*x +0];
-					unsigned char g = ((unsigned char *)pBuffer)[dstLine*imagePitch +3*x +1];
-					unsigned char b = ((unsigned char *)pBuffer)[dstLine*imagePitch +3*x +2];
-									
-					((unsigned char *)pBuffer)[dstLine*imagePitch +3*x +0] = ((unsigned char *)pBuffer)[srcLine*imagePitch +3*x +2];
-					((unsigned char *)pBuffer)[dstLine*imagePitch +3*x +1] = ((unsigned char *)pBuffer)[srcLine*imagePitch +3*x +1];
-					((unsigned char *)pBuffer)[dstLine*imagePitch +3*x +2] = ((unsigned char *)pBuffer)[srcLine*imagePitch +3*x +0];
-									
-					((unsigned char *)pBuffer)[srcLine*imagePitch +3*x +0] = b;
-					((unsigned char *)pBuffer)[srcLine*imagePitch +3*x +1] = g;
-					((unsigned char *)pBuffer)[srcLine*imagePitch +3*x +2] = r;
-				}
-			}
-
-			captureTarget->OnImageBufferCaptured(streamIndex, buffer);
+			captureTarget->OnImageBufferCaptured(streamIndex, buffer, [buffer, width, height, imagePitch]() {
+				AfxImageKernels::Get(AfxImageKernels::EK_Auto)->FlipSwap24((unsigned char *)buffer->Buffer, width, height, imagePitch);
+			});
 		}
 	}
 	else
@@ -821,6 +776,27 @@ CAfxRecordStream::CAfxRecordStream(char const * streamName, std::vector<CAfxRend
 	}
 
 	m_Buffers.resize(m_Streams.size());
+	m_Conversions.resize(m_Streams.size());
+}
+
+CAfxRecordStream::~CAfxRecordStream()
+{
+	for (size_t i = 0; i < m_Streams.size(); ++i)
+	{
+		if (CAfxImageBuffer * buffer = m_Buffers[i])
+		{
+			buffer->Release();
+		}
+	}
+
+	for (size_t i = 0; i < m_Streams.size(); ++i)
+	{
+		m_Streams[i]->Release();
+	}
+
+	m_Settings->Release();
+
+	if (m_ConvertQueue) g_AfxStreams.CapturePipeline.Convert.DeleteQueue(m_ConvertQueue);
 }
 
 bool CAfxRecordStream::Record_get(void)
@@ -864,9 +840,56 @@ void CAfxRecordStream::QueueCaptureEnd(IAfxMatRenderContextOrg * ctx)
 	QueueOrExecute(ctx, new CAfxLeafExecute_Functor(new CCaptureEndFunctor(*this)));
 }
 
-void CAfxRecordStream::OnImageBufferCaptured(size_t index, CAfxImageBuffer * buffer)
+void CAfxRecordStream::OnImageBufferCaptured(size_t index, CAfxImageBuffer * buffer, std::function<void(void)> && convert)
 {
 	m_Buffers[index] = buffer;
+	m_Conversions[index] = std::move(convert);
+}
+
+void CAfxRecordStream::QueueSupply(CAfxImageBuffer * buffer, std::function<void(void)> && combine)
+{
+	if (nullptr == m_OutVideoStream)
+		return;
+
+	if (nullptr == m_ConvertQueue)
+		m_ConvertQueue = g_AfxStreams.CapturePipeline.Convert.CreateQueue();
+
+	// The job takes over the buffers (and doesn't touch this stream, which might be gone by then):
+
+	std::vector<CAfxImageBuffer *> buffers(m_Buffers);
+	std::vector<std::function<void(void)>> conversions(m_Conversions.size());
+
+	for (size_t i = 0; i < m_Buffers.size(); ++i)
+	{
+		m_Buffers[i] = nullptr;
+		conversions[i].swap(m_Conversions[i]);
+	}
+
+	CAfxOutVideoStream * outVideoStream = m_OutVideoStream;
+	outVideoStream->AddRef();
+
+	std::string streamName(m_StreamName);
+
+	g_AfxStreams.CapturePipeline.Convert.Queue(m_ConvertQueue, [buffer, outVideoStream, streamName, buffers = std::move(buffers), conversions = std::move(conversions), combine = std::move(combine)]() {
+		for (auto it = conversions.begin(); it != conversions.end(); ++it)
+		{
+			if (*it) (*it)();
+		}
+
+		if (combine) combine();
+
+		if (!outVideoStream->SupplyVideoData(*buffer))
+		{
+			Tier0_Warning("AFXERROR: Failed writing image for stream %s.\n", streamName.c_str());
+		}
+
+		for (auto it = buffers.begin(); it != buffers.end(); ++it)
+		{
+			if (CAfxImageBuffer * curBuffer = *it) curBuffer->Release();
+		}
+
+		outVideoStream->Release();
+	});
 }
 
 bool CAfxRecordStream::Console_Edit_Head(IWrpCommandArgs * args)
@@ -964,10 +987,7 @@ void CAfxSingleStream::CaptureEnd()
 			}
 		}
 
-		if (nullptr != m_OutVideoStream && !m_OutVideoStream->SupplyVideoData(*buffer))
-		{
-			Tier0_Warning("AFXERROR: Failed writing image for stream %s.\n", this->StreamName_get());
-		}
+		QueueSupply(buffer);
 	}
 
 	CAfxRecordStream::CaptureEnd();
@@ -1091,31 +1111,6 @@ void CAfxTwinStream::CaptureEnd()
 
 				if (canCombine)
 				{
-					// interleave B as alpha into A:
-
-					int height = bufferA->Format.Height;
-					int width = bufferA->Format.Width;
-					int newImagePitchA = bufferA->Format.Pitch;
-
-					unsigned char * pBufferA = (unsigned char *)(bufferA->Buffer);
-					unsigned char * pBufferB = (unsigned char *)(bufferB->Buffer);
-
-					for (int y = height - 1; y >= 0; --y)
-					{
-						for (int x = width - 1; x >= 0; --x)
-						{
-							unsigned char b = ((unsigned char *)pBufferA)[y*orgImagePitch + x * 3 + 0];
-							unsigned char g = ((unsigned char *)pBufferA)[y*orgImagePitch + x * 3 + 1];
-							unsigned char r = ((unsigned char *)pBufferA)[y*orgImagePitch + x * 3 + 2];
-							unsigned char a = ((unsigned char *)pBufferB)[y*orgImagePitch + x * 3 + 0];
-
-							((unsigned char *)pBufferA)[y*newImagePitchA + x * 4 + 0] = b;
-							((unsigned char *)pBufferA)[y*newImagePitchA + x * 4 + 1] = g;
-							((unsigned char *)pBufferA)[y*newImagePitchA + x * 4 + 2] = r;
-							((unsigned char *)pBufferA)[y*newImagePitchA + x * 4 + 3] = a;
-						}
-					}
-
 					if (nullptr == m_OutVideoStream)
 					{
 						m_OutVideoStream = m_Settings->CreateOutVideoStream(g_AfxStreams, *this, bufferA->Format, g_AfxStreams.GetStartHostFrameRate(), "");
@@ -1129,10 +1124,13 @@ void CAfxTwinStream::CaptureEnd()
 						}
 					}
 
-					if(nullptr != m_OutVideoStream && !m_OutVideoStream->SupplyVideoData(*bufferA))
-					{
-						Tier0_Warning("AFXERROR: Failed writing image for stream %s\n.", this->StreamName_get());
-					}
+					QueueSupply(bufferA, [bufferA, bufferB, orgImagePitch]() {
+						// interleave B as alpha into A:
+
+						AfxImageKernels::Get(AfxImageKernels::EK_Auto)->BgrMergeBlueToBgra(
+							(unsigned char *)bufferA->Buffer, bufferA->Format.Width, bufferA->Format.Height, orgImagePitch, bufferA->Format.Pitch,
+							(unsigned char const *)bufferB->Buffer, orgImagePitch);
+					});
 				}
 			}
 			break;
@@ -1151,76 +1149,73 @@ void CAfxTwinStream::CaptureEnd()
 
 				if (canCombine)
 				{
-					int height = bufferA->Format.Height;
-					int width = bufferA->Format.Width;
-					int newImagePitchA = bufferA->Format.Pitch;
-
-					unsigned char * pBufferA = (unsigned char *)(bufferA->Buffer);
-					unsigned char * pBufferB = (unsigned char *)(bufferB->Buffer);
-
-					for (int y = height - 1; y >= 0; --y)
-					{
-						for (int x = width - 1; x >= 0; --x)
-						{
-							// game = (1 - a/255) * gameBg + a/255 * hud
-							// hudBlack = a/255 * hud
-							// hudWhite = min(255, 255 - a + a/255 * hud)
-							//
-							// hudWhite - hudBlack 
-							// = min(255, 255 - a + a/255 * hud) - a/255 * hud
-							// = min(255 - a/255 * hud, 255 -a)
-							// = min(255 - hudBlack, 255 -a)
-							// 
-							// hudBlack - hudWhite
-							// = max(hudBlack -255, a -255)
-							//
-							// 255 + hudBlack - hudWhite
-							// = max(hudBlack, a)
-							// = max(a/255 * hud, a)
-							// 
-							// a/255 * hud >= a
-							// hud >= 255
-
-							unsigned char white[3] = {
-								((unsigned char *)pBufferA)[y*orgImagePitch + x * 3 + 0],
-								((unsigned char *)pBufferA)[y*orgImagePitch + x * 3 + 1],
-								((unsigned char *)pBufferA)[y*orgImagePitch + x * 3 + 2]
-							};
-							unsigned char black[3] = {
-								((unsigned char *)pBufferB)[y*orgImagePitch + x * 3 + 0],
-								((unsigned char *)pBufferB)[y*orgImagePitch + x * 3 + 1],
-								((unsigned char *)pBufferB)[y*orgImagePitch + x * 3 + 2]
-							};
-
-							signed short whiteMinusBlack[3] = {
-								white[0] - black[0],
-								white[1] - black[1],
-								white[2] - black[2]
-							};
-
-							float hudB =  0.0f;
-							float hudG =  0.0f;
-							float hudR =  0.0f;
-
-							float alpha  = 0.5;
-
-							((unsigned char *)pBufferA)[y*newImagePitchA + x * 4 + 0] = (unsigned char)hudB;
-							((unsigned char *)pBufferA)[y*newImagePitchA + x * 4 + 1] = (unsigned char)hudG;
-							((unsigned char *)pBufferA)[y*newImagePitchA + x * 4 + 2] = (unsigned char)hudR;
-							((unsigned char *)pBufferA)[y*newImagePitchA + x * 4 + 3] = (unsigned char)(alpha);
-						}
-					}
-
 					if (nullptr == m_OutVideoStream)
 					{
 						m_OutVideoStream = m_Settings->CreateOutVideoStream(g_AfxStreams, *this, bufferA->Format, g_AfxStreams.GetStartHostFrameRate(), "");
 						m_OutVideoStream->AddRef();
 					}
 
-					if (!m_OutVideoStream->SupplyVideoData(*bufferA))
-					{
-						Tier0_Warning("AFXERROR: Failed writing image for stream %s\n.", this->StreamName_get());
-					}
+					QueueSupply(bufferA, [bufferA, bufferB, orgImagePitch]() {
+						int height = bufferA->Format.Height;
+						int width = bufferA->Format.Width;
+						int newImagePitchA = bufferA->Format.Pitch;
+
+						unsigned char * pBufferA = (unsigned char *)(bufferA->Buffer);
+						unsigned char * pBufferB = (unsigned char *)(bufferB->Buffer);
+
+						for (int y = height - 1; y >= 0; --y)
+						{
+							for (int x = width - 1; x >= 0; --x)
+							{
+								// game = (1 - a/255) * gameBg + a/255 * hud
+								// hudBlack = a/255 * hud
+								// hudWhite = min(255, 255 - a + a/255 * hud)
+								//
+								// hudWhite - hudBlack 
+								// = min(255, 255 - a + a/255 * hud) - a/255 * hud
+								// = min(255 - a/255 * hud, 255 -a)
+								// = min(255 - hudBlack, 255 -a)
+								// 
+								// hudBlack - hudWhite
+								// = max(hudBlack -255, a -255)
+								//
+								// 255 + hudBlack - hudWhite
+								// = max(hudBlack, a)
+								// = max(a/255 * hud, a)
+								// 
+								// a/255 * hud >= a
+								// hud >= 255
+
+								unsigned char white[3] = {
+									((unsigned char *)pBufferA)[y*orgImagePitch + x * 3 + 0],
+									((unsigned char *)pBufferA)[y*orgImagePitch + x * 3 + 1],
+									((unsigned char *)pBufferA)[y*orgImagePitch + x * 3 + 2]
+								};
+								unsigned char black[3] = {
+									((unsigned char *)pBufferB)[y*orgImagePitch + x * 3 + 0],
+									((unsigned char *)pBufferB)[y*orgImagePitch + x * 3 + 1],
+									((unsigned char *)pBufferB)[y*orgImagePitch + x * 3 + 2]
+								};
+
+								signed short whiteMinusBlack[3] = {
+									white[0] - black[0],
+									white[1] - black[1],
+									white[2] - black[2]
+								};
+
+								float hudB =  0.0f;
+								float hudG =  0.0f;
+								float hudR =  0.0f;
+
+								float alpha  = 0.5;
+
+								((unsigned char *)pBufferA)[y*newImagePitchA + x * 4 + 0] = (unsigned char)hudB;
+								((unsigned char *)pBufferA)[y*newImagePitchA + x * 4 + 1] = (unsigned char)hudG;
+								((unsigned char *)pBufferA)[y*newImagePitchA + x * 4 + 2] = (unsigned char)hudR;
+								((unsigned char *)pBufferA)[y*newImagePitchA + x * 4 + 3] = (unsigned char)(alpha);
+							}
+						}
+					});
 				}
 			}
 			break;
@@ -1478,36 +1473,6 @@ void CAfxMatteStream::CaptureEnd()
 
 	if (canCombine)
 	{
-		int height = bufferEntBlack->Format.Height;
-		int width = bufferEntBlack->Format.Width;
-		int newImagePitchA = bufferEntBlack->Format.Pitch;
-
-		unsigned char * pBufferEntBlack = (unsigned char *)(bufferEntBlack->Buffer);
-		unsigned char * pBufferEntWhite = (unsigned char *)(bufferEntWhite->Buffer);
-
-		for (int y = height - 1; y >= 0; --y)
-		{
-			for (int x = width - 1; x >= 0; --x)
-			{
-				unsigned char entBlack_b = ((unsigned char *)pBufferEntBlack)[y*orgImagePitch + x * 3 + 0];
-				unsigned char entBlack_g = ((unsigned char *)pBufferEntBlack)[y*orgImagePitch + x * 3 + 1];
-				unsigned char entBlack_r = ((unsigned char *)pBufferEntBlack)[y*orgImagePitch + x * 3 + 2];
-
-				unsigned char entWhite_b = ((unsigned char *)pBufferEntWhite)[y*orgImagePitch + x * 3 + 0];
-				unsigned char entWhite_g = ((unsigned char *)pBufferEntWhite)[y*orgImagePitch + x * 3 + 1];
-				unsigned char entWhite_r = ((unsigned char *)pBufferEntWhite)[y*orgImagePitch + x * 3 + 2];
-
-				//((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 0] = y < 1 * height / 3 ? entBlack_b : (y < 2 * height / 3 ? entWhite_b : (unsigned char)(((int)entBlack_b + (int)entWhite_b)/2));
-				//((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 1] = y < 1 * height / 3 ? entBlack_g : (y < 2 * height / 3 ? entWhite_g : (unsigned char)(((int)entBlack_g + (int)entWhite_g)/2));
-				//((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 2] = y < 1 * height / 3 ? entBlack_r : (y < 2 * height / 3 ? entWhite_r : (unsigned char)(((int)entBlack_r + (int)entWhite_r)/2));
-				//((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 3] = y < 1 * height / 3 ? 255 : (y < 2 * height / 3 ? 255 : (unsigned char)min(max((255l - (int)entWhite_b + (int)entBlack_b + 255l - (int)entWhite_g + (int)entBlack_g + 255l - (int)entWhite_r + (int)entBlack_r) / 3l, 0), 255));
-				((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 0] = (unsigned char)(((int)entBlack_b + (int)entWhite_b)/2);
-				((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 1] = (unsigned char)(((int)entBlack_g + (int)entWhite_g)/2);
-				((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 2] = (unsigned char)(((int)entBlack_r + (int)entWhite_r)/2);
-				((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 3] = (unsigned char)min(max((255l - (int)entWhite_b + (int)entBlack_b + 255l - (int)entWhite_g + (int)entBlack_g + 255l - (int)entWhite_r + (int)entBlack_r) / 3l, 0), 255);
-			}
-		}
-
 		if (nullptr == m_OutVideoStream)
 		{
 			m_OutVideoStream = m_Settings->CreateOutVideoStream(g_AfxStreams, *this, bufferEntBlack->Format, g_AfxStreams.GetStartHostFrameRate(), "");
@@ -1521,10 +1486,37 @@ void CAfxMatteStream::CaptureEnd()
 			}
 		}
 
-		if (nullptr != m_OutVideoStream && !m_OutVideoStream->SupplyVideoData(*bufferEntBlack))
-		{
-			Tier0_Warning("AFXERROR: Failed writing image for stream %s\n.", this->StreamName_get());
-		}
+		QueueSupply(bufferEntBlack, [bufferEntBlack, bufferEntWhite, orgImagePitch]() {
+			int height = bufferEntBlack->Format.Height;
+			int width = bufferEntBlack->Format.Width;
+			int newImagePitchA = bufferEntBlack->Format.Pitch;
+
+			unsigned char * pBufferEntBlack = (unsigned char *)(bufferEntBlack->Buffer);
+			unsigned char * pBufferEntWhite = (unsigned char *)(bufferEntWhite->Buffer);
+
+			for (int y = height - 1; y >= 0; --y)
+			{
+				for (int x = width - 1; x >= 0; --x)
+				{
+					unsigned char entBlack_b = ((unsigned char *)pBufferEntBlack)[y*orgImagePitch + x * 3 + 0];
+					unsigned char entBlack_g = ((unsigned char *)pBufferEntBlack)[y*orgImagePitch + x * 3 + 1];
+					unsigned char entBlack_r = ((unsigned char *)pBufferEntBlack)[y*orgImagePitch + x * 3 + 2];
+
+					unsigned char entWhite_b = ((unsigned char *)pBufferEntWhite)[y*orgImagePitch + x * 3 + 0];
+					unsigned char entWhite_g = ((unsigned char *)pBufferEntWhite)[y*orgImagePitch + x * 3 + 1];
+					unsigned char entWhite_r = ((unsigned char *)pBufferEntWhite)[y*orgImagePitch + x * 3 + 2];
+
+					//((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 0] = y < 1 * height / 3 ? entBlack_b : (y < 2 * height / 3 ? entWhite_b : (unsigned char)(((int)entBlack_b + (int)entWhite_b)/2));
+					//((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 1] = y < 1 * height / 3 ? entBlack_g : (y < 2 * height / 3 ? entWhite_g : (unsigned char)(((int)entBlack_g + (int)entWhite_g)/2));
+					//((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 2] = y < 1 * height / 3 ? entBlack_r : (y < 2 * height / 3 ? entWhite_r : (unsigned char)(((int)entBlack_r + (int)entWhite_r)/2));
+					//((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 3] = y < 1 * height / 3 ? 255 : (y < 2 * height / 3 ? 255 : (unsigned char)min(max((255l - (int)entWhite_b + (int)entBlack_b + 255l - (int)entWhite_g + (int)entBlack_g + 255l - (int)entWhite_r + (int)entBlack_r) / 3l, 0), 255));
+					((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 0] = (unsigned char)(((int)entBlack_b + (int)entWhite_b)/2);
+					((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 1] = (unsigned char)(((int)entBlack_g + (int)entWhite_g)/2);
+					((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 2] = (unsigned char)(((int)entBlack_r + (int)entWhite_r)/2);
+					((unsigned char *)pBufferEntBlack)[y*newImagePitchA + x * 4 + 3] = (unsigned char)min(max((255l - (int)entWhite_b + (int)entBlack_b + 255l - (int)entWhite_g + (int)entBlack_g + 255l - (int)entWhite_r + (int)entBlack_r) / 3l, 0), 255);
+				}
+			}
+		});
 	}
 	else
 	{
@@ -1568,7 +1560,14 @@ CAfxBaseFxStream::CAfxBaseFxStream()
 , m_OtherEngineAction(0)
 , m_OtherSpecialAction(0)
 , m_VguiAction(0)
+, m_MapGeneration(0)
+, m_MapReaders(0)
+, m_ActionFilterIndexGeneration(0)
+, m_ActionFilterIndexValid(false)
 {
+	for (unsigned int i = 0; i < m_CacheChunkCount; ++i)
+		m_CacheChunks[i].store(nullptr, std::memory_order_relaxed);
+
 	m_MapRleaseNotification = new CMapRleaseNotification(this);
 	m_PickerMaterialsRleaseNotification = new CPickerMaterialsRleaseNotification(this);
 
@@ -1603,7 +1602,7 @@ CAfxBaseFxStream::CAfxBaseFxStream()
 
 CAfxBaseFxStream::~CAfxBaseFxStream()
 {
-	InvalidateMap();
+	ClearMap();
 
 	SetAction(m_ClientEffectTexturesAction, 0);
 	SetAction(m_WorldTexturesAction, 0);
@@ -1647,8 +1646,8 @@ void CAfxBaseFxStream::AfxStreamsShutdown(void)
 
 void CAfxBaseFxStream::Console_ActionFilter_Add(const char * expression, CAction * action)
 {
-	InvalidateMap();
 	m_ActionFilter.push_back(CActionFilterValue(expression,action));
+	InvalidateMap();
 }
 
 void CAfxBaseFxStream::Console_ActionFilter_AddEx(CAfxStreams * streams, IWrpCommandArgs * args)
@@ -1656,10 +1655,10 @@ void CAfxBaseFxStream::Console_ActionFilter_AddEx(CAfxStreams * streams, IWrpCom
 	CActionFilterValue * value = CActionFilterValue::Console_Parse(streams, args);
 	if (value)
 	{
-		InvalidateMap();
 		//if (value->GetUseEntity()) this->Console_DisableFastPathRequired();
 		m_ActionFilter.push_back(*value);
 		delete value;
+		InvalidateMap();
 	}
 }
 
@@ -1681,8 +1680,8 @@ void CAfxBaseFxStream::Console_ActionFilter_Remove(int id)
 	{
 		if(curId == id)
 		{
-			InvalidateMap();
 			m_ActionFilter.erase(it);
+			InvalidateMap();
 			return;
 		}
 
@@ -1719,8 +1718,6 @@ void CAfxBaseFxStream::Console_ActionFilter_Move(int id, int moveBeforeId)
 
 		val = *it;
 
-		InvalidateMap();
-
 		m_ActionFilter.erase(it);
 	}
 
@@ -1735,12 +1732,14 @@ void CAfxBaseFxStream::Console_ActionFilter_Move(int id, int moveBeforeId)
 
 		m_ActionFilter.insert(it,val);
 	}
+
+	InvalidateMap();
 }
 
 void CAfxBaseFxStream::Console_ActionFilter_Clear()
 {
-	InvalidateMap();
 	m_ActionFilter.clear();
+	InvalidateMap();
 }
 
 void CAfxBaseFxStream::MainThreadInitialize(void)
@@ -1786,111 +1785,31 @@ CAfxBaseFxStream::CAction * CAfxBaseFxStream::RetrieveAction(CAfxTrackedMaterial
 
 	if (!action)
 	{
-		m_MapMutex.lock_shared();
-
-		std::map<CAfxTrackedMaterial *, CCacheEntry>::iterator it = m_Map.find(tackedMaterial);
-
-		if (it != m_Map.end())
-		{
-			std::map<SOURCESDK::CSGO::CBaseHandle, CAction *>::iterator itEnt = it->second.EntityActions.find(currentEntity.Handle);
-			if (itEnt != it->second.EntityActions.end())
-				action = itEnt->second;
-			else
-				action = it->second.DefaultAction;
-
-			m_MapMutex.unlock_shared();
-		}
-		else
-		{
-			m_MapMutex.unlock_shared();
-			m_MapMutex.lock();
-
-			it = m_Map.find(tackedMaterial);
-
-			if (it != m_Map.end())
-			{
-				std::map<SOURCESDK::CSGO::CBaseHandle, CAction *>::iterator itEnt = it->second.EntityActions.find(currentEntity.Handle);
-				if (itEnt != it->second.EntityActions.end())
-					action = itEnt->second;
-				else
-					action = it->second.DefaultAction;
-			}
-
-			if (!action)
-			{
-				// determine current action and cache it.
-
-				CCacheEntry & entry = m_Map[tackedMaterial];
-
-				tackedMaterial->AddNotifyee(m_MapRleaseNotification);
-
-				for (std::list<CActionFilterValue>::iterator it = m_ActionFilter.begin(); it != m_ActionFilter.end(); ++it)
-				{
-					if (it->CalcMatch_Material(tackedMaterial))
-					{
-						if (it->GetUseEntity())
-						{
-							if(entry.EntityActions.end() == entry.EntityActions.find(currentEntity.Handle) && it->CalcMatch_Entity(currentEntity))
-							{
-								CAction * itAction = GetAction(tackedMaterial, it->GetMatchAction());
-								itAction->AddRef();
-								entry.EntityActions[currentEntity.Handle] = itAction;
-
-								if (!action)
-								{
-									action = itAction;
-								}
-							}
-						}
-						else
-						{
-							if (!entry.DefaultAction)
-							{
-								CAction * itAction = GetAction(tackedMaterial, it->GetMatchAction());
-								itAction->AddRef();
-								entry.DefaultAction = itAction;
-
-								if (!action)
-								{
-									action = itAction;
-								}
-							}
-
-							break;
-						}
-					}
-				}
-
-				if (!entry.DefaultAction)
-				{
-					CAction * itAction = GetAction(tackedMaterial);
-					itAction->AddRef();
-					entry.DefaultAction = itAction;
+		action = FindCachedAction(tackedMaterial, currentEntity);
+	}
 
-					if (!action)
-						action = entry.DefaultAction;
-				}
+	if (!action)
+	{
+		std::unique_lock<std::mutex> lock(m_MapMutex);
 
-				Assert(0 != action);
+		action = CacheAction(tackedMaterial, currentEntity);
 
-				if (m_DebugPrint)
-				{
-					const char * name = material->GetName();
-					const char * groupName = material->GetTextureGroupName();
-					const char * shaderName = material->GetShaderName();
-					bool isErrorMaterial = material->IsErrorMaterial();
+		Assert(0 != action);
 
-					Tier0_Msg("Stream: RetrieveAction: Material action cache miss: \"handle=%i\" \"name=%s\" \"textureGroup=%s\" \"shader=%s\" \"isErrrorMaterial=%u\" -> %s\n"
-						, currentEntity.Handle
-						, name
-						, groupName
-						, shaderName
-						, isErrorMaterial ? 1 : 0
-						, action ? action->Key_get().m_Name.c_str() : "(null)");
-				}
-			}
+		if (m_DebugPrint)
+		{
+			const char * name = material->GetName();
+			const char * groupName = material->GetTextureGroupName();
+			const char * shaderName = material->GetShaderName();
+			bool isErrorMaterial = material->IsErrorMaterial();
 
-			m_MapMutex.unlock();
+			Tier0_Msg("Stream: RetrieveAction: Material action cache miss: \"handle=%i\" \"name=%s\" \"textureGroup=%s\" \"shader=%s\" \"isErrrorMaterial=%u\" -> %s\n"
+				, currentEntity.Handle
+				, name
+				, groupName
+				, shaderName
+				, isErrorMaterial ? 1 : 0
+				, action ? action->Key_get().m_Name.c_str() : "(null)");
 		}
 	}
 
@@ -2307,24 +2226,263 @@ void CAfxBaseFxStream::DebugPrint_set(bool value)
 
 void CAfxBaseFxStream::InvalidateMap(void)
 {
-	m_MapMutex.lock();
+	std::unique_lock<std::mutex> lock(m_MapMutex);
 
 	if(m_DebugPrint)
 		Tier0_Msg("Stream: Invalidating material cache.\n");
 
-	for(std::map<CAfxTrackedMaterial *, CCacheEntry>::iterator it = m_Map.begin(); it != m_Map.end(); ++it)
+	++m_MapGeneration;
+}
+
+CAfxBaseFxStream::CCacheEntry::CCacheEntry(CAfxTrackedMaterial * material, unsigned int generation, bool useEntity, CAction * defaultAction)
+	: Material(material)
+	, Generation(generation)
+	, UseEntity(useEntity)
+	, DefaultAction(defaultAction)
+	, EntityActions(useEntity ? new CEntityActions(8) : nullptr)
+{
+	DefaultAction->AddRef();
+}
+
+CAfxBaseFxStream::CCacheEntry::~CCacheEntry()
+{
+	if (CEntityActions * entityActions = EntityActions.load())
 	{
-		for (std::map<SOURCESDK::CSGO::CBaseHandle, CAction *>::iterator itIt = it->second.EntityActions.begin(); itIt != it->second.EntityActions.end(); ++itIt)
+		for (unsigned int i = 0; i <= entityActions->Mask; ++i)
 		{
-			itIt->second->Release();
+			if (CAction * action = entityActions->Actions[i].load()) action->Release();
 		}
 
-		it->second.DefaultAction->Release();
-		it->first->RemoveNotifyee(m_MapRleaseNotification);
+		delete entityActions;
+	}
+
+	DefaultAction->Release();
+}
+
+std::atomic<CAfxBaseFxStream::CCacheEntry *> * CAfxBaseFxStream::GetCacheSlot(int slot, bool create)
+{
+	unsigned int chunkIndex = (unsigned int)slot >> m_CacheChunkBits;
+
+	if (m_CacheChunkCount <= chunkIndex)
+		return nullptr;
+
+	CCacheChunk * chunk = m_CacheChunks[chunkIndex].load();
+
+	if (nullptr == chunk)
+	{
+		if (!create)
+			return nullptr;
+
+		chunk = new CCacheChunk();
+		m_CacheChunks[chunkIndex].store(chunk);
 	}
-	m_Map.clear();
 
-	m_MapMutex.unlock();
+	return &(chunk->Entries[(unsigned int)slot & (m_CacheChunkSize - 1)]);
+}
+
+CAfxBaseFxStream::CAction * CAfxBaseFxStream::FindCachedAction(CAfxTrackedMaterial * trackedMaterial, const CEntityInfo & currentEntity)
+{
+	CAction * action = nullptr;
+
+	++m_MapReaders;
+
+	if (std::atomic<CCacheEntry *> * slot = GetCacheSlot(trackedMaterial->GetSlot(), false))
+	{
+		CCacheEntry * entry = slot->load();
+
+		if (entry && entry->Material == trackedMaterial && entry->Generation == m_MapGeneration.load())
+		{
+			if (entry->UseEntity)
+				action = entry->EntityActions.load()->Find(currentEntity.Handle.ToInt());
+			else
+				action = entry->DefaultAction;
+		}
+	}
+
+	--m_MapReaders;
+
+	return action;
+}
+
+CAfxBaseFxStream::CAction * CAfxBaseFxStream::CacheAction(CAfxTrackedMaterial * trackedMaterial, const CEntityInfo & currentEntity)
+{
+	int handle = currentEntity.Handle.ToInt();
+
+	std::atomic<CCacheEntry *> * slot = GetCacheSlot(trackedMaterial->GetSlot(), true);
+	CCacheEntry * entry = slot ? slot->load() : nullptr;
+
+	if (entry && (entry->Material != trackedMaterial || entry->Generation != m_MapGeneration))
+	{
+		slot->store(nullptr);
+		m_RetiredEntries.push_back(entry);
+		entry = nullptr;
+	}
+
+	if (entry)
+	{
+		// Another thread might have cached it meanwhile.
+
+		if (!entry->UseEntity)
+			return entry->DefaultAction;
+
+		if (CAction * action = entry->EntityActions.load()->Find(handle))
+			return action;
+	}
+
+	CAction * entityAction;
+	CAction * defaultAction;
+	bool useEntity;
+
+	EvalActionFilter(trackedMaterial, currentEntity, entityAction, defaultAction, useEntity);
+
+	bool isNewEntry = nullptr == entry;
+
+	if (isNewEntry)
+	{
+		if (nullptr == slot)
+			return entityAction ? entityAction : defaultAction; // Out of cache slots, can't cache.
+
+		entry = new CCacheEntry(trackedMaterial, m_MapGeneration, useEntity, defaultAction);
+
+		trackedMaterial->AddNotifyee(m_MapRleaseNotification);
+	}
+
+	CAction * action = entityAction ? entityAction : entry->DefaultAction;
+
+	if (entry->UseEntity)
+	{
+		CEntityActions * entityActions = entry->EntityActions.load();
+
+		if (entityActions->Mask + 1 < 2 * (entityActions->Count + 1))
+		{
+			CEntityActions * grown = new CEntityActions(2 * (entityActions->Mask + 1));
+
+			for (unsigned int i = 0; i <= entityActions->Mask; ++i)
+			{
+				if (CAction * itAction = entityActions->Actions[i].load())
+					grown->Insert(entityActions->Handles[i].load(), itAction);
+			}
+
+			entry->EntityActions.store(grown);
+			m_RetiredEntityActions.push_back(entityActions);
+			entityActions = grown;
+		}
+
+		action->AddRef();
+		entityActions->Insert(handle, action);
+	}
+
+	if (isNewEntry)
+		slot->store(entry);
+
+	ReclaimRetired();
+
+	return action;
+}
+
+void CAfxBaseFxStream::EvalActionFilter(CAfxTrackedMaterial * trackedMaterial, const CEntityInfo & currentEntity, CAction * & outEntityAction, CAction * & outDefaultAction, bool & outUseEntity)
+{
+	outEntityAction = nullptr;
+	outDefaultAction = nullptr;
+	outUseEntity = false;
+
+	SOURCESDK::IMaterial_csgo * material = trackedMaterial->GetMaterial();
+
+	CMaterialInfo info(material);
+
+	UpdateActionFilterIndex();
+
+	// Ascending, so the first match still wins (the name is tested again by CalcMatch_Material):
+	m_ActionFilterIndex.FindCandidates(info.Name, m_ActionFilterCandidates);
+
+	for (std::vector<size_t>::iterator itIndex = m_ActionFilterCandidates.begin(); itIndex != m_ActionFilterCandidates.end(); ++itIndex)
+	{
+		CActionFilterValue * it = m_ActionFilterValues[*itIndex];
+
+		if (it->CalcMatch_Material(info))
+		{
+			if (it->GetUseEntity())
+			{
+				outUseEntity = true;
+
+				if (!outEntityAction && it->CalcMatch_Entity(currentEntity))
+				{
+					outEntityAction = GetAction(trackedMaterial, it->GetMatchAction());
+				}
+			}
+			else
+			{
+				outDefaultAction = GetAction(trackedMaterial, it->GetMatchAction());
+				break;
+			}
+		}
+	}
+
+	if (!outDefaultAction)
+		outDefaultAction = GetAction(trackedMaterial);
+}
+
+void CAfxBaseFxStream::UpdateActionFilterIndex(void)
+{
+	unsigned int generation = m_MapGeneration.load();
+
+	if (m_ActionFilterIndexValid && m_ActionFilterIndexGeneration == generation)
+		return;
+
+	m_ActionFilterIndex.Clear();
+	m_ActionFilterValues.clear();
+
+	for (std::list<CActionFilterValue>::iterator it = m_ActionFilter.begin(); it != m_ActionFilter.end(); ++it)
+	{
+		m_ActionFilterIndex.Add(it->GetName());
+		m_ActionFilterValues.push_back(&(*it));
+	}
+
+	m_ActionFilterIndexGeneration = generation;
+	m_ActionFilterIndexValid = true;
+}
+
+void CAfxBaseFxStream::ReclaimRetired(void)
+{
+	if (0 != m_MapReaders.load())
+		return;
+
+	for (std::vector<CCacheEntry *>::iterator it = m_RetiredEntries.begin(); it != m_RetiredEntries.end(); ++it)
+	{
+		delete *it;
+	}
+	m_RetiredEntries.clear();
+
+	for (std::vector<CEntityActions *>::iterator it = m_RetiredEntityActions.begin(); it != m_RetiredEntityActions.end(); ++it)
+	{
+		delete *it;
+	}
+	m_RetiredEntityActions.clear();
+}
+
+void CAfxBaseFxStream::ClearMap(void)
+{
+	std::unique_lock<std::mutex> lock(m_MapMutex);
+
+	for (unsigned int i = 0; i < m_CacheChunkCount; ++i)
+	{
+		if (CCacheChunk * chunk = m_CacheChunks[i].load())
+		{
+			for (unsigned int j = 0; j < m_CacheChunkSize; ++j)
+			{
+				if (CCacheEntry * entry = chunk->Entries[j].load())
+				{
+					entry->Material->RemoveNotifyee(m_MapRleaseNotification);
+					delete entry;
+				}
+			}
+
+			m_CacheChunks[i].store(nullptr);
+			delete chunk;
+		}
+	}
+
+	ReclaimRetired();
 }
 
 void CAfxBaseFxStream::Picker_Stop(void)
@@ -3555,18 +3713,13 @@ CAfxBaseFxStream::CActionFilterValue * CAfxBaseFxStream::CActionFilterValue::Con
 	return result;
 }
 
-bool CAfxBaseFxStream::CActionFilterValue::CalcMatch_Material(CAfxTrackedMaterial * trackedMaterial)
+bool CAfxBaseFxStream::CActionFilterValue::CalcMatch_Material(const CMaterialInfo & info) const
 {
-	SOURCESDK::IMaterial_csgo * material = trackedMaterial->GetMaterial();
-		
-	if (!material)
-		return false;
-
 	return
-		StringWildCard1Matched(m_Name.c_str(), material->GetName())
-		&& StringWildCard1Matched(m_TextureGroupName.c_str(), material->GetTextureGroupName())
-		&& StringWildCard1Matched(m_ShaderName.c_str(), material->GetShaderName())
-		&& (m_IsErrorMaterial == TS_True ? (material->IsErrorMaterial() == true) : (m_IsErrorMaterial == TS_False ? (material->IsErrorMaterial() == false) : true));
+		(m_IsErrorMaterial == TS_True ? (info.IsErrorMaterial == true) : (m_IsErrorMaterial == TS_False ? (info.IsErrorMaterial == false) : true))
+		&& m_Name.Matches(info.Name)
+		&& m_TextureGroupName.Matches(info.TextureGroupName)
+		&& m_ShaderName.Matches(info.ShaderName);
 }
 
 bool CAfxBaseFxStream::CActionFilterValue::CalcMatch_Entity(const CEntityInfo & info)
@@ -5128,6 +5281,7 @@ CAfxStreams::CAfxStreams()
 : m_RecordName("untitled_rec")
 , m_PresentRecordOnScreen(false)
 , m_StartMovieWav(true)
+, m_WavFormat(CMirvWav::SF_PCM16)
 , m_RecordVoices(false)
 , m_MaterialSystem(0)
 , m_AfxBaseClientDll(0)
@@ -6025,6 +6179,16 @@ bool CAfxStreams::Console_StartMovieWav_get()
 	return m_StartMovieWav;
 }
 
+void CAfxStreams::Console_WavFormat_set(CMirvWav::SampleFormat value)
+{
+	m_WavFormat = value;
+}
+
+CMirvWav::SampleFormat CAfxStreams::Console_WavFormat_get()
+{
+	return m_WavFormat;
+}
+
 void CAfxStreams::Console_RecordVoices_set(bool value)
 {
 	m_RecordVoices = value;
@@ -6151,7 +6315,10 @@ void CAfxStreams::Console_Record_Start()
 			std::wstring camFileName(m_TakeDir);
 			camFileName.append(L"\\cam_main.cam");
 
-			m_CamExportObj = new CamExport(camFileName.c_str(), m_CamExportScaleFov);
+			m_CamExportObj = new CamExport(camFileName.c_str(), m_CamExportScaleFov, m_CamExportBinary);
+
+			if (m_CamExportObj->IsBad())
+				Tier0_Warning("AFXERROR: Could not open cam_main.cam for writing.\n");
 		}
 
 		Tier0_Msg("done.\n");
@@ -6162,7 +6329,7 @@ void CAfxStreams::Console_Record_Start()
 
 		if (m_StartMovieWavUsed)
 		{
-			if (!csgo_Audio_StartRecording(m_TakeDir.c_str()))
+			if (!csgo_Audio_StartRecording(m_TakeDir.c_str(), m_WavFormat))
 				Tier0_Warning("Error: Could not start WAV audio recording!\n");
 		}
 
@@ -6219,6 +6386,9 @@ void CAfxStreams::Console_Record_End()
 			if (CClientTools * instance = CClientTools::Instance()) instance->EndRecording();
 		}
 
+		// Let the queued frames be written:
+		CapturePipeline.Wait();
+
 		for(std::list<CAfxRecordStream *>::iterator it = m_Streams.begin(); it != m_Streams.end(); ++it)
 		{
 			(*it)->RecordEnd();
@@ -6589,6 +6759,62 @@ void CAfxStreams::Console_MainStream(IWrpCommandArgs * args)
 	);
 }
 
+void CAfxStreams::Console_Pipeline(IWrpCommandArgs * args)
+{
+	int argC = args->ArgC();
+	const char * arg0 = args->ArgV(0);
+
+	if (2 <= argC)
+	{
+		const char * arg1 = args->ArgV(1);
+
+		if (0 == _stricmp("reset", arg1))
+		{
+			CapturePipeline.ResetStats();
+			ImageBufferPool.ResetStats();
+			return;
+		}
+	}
+
+	CapturePipeline.PrintStats();
+	ImageBufferPool.Console_PrintStats();
+
+	Tier0_Msg(
+		"%s reset - Reset the statistics.\n"
+		, arg0
+	);
+}
+
+void CAfxStreams::Console_BufferBudget(IWrpCommandArgs * args)
+{
+	int argC = args->ArgC();
+	const char * arg0 = args->ArgV(0);
+
+	if (2 <= argC)
+	{
+		const char * arg1 = args->ArgV(1);
+
+		char * end = nullptr;
+		long value = strtol(arg1, &end, 10);
+
+		if (end == arg1 || '\0' != *end || value < 0 || (unsigned long)value > (size_t)-1 / (1024 * 1024))
+		{
+			Tier0_Warning("AFXERROR: %s is not a valid budget, expected a number of MiB from 0 to %u.\n", arg1, (unsigned int)((size_t)-1 / (1024 * 1024)));
+			return;
+		}
+
+		ImageBufferPool.SetBudget((size_t)value * 1024 * 1024);
+		return;
+	}
+
+	Tier0_Msg(
+		"%s <iMiB> - Memory budget for capture image buffers in MiB, 0 means no limit.\n"
+		"Current value: %u\n"
+		, arg0
+		, (unsigned int)(ImageBufferPool.GetBudget() / (1024 * 1024))
+	);
+}
+
 void CAfxStreams::Console_PreviewStream(const char * streamName, int slot)
 {
 	if (slot >= (int)(sizeof(m_PreviewStreams) / sizeof(m_PreviewStreams[0])))
@@ -8959,6 +9185,8 @@ void CAfxStreams::ShutDown(void)
 			m_Streams.pop_front();
 		}
 
+		CapturePipeline.Shutdown();
+
 		delete m_MatPostProcessEnableRef;
 		delete m_HostFrameRate;
 	}
@@ -9074,6 +9302,12 @@ void CAfxRecordingSettings::Console(IWrpCommandArgs * args)
 			}
 			return;
 		}
+		else if (0 == _stricmp("bufferBudget", arg1))
+		{
+			CSubWrpCommandArgs subArgs(args, 2);
+			g_AfxStreams.Console_BufferBudget(&subArgs);
+			return;
+		}
 		else if (0 == _strcmpi("add", arg1))
 		{
 			if (5 == argC && 0 == _stricmp("ffmpeg", args->ArgV(2)))
@@ -9151,6 +9385,8 @@ void CAfxRecordingSettings::Console(IWrpCommandArgs * args)
 		"%s edit <name> - Remove setting.\n"
 		"%s remove <name> - Remove setting.\n"
 		"%s add [...] - Add a setting.\n"
+		"%s bufferBudget [...] - Memory budget for capture image buffers.\n"
+		, arg0
 		, arg0
 		, arg0
 		, arg0
@@ -9179,7 +9415,8 @@ CAfxOutVideoStream * CAfxClassicRecordingSettings::CreateOutVideoStream(const CA
 
 		CAfxRenderViewStream::StreamCaptureType captureType = stream.GetCaptureType();
 
-		return new CAfxOutImageStream(imageFormat, capturePath, (captureType == CAfxRenderViewStream::SCT_Depth24ZIP || captureType == CAfxRenderViewStream::SCT_DepthFZIP), streams.m_FormatBmpAndNotTga);
+		return new CAfxOutStageVideoStream(imageFormat, g_AfxStreams.CapturePipeline.Output,
+			new CAfxOutImageStream(imageFormat, capturePath, (captureType == CAfxRenderViewStream::SCT_Depth24ZIP || captureType == CAfxRenderViewStream::SCT_DepthFZIP), streams.m_FormatBmpAndNotTga));
 	}
 	else
 	{
@@ -9250,7 +9487,8 @@ CAfxOutVideoStream * CAfxFfmpegRecordingSettings::CreateOutVideoStream(const CAf
 
 				CAfxRenderViewStream::StreamCaptureType captureType = stream.GetCaptureType();
 
-				return new CAfxOutFFMPEGVideoStream(imageFormat, capturePath, wideOptions, frameRate);
+				return new CAfxOutStageVideoStream(imageFormat, g_AfxStreams.CapturePipeline.Output,
+					new CAfxOutFFMPEGVideoStream(imageFormat, capturePath, wideOptions, frameRate));
 			}
 			else
 			{
@@ -9431,7 +9669,8 @@ CAfxOutVideoStream * CAfxSamplingRecordingSettings::CreateOutVideoStream(const C
 	{
 		if (CAfxOutVideoStream * outVideoStream = m_OutputSettings->CreateOutVideoStream(streams, stream, imageFormat, m_OutFps, pathSuffix))
 		{
-			return new CAfxOutSamplingStream(imageFormat, outVideoStream, frameRate, m_Method, m_OutFps ? 1.0 / m_OutFps : 0.0, m_Exposure, m_FrameStrength);
+			return new CAfxOutStageVideoStream(imageFormat, g_AfxStreams.CapturePipeline.Sample,
+				new CAfxOutSamplingStream(imageFormat, outVideoStream, frameRate, m_Method, m_OutFps ? 1.0 / m_OutFps : 0.0, m_Exposure, m_FrameStrength, m_Threads, m_Kernels));
 		}
 	}
 
@@ -9594,6 +9833,77 @@ void CAfxSamplingRecordingSettings::Console_Edit(IWrpCommandArgs * args)
 			);
 			return;
 		}
+		else if (0 == _stricmp("threads", arg1))
+		{
+			if (3 == argC)
+			{
+				if (m_Protected)
+				{
+					Tier0_Warning("This setting is protected and can not be changed.\n");
+					return;
+				}
+
+				m_Threads = atoi(args->ArgV(2));
+				return;
+			}
+
+			Tier0_Msg(
+				"%s threads <iValue> - Number of threads to sample with, 0 for number of logical processors.\n"
+				"Current value: %i\n"
+				, arg0
+				, m_Threads
+			);
+			return;
+		}
+		else if (0 == _stricmp("kernels", arg1))
+		{
+			if (3 == argC)
+			{
+				if (m_Protected)
+				{
+					Tier0_Warning("This setting is protected and can not be changed.\n");
+					return;
+				}
+
+				const char * arg2 = args->ArgV(2);
+
+				if (0 == _stricmp(arg2, "auto"))
+				{
+					m_Kernels = EasySamplerKernels::EK_Auto;
+				}
+				else if (0 == _stricmp(arg2, "scalar"))
+				{
+					m_Kernels = EasySamplerKernels::EK_Scalar;
+				}
+				else if (0 == _stricmp(arg2, "sse2"))
+				{
+					m_Kernels = EasySamplerKernels::EK_Sse2;
+				}
+				else if (0 == _stricmp(arg2, "avx2"))
+				{
+					m_Kernels = EasySamplerKernels::EK_Avx2;
+				}
+				else
+				{
+					Tier0_Warning("AFXERROR: Invalid value.\n");
+					return;
+				}
+
+				if (!EasySamplerKernels::IsSupported(m_Kernels))
+					Tier0_Warning("AFXWARNING: %s is not supported by this CPU, %s will be used instead.\n", EasySamplerKernels::GetName(m_Kernels), EasySamplerKernels::GetName(EasySamplerKernels::GetBestSupported()));
+
+				return;
+			}
+
+			Tier0_Msg(
+				"%s kernels auto|scalar|sse2|avx2 - Inner loops to sample with, all give identical results.\n"
+				"Current value: %s (best supported: %s)\n"
+				, arg0
+				, EasySamplerKernels::GetName(m_Kernels)
+				, EasySamplerKernels::GetName(EasySamplerKernels::GetBestSupported())
+			);
+			return;
+		}
 	}
 
 	Tier0_Msg(
@@ -9602,6 +9912,10 @@ void CAfxSamplingRecordingSettings::Console_Edit(IWrpCommandArgs * args)
 		"%s method [...] - Sampling method (default: trapezoid).\n"
 		"%s exposure [...] - Frame exposure (0.0 (0 shutter angle) - 1.0 (360 shutter angle), default: 1.0).\n"
 		"%s strength [...] - Frame strength (0.0 (max cross-frame blur) - 1.0 (no cross-frame blur), default: 1.0).\n"
+		"%s threads [...] - Number of threads to sample with (default: 1).\n"
+		"%s kernels [...] - Inner loops to sample with (default: auto).\n"
+		, arg0
+		, arg0
 		, arg0
 		, arg0
 		, arg0
@@ -9688,4 +10002,4 @@ void CAfxStreams::SetClientRenderable(SOURCESDK::IClientRenderable_csgo * render
 			baseFxStream->SetClientRenderable(renderable);
 		}
 	}
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -12,9 +12,11 @@
 #include "MatRenderContextHook.h"
 #include "AfxImageBuffer.h"
 #include "AfxOutStreams.h"
+#include "AfxCapturePipeline.h"
 #include "AfxWriteFileLimiter.h"
 #include "AfxThreadedRefCounted.h"
 #include "MirvCalcs.h"
+#include "MirvWav.h"
 
 #define AFX_SHADERS_CSGO 0
 
@@ -31,12 +33,14 @@
 #endif
 
 #include <shared/bvhexport.h>
+#include <shared/StringTools.h>
 
 #include <cctype>
 
 #include <string>
 #include <set>
 #include <list>
+#include <vector>
 #include <queue>
 #include <map>
 #include <stack>
@@ -44,6 +48,7 @@
 #include <shared_mutex>
 #include <mutex>
 #include <condition_variable>
+#include <functional>
 
 typedef void(__stdcall * CCSViewRender_Render_t)(void * this_ptr, const SOURCESDK::vrect_t_csgo * rect);
 typedef void(__stdcall * CCSViewRender_RenderView_t)(void * this_ptr, const SOURCESDK::CViewSetup_csgo &view, const SOURCESDK::CViewSetup_csgo &hudViewSetup, int nClearFlags, int whatToDraw);
@@ -813,6 +818,8 @@ public:
 		, m_OutFps(outFps)
 		, m_Exposure(exposure)
 		, m_FrameStrength(frameStrength)
+		, m_Threads(1)
+		, m_Kernels(EasySamplerKernels::EK_Auto)
 	{
 		if (m_OutputSettings) m_OutputSettings->AddRef();
 	}
@@ -836,6 +843,8 @@ private:
 	float m_OutFps;
 	double m_Exposure;
 	float m_FrameStrength;
+	int m_Threads;
+	EasySamplerKernels::Kind m_Kernels;
 };
 
 class CAfxRecordStream abstract
@@ -879,7 +888,8 @@ public:
 	void QueueCaptureEnd(IAfxMatRenderContextOrg * ctx);
 
 	/// <remarks>This is not guaranteed to be called, i.e. not called upon buffer re-allocation error.</remarks>
-	void OnImageBufferCaptured(size_t index, CAfxImageBuffer * buffer);
+	/// <param name="convert">Conversion to apply to the buffer on the convert stage of the capture pipeline, can be empty.</param>
+	void OnImageBufferCaptured(size_t index, CAfxImageBuffer * buffer, std::function<void(void)> && convert);
 
 	virtual CAfxRenderViewStream::StreamCaptureType GetCaptureType() const = 0;
 
@@ -909,33 +919,19 @@ protected:
 	std::vector<CAfxRenderViewStream *> m_Streams;
 
 	std::vector<CAfxImageBuffer *> m_Buffers;
+	std::vector<std::function<void(void)>> m_Conversions;
 
 	CAfxRecordingSettings * m_Settings;
 	CAfxOutVideoStream * m_OutVideoStream;
 
-	virtual ~CAfxRecordStream() override
-	{
-		for (size_t i = 0; i < m_Streams.size(); ++i)
-		{
-			if (CAfxImageBuffer * buffer = m_Buffers[i])
-			{
-				buffer->Release();
-			}
-		}
-
-		for (size_t i = 0; i < m_Streams.size(); ++i)
-		{
-			m_Streams[i]->Release();
-		}
-
-		m_Settings->Release();
-	}
+	virtual ~CAfxRecordStream() override;
 
 	virtual void CaptureStart(void)
 	{
 
 	}
 
+	/// <remarks>Releases the buffers not handed on with QueueSupply.</remarks>
 	virtual void CaptureEnd()
 	{
 		for (size_t i = 0; i < m_Buffers.size(); ++i)
@@ -945,9 +941,19 @@ protected:
 				buffer->Release();
 				buffer = nullptr;
 			}
+
+			m_Conversions[i] = nullptr;
 		}
 	}
 
+	/// <summary>
+	/// Hands the captured buffers on to the convert stage of the capture pipeline,
+	/// which applies their conversions, then calls combine (if not empty) and
+	/// finally supplies buffer to m_OutVideoStream.
+	/// </summary>
+	/// <remarks>Does nothing if there is no m_OutVideoStream.</remarks>
+	void QueueSupply(CAfxImageBuffer * buffer, std::function<void(void)> && combine = nullptr);
+
 private:
 	class CCaptureStartFunctor
 		: public CAfxFunctor
@@ -991,6 +997,7 @@ private:
 
 	std::string m_StreamName;
 	bool m_Record;
+	CAfxCaptureStage::CQueue * m_ConvertQueue = nullptr;
 };
 
 class CAfxSingleStream
@@ -1953,6 +1960,23 @@ private:
 	};
 #endif
 
+	/// <summary>Material properties fetched once for matching a material against the filters.</summary>
+	struct CMaterialInfo
+	{
+		const char * Name;
+		const char * TextureGroupName;
+		const char * ShaderName;
+		bool IsErrorMaterial;
+
+		CMaterialInfo(SOURCESDK::IMaterial_csgo * material)
+			: Name(material->GetName())
+			, TextureGroupName(material->GetTextureGroupName())
+			, ShaderName(material->GetShaderName())
+			, IsErrorMaterial(material->IsErrorMaterial())
+		{
+		}
+	};
+
 	class CActionFilterValue
 	{
 	public:
@@ -1964,6 +1988,9 @@ private:
 
 		CActionFilterValue()
 		: m_UseHandle(false)
+		, m_Name("")
+		, m_TextureGroupName("")
+		, m_ShaderName("")
 		, m_IsErrorMaterial(TS_DontCare)
 		, m_MatchAction(0)
 		{
@@ -2048,9 +2075,9 @@ private:
 			Tier0_Msg("id=%i, \"handle=%s\",\"name=%s\", \"textureGroup=%s\", \"shader=%s\", \"isErrrorMaterial=%s\", \"action=%s\"\n",
 				id,
 				handleStr.c_str(),
-				m_Name.c_str(),
-				m_TextureGroupName.c_str(),
-				m_ShaderName.c_str(),
+				m_Name.GetMask().c_str(),
+				m_TextureGroupName.GetMask().c_str(),
+				m_ShaderName.GetMask().c_str(),
 				m_IsErrorMaterial == TS_True ? "1" : (m_IsErrorMaterial == TS_False ? "0" : "(don't care)"),
 				m_MatchAction ? m_MatchAction->Key_get().m_Name.c_str() : "(null)"
 			);
@@ -2066,7 +2093,12 @@ private:
 			return m_UseHandle;
 		}
 
-		bool CalcMatch_Material(CAfxTrackedMaterial * trackedMaterial);
+		const StringWildCard1Matcher & GetName(void) const
+		{
+			return m_Name;
+		}
+
+		bool CalcMatch_Material(const CMaterialInfo & info) const;
 
 		bool CalcMatch_Entity(const CEntityInfo & info);
 
@@ -2074,9 +2106,9 @@ private:
 		bool m_UseHandle;
 		SOURCESDK::CSGO::CBaseHandle m_Handle;
 		std::string m_ClassName;
-		std::string m_Name;
-		std::string m_TextureGroupName;
-		std::string m_ShaderName;
+		StringWildCard1Matcher m_Name;
+		StringWildCard1Matcher m_TextureGroupName;
+		StringWildCard1Matcher m_ShaderName;
 		TriState m_IsErrorMaterial;
 		CAction * m_MatchAction;
 	};
@@ -2318,18 +2350,136 @@ private:
 	CAfxBaseFxStreamContext * m_ActiveStreamContext = nullptr;
 
 	bool m_DebugPrint;
+
+	/// <summary>
+	///   Open addressed entity handle to action table of a CCacheEntry.<br />
+	///   Readers don't lock, the writer only inserts (under m_MapMutex)
+	///   and replaces the table with a bigger one when it gets half full.
+	/// </summary>
+	struct CEntityActions
+	{
+		unsigned int Mask;
+		unsigned int Count;
+		std::atomic_int * Handles;
+		std::atomic<CAction *> * Actions;
+
+		CEntityActions(unsigned int capacity)
+			: Mask(capacity - 1)
+			, Count(0)
+			, Handles(new std::atomic_int[capacity])
+			, Actions(new std::atomic<CAction *>[capacity])
+		{
+			for (unsigned int i = 0; i < capacity; ++i)
+			{
+				Handles[i].store(0, std::memory_order_relaxed);
+				Actions[i].store(nullptr, std::memory_order_relaxed);
+			}
+		}
+
+		~CEntityActions()
+		{
+			delete[] Actions;
+			delete[] Handles;
+		}
+
+		/// <returns>0 if not found.</returns>
+		CAction * Find(int handle) const
+		{
+			for (unsigned int i = Hash(handle) & Mask; ; i = (i + 1) & Mask)
+			{
+				CAction * action = Actions[i].load(std::memory_order_acquire);
+
+				if (nullptr == action || Handles[i].load(std::memory_order_relaxed) == handle)
+					return action;
+			}
+		}
+
+		/// <remarks>The handle must not be in the table yet and there must be room (Count + 1 < Mask + 1).</remarks>
+		void Insert(int handle, CAction * action)
+		{
+			unsigned int i = Hash(handle) & Mask;
+
+			while (nullptr != Actions[i].load(std::memory_order_relaxed))
+				i = (i + 1) & Mask;
+
+			Handles[i].store(handle, std::memory_order_relaxed);
+			Actions[i].store(action, std::memory_order_release);
+			++Count;
+		}
+
+		static unsigned int Hash(int handle)
+		{
+			return (unsigned int)handle * 2654435761u;
+		}
+	};
+
+	/// <summary>
+	///   Cached RetrieveAction result for one material, immutable once published
+	///   (except for the entity table).
+	/// </summary>
 	struct CCacheEntry
 	{
-		std::map<SOURCESDK::CSGO::CBaseHandle, CAction *> EntityActions;
+		CAfxTrackedMaterial * Material;
+		unsigned int Generation;
+
+		/// <summary>If entity dependent filters match the material, otherwise DefaultAction is used for all entities.</summary>
+		bool UseEntity;
+
 		CAction * DefaultAction;
 
-		CCacheEntry()
-			: DefaultAction(0)
+		/// <remarks>Only set if UseEntity.</remarks>
+		std::atomic<CEntityActions *> EntityActions;
+
+		CCacheEntry(CAfxTrackedMaterial * material, unsigned int generation, bool useEntity, CAction * defaultAction);
+		~CCacheEntry();
+	};
+
+	static const unsigned int m_CacheChunkBits = 8;
+	static const unsigned int m_CacheChunkSize = 1 << m_CacheChunkBits;
+	static const unsigned int m_CacheChunkCount = 1024;
+
+	struct CCacheChunk
+	{
+		std::atomic<CCacheEntry *> Entries[m_CacheChunkSize];
+
+		CCacheChunk()
 		{
+			for (unsigned int i = 0; i < m_CacheChunkSize; ++i)
+				Entries[i].store(nullptr, std::memory_order_relaxed);
 		}
 	};
-	std::map<CAfxTrackedMaterial *, CCacheEntry> m_Map;
-	std::shared_timed_mutex m_MapMutex;
+
+	/// <summary>
+	///   Action cache indexed by CAfxTrackedMaterial::GetSlot(), chunks are allocated on demand.<br />
+	///   Reads are lock-free, writes happen under m_MapMutex.
+	///   InvalidateMap only increments m_MapGeneration, entries of an older generation are replaced on the next miss.
+	///   Replaced entries and entity tables are retired and only deleted once no reader is active (m_MapReaders).
+	/// </summary>
+	std::atomic<CCacheChunk *> m_CacheChunks[m_CacheChunkCount];
+	std::atomic_uint m_MapGeneration;
+	std::atomic_int m_MapReaders;
+	std::vector<CCacheEntry *> m_RetiredEntries;
+	std::vector<CEntityActions *> m_RetiredEntityActions;
+	std::mutex m_MapMutex;
+
+	/// <returns>0 if slot is out of range or (if not create) the chunk is not allocated yet.</returns>
+	std::atomic<CCacheEntry *> * GetCacheSlot(int slot, bool create);
+
+	/// <summary>Lock-free lookup.</summary>
+	/// <returns>0 on cache miss.</returns>
+	CAction * FindCachedAction(CAfxTrackedMaterial * trackedMaterial, const CEntityInfo & currentEntity);
+
+	/// <summary>Determines and caches the action, m_MapMutex must be held.</summary>
+	CAction * CacheAction(CAfxTrackedMaterial * trackedMaterial, const CEntityInfo & currentEntity);
+
+	/// <summary>m_MapMutex must be held.</summary>
+	void EvalActionFilter(CAfxTrackedMaterial * trackedMaterial, const CEntityInfo & currentEntity, CAction * & outEntityAction, CAction * & outDefaultAction, bool & outUseEntity);
+
+	/// <summary>m_MapMutex must be held.</summary>
+	void ReclaimRetired(void);
+
+	/// <summary>Deletes all entries (without retiring), only to be called when no reader can be active anymore.</summary>
+	void ClearMap(void);
 
 	class CMapRleaseNotification : public IAfxMaterialFree
 	{
@@ -2339,35 +2489,20 @@ private:
 		{
 		}
 
-		~CMapRleaseNotification()
-		{
-			std::unique_lock<std::shared_timed_mutex> unique_lock(m_Stream->m_MapMutex);
-
-			std::map<CAfxTrackedMaterial *, CCacheEntry> & map = m_Stream->m_Map;
-
-			for (std::map<CAfxTrackedMaterial *, CCacheEntry>::iterator it = map.begin(); it != map.end(); ++it)
-			{
-				it->first->RemoveNotifyee(this);
-			}
-		}
-
 		virtual void AfxMaterialFree(CAfxTrackedMaterial * trackedMaterial)
 		{
-			std::unique_lock<std::shared_timed_mutex> unique_lock(m_Stream->m_MapMutex);
+			std::unique_lock<std::mutex> unique_lock(m_Stream->m_MapMutex);
 
-			std::map<CAfxTrackedMaterial *, CCacheEntry>::iterator it = m_Stream->m_Map.find(trackedMaterial);
-
-			if (it != m_Stream->m_Map.end())
+			if (std::atomic<CCacheEntry *> * slot = m_Stream->GetCacheSlot(trackedMaterial->GetSlot(), false))
 			{
+				CCacheEntry * entry = slot->load();
 
-				for (std::map<SOURCESDK::CSGO::CBaseHandle, CAction *>::iterator itIt = it->second.EntityActions.begin(); itIt != it->second.EntityActions.end(); ++itIt)
+				if (entry && entry->Material == trackedMaterial)
 				{
-					itIt->second->Release();
+					slot->store(nullptr);
+					m_Stream->m_RetiredEntries.push_back(entry);
+					m_Stream->ReclaimRetired();
 				}
-
-				it->second.DefaultAction->Release();
-
-				m_Stream->m_Map.erase(it);
 			}
 		}
 
@@ -2412,6 +2547,20 @@ private:
 
 	std::list<CActionFilterValue> m_ActionFilter;
 
+	/// <summary>
+	///   m_ActionFilter indexed by the name masks, so a miss only tests the filters that can match the material name.<br />
+	///   Rebuilt by EvalActionFilter when m_MapGeneration changed (every change to m_ActionFilter calls InvalidateMap afterwards).
+	///   Only used under m_MapMutex.
+	/// </summary>
+	StringWildCard1Index m_ActionFilterIndex;
+	std::vector<CActionFilterValue *> m_ActionFilterValues;
+	std::vector<size_t> m_ActionFilterCandidates;
+	unsigned int m_ActionFilterIndexGeneration;
+	bool m_ActionFilterIndexValid;
+
+	/// <summary>m_MapMutex must be held.</summary>
+	void UpdateActionFilterIndex(void);
+
 	struct CPickerMatValue
 	{
 		int Index;
@@ -2888,6 +3037,8 @@ public:
 
 	CAfxImageBufferPool ImageBufferPool;
 
+	CAfxCapturePipeline CapturePipeline;
+
 	bool m_FormatBmpAndNotTga;
 
 	CAfxStreams();
@@ -2939,6 +3090,9 @@ public:
 	void Console_StartMovieWav_set(bool value);
 	bool Console_StartMovieWav_get();	
 
+	void Console_WavFormat_set(CMirvWav::SampleFormat value);
+	CMirvWav::SampleFormat Console_WavFormat_get();
+
 	void Console_RecordVoices_set(bool value);
 	bool Console_RecordVoices_get();
 
@@ -2994,6 +3148,9 @@ public:
 	CamExport::ScaleFov CamExportScaleFov_get(void) { return m_CamExportScaleFov;  }
 	void CamExportScaleFov_set(CamExport::ScaleFov value) { m_CamExportScaleFov = value;  }
 
+	bool CamExportBinary_get(void) { return m_CamExportBinary;  }
+	void CamExportBinary_set(bool value) { m_CamExportBinary = value;  }
+
 	void Console_GameRecording(IWrpCommandArgs * args);
 
 	/// <param name="streamName">stream name to preview or empty string if to preview nothing.</param>
@@ -3020,6 +3177,11 @@ public:
 
 	void Console_MainStream(IWrpCommandArgs * args);
 
+	void Console_Pipeline(IWrpCommandArgs * args);
+
+	/// <summary>mirv_streams settings bufferBudget</summary>
+	void Console_BufferBudget(IWrpCommandArgs * args);
+
 	bool DrawPhiGrid = false;
 	bool DrawRuleOfThirds = false;
 
@@ -3095,6 +3257,7 @@ private:
 	bool m_PresentRecordOnScreen;
 	bool m_StartMovieWav;
 	bool m_StartMovieWavUsed;
+	CMirvWav::SampleFormat m_WavFormat;
 
 	bool m_RecordVoices;
 	bool m_RecordVoicesUsed;
@@ -3114,6 +3277,7 @@ private:
 	std::list<CEntityBvhCapture *> m_EntityBvhCaptures;
 	bool m_CamExport = false;
 	CamExport::ScaleFov m_CamExportScaleFov = CamExport::SF_None;
+	bool m_CamExportBinary = false;
 	CamExport * m_CamExportObj = 0;
 	bool m_GameRecording;
 
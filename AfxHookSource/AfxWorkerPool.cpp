@@ -0,0 +1,96 @@
+#include "stdafx.h"
+
+#include "AfxWorkerPool.h"
+
+CAfxWorkerPool::CAfxWorkerPool(size_t workerCount)
+{
+	m_Threads.reserve(workerCount);
+
+	for (size_t i = 0; i < workerCount; ++i)
+	{
+		m_Threads.emplace_back(&CAfxWorkerPool::Worker, this);
+	}
+}
+
+CAfxWorkerPool::~CAfxWorkerPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_JobMutex);
+		m_Quit = true;
+	}
+
+	m_JobCondition.notify_all();
+
+	for (auto it = m_Threads.begin(); it != m_Threads.end(); ++it)
+	{
+		it->join();
+	}
+}
+
+void CAfxWorkerPool::Run(size_t count, const std::function<void(size_t index)> & fn)
+{
+	if (0 == count) return;
+
+	if (m_Threads.empty() || 1 == count)
+	{
+		for (size_t i = 0; i < count; ++i) fn(i);
+		return;
+	}
+
+	std::unique_lock<std::mutex> runLock(m_RunMutex);
+
+	std::unique_lock<std::mutex> lock(m_JobMutex);
+
+	m_JobFn = &fn;
+	m_JobCount = count;
+	m_JobNext = 0;
+	m_JobDone = 0;
+	++m_JobGeneration;
+
+	m_JobCondition.notify_all();
+
+	WorkOnJob(lock);
+
+	m_DoneCondition.wait(lock, [this]() { return m_JobDone == m_JobCount; });
+
+	m_JobFn = nullptr;
+}
+
+void CAfxWorkerPool::Worker(void)
+{
+	std::unique_lock<std::mutex> lock(m_JobMutex);
+
+	unsigned int generation = m_JobGeneration;
+
+	while (true)
+	{
+		m_JobCondition.wait(lock, [this, generation]() { return m_Quit || generation != m_JobGeneration; });
+
+		if (m_Quit) break;
+
+		generation = m_JobGeneration;
+
+		WorkOnJob(lock);
+	}
+}
+
+void CAfxWorkerPool::WorkOnJob(std::unique_lock<std::mutex> & lock)
+{
+	while (m_JobFn && m_JobNext < m_JobCount)
+	{
+		size_t index = m_JobNext;
+		++m_JobNext;
+
+		const std::function<void(size_t index)> & fn = *m_JobFn;
+
+		lock.unlock();
+
+		fn(index);
+
+		lock.lock();
+
+		++m_JobDone;
+
+		if (m_JobDone == m_JobCount) m_DoneCondition.notify_all();
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Fixed set of worker threads that run the items of a job in parallel.
+/// The calling thread works on the job too, so for n threads in total
+/// create it with n -1 workers.
+/// </summary>
+class CAfxWorkerPool
+{
+public:
+	CAfxWorkerPool(size_t workerCount);
+
+	/// <remarks>Must not be called while Run is in progress.</remarks>
+	~CAfxWorkerPool();
+
+	size_t GetWorkerCount(void) const
+	{
+		return m_Threads.size();
+	}
+
+	/// <summary>Calls fn(index) for each index in [0, count) and returns when all calls are done.</summary>
+	/// <remarks>Not re-entrant, calls from different threads are serialized.</remarks>
+	void Run(size_t count, const std::function<void(size_t index)> & fn);
+
+private:
+	std::vector<std::thread> m_Threads;
+
+	std::mutex m_RunMutex;
+
+	std::mutex m_JobMutex;
+	std::condition_variable m_JobCondition;
+	std::condition_variable m_DoneCondition;
+	const std::function<void(size_t index)> * m_JobFn = nullptr;
+	size_t m_JobCount = 0;
+	size_t m_JobNext = 0;
+	size_t m_JobDone = 0;
+	unsigned int m_JobGeneration = 0;
+	bool m_Quit = false;
+
+	void Worker(void);
+
+	/// <remarks>lock must be locked on m_JobMutex, returns with it locked.</remarks>
+	void WorkOnJob(std::unique_lock<std::mutex> & lock);
+};
@@ -2,9 +2,17 @@
 
 #include "CamIO.h"
 
+#include <shared/AfxPipeWriter.h>
+
+#include <math.h>
 #include <string>
 #include <sstream>
+#include <algorithm>
 #include <share.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 double CamIO::DoFovScaling(double width, double height, double fov)
 {
@@ -23,29 +31,200 @@ double CamIO::UndoFovScaling(double width, double height, double fov)
 }
 
 
-CamExport::CamExport(const wchar_t * fileName, ScaleFov scaleFov)
-	: m_Ofs(fileName, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc)
+namespace {
+
+/// <summary>Buffered frames are handed to the writer once the buffer has this size.</summary>
+const size_t c_CamExportFlushBytes = 64 * 1024;
+
+/// <summary>Or once the oldest buffered frame is this old.</summary>
+const double c_CamExportFlushSeconds = 1.0;
+
+void AppendString(std::vector<char> & buffer, char const * value)
+{
+	buffer.insert(buffer.end(), value, value + strlen(value));
+}
+
+/// <summary>Appends value formatted like printf &quot;%f&quot; does.</summary>
+void AppendFixed6(std::vector<char> & buffer, double value)
+{
+	bool negative = 0 != signbit(value);
+	double scaled = (negative ? -value : value) * 1000000.0;
+
+	// Fast path in integers, if the rounding is certainly the same as printf's
+	// (scaled is small enough to be exact within 1/4096 and not close to .5):
+	if (scaled < 1099511627776.0) // 2^40
+	{
+		double whole = floor(scaled);
+		double fraction = scaled - whole;
+
+		if (0.001 < fabs(fraction - 0.5))
+		{
+			uint64_t digits = (uint64_t)whole + (0.5 < fraction ? 1 : 0);
+
+			char text[32];
+			char * pc = text + sizeof(text);
+
+			for (int i = 0; i < 6; ++i)
+			{
+				*--pc = (char)('0' + digits % 10);
+				digits /= 10;
+			}
+
+			*--pc = '.';
+
+			do
+			{
+				*--pc = (char)('0' + digits % 10);
+				digits /= 10;
+			} while (digits);
+
+			if (negative) *--pc = '-';
+
+			buffer.insert(buffer.end(), pc, text + sizeof(text));
+			return;
+		}
+	}
+
+	char text[400];
+	_snprintf_s(text, _TRUNCATE, "%f", value);
+	AppendString(buffer, text);
+}
+
+} // namespace {
+
+CamExport::CamExport(const wchar_t * fileName, ScaleFov scaleFov, bool binary)
+	: m_Binary(binary)
 {
 	m_ScaleFov = scaleFov;
 
-	m_Ofs << "advancedfx Cam" << std::endl;
-	m_Ofs << "version 1" << std::endl;
-	m_Ofs << "scaleFov " << (m_ScaleFov == SF_AlienSwarm ? "alienSwarm" : "none") << std::endl;
-	m_Ofs << "channels time xPosition yPosition zPosition xRotation yRotation zRotation fov" << std::endl;
-	m_Ofs << "DATA" << std::endl;
+	_wfopen_s(&m_File, fileName, L"wb");
 
-	m_Ofs << std::fixed;
-	m_Ofs.precision(6);
+	if (nullptr == m_File)
+		return;
+
+	FILE * file = m_File;
+
+	m_FileWriter = new CAfxPipeWriter(8, [file](void const * data, size_t bytes) {
+		return 1 == fwrite(data, bytes, 1, file);
+	});
+	m_Buffer = AquireBuffer();
+	m_BufferTime = std::chrono::steady_clock::now();
+
+	AppendString(*m_Buffer, "advancedfx Cam\n");
+	AppendString(*m_Buffer, m_Binary ? "version 2\n" : "version 1\n");
+	AppendString(*m_Buffer, m_ScaleFov == SF_AlienSwarm ? "scaleFov alienSwarm\n" : "scaleFov none\n");
+	AppendString(*m_Buffer, "channels time xPosition yPosition zPosition xRotation yRotation zRotation fov\n");
+	AppendString(*m_Buffer, "DATA\n");
 }
 
 CamExport::~CamExport()
 {
-	m_Ofs.close();
+	if (m_File)
+	{
+		FlushBuffer();
+
+		m_FileWriter->Finish();
+		delete m_FileWriter;
+		m_FileWriter = nullptr;
+
+		ReleaseBuffer(m_Buffer);
+		m_Buffer = nullptr;
+
+		fclose(m_File);
+		m_File = nullptr;
+	}
+
+	for (std::vector<std::vector<char> *>::iterator it = m_FreeBuffers.begin(); it != m_FreeBuffers.end(); ++it)
+	{
+		delete *it;
+	}
+}
+
+bool CamExport::IsBad()
+{
+	return nullptr == m_File || m_FileWriter->GetFailed();
 }
 
 void CamExport::WriteFrame(double width, double height, const CamData & camData)
 {
-	m_Ofs << camData.Time << " " << camData.XPosition << " " << camData.YPosition << " " << camData.ZPosition << " " << camData.XRotation << " " << camData.YRotation << " " << camData.ZRotation << " " << DoFovScaling(width, height, camData.Fov) << std::endl;
+	if (nullptr == m_File)
+		return;
+
+	double values[8] = {
+		camData.Time,
+		camData.XPosition,
+		camData.YPosition,
+		camData.ZPosition,
+		camData.XRotation,
+		camData.YRotation,
+		camData.ZRotation,
+		DoFovScaling(width, height, camData.Fov)
+	};
+
+	if (m_Binary)
+	{
+		char const * bytes = (char const *)values;
+
+		m_Buffer->insert(m_Buffer->end(), bytes, bytes + sizeof(values));
+	}
+	else
+	{
+		for (int i = 0; i < 8; ++i)
+		{
+			if (0 < i) m_Buffer->push_back(' ');
+			AppendFixed6(*m_Buffer, values[i]);
+		}
+
+		m_Buffer->push_back('\n');
+	}
+
+	if (c_CamExportFlushBytes <= m_Buffer->size()
+		|| c_CamExportFlushSeconds <= std::chrono::duration<double>(std::chrono::steady_clock::now() - m_BufferTime).count())
+	{
+		FlushBuffer();
+	}
+}
+
+void CamExport::FlushBuffer(void)
+{
+	m_BufferTime = std::chrono::steady_clock::now();
+
+	if (!m_File || m_Buffer->empty()) return;
+
+	std::vector<char> * buffer = m_Buffer;
+
+	m_Buffer = AquireBuffer();
+
+	m_FileWriter->Queue(&(*buffer)[0], buffer->size(), [this, buffer]() {
+		ReleaseBuffer(buffer);
+	});
+}
+
+std::vector<char> * CamExport::AquireBuffer(void)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_FreeBuffersMutex);
+
+		if (!m_FreeBuffers.empty())
+		{
+			std::vector<char> * buffer = m_FreeBuffers.back();
+			m_FreeBuffers.pop_back();
+			return buffer;
+		}
+	}
+
+	std::vector<char> * buffer = new std::vector<char>();
+	buffer->reserve(c_CamExportFlushBytes + 1024);
+	return buffer;
+}
+
+void CamExport::ReleaseBuffer(std::vector<char> * buffer)
+{
+	buffer->clear();
+
+	std::unique_lock<std::mutex> lock(m_FreeBuffersMutex);
+
+	m_FreeBuffers.push_back(buffer);
 }
 
 void afx_std_string_remove_CR(std::string & inOutValue) {
@@ -53,25 +232,165 @@ void afx_std_string_remove_CR(std::string & inOutValue) {
 		inOutValue.erase(--inOutValue.end());
 }
 
+namespace {
+
+const char c_CamCacheMagic[] = "afxCamCache"; // including the terminating 0
+const int c_CamCacheVersion = 1;
+
+/// <summary>Files smaller than this parse fast enough without cache.</summary>
+const int64_t c_CamCacheMinSourceSize = 1024 * 1024;
+
+const size_t c_CamCacheFrameValues = 9;
+
+/// <summary>Reads a line (without \r\n) and advances pc to the next one.</summary>
+/// <returns>false if at end of data.</returns>
+bool GetDataLine(char const * & pc, std::string & outLine)
+{
+	if (!*pc)
+		return false;
+
+	char const * end = pc;
+	while (*end && '\n' != *end) ++end;
+
+	outLine.assign(pc, end);
+	afx_std_string_remove_CR(outLine);
+
+	pc = *end ? end + 1 : end;
+	return true;
+}
+
+} // namespace {
+
 CamImport::CamImport(char const * fileName, double startTime)
-	: m_Ifs(fileName, std::ifstream::in | std::ofstream::binary, _SH_DENYWR)
-	, m_StartTime(startTime)
+	: m_StartTime(startTime)
 {
-	int version = 0;
-	m_ScaleFov = SF_None;
+	std::string cacheFileName(fileName);
+	cacheFileName += ".afxcache";
+
+	struct _stat64 sourceStat;
+	bool hasSourceStat = 0 == _stat64(fileName, &sourceStat);
+
+	if (hasSourceStat && c_CamCacheMinSourceSize <= sourceStat.st_size && LoadCache(cacheFileName.c_str(), sourceStat.st_size, sourceStat.st_mtime))
+		return;
+
+	FILE * file = _fsopen(fileName, "rb", _SH_DENYWR);
+	if (nullptr == file)
+	{
+		m_Bad = true;
+		return;
+	}
+
+	std::vector<char> data;
+	if (hasSourceStat) data.reserve((size_t)sourceStat.st_size + 1);
 
-	char magic[14 + 1 + 1] = { 0 };
+	while (true)
+	{
+		const size_t chunkSize = 1024 * 1024;
+		size_t oldSize = data.size();
+
+		data.resize(oldSize + chunkSize);
+		size_t read = fread(&(data[oldSize]), sizeof(char), chunkSize, file);
+		data.resize(oldSize + read);
+
+		if (read < chunkSize)
+			break;
+	}
+
+	bool readError = 0 != ferror(file);
+
+	fclose(file);
 
-	m_Ifs.getline(magic, sizeof(magic) / sizeof(char), '\n'); if ('\r' == magic[14]) magic[14] = '\0';
-	if (0 != strcmp(magic, "advancedfx Cam"))m_Ifs.clear(m_Ifs.rdstate() | std::ifstream::badbit);
+	size_t size = data.size();
+	data.push_back('\0');
 
+	bool binary = false;
 
-	while (m_Ifs.good())
+	if (readError || !Parse(&(data[0]), size, binary))
 	{
-		std::string line;
+		m_Bad = true;
+		m_Frames.clear();
+		return;
+	}
+
+	// Binary files load about as fast as the cache would:
+	if (!binary && hasSourceStat && c_CamCacheMinSourceSize <= sourceStat.st_size)
+		SaveCache(cacheFileName.c_str(), sourceStat.st_size, sourceStat.st_mtime);
+}
 
-		std::getline(m_Ifs, line, '\n'); afx_std_string_remove_CR(line);
+CamImport::~CamImport()
+{
+}
 
+void CamImport::SetStart(double startTime)
+{
+	m_StartTime = startTime;
+}
+
+bool CamImport::GetCamData(double time, double width, double height, CamData & outCamData)
+{
+	if (m_Bad || m_Frames.empty())
+		return false;
+
+	double relTime = time - m_StartTime;
+
+	if (relTime < 0)
+		return false;
+
+	double firstFrameTime = m_Frames.front().Time;
+
+	// Find first frame at or after time, try the last one found first:
+
+	size_t next = m_Cursor;
+
+	if (!(next < m_Frames.size()
+		&& !(m_Frames[next].Time - firstFrameTime < relTime)
+		&& (0 == next || m_Frames[next - 1].Time - firstFrameTime < relTime)))
+	{
+		next = std::lower_bound(m_Frames.begin(), m_Frames.end(), relTime, [firstFrameTime](Frame const & frame, double value) {
+			return frame.Time - firstFrameTime < value;
+		}) - m_Frames.begin();
+
+		if (m_Frames.size() <= next)
+			return false; // after last frame
+
+		m_Cursor = next;
+	}
+
+	Frame const & lastFrame = m_Frames[0 < next ? next - 1 : next];
+	Frame const & nextFrame = m_Frames[next];
+
+	double orgTime = relTime + firstFrameTime;
+
+	double delta = nextFrame.Time - lastFrame.Time;
+	double t = delta ? ((orgTime - lastFrame.Time) / delta) : 0;
+
+	Afx::Math::QEulerAngles rot = lastFrame.Quat.Slerp(nextFrame.Quat, t).ToQREulerAngles().ToQEulerAngles();
+
+	outCamData.Time = time;
+	outCamData.XPosition = (1 - t) * lastFrame.XPosition + t * nextFrame.XPosition;
+	outCamData.YPosition = (1 - t) * lastFrame.YPosition + t * nextFrame.YPosition;
+	outCamData.ZPosition = (1 - t) * lastFrame.ZPosition + t * nextFrame.ZPosition;
+	outCamData.XRotation = rot.Roll;
+	outCamData.YRotation = rot.Pitch;
+	outCamData.ZRotation = rot.Yaw;
+	outCamData.Fov = (1 - t) * UndoFovScaling(width, height, lastFrame.Fov) + t * UndoFovScaling(width, height, nextFrame.Fov); // TODO: this maybe won't result in linear perception, maybe fix it when time.
+
+	return true;
+}
+
+bool CamImport::Parse(char const * data, size_t size, bool & outBinary)
+{
+	char const * pc = data;
+	std::string line;
+
+	int version = 0;
+	m_ScaleFov = SF_None;
+
+	if (!GetDataLine(pc, line) || 0 != line.compare("advancedfx Cam"))
+		return false;
+
+	while (GetDataLine(pc, line))
+	{
 		std::istringstream iss(line);
 
 		std::string verb;
@@ -95,144 +414,204 @@ CamImport::CamImport(char const * fileName, double startTime)
 		}
 	}
 
-	if (1 != version) m_Ifs.setstate(m_Ifs.rdstate() | std::ifstream::badbit);
+	if (2 == version)
+	{
+		// 8 doubles per frame, an incomplete frame at the end is ignored:
 
-	m_DataStart = m_Ifs.tellg();
-}
+		outBinary = true;
 
-CamImport::~CamImport()
-{
-	m_Ifs.close();
-}
+		size_t frameCount = (size - (pc - data)) / (8 * sizeof(double));
 
-void CamImport::SetStart(double startTime)
-{
-	m_StartTime = startTime;
-}
+		m_Frames.reserve(frameCount);
 
-bool CamImport::GetCamData(double time, double width, double height, CamData & outCamData)
-{
-	if (m_Ifs.bad())
-		return false;
+		for (size_t i = 0; i < frameCount; ++i)
+		{
+			double values[8];
 
-	if (time - m_StartTime < 0)
-		return false;
+			memcpy(values, pc + i * sizeof(values), sizeof(values));
+
+			AddFrame(values);
+		}
 
-	if (m_HasFinalFrame && m_FinalFrameTime - m_FirstFrameTime < time - m_StartTime)
+		return true;
+	}
+
+	if (1 != version)
 		return false;
 
-	// Jump direcltly to beginning if possible and required:
+	outBinary = false;
+
+	// Data lines: time xPosition yPosition zPosition xRotation yRotation zRotation fov
+	// The first line that can't be read ends the data.
 
-	if (m_HasLastFrame && 0 >= time - m_StartTime)
+	while (*pc)
 	{
-		if (!m_Ifs.seekg(m_DataStart))
-			return false;
+		double values[8];
+		bool ok = true;
 
-		m_HasLastFrame = false; // potentially invalid, go into backwards seek mode.
+		for (int i = 0; ok && i < 8; ++i)
+		{
+			while (' ' == *pc || '\t' == *pc || '\r' == *pc) ++pc;
+
+			if ('\n' == *pc || '\0' == *pc)
+			{
+				ok = false;
+				break;
+			}
+
+			char * end;
+			values[i] = strtod(pc, &end);
+			ok = end != pc;
+			pc = end;
+		}
+
+		if (!ok)
+			break;
+
+		// skip rest of line:
+		while (*pc && '\n' != *pc) ++pc;
+		if ('\n' == *pc) ++pc;
+
+		AddFrame(values);
 	}
 
-	// Seek backwards if required:
+	return true;
+}
 
-	while (
-		!m_HasLastFrame // has not read any frame yet
-		|| m_LastFrame.Time - m_FirstFrameTime > time - m_StartTime // OR time is before current interval
-		&& m_Ifs.tellg() != m_DataStart // AND not at start of current file
-		)
+void CamImport::AddFrame(double const values[8])
+{
+	Frame frame;
+
+	frame.Time = values[0];
+	frame.XPosition = values[1];
+	frame.YPosition = values[2];
+	frame.ZPosition = values[3];
+	frame.Fov = values[7];
+	frame.Quat = Afx::Math::Quaternion::FromQREulerAngles(Afx::Math::QREulerAngles::FromQEulerAngles(Afx::Math::QEulerAngles(values[5], values[6], values[4])));
+
+	// Make sure we will travel the short way:
+	if (!m_Frames.empty() && DotProduct(frame.Quat, m_Frames.back().Quat) < 0.0)
 	{
-		int lineBreakCount = 0;
+		frame.Quat = -1.0 * frame.Quat;
+	}
 
-		while (m_Ifs.tellg() != m_DataStart)
-		{
-			if (!m_Ifs.seekg(-1, std::ios_base::cur))
-				return false;
+	m_Frames.push_back(frame);
+}
 
-			char c;
+bool CamImport::LoadCache(char const * cacheFileName, int64_t sourceSize, int64_t sourceTime)
+{
+	FILE * file = _fsopen(cacheFileName, "rb", _SH_DENYWR);
+	if (nullptr == file)
+		return false;
 
-			if (!m_Ifs.get(c))
-				return false;
+	bool ok = true;
 
-			if ('\n' == c)
-				++lineBreakCount;
+	char magic[sizeof(c_CamCacheMagic)];
+	int version;
+	int scaleFov;
+	int64_t cachedSize;
+	int64_t cachedTime;
+	int64_t frameCount;
 
-			if (2 <= lineBreakCount)
-			{
-				if (!m_Ifs.seekg(1, std::ios_base::cur))
-					return false;
+	ok = ok && 1 == fread(magic, sizeof(magic), 1, file) && 0 == memcmp(magic, c_CamCacheMagic, sizeof(magic));
+	ok = ok && 1 == fread(&version, sizeof(version), 1, file) && c_CamCacheVersion == version;
+	ok = ok && 1 == fread(&scaleFov, sizeof(scaleFov), 1, file) && (SF_None == scaleFov || SF_AlienSwarm == scaleFov);
+	ok = ok && 1 == fread(&cachedSize, sizeof(cachedSize), 1, file) && sourceSize == cachedSize;
+	ok = ok && 1 == fread(&cachedTime, sizeof(cachedTime), 1, file) && sourceTime == cachedTime;
+	ok = ok && 1 == fread(&frameCount, sizeof(frameCount), 1, file) && 0 <= frameCount;
 
-				break;
-			}
-		}
+	std::vector<double> values;
 
-		bool hadFrame = m_HasLastFrame;
+	if (ok)
+	{
+		// Check the frame count against the data actually there, before
+		// allocating for it (the cache could be corrupted):
 
-		m_HasLastFrame = ReadDataLine(m_LastFrame);
-		if (!m_HasLastFrame)
-			return false;
+		int64_t dataStart = _ftelli64(file);
+		ok = 0 <= dataStart && 0 == _fseeki64(file, 0, SEEK_END);
 
-		if (!hadFrame)
-		{
-			// First frame read.
-			m_FirstFrameTime = m_LastFrame.Time;
-		}
+		int64_t dataSize = ok ? _ftelli64(file) - dataStart : -1;
+		int64_t frameSize = (int64_t)(c_CamCacheFrameValues * sizeof(double));
 
-		m_LastQuat = Afx::Math::Quaternion::FromQREulerAngles(Afx::Math::QREulerAngles::FromQEulerAngles(Afx::Math::QEulerAngles(m_LastFrame.YRotation, m_LastFrame.ZRotation, m_LastFrame.XRotation)));
-		m_NextFrame = m_LastFrame;
-		m_NextQuat = m_LastQuat;
+		ok = ok && 0 == _fseeki64(file, dataStart, SEEK_SET)
+			&& frameCount <= dataSize / frameSize
+			&& frameCount * frameSize == dataSize;
 	}
 
-	// Read next frame and Seek forward if required
-
-	while (m_NextFrame.Time - m_FirstFrameTime < time - m_StartTime)
+	if (ok)
 	{
-		m_LastFrame = m_NextFrame;
-		m_LastQuat = m_NextQuat;
-		
-		if (!ReadDataLine(m_NextFrame)) {
-			m_FinalFrameTime = m_LastFrame.Time;
-			m_HasFinalFrame = true;
-			return false;
-		}
-		m_NextQuat = Afx::Math::Quaternion::FromQREulerAngles(Afx::Math::QREulerAngles::FromQEulerAngles(Afx::Math::QEulerAngles(m_NextFrame.YRotation, m_NextFrame.ZRotation, m_NextFrame.XRotation)));
+		values.resize((size_t)frameCount * c_CamCacheFrameValues);
 
-		// Make sure we will travel the short way:
-		double dotProduct = DotProduct(m_NextQuat, m_LastQuat);
-		if (dotProduct<0.0)
-		{
-			m_NextQuat = -1.0 * m_NextQuat;
-		}
+		ok = values.empty() || values.size() == fread(&(values[0]), sizeof(double), values.size(), file);
+
+		// Must be at end of file now (not truncated nor appended to):
+		ok = ok && EOF == fgetc(file);
 	}
 
-	double orgTime = time - m_StartTime + m_FirstFrameTime;
+	fclose(file);
 
-	double delta = m_NextFrame.Time - m_LastFrame.Time;
-	double t = delta ? ((orgTime - m_LastFrame.Time) / delta) : 0;
+	if (!ok)
+		return false;
 
-	Afx::Math::QEulerAngles rot = m_LastQuat.Slerp(m_NextQuat, t).ToQREulerAngles().ToQEulerAngles();
+	m_ScaleFov = (ScaleFov)scaleFov;
+	m_Frames.resize((size_t)frameCount);
 
-	outCamData.Time = time;
-	outCamData.XPosition = (1 - t) * m_LastFrame.XPosition + t * m_NextFrame.XPosition;
-	outCamData.YPosition = (1 - t) * m_LastFrame.YPosition + t * m_NextFrame.YPosition;
-	outCamData.ZPosition = (1 - t) * m_LastFrame.ZPosition + t * m_NextFrame.ZPosition;
-	outCamData.XRotation = rot.Roll;
-	outCamData.YRotation = rot.Pitch;
-	outCamData.ZRotation = rot.Yaw;
-	outCamData.Fov = (1 - t) * UndoFovScaling(width, height, m_LastFrame.Fov) + t * UndoFovScaling(width, height, m_NextFrame.Fov); // TODO: this maybe won't result in linear perception, maybe fix it when time.
+	for (size_t i = 0; i < m_Frames.size(); ++i)
+	{
+		double const * cur = &(values[i * c_CamCacheFrameValues]);
+		Frame & frame = m_Frames[i];
+
+		frame.Time = cur[0];
+		frame.XPosition = cur[1];
+		frame.YPosition = cur[2];
+		frame.ZPosition = cur[3];
+		frame.Fov = cur[4];
+		frame.Quat = Afx::Math::Quaternion(cur[5], cur[6], cur[7], cur[8]);
+	}
 
 	return true;
 }
 
-bool CamImport::ReadDataLine(CamData & outCamData)
+void CamImport::SaveCache(char const * cacheFileName, int64_t sourceSize, int64_t sourceTime)
 {
-	std::string line;
+	FILE * file = _fsopen(cacheFileName, "wb", _SH_DENYWR);
+	if (nullptr == file)
+		return; // i.e. read-only folder, the cache is optional.
 
-	if (!std::getline(m_Ifs, line, '\n'))
-		return false;
+	int version = c_CamCacheVersion;
+	int scaleFov = m_ScaleFov;
+	int64_t frameCount = (int64_t)m_Frames.size();
+
+	std::vector<double> values;
+	values.reserve(m_Frames.size() * c_CamCacheFrameValues);
+
+	for (size_t i = 0; i < m_Frames.size(); ++i)
+	{
+		Frame const & frame = m_Frames[i];
+
+		values.push_back(frame.Time);
+		values.push_back(frame.XPosition);
+		values.push_back(frame.YPosition);
+		values.push_back(frame.ZPosition);
+		values.push_back(frame.Fov);
+		values.push_back(frame.Quat.W);
+		values.push_back(frame.Quat.X);
+		values.push_back(frame.Quat.Y);
+		values.push_back(frame.Quat.Z);
+	}
 
-	afx_std_string_remove_CR(line);
+	bool ok = true;
 
-	std::istringstream iss(line);
+	ok = ok && 1 == fwrite(c_CamCacheMagic, sizeof(c_CamCacheMagic), 1, file);
+	ok = ok && 1 == fwrite(&version, sizeof(version), 1, file);
+	ok = ok && 1 == fwrite(&scaleFov, sizeof(scaleFov), 1, file);
+	ok = ok && 1 == fwrite(&sourceSize, sizeof(sourceSize), 1, file);
+	ok = ok && 1 == fwrite(&sourceTime, sizeof(sourceTime), 1, file);
+	ok = ok && 1 == fwrite(&frameCount, sizeof(frameCount), 1, file);
+	ok = ok && (values.empty() || values.size() == fwrite(&(values[0]), sizeof(double), values.size(), file));
 
-	iss >> outCamData.Time >> outCamData.XPosition >> outCamData.YPosition >> outCamData.ZPosition >> outCamData.XRotation >> outCamData.YRotation >> outCamData.ZRotation >> outCamData.Fov;
+	fclose(file);
 
-	return !iss.fail();
+	if (!ok)
+		remove(cacheFileName); // incomplete
 }
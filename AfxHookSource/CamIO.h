@@ -4,8 +4,25 @@
 #include "FovScaling.h"
 
 #include <stdio.h>
-#include <fstream>
+#include <stdint.h>
+#include <chrono>
 #include <map>
+#include <mutex>
+#include <vector>
+
+class CAfxPipeWriter;
+
+// camio (.cam) ////////////////////////////////////////////////////////////////
+//
+// Text header lines:
+//   advancedfx Cam
+//   version 1|2
+//   scaleFov none|alienSwarm
+//   channels time xPosition yPosition zPosition xRotation yRotation zRotation fov
+//   DATA
+// followed by one frame per channel listed:
+// - version 1: a text line per frame, values separated by space.
+// - version 2 (binary): 8 little endian doubles per frame.
 
 
 class CamIO
@@ -37,11 +54,18 @@ protected:
 };
 
 
+/// <remarks>
+///   Frames are collected in a buffer, which is handed to a writer thread
+///   once it is big enough or old enough, so WriteFrame does not block on
+///   file I/O.
+/// </remarks>
 class CamExport : public CamIO
 {
 public:
-	CamExport(const wchar_t * fileName, ScaleFov scaleFov);
+	/// <param name="binary">Write version 2 (binary) instead of version 1 (text).</param>
+	CamExport(const wchar_t * fileName, ScaleFov scaleFov, bool binary = false);
 
+	/// <summary>Writes the remaining frames and closes the file.</summary>
 	~CamExport();
 
 	void WriteFrame(
@@ -49,11 +73,39 @@ public:
 		, const CamData & camData
 	);
 
+	/// <returns>true if the file could not be opened or writing failed.</returns>
+	bool IsBad();
+
 private:
-	std::ofstream m_Ofs;
+	FILE * m_File = nullptr;
+	bool m_Binary;
+
+	/// <summary>Writes the buffers to m_File in the background.</summary>
+	CAfxPipeWriter * m_FileWriter = nullptr;
+
+	/// <summary>Frames not handed to m_FileWriter yet.</summary>
+	std::vector<char> * m_Buffer = nullptr;
+	std::chrono::steady_clock::time_point m_BufferTime;
+
+	std::mutex m_FreeBuffersMutex;
+	std::vector<std::vector<char> *> m_FreeBuffers;
+
+	void FlushBuffer(void);
+
+	std::vector<char> * AquireBuffer(void);
+
+	/// <remarks>Called from the writer thread.</remarks>
+	void ReleaseBuffer(std::vector<char> * buffer);
 };
 
-/// <remarks>Going back in time is very inefficient, you should avoid that or improve code for that.</remarks>
+/// <remarks>
+///   The file is parsed completely on construction and frames are found by
+///   binary search, so seeking in either direction is cheap.<br />
+///   For big files the parsed frames are also stored in a binary cache next
+///   to the file (file name + &quot;.afxcache&quot;), which is loaded instead
+///   of parsing again as long as the size and modification time of the file
+///   match.
+/// </remarks>
 class CamImport : public CamIO
 {
 public:
@@ -66,20 +118,35 @@ public:
 	/// <remarks>If the function fails outCamData content is undefined.</remarks>
 	bool GetCamData(double time, double width, double height, CamData & outCamData);
 
-	bool IsBad() { return m_Ifs.bad(); }
+	bool IsBad() { return m_Bad; }
 
 private:
-	std::ifstream m_Ifs;
+	struct Frame
+	{
+		double Time;
+		double XPosition;
+		double YPosition;
+		double ZPosition;
+		double Fov;
+
+		/// <summary>Sign is chosen so slerping from the previous frame travels the short way.</summary>
+		Afx::Math::Quaternion Quat;
+	};
+
+	bool m_Bad = false;
 	double m_StartTime;
-	std::streampos m_DataStart;
-	double m_FirstFrameTime;
-	bool m_HasLastFrame = false;
-	double m_FinalFrameTime;
-	bool m_HasFinalFrame = false;
-	CamData m_LastFrame;
-	Afx::Math::Quaternion m_LastQuat;
-	CamData m_NextFrame;
-	Afx::Math::Quaternion m_NextQuat;
-
-	bool ReadDataLine(CamData & outCamData);
+	std::vector<Frame> m_Frames;
+
+	/// <summary>Index of the end of the interval found last.</summary>
+	size_t m_Cursor = 0;
+
+	/// <param name="data">File content of size bytes, followed by a terminating 0.</param>
+	/// <param name="outBinary">If the data is version 2 (binary).</param>
+	bool Parse(char const * data, size_t size, bool & outBinary);
+
+	/// <param name="values">Channels in file order.</param>
+	void AddFrame(double const values[8]);
+
+	bool LoadCache(char const * cacheFileName, int64_t sourceSize, int64_t sourceTime);
+	void SaveCache(char const * cacheFileName, int64_t sourceSize, int64_t sourceTime);
 };
@@ -7,6 +7,8 @@
 #include "WrpVEngineClient.h"
 #include "MirvTime.h"
 
+#include <shared/CamPathTrajectory.h>
+
 #define _USE_MATH_DEFINES
 #include <math.h>
 
@@ -480,44 +482,9 @@ void CCampathDrawer::OnPostRenderAllTools()
 				// This operation can be quite expensive (up to O(N^2)),
 				// so it should be done only when s.th.
 				// changed (which is what we do here).
+				// Intervals whose samples did not change come from the cache.
 
-				m_TrajectoryPoints.clear();
-				
-				CamPathIterator last = g_Hook_VClient_RenderView.m_CamPath.GetBegin();				
-				CamPathIterator it = last;
-
-				TempPoint * pts = new TempPoint[c_CameraTrajectoryMaxPointsPerInterval];
-
-				for(++it; it != g_Hook_VClient_RenderView.m_CamPath.GetEnd(); ++it)
-				{
-					double delta = it.GetTime() -last.GetTime();
-
-					for(size_t i = 0; i<c_CameraTrajectoryMaxPointsPerInterval; i++)
-					{
-						double t = last.GetTime() + delta*((double)i/(c_CameraTrajectoryMaxPointsPerInterval-1));
-
-						CamPathValue cpv = g_Hook_VClient_RenderView.m_CamPath.Eval(t);
-
-						pts[i].t = t;
-						pts[i].y = Vector3(cpv.X, cpv.Y, cpv.Z);
-						pts[i].nextPt = i+1 <c_CameraTrajectoryMaxPointsPerInterval ? &(pts[i+1]) : 0;
-					}
-
-					RamerDouglasPeucker(&(pts[0]), &(pts[c_CameraTrajectoryMaxPointsPerInterval-1]), c_CameraTrajectoryEpsilon);
-
-					// add all points except the last one (to avoid duplicates):
-					for(TempPoint * pt = &(pts[0]); pt && pt->nextPt; pt = pt->nextPt)
-					{
-						m_TrajectoryPoints.push_back(pt->t);
-					}
-
-					last = it;
-				}
-
-				// add last point:
-				m_TrajectoryPoints.push_back(pts[c_CameraTrajectoryMaxPointsPerInterval-1].t);
-
-				delete pts;
+				CamPathTrajectory_Build(g_Hook_VClient_RenderView.m_CamPath, c_CameraTrajectoryMaxPointsPerInterval, c_CameraTrajectoryEpsilon, m_TrajectoryCache, m_TrajectoryPoints);
 
 				m_RebuildDrawing = false;
 			}
@@ -527,7 +494,7 @@ void CCampathDrawer::OnPostRenderAllTools()
 
 			AutoPolyLineStart();
 
-			std::list<double>::iterator itPts = m_TrajectoryPoints.begin();
+			std::vector<double>::iterator itPts = m_TrajectoryPoints.begin();
 
 			CamPathIterator itKeysLast = g_Hook_VClient_RenderView.m_CamPath.GetBegin();
 			CamPathIterator itKeysNext = itKeysLast;
@@ -940,51 +907,7 @@ void CCampathDrawer::UnloadVertexBuffer()
 	if(m_VertexBuffer) { m_VertexBuffer->Release(); m_VertexBuffer = 0; }
 }
 
-void CCampathDrawer::RamerDouglasPeucker(TempPoint * start, TempPoint * end, double epsilon)
-{
-	double dmax = 0;
-	TempPoint * index = start;
-
-	for(TempPoint * i = start->nextPt; i && i != end; i = i->nextPt)
-	{
-		double d = ShortestDistanceToSegment(i, start, end);
-		if(d > dmax)
-		{
-			index = i;
-			dmax = d;
-		}
-	}
-
-	// If max distance is greater than epsilon, recursively simplify
-	if ( dmax > epsilon )
-	{
-		RamerDouglasPeucker(start, index, epsilon);
-		RamerDouglasPeucker(index, end, epsilon);
-	} else {
-		start->nextPt = end;
-	}
-}
-
 void CCampathDrawer::Reset()
 {
 	UnloadVertexBuffer();
 }
-
-double CCampathDrawer::ShortestDistanceToSegment(TempPoint * pt, TempPoint * start, TempPoint * end)
-{
-	double ESx = end->y.X - start->y.X;
-	double ESy = end->y.Y - start->y.Y;
-	double ESz = end->y.Z - start->y.Z;
-	double dESdES = ESx*ESx + ESy*ESy + ESz*ESz;
-	double t = dESdES ? (
-		(pt->y.X-start->y.X)*ESx +(pt->y.Y -start->y.Y)*ESy + (pt->y.Z -start->y.Z)*ESz
-	) / dESdES : 0.0;
-
-	if(t <= 0.0)
-		return (start->y -pt->y).Length();
-	else
-	if(1.0 <= t)
-		return (pt->y -end->y).Length();
-
-	return (pt->y -(start->y +t*(end->y -start->y))).Length();
-}
@@ -11,6 +11,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <chrono>
 
 CClientTools * CClientTools::m_Instance = 0;
 
@@ -40,10 +41,7 @@ void CClientTools::OnBeforeFrameRenderStart(void)
 
 	if (m_File)
 	{
-		WriteDictionary("afxFrame");
-		Write((float)g_Hook_VClient_RenderView.GetGlobals()->absoluteframetime_get());
-		m_HiddenFileOffset = ftell(m_File);
-		Write((int)0);
+		m_GameRecording.BeginFrame((float)g_Hook_VClient_RenderView.GetGlobals()->absoluteframetime_get());
 	}
 	
 }
@@ -65,30 +63,10 @@ void CClientTools::OnAfterFrameRenderEnd(void)
 		Write((float)ScaleFov(g_Hook_VClient_RenderView.LastWidth, g_Hook_VClient_RenderView.LastHeight, (float)g_Hook_VClient_RenderView.LastCameraFov));
 	}
 
-	if (m_File && m_HiddenFileOffset && 0 < m_Hidden.size())
+	if (m_File)
 	{
-		WriteDictionary("afxHidden");
-
-		size_t curOffset = ftell(m_File);
-
-		int offset = (int)(curOffset - m_HiddenFileOffset);
-
-		fseek(m_File, m_HiddenFileOffset, SEEK_SET);
-		Write((int)offset);
-		fseek(m_File, curOffset, SEEK_SET);
-
-		Write((int)m_Hidden.size());
-
-		for (std::set<int>::iterator it = m_Hidden.begin(); it != m_Hidden.end(); ++it)
-		{
-			Write((int)(*it));
-		}
-
-		m_Hidden.clear();
-		m_HiddenFileOffset = 0;
+		m_GameRecording.EndFrame();
 	}
-
-	WriteDictionary("afxFrameEnd");
 }
 
 bool CClientTools::GetRecording(void)
@@ -102,20 +80,13 @@ void CClientTools::StartRecording(wchar_t const * fileName)
 
 	m_Recording = true;
 
-	Dictionary_Clear();
 	m_File = 0;
 
-	m_HiddenFileOffset = 0;
-	m_Hidden.clear();
-
 	_wfopen_s(&m_File, fileName, L"wb");
 
 	if (m_File)
 	{
-		fputs("afxGameRecord", m_File);
-		fputc('\0', m_File);
-		int version = 4;
-		fwrite(&version, sizeof(version), 1, m_File);
+		m_GameRecording.Begin(m_File, m_Version, m_Epsilon);
 	}
 	else
 		Tier0_Warning("ERROR opening file \"%s\" for writing.\n", fileName);
@@ -137,60 +108,56 @@ void CClientTools::EndRecording()
 
 	if (m_File)
 	{
+		if (!m_GameRecording.End())
+			Tier0_Warning("AFXERROR: CClientTools::EndRecording: Writing to file failed.\n");
+
 		fclose(m_File);
+		m_File = 0;
 	}
 
-	Dictionary_Clear();
-
 	m_Recording = false;
 }
 
 void CClientTools::WriteDictionary(char const * value)
 {
-	int idx = Dictionary_Get(value);
-
-	Write(idx);
+	if (!m_File) return;
 
-	if (-1 == idx)
-	{
-		Write(value);
-	}
+	m_GameRecording.GetWriter().WriteDictionary(value);
 }
 
 void CClientTools::Write(bool value)
 {
 	if (!m_File) return;
 
-	fwrite(&value, sizeof(value), 1, m_File);
+	m_GameRecording.GetWriter().Write(value);
 }
 
 void CClientTools::Write(int value)
 {
 	if (!m_File) return;
 
-	fwrite(&value, sizeof(value), 1, m_File);
+	m_GameRecording.GetWriter().Write(value);
 }
 
 void CClientTools::Write(float value)
 {
 	if (!m_File) return;
 
-	fwrite(&value, sizeof(value), 1, m_File);
+	m_GameRecording.GetWriter().Write(value);
 }
 
 void CClientTools::Write(double value)
 {
 	if (!m_File) return;
 
-	fwrite(&value, sizeof(value), 1, m_File);
+	m_GameRecording.GetWriter().Write(value);
 }
 
 void CClientTools::Write(char const * value)
 {
 	if (!m_File) return;
 
-	fputs(value, m_File);
-	fputc('\0', m_File);
+	m_GameRecording.GetWriter().Write(value);
 }
 
 void CClientTools::Write(SOURCESDK::Vector const & value)
@@ -217,7 +184,30 @@ void CClientTools::Write(SOURCESDK::Quaternion const & value)
 
 void CClientTools::MarkHidden(int value)
 {
-	m_Hidden.insert(value);
+	m_GameRecording.MarkHidden(value);
+}
+
+void CClientTools::BeginEntityState(int handle)
+{
+	WriteDictionary("entity_state");
+	Write(handle);
+
+	m_GameRecording.GetWriter().BeginDelta(handle);
+}
+
+void CClientTools::EndEntityState(void)
+{
+	m_GameRecording.GetWriter().EndDelta();
+
+	WriteDictionary("/");
+}
+
+void CClientTools::WriteDeleted(int handle)
+{
+	WriteDictionary("deleted");
+	Write(handle);
+
+	m_GameRecording.GetWriter().DeleteDelta(handle);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -356,6 +346,45 @@ bool ClientTools_Console_Cfg(IWrpCommandArgs * args)
 			);
 			return true;
 		}
+		else if (0 == _stricmp("version", cmd1))
+		{
+			if (3 <= argc)
+			{
+				int value = atoi(args->ArgV(2));
+
+				if (4 == value || 6 == value)
+				{
+					clientTools->Version_set(value);
+					return true;
+				}
+			}
+
+			Tier0_Msg(
+				"%s version 4|6 - File format version to record, 6 is delta compressed and has a frame index (not supported by all importers yet).\n"
+				"Current value: %i.\n"
+				, prefix
+				, clientTools->Version_get()
+			);
+			return true;
+		}
+		else if (0 == _stricmp("epsilon", cmd1))
+		{
+			if (3 <= argc)
+			{
+				char const * cmd2 = args->ArgV(2);
+
+				clientTools->Epsilon_set((float)atof(cmd2));
+				return true;
+			}
+
+			Tier0_Msg(
+				"%s epsilon <fValue> - Version 6 only: Quantization step for entity positions / angles / bones, 0 means lossless.\n"
+				"Current value: %f.\n"
+				, prefix
+				, clientTools->Epsilon_get()
+			);
+			return true;
+		}
 		else if (0 == _stricmp("debug", cmd1))
 		{
 			if (3 <= argc)
@@ -383,6 +412,8 @@ bool ClientTools_Console_Cfg(IWrpCommandArgs * args)
 		"%s recordProjectiles [...]\n"
 		"%s recordViewmodel [...] - (not recommended)\n"
 		"%s recordInvisible [...] - (not recommended)\n"
+		"%s version [...]\n"
+		"%s epsilon [...]\n"
 		"%s debug [...]\n"
 		, prefix
 		, prefix
@@ -391,6 +422,8 @@ bool ClientTools_Console_Cfg(IWrpCommandArgs * args)
 		, prefix
 		, prefix
 		, prefix
+		, prefix
+		, prefix
 	);
 
 	return false;
@@ -464,6 +497,69 @@ CON_COMMAND(mirv_agr, "AFX GameRecord")
 			);
 			return;
 		}
+		else if (!_stricmp(cmd1, "convert") && 4 <= argc)
+		{
+			int version = 5 <= argc ? atoi(args->ArgV(4)) : 6;
+			float epsilon = 6 <= argc ? (float)atof(args->ArgV(5)) : 0.0f;
+
+			std::wstring wideInPath;
+			std::wstring wideOutPath;
+			FILE * inFile = 0;
+			FILE * outFile = 0;
+
+			if (4 != version && 6 != version)
+			{
+				Tier0_Warning("Error: Unsupported version %i.\n", version);
+				return;
+			}
+
+			if (!(UTF8StringToWideString(args->ArgV(2), wideInPath) && 0 == _wfopen_s(&inFile, wideInPath.c_str(), L"rb") && inFile))
+			{
+				Tier0_Warning("Error: Could not open \"%s\" for reading.\n", args->ArgV(2));
+				return;
+			}
+
+			if (!(UTF8StringToWideString(args->ArgV(3), wideOutPath) && 0 == _wfopen_s(&outFile, wideOutPath.c_str(), L"wb") && outFile))
+			{
+				Tier0_Warning("Error: Could not open \"%s\" for writing.\n", args->ArgV(3));
+				fclose(inFile);
+				return;
+			}
+
+			std::string error;
+			size_t frames;
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			bool okay = AfxGameRecord_Convert(inFile, outFile, version, epsilon, error, frames);
+
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			_fseeki64(inFile, 0, SEEK_END);
+
+			double inMiB = _ftelli64(inFile) / (1024.0 * 1024.0);
+			double outMiB = _ftelli64(outFile) / (1024.0 * 1024.0);
+
+			fclose(outFile);
+			fclose(inFile);
+
+			if (!okay)
+			{
+				Tier0_Warning("Error: %s\n", error.c_str());
+				return;
+			}
+
+			Tier0_Msg(
+				"Converted %u frames in %.2f s: %.1f MiB -> %.1f MiB (%.1f %%), %.1f MiB/s.\n"
+				, (unsigned int)frames
+				, seconds
+				, inMiB
+				, outMiB
+				, 0 < inMiB ? 100.0 * outMiB / inMiB : 0.0
+				, 0 < seconds ? inMiB / seconds : 0.0
+			);
+			return;
+		}
 	}
 
 	if (ClientTools_Console_Cfg(args))
@@ -479,6 +575,8 @@ CON_COMMAND(mirv_agr, "AFX GameRecord")
 	Tier0_Msg(
 		"%s start <sFilePath> - Start recording to file <sFilePath>, you should set a low host_framerate before (i.e. 30) and give the \".agr\" file extension.\n"
 		"%s stop - Stop recording.\n"
+		"%s convert <sInFilePath> <sOutFilePath> [<iVersion> [<fEpsilon>]] - Convert a recording to version <iVersion> (4 or 6 (default)), see epsilon for <fEpsilon>.\n"
+		, prefix
 		, prefix
 		, prefix
 	);
@@ -3,6 +3,8 @@
 #include "SourceInterfaces.h"
 #include "WrpConsole.h"
 
+#include <shared/AfxGameRecord.h>
+
 #include <string>
 #include <set>
 #include <map>
@@ -112,6 +114,28 @@ public:
 		m_RecordInvisible = value;
 	}
 
+	int Version_get(void)
+	{
+		return m_Version;
+	}
+
+	/// <param name="value">4 or 6, takes effect on next recording start.</param>
+	void Version_set(int value)
+	{
+		m_Version = value;
+	}
+
+	float Epsilon_get(void)
+	{
+		return m_Epsilon;
+	}
+
+	/// <summary>Quantization of entity state floats in version 6, 0 means lossless.</summary>
+	void Epsilon_set(float value)
+	{
+		m_Epsilon = value;
+	}
+
 protected:
 	virtual float ScaleFov(int width, int height, float fov) { return fov; }
 
@@ -128,17 +152,26 @@ protected:
 
 	void MarkHidden(int value);
 
-private:
-	static CClientTools * m_Instance;
+	/// <summary>Writes "entity_state" and the handle, the entity's state follows until EndEntityState.</summary>
+	void BeginEntityState(int handle);
 
-	std::map<std::string, int> m_Dictionary;
+	/// <summary>Writes "/".</summary>
+	void EndEntityState(void);
 
-	size_t m_HiddenFileOffset;
-	std::set<int> m_Hidden;
+	/// <summary>Writes "deleted" and the handle.</summary>
+	void WriteDeleted(int handle);
+
+private:
+	static CClientTools * m_Instance;
 
 	bool m_EnableRecording = false;
 	bool m_Recording;
-	FILE * m_File;
+	FILE * m_File = 0;
+
+	int m_Version = 4;
+	float m_Epsilon = 0.0f;
+
+	CAfxGameRecording m_GameRecording;
 
 	int m_Debug = 0;
 	bool m_RecordCamera = true;
@@ -147,27 +180,6 @@ private:
 	bool m_RecordProjectiles = true;
 	bool m_RecordViewModel = false;
 	bool m_RecordInvisible = false;
-
-	void Dictionary_Clear()
-	{
-		m_Dictionary.clear();
-	}
-
-	int Dictionary_Get(char const * value)
-	{
-		std::string sValue(value);
-
-		std::map<std::string, int>::iterator it = m_Dictionary.find(sValue);
-
-		if (it != m_Dictionary.end())
-		{
-			const std::pair<const std::string, int> & pair = *it;
-			return pair.second;
-		}
-
-		m_Dictionary[sValue] = m_Dictionary.size();
-		return -1;
-	}
 };
 
 bool ClientTools_Console_Cfg(IWrpCommandArgs * args);
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "WrpConsole.h"
+class IWrpCommandArgs;
 
 double Auto_FovScaling(double width, double height, double fov);
 
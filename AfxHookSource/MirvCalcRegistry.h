@@ -0,0 +1,104 @@
+#pragma once
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// Calcs of one kind, looked up by case-insensitive name through a hash map
+/// or by a stable id (ids are not reused after a calc is removed).
+/// </summary>
+/// <remarks>
+/// T only needs a GetName() returning char const *, names must be unique.<br />
+/// The id table is not compacted: it grows by one pointer for every calc
+/// ever added (removed calcs leave a 0 entry), so ids stay plain indices.
+/// Even 100000 calcs added over a session only take 800 KiB.
+/// </remarks>
+template<class T> class CMirvCalcRegistry
+{
+public:
+	typedef typename std::list<T *>::iterator iterator;
+
+	iterator begin()
+	{
+		return m_Calcs.begin();
+	}
+
+	iterator end()
+	{
+		return m_Calcs.end();
+	}
+
+	/// <returns>end() if not found.</returns>
+	iterator Find(char const * name)
+	{
+		typename std::unordered_map<std::string, CEntry>::iterator it = m_ByName.find(MakeKey(name));
+
+		return it != m_ByName.end() ? it->second.It : m_Calcs.end();
+	}
+
+	/// <returns>0 if not found.</returns>
+	T * GetById(int id)
+	{
+		return 1 <= id && id <= (int)m_ById.size() ? m_ById[id - 1] : 0;
+	}
+
+	/// <returns>0 if not found, otherwise the id.</returns>
+	int GetId(char const * name)
+	{
+		typename std::unordered_map<std::string, CEntry>::iterator it = m_ByName.find(MakeKey(name));
+
+		return it != m_ByName.end() ? it->second.Id : 0;
+	}
+
+	void Add(T * calc)
+	{
+		m_ById.push_back(calc);
+
+		CEntry & entry = m_ByName[MakeKey(calc->GetName())];
+		entry.It = m_Calcs.insert(m_Calcs.end(), calc);
+		entry.Id = (int)m_ById.size();
+	}
+
+	void Erase(iterator it)
+	{
+		typename std::unordered_map<std::string, CEntry>::iterator itName = m_ByName.find(MakeKey((*it)->GetName()));
+
+		if (itName != m_ByName.end())
+		{
+			m_ById[itName->second.Id - 1] = 0;
+			m_ByName.erase(itName);
+		}
+
+		m_Calcs.erase(it);
+	}
+
+private:
+	struct CEntry
+	{
+		iterator It;
+		int Id;
+	};
+
+	std::list<T *> m_Calcs;
+	std::unordered_map<std::string, CEntry> m_ByName;
+	std::vector<T *> m_ById;
+
+	/// <summary>Reused by MakeKey, so lookups don't allocate.</summary>
+	std::string m_Key;
+
+	/// <returns>Lower case name, valid until the next call.</returns>
+	std::string const & MakeKey(char const * name)
+	{
+		m_Key.clear();
+
+		for (; *name; ++name)
+		{
+			char c = *name;
+			m_Key.push_back('A' <= c && c <= 'Z' ? (char)(c - 'A' + 'a') : c);
+		}
+
+		return m_Key;
+	}
+};
@@ -20,6 +20,11 @@
 
 extern WrpVEngineClient * g_VEngineClient;
 
+static void MirvCalcs_PrintStats(char const * type, IMirvCalc * calc)
+{
+	Tier0_Msg("%-6s %-32s %10u %10u\n", type, calc->GetName(), calc->GetEvaluations(), calc->GetCacheHits());
+}
+
 CMirvHandleCalcs g_MirvHandleCalcs;
 CMirvVecAngCalcs g_MirvVecAngCalcs;
 CMirvCamCalcs g_MirvCamCalcs;
@@ -347,6 +352,18 @@ void MatrixAngles(const SOURCESDK::matrix3x4_t & matrix, SOURCESDK::QAngle & ang
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// 0 means no frame started yet, in which case nothing is cached.
+static unsigned int g_MirvCalcs_Frame = 0;
+
+// Set when the current evaluation read state that can change within a frame.
+static bool g_MirvCalcs_VolatileTouched = false;
+
+void MirvCalcs_OnBeforeFrameRenderStart(void)
+{
+	++g_MirvCalcs_Frame;
+	if (0 == g_MirvCalcs_Frame) g_MirvCalcs_Frame = 1;
+}
+
 class CMirvCalc : public IMirvCalc
 {
 public:
@@ -375,6 +392,22 @@ public:
 		return m_RefCount;
 	}
 
+	virtual unsigned int GetEvaluations(void)
+	{
+		return m_Evaluations;
+	}
+
+	virtual unsigned int GetCacheHits(void)
+	{
+		return m_CacheHits;
+	}
+
+	virtual void ResetStats(void)
+	{
+		m_Evaluations = 0;
+		m_CacheHits = 0;
+	}
+
 	virtual  char const * GetName(void)
 	{
 		return m_Name.c_str();
@@ -402,10 +435,49 @@ protected:
 
 	}
 
+	/// <returns>true if there is a result from the current frame.</returns>
+	bool Cache_Lookup(void)
+	{
+		if (0 != g_MirvCalcs_Frame && m_CacheFrame == g_MirvCalcs_Frame)
+		{
+			++m_CacheHits;
+			return true;
+		}
+
+		return false;
+	}
+
+	/// <summary>Call before evaluating, pass the result to Cache_EndEval.</summary>
+	bool Cache_BeginEval(void)
+	{
+		bool outerVolatile = g_MirvCalcs_VolatileTouched;
+		g_MirvCalcs_VolatileTouched = false;
+		++m_Evaluations;
+		return outerVolatile;
+	}
+
+	void Cache_EndEval(bool outerVolatile)
+	{
+		m_CacheFrame = g_MirvCalcs_VolatileTouched ? 0 : g_MirvCalcs_Frame;
+		g_MirvCalcs_VolatileTouched = g_MirvCalcs_VolatileTouched || outerVolatile;
+	}
+
+	/// <summary>
+	/// Calcs that read state which can change within a frame (e.g. the current view) must call this when evaluating,
+	/// so neither their result nor the results of calcs depending on them are cached.
+	/// </summary>
+	static void Cache_MarkVolatile(void)
+	{
+		g_MirvCalcs_VolatileTouched = true;
+	}
+
 private:
 	bool m_HasName;
 	std::string m_Name;
 	int m_RefCount = 0;
+	unsigned int m_CacheFrame = 0;
+	unsigned int m_Evaluations = 0;
+	unsigned int m_CacheHits = 0;
 };
 
 class CMirvHandleCalc : public CMirvCalc, public IMirvHandleCalc
@@ -432,6 +504,21 @@ public:
 		return CMirvCalc::GetRefCount();
 	}
 
+	virtual unsigned int GetEvaluations(void)
+	{
+		return CMirvCalc::GetEvaluations();
+	}
+
+	virtual unsigned int GetCacheHits(void)
+	{
+		return CMirvCalc::GetCacheHits();
+	}
+
+	virtual void ResetStats(void)
+	{
+		CMirvCalc::ResetStats();
+	}
+
 	virtual  char const * GetName(void)
 	{
 		return CMirvCalc::GetName();
@@ -448,15 +535,38 @@ public:
 		CMirvCalc::Console_PrintEnd();
 	}
 
+	/// <summary>Evaluates at most once per frame, see DoCalcHandle.</summary>
 	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
-		return false;
+		if (!Cache_Lookup())
+		{
+			bool outerVolatile = Cache_BeginEval();
+			m_CachedOk = DoCalcHandle(m_CachedHandle);
+			Cache_EndEval(outerVolatile);
+		}
+
+		if (m_CachedOk)
+		{
+			outHandle = m_CachedHandle;
+		}
+
+		return m_CachedOk;
 	}
 
 	virtual void Console_Edit(IWrpCommandArgs * args)
 	{
 		CMirvCalc::Console_Edit(args);
 	}
+
+protected:
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	{
+		return false;
+	}
+
+private:
+	bool m_CachedOk = false;
+	SOURCESDK::CSGO::CBaseHandle m_CachedHandle;
 };
 
 
@@ -470,7 +580,7 @@ public:
 
 	}
 
-	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		outHandle = m_Handle;
 		return true;
@@ -529,7 +639,7 @@ public:
 
 	}
 
-	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		SOURCESDK::IClientEntity_csgo * ce = SOURCESDK::g_Entitylist_csgo->GetClientEntity(m_Index);
 
@@ -599,7 +709,7 @@ public:
 
 	}
 
-	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		// Left screen side keys: 1, 2, 3, 4, 5
 		// Right screen side keys: 6, 7, 8, 9, 0
@@ -711,7 +821,7 @@ public:
 
 	}
 
-	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		SOURCESDK::CSGO::CBaseHandle parentHandle;
 
@@ -806,7 +916,7 @@ public:
 	{
 	}
 
-	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		SOURCESDK::IClientEntity_csgo * ce = SOURCESDK::g_Entitylist_csgo->GetClientEntity(g_VEngineClient->GetLocalPlayer());
 
@@ -851,7 +961,7 @@ public:
 
 	}
 
-	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		SOURCESDK::CSGO::CBaseHandle parentHandle;
 
@@ -914,7 +1024,7 @@ public:
 
 	}
 
-	virtual bool CalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
+	virtual bool DoCalcHandle(SOURCESDK::CSGO::CBaseHandle & outHandle)
 	{
 		SOURCESDK::CSGO::CBaseHandle parentHandle;
 
@@ -1001,6 +1111,21 @@ public:
 		return CMirvCalc::GetRefCount();
 	}
 
+	virtual unsigned int GetEvaluations(void)
+	{
+		return CMirvCalc::GetEvaluations();
+	}
+
+	virtual unsigned int GetCacheHits(void)
+	{
+		return CMirvCalc::GetCacheHits();
+	}
+
+	virtual void ResetStats(void)
+	{
+		CMirvCalc::ResetStats();
+	}
+
 	virtual  char const * GetName(void)
 	{
 		return CMirvCalc::GetName();
@@ -1017,15 +1142,40 @@ public:
 		CMirvCalc::Console_PrintEnd();
 	}
 
+	/// <summary>Evaluates at most once per frame, see DoCalcVecAng.</summary>
 	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
-		return false;
+		if (!Cache_Lookup())
+		{
+			bool outerVolatile = Cache_BeginEval();
+			m_CachedOk = DoCalcVecAng(m_CachedVector, m_CachedAngles);
+			Cache_EndEval(outerVolatile);
+		}
+
+		if (m_CachedOk)
+		{
+			outVector = m_CachedVector;
+			outAngles = m_CachedAngles;
+		}
+
+		return m_CachedOk;
 	}
 
 	virtual void Console_Edit(IWrpCommandArgs * args)
 	{
 		CMirvCalc::Console_Edit(args);
 	}
+
+protected:
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	{
+		return false;
+	}
+
+private:
+	bool m_CachedOk = false;
+	SOURCESDK::Vector m_CachedVector;
+	SOURCESDK::QAngle m_CachedAngles;
 };
 
 
@@ -1053,6 +1203,21 @@ public:
 		return CMirvCalc::GetRefCount();
 	}
 
+	virtual unsigned int GetEvaluations(void)
+	{
+		return CMirvCalc::GetEvaluations();
+	}
+
+	virtual unsigned int GetCacheHits(void)
+	{
+		return CMirvCalc::GetCacheHits();
+	}
+
+	virtual void ResetStats(void)
+	{
+		CMirvCalc::ResetStats();
+	}
+
 	virtual  char const * GetName(void)
 	{
 		return CMirvCalc::GetName();
@@ -1069,15 +1234,42 @@ public:
 		CMirvCalc::Console_PrintEnd();
 	}
 
+	/// <summary>Evaluates at most once per frame, see DoCalcCam.</summary>
 	virtual bool CalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
 	{
-		return false;
+		if (!Cache_Lookup())
+		{
+			bool outerVolatile = Cache_BeginEval();
+			m_CachedOk = DoCalcCam(m_CachedVector, m_CachedAngles, m_CachedFov);
+			Cache_EndEval(outerVolatile);
+		}
+
+		if (m_CachedOk)
+		{
+			outVector = m_CachedVector;
+			outAngles = m_CachedAngles;
+			outFov = m_CachedFov;
+		}
+
+		return m_CachedOk;
 	}
 
 	virtual void Console_Edit(IWrpCommandArgs * args)
 	{
 		CMirvCalc::Console_Edit(args);
 	}
+
+protected:
+	virtual bool DoCalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
+	{
+		return false;
+	}
+
+private:
+	bool m_CachedOk = false;
+	SOURCESDK::Vector m_CachedVector;
+	SOURCESDK::QAngle m_CachedAngles;
+	float m_CachedFov;
 };
 
 double CalcExpSmooth(double deltaT, double oldVal, double newVal)
@@ -1204,7 +1396,7 @@ public:
 		);
 	}
 
-	virtual bool CalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov) override
+	virtual bool DoCalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov) override
 	{
 		SOURCESDK::Vector parentVector;
 		SOURCESDK::QAngle parentAngles;
@@ -1364,7 +1556,7 @@ public:
 		CMirvCamCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov) override
+	virtual bool DoCalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov) override
 	{
 		SOURCESDK::Vector parentVector;
 		SOURCESDK::QAngle parentAngles;
@@ -1426,6 +1618,21 @@ public:
 		return CMirvCalc::GetRefCount();
 	}
 
+	virtual unsigned int GetEvaluations(void)
+	{
+		return CMirvCalc::GetEvaluations();
+	}
+
+	virtual unsigned int GetCacheHits(void)
+	{
+		return CMirvCalc::GetCacheHits();
+	}
+
+	virtual void ResetStats(void)
+	{
+		CMirvCalc::ResetStats();
+	}
+
 	virtual  char const * GetName(void)
 	{
 		return CMirvCalc::GetName();
@@ -1442,15 +1649,38 @@ public:
 		CMirvCalc::Console_PrintEnd();
 	}
 
+	/// <summary>Evaluates at most once per frame, see DoCalcFov.</summary>
 	virtual bool CalcFov(float & outFov)
 	{
-		return false;
+		if (!Cache_Lookup())
+		{
+			bool outerVolatile = Cache_BeginEval();
+			m_CachedOk = DoCalcFov(m_CachedFov);
+			Cache_EndEval(outerVolatile);
+		}
+
+		if (m_CachedOk)
+		{
+			outFov = m_CachedFov;
+		}
+
+		return m_CachedOk;
 	}
 
 	virtual void Console_Edit(IWrpCommandArgs * args)
 	{
 		CMirvCalc::Console_Edit(args);
 	}
+
+protected:
+	virtual bool DoCalcFov(float & outFov)
+	{
+		return false;
+	}
+
+private:
+	bool m_CachedOk = false;
+	float m_CachedFov;
 };
 
 class CMirvVecAngValueCalc : public CMirvVecAngCalc
@@ -1474,7 +1704,7 @@ public:
 		Tier0_Msg(", fn: \"value\", x: %f, y: %f, z: %f, rX: %f, rY: %f, rZ: %f", m_Vec.x, m_Vec.y, m_Vec.z, m_Ang.z, m_Ang.x, m_Ang.y);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		outVector = m_Vec;
 		outAngles = m_Ang;
@@ -1668,7 +1898,7 @@ public:
 		);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::Vector parentVector;
 		SOURCESDK::QAngle parentAngles;
@@ -1821,7 +2051,7 @@ public:
 		);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::CSGO::CBaseHandle handle;
 		bool calcedHandle = m_Handle->CalcHandle(handle);
@@ -1903,7 +2133,7 @@ public:
 		);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::CSGO::CBaseHandle handle;
 		bool calcedHandle = m_Handle->CalcHandle(handle);
@@ -1956,7 +2186,7 @@ public:
 		Tier0_Msg(", false: "); m_CondFalse->Console_PrintBegin(); m_CondFalse->Console_PrintEnd();
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		bool condition;
 
@@ -2003,7 +2233,7 @@ public:
 		Tier0_Msg(", b: "); m_B->Console_PrintBegin(); m_B->Console_PrintEnd();
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		return m_A->CalcVecAng(outVector, outAngles) || m_B->CalcVecAng(outVector, outAngles);
 	}
@@ -2212,7 +2442,7 @@ public:
 		);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::Vector parentVector;
 		SOURCESDK::QAngle parentAngles;
@@ -2356,7 +2586,7 @@ public:
 		CMirvVecAngCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::Vector aVector;
 		SOURCESDK::QAngle aAngles;
@@ -2430,7 +2660,7 @@ public:
 		CMirvVecAngCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::Vector sourceVector;
 		SOURCESDK::QAngle sourceAngles;
@@ -2566,7 +2796,7 @@ public:
 		);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::CSGO::CBaseHandle handle;
 		SOURCESDK::CSGO::CBaseHandle resetHandle;
@@ -2720,7 +2950,7 @@ public:
 		CMirvVecAngCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::CSGO::CBaseHandle handle;
 		SOURCESDK::Vector sourceVector;
@@ -2798,7 +3028,7 @@ public:
 		CMirvVecAngCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		SOURCESDK::CSGO::CBaseHandle handle;
 		SOURCESDK::Vector sourceVector;
@@ -2946,7 +3176,7 @@ public:
 		);
 	}
 
-	virtual bool CalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
+	virtual bool DoCalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
 	{
 		CamIO::CamData outCamData;
 
@@ -3007,8 +3237,10 @@ public:
 		CMirvCamCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
+	virtual bool DoCalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
 	{
+		Cache_MarkVolatile();
+
 		outVector.x = g_Hook_VClient_RenderView.GameCameraOrigin[0];
 		outVector.y = g_Hook_VClient_RenderView.GameCameraOrigin[1];
 		outVector.z = g_Hook_VClient_RenderView.GameCameraOrigin[2];
@@ -3050,8 +3282,10 @@ public:
 		CMirvCamCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
+	virtual bool DoCalcCam(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles, float & outFov)
 	{
+		Cache_MarkVolatile();
+
 		outVector.x = (float)g_Hook_VClient_RenderView.CurrentCameraOrigin[0];
 		outVector.y = (float)g_Hook_VClient_RenderView.CurrentCameraOrigin[1];
 		outVector.z = (float)g_Hook_VClient_RenderView.CurrentCameraOrigin[2];
@@ -3095,7 +3329,7 @@ public:
 		CMirvVecAngCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
+	virtual bool DoCalcVecAng(SOURCESDK::Vector & outVector, SOURCESDK::QAngle & outAngles)
 	{
 		float dummyFov;
 
@@ -3135,7 +3369,7 @@ public:
 		CMirvFovCalc::Console_Edit(args);
 	}
 
-	virtual bool CalcFov(float & outFov)
+	virtual bool DoCalcFov(float & outFov)
 	{
 		SOURCESDK::Vector dummyVector;
 		SOURCESDK::QAngle dummyAngles;
@@ -3177,6 +3411,21 @@ public:
 		return CMirvCalc::GetRefCount();
 	}
 
+	virtual unsigned int GetEvaluations(void)
+	{
+		return CMirvCalc::GetEvaluations();
+	}
+
+	virtual unsigned int GetCacheHits(void)
+	{
+		return CMirvCalc::GetCacheHits();
+	}
+
+	virtual void ResetStats(void)
+	{
+		CMirvCalc::ResetStats();
+	}
+
 	virtual  char const * GetName(void)
 	{
 		return CMirvCalc::GetName();
@@ -3194,15 +3443,38 @@ public:
 		CMirvCalc::Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(void)
+	/// <summary>Evaluates at most once per frame, see DoCalcBool.</summary>
+	virtual bool CalcBool(bool & outResult)
 	{
-		return false;
+		if (!Cache_Lookup())
+		{
+			bool outerVolatile = Cache_BeginEval();
+			m_CachedOk = DoCalcBool(m_CachedResult);
+			Cache_EndEval(outerVolatile);
+		}
+
+		if (m_CachedOk)
+		{
+			outResult = m_CachedResult;
+		}
+
+		return m_CachedOk;
 	}
 
 	virtual void Console_Edit(IWrpCommandArgs * args)
 	{
 		CMirvCalc::Console_Edit(args);
 	}
+
+protected:
+	virtual bool DoCalcBool(bool & outResult)
+	{
+		return false;
+	}
+
+private:
+	bool m_CachedOk = false;
+	bool m_CachedResult;
 };
 
 class CMirvBoolAndCalc : public CMirvBoolCalc
@@ -3226,7 +3498,7 @@ public:
 		Tier0_Msg(", calcB: "); m_CalcB->Console_PrintBegin(); m_CalcB->Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		bool calcValueA, calcValueB;
 
@@ -3272,7 +3544,7 @@ public:
 		Tier0_Msg(", calcB: "); m_CalcB->Console_PrintBegin(); m_CalcB->Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		bool calcValueA, calcValueB;
 
@@ -3322,7 +3594,7 @@ public:
 
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		bool calcValue;
 
@@ -3363,7 +3635,7 @@ public:
 		Tier0_Msg(", handle: "); m_Handle->Console_PrintBegin(); m_Handle->Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		SOURCESDK::CSGO::CBaseHandle dummy;
 
@@ -3400,7 +3672,7 @@ public:
 		Tier0_Msg(", vecAng: "); m_VecAng->Console_PrintBegin(); m_VecAng->Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		SOURCESDK::Vector dummyVec;
 		SOURCESDK::QAngle dummyAng;
@@ -3438,7 +3710,7 @@ public:
 		Tier0_Msg(", handle: "); m_Handle->Console_PrintBegin(); m_Handle->Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		SOURCESDK::CSGO::CBaseHandle parentHandle;
 
@@ -3488,7 +3760,7 @@ public:
 		Tier0_Msg(", calcB: "); m_CalcB->Console_PrintBegin(); m_CalcB->Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		SOURCESDK::CSGO::CBaseHandle calcValueA, calcValueB;
 
@@ -3534,7 +3806,7 @@ public:
 		Tier0_Msg(", calcB: "); m_CalcB->Console_PrintBegin(); m_CalcB->Console_PrintEnd();
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		int calcValueA, calcValueB;
 
@@ -3580,7 +3852,7 @@ public:
 		Tier0_Msg(", wildCardString: \"%s\"", m_WildCardString.c_str());
 	}
 
-	virtual bool CalcBool(bool & outResult)
+	virtual bool DoCalcBool(bool & outResult)
 	{
 		SOURCESDK::CSGO::CBaseHandle handle;
 
@@ -3635,6 +3907,21 @@ public:
 		return CMirvCalc::GetRefCount();
 	}
 
+	virtual unsigned int GetEvaluations(void)
+	{
+		return CMirvCalc::GetEvaluations();
+	}
+
+	virtual unsigned int GetCacheHits(void)
+	{
+		return CMirvCalc::GetCacheHits();
+	}
+
+	virtual void ResetStats(void)
+	{
+		CMirvCalc::ResetStats();
+	}
+
 	virtual  char const * GetName(void)
 	{
 		return CMirvCalc::GetName();
@@ -3652,15 +3939,38 @@ public:
 		CMirvCalc::Console_PrintEnd();
 	}
 
-	virtual bool CalcInt(void)
+	/// <summary>Evaluates at most once per frame, see DoCalcInt.</summary>
+	virtual bool CalcInt(int & outResult)
 	{
-		return false;
+		if (!Cache_Lookup())
+		{
+			bool outerVolatile = Cache_BeginEval();
+			m_CachedOk = DoCalcInt(m_CachedResult);
+			Cache_EndEval(outerVolatile);
+		}
+
+		if (m_CachedOk)
+		{
+			outResult = m_CachedResult;
+		}
+
+		return m_CachedOk;
 	}
 
 	virtual void Console_Edit(IWrpCommandArgs * args)
 	{
 		CMirvCalc::Console_Edit(args);
 	}
+
+protected:
+	virtual bool DoCalcInt(int & outResult)
+	{
+		return false;
+	}
+
+private:
+	bool m_CachedOk = false;
+	int m_CachedResult;
 };
 
 
@@ -3680,7 +3990,7 @@ public:
 		Tier0_Msg(", fn: \"value\", value: %i", m_Value);
 	}
 
-	virtual bool CalcInt(int & outResult)
+	virtual bool DoCalcInt(int & outResult)
 	{
 		outResult = m_Value;
 
@@ -3714,7 +4024,7 @@ public:
 		Tier0_Msg(", handle: "); m_Handle->Console_PrintBegin(); m_Handle->Console_PrintEnd();
 	}
 
-	virtual bool CalcInt(int & outResult)
+	virtual bool DoCalcInt(int & outResult)
 	{
 		SOURCESDK::CSGO::CBaseHandle parentHandle;
 
@@ -3746,7 +4056,7 @@ private:
 
 CMirvHandleCalcs::~CMirvHandleCalcs()
 {
-	for (std::list<IMirvHandleCalc *>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	for (CMirvCalcRegistry<IMirvHandleCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
 		(*it)->Release();
 	}
@@ -3754,8 +4064,7 @@ CMirvHandleCalcs::~CMirvHandleCalcs()
 
 IMirvHandleCalc * CMirvHandleCalcs::GetByName(char const * name)
 {
-	std::list<IMirvHandleCalc *>::iterator it;
-	GetIteratorByName(name, it);
+	CMirvCalcRegistry<IMirvHandleCalc>::iterator it = m_Calcs.Find(name);
 	if (it != m_Calcs.end())
 	{
 		return *it;
@@ -3764,6 +4073,16 @@ IMirvHandleCalc * CMirvHandleCalcs::GetByName(char const * name)
 	return 0;
 }
 
+IMirvHandleCalc * CMirvHandleCalcs::GetById(int id)
+{
+	return m_Calcs.GetById(id);
+}
+
+int CMirvHandleCalcs::GetId(char const * name)
+{
+	return m_Calcs.GetId(name);
+}
+
 IMirvHandleCalc * CMirvHandleCalcs::NewValueCalc(char const * name, int handle)
 {
 	if (name && !Console_CheckName(name))
@@ -3775,7 +4094,7 @@ IMirvHandleCalc * CMirvHandleCalcs::NewValueCalc(char const * name, int handle)
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -3792,7 +4111,7 @@ IMirvHandleCalc * CMirvHandleCalcs::NewIndexCalc(char const * name, int entityIn
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -3809,7 +4128,7 @@ IMirvHandleCalc * CMirvHandleCalcs::NewActiveWeaponCalc(char const * name, IMirv
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -3826,7 +4145,7 @@ IMirvHandleCalc *  CMirvHandleCalcs::NewLocalPlayerCalc(char const * name)
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -3843,7 +4162,7 @@ IMirvHandleCalc *  CMirvHandleCalcs::NewObserverTargetCalc(char const * name, IM
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -3860,7 +4179,7 @@ IMirvHandleCalc *  CMirvHandleCalcs::NewOwnerEntityCalc(char const * name, IMirv
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -3879,7 +4198,7 @@ IMirvHandleCalc * CMirvHandleCalcs::NewKeyCalc(char const * name, int key)
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -3887,14 +4206,13 @@ IMirvHandleCalc * CMirvHandleCalcs::NewKeyCalc(char const * name, int key)
 
 void CMirvHandleCalcs::Console_Remove(char const * name)
 {
-	std::list<IMirvHandleCalc *>::iterator it;
-	GetIteratorByName(name, it);
+	CMirvCalcRegistry<IMirvHandleCalc>::iterator it = m_Calcs.Find(name);
 	if (it != m_Calcs.end())
 	{
 		if (1 == (*it)->GetRefCount())
 		{
 			(*it)->Release();
-			m_Calcs.erase(it);
+			m_Calcs.Erase(it);
 		}
 		else
 			Tier0_Warning("Error: Cannot remove %s: Still in use.\n", (*it)->GetName());
@@ -3936,25 +4254,33 @@ bool CMirvHandleCalcs::Console_CheckName(char const * name)
 
 void CMirvHandleCalcs::Console_Print(void)
 {
-	for (std::list<IMirvHandleCalc *>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	for (CMirvCalcRegistry<IMirvHandleCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
 		(*it)->Console_PrintBegin(); (*it)->Console_PrintEnd(); Tier0_Msg(";\n");
 	}
 }
 
-void CMirvHandleCalcs::GetIteratorByName(char const * name, std::list<IMirvHandleCalc *>::iterator & outIt)
+void CMirvHandleCalcs::Console_PrintStats(void)
 {
-	for (outIt = m_Calcs.begin(); outIt != m_Calcs.end(); ++outIt)
+	for (CMirvCalcRegistry<IMirvHandleCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
-		if (0 == _stricmp(name, (*outIt)->GetName()))
-			break;
+		MirvCalcs_PrintStats("handle", *it);
+	}
+}
+
+void CMirvHandleCalcs::ResetStats(void)
+{
+	for (CMirvCalcRegistry<IMirvHandleCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	{
+		(*it)->ResetStats();
 	}
 }
 
 
+
 CMirvVecAngCalcs::~CMirvVecAngCalcs()
 {
-	for (std::list<IMirvVecAngCalc *>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	for (CMirvCalcRegistry<IMirvVecAngCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
 		(*it)->Release();
 	}
@@ -3962,8 +4288,7 @@ CMirvVecAngCalcs::~CMirvVecAngCalcs()
 
 IMirvVecAngCalc * CMirvVecAngCalcs::GetByName(char const * name)
 {
-	std::list<IMirvVecAngCalc *>::iterator it;
-	GetIteratorByName(name, it);
+	CMirvCalcRegistry<IMirvVecAngCalc>::iterator it = m_Calcs.Find(name);
 	if (it != m_Calcs.end())
 	{
 		return *it;
@@ -3972,6 +4297,16 @@ IMirvVecAngCalc * CMirvVecAngCalcs::GetByName(char const * name)
 	return 0;
 }
 
+IMirvVecAngCalc * CMirvVecAngCalcs::GetById(int id)
+{
+	return m_Calcs.GetById(id);
+}
+
+int CMirvVecAngCalcs::GetId(char const * name)
+{
+	return m_Calcs.GetId(name);
+}
+
 IMirvVecAngCalc * CMirvVecAngCalcs::NewValueCalc(char const * name, float x, float y, float z, float rX, float rY, float rZ)
 {
 	if (name && !Console_CheckName(name))
@@ -3983,7 +4318,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewValueCalc(char const * name, float x, flo
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4000,7 +4335,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewAddCalc(char const * name, IMirvVecAngCal
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4017,7 +4352,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewSubtractCalc(char const * name, IMirvVecA
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4035,7 +4370,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewOffsetCalc(char const * name, IMirvVecAng
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4052,7 +4387,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewHandleCalc(char const * name, IMirvHandle
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4069,7 +4404,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewHandleEyeCalc(char const * name, IMirvHan
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4086,7 +4421,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewHandleCalcEx(char const * name, IMirvHand
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4103,7 +4438,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewHandleAttachmentCalc(char const * name, I
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4120,7 +4455,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewIfCalc(char const * name, IMirvBoolCalc *
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4137,7 +4472,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewOrCalc(char const * name, IMirvVecAngCalc
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4154,7 +4489,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewCamCalc(char const * name, IMirvCamCalc *
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4171,7 +4506,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewMotionProfile2Calc(char const * name, IMi
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4188,7 +4523,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewSwitchInterpCalc(char const * name, IMirv
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4205,7 +4540,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewLocalToGlobalCalc(char const * name, IMir
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4222,7 +4557,7 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewGlobalToLocalCalc(char const * name, IMir
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4230,14 +4565,13 @@ IMirvVecAngCalc * CMirvVecAngCalcs::NewGlobalToLocalCalc(char const * name, IMir
 
 void CMirvVecAngCalcs::Console_Remove(char const * name)
 {
-	std::list<IMirvVecAngCalc *>::iterator it;
-	GetIteratorByName(name, it);
+	CMirvCalcRegistry<IMirvVecAngCalc>::iterator it = m_Calcs.Find(name);
 	if (it != m_Calcs.end())
 	{
 		if (1 == (*it)->GetRefCount())
 		{
 			(*it)->Release();
-			m_Calcs.erase(it);
+			m_Calcs.Erase(it);
 		}
 		else
 			Tier0_Warning("Error: Cannot remove %s: Still in use.\n", (*it)->GetName());
@@ -4279,26 +4613,34 @@ bool CMirvVecAngCalcs::Console_CheckName(char const * name)
 
 void CMirvVecAngCalcs::Console_Print(void)
 {
-	for (std::list<IMirvVecAngCalc *>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	for (CMirvCalcRegistry<IMirvVecAngCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
 		(*it)->Console_PrintBegin(); (*it)->Console_PrintEnd(); Tier0_Msg(";\n");
 	}
 }
 
-void CMirvVecAngCalcs::GetIteratorByName(char const * name, std::list<IMirvVecAngCalc *>::iterator & outIt)
+void CMirvVecAngCalcs::Console_PrintStats(void)
+{
+	for (CMirvCalcRegistry<IMirvVecAngCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	{
+		MirvCalcs_PrintStats("vecAng", *it);
+	}
+}
+
+void CMirvVecAngCalcs::ResetStats(void)
 {
-	for (outIt = m_Calcs.begin(); outIt != m_Calcs.end(); ++outIt)
+	for (CMirvCalcRegistry<IMirvVecAngCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
-		if (0 == _stricmp(name, (*outIt)->GetName()))
-			break;
+		(*it)->ResetStats();
 	}
 }
 
 
 
+
 CMirvCamCalcs::~CMirvCamCalcs()
 {
-	for (std::list<IMirvCamCalc *>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	for (CMirvCalcRegistry<IMirvCamCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
 		(*it)->Release();
 	}
@@ -4306,8 +4648,7 @@ CMirvCamCalcs::~CMirvCamCalcs()
 
 IMirvCamCalc * CMirvCamCalcs::GetByName(char const * name)
 {
-	std::list<IMirvCamCalc *>::iterator it;
-	GetIteratorByName(name, it);
+	CMirvCalcRegistry<IMirvCamCalc>::iterator it = m_Calcs.Find(name);
 	if (it != m_Calcs.end())
 	{
 		return *it;
@@ -4316,6 +4657,16 @@ IMirvCamCalc * CMirvCamCalcs::GetByName(char const * name)
 	return 0;
 }
 
+IMirvCamCalc * CMirvCamCalcs::GetById(int id)
+{
+	return m_Calcs.GetById(id);
+}
+
+int CMirvCamCalcs::GetId(char const * name)
+{
+	return m_Calcs.GetId(name);
+}
+
 IMirvCamCalc * CMirvCamCalcs::NewCamCalc(char const * name, const char * camFileName, const char * startClientTime)
 {
 	if (name && !Console_CheckName(name))
@@ -4329,7 +4680,7 @@ IMirvCamCalc * CMirvCamCalcs::NewCamCalc(char const * name, const char * camFile
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4346,7 +4697,7 @@ IMirvCamCalc * CMirvCamCalcs::NewGameCalc(char const * name)
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4364,7 +4715,7 @@ IMirvCamCalc * CMirvCamCalcs::NewCurrentCalc(char const * name)
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4381,7 +4732,7 @@ IMirvCamCalc * CMirvCamCalcs::NewSmoothCalc(char const * name, IMirvCamCalc * pa
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4398,7 +4749,7 @@ IMirvCamCalc * CMirvCamCalcs::NewVecAngFovCalc(char const * name, IMirvVecAngCal
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4407,14 +4758,13 @@ IMirvCamCalc * CMirvCamCalcs::NewVecAngFovCalc(char const * name, IMirvVecAngCal
 
 void CMirvCamCalcs::Console_Remove(char const * name)
 {
-	std::list<IMirvCamCalc *>::iterator it;
-	GetIteratorByName(name, it);
+	CMirvCalcRegistry<IMirvCamCalc>::iterator it = m_Calcs.Find(name);
 	if (it != m_Calcs.end())
 	{
 		if (1 == (*it)->GetRefCount())
 		{
 			(*it)->Release();
-			m_Calcs.erase(it);
+			m_Calcs.Erase(it);
 		}
 		else
 			Tier0_Warning("Error: Cannot remove %s: Still in use.\n", (*it)->GetName());
@@ -4456,25 +4806,33 @@ bool CMirvCamCalcs::Console_CheckName(char const * name)
 
 void CMirvCamCalcs::Console_Print(void)
 {
-	for (std::list<IMirvCamCalc *>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	for (CMirvCalcRegistry<IMirvCamCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
 		(*it)->Console_PrintBegin(); (*it)->Console_PrintEnd(); Tier0_Msg(";\n");
 	}
 }
 
-void CMirvCamCalcs::GetIteratorByName(char const * name, std::list<IMirvCamCalc *>::iterator & outIt)
+void CMirvCamCalcs::Console_PrintStats(void)
 {
-	for (outIt = m_Calcs.begin(); outIt != m_Calcs.end(); ++outIt)
+	for (CMirvCalcRegistry<IMirvCamCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
-		if (0 == _stricmp(name, (*outIt)->GetName()))
-			break;
+		MirvCalcs_PrintStats("cam", *it);
+	}
+}
+
+void CMirvCamCalcs::ResetStats(void)
+{
+	for (CMirvCalcRegistry<IMirvCamCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	{
+		(*it)->ResetStats();
 	}
 }
 
 
+
 CMirvFovCalcs::~CMirvFovCalcs()
 {
-	for (std::list<IMirvFovCalc *>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	for (CMirvCalcRegistry<IMirvFovCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
 		(*it)->Release();
 	}
@@ -4482,8 +4840,7 @@ CMirvFovCalcs::~CMirvFovCalcs()
 
 IMirvFovCalc * CMirvFovCalcs::GetByName(char const * name)
 {
-	std::list<IMirvFovCalc *>::iterator it;
-	GetIteratorByName(name, it);
+	CMirvCalcRegistry<IMirvFovCalc>::iterator it = m_Calcs.Find(name);
 	if (it != m_Calcs.end())
 	{
 		return *it;
@@ -4492,6 +4849,16 @@ IMirvFovCalc * CMirvFovCalcs::GetByName(char const * name)
 	return 0;
 }
 
+IMirvFovCalc * CMirvFovCalcs::GetById(int id)
+{
+	return m_Calcs.GetById(id);
+}
+
+int CMirvFovCalcs::GetId(char const * name)
+{
+	return m_Calcs.GetId(name);
+}
+
 IMirvFovCalc * CMirvFovCalcs::NewCamCalc(char const * name, IMirvCamCalc * src)
 {
 	if (name && !Console_CheckName(name))
@@ -4503,7 +4870,7 @@ IMirvFovCalc * CMirvFovCalcs::NewCamCalc(char const * name, IMirvCamCalc * src)
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4511,14 +4878,13 @@ IMirvFovCalc * CMirvFovCalcs::NewCamCalc(char const * name, IMirvCamCalc * src)
 
 void CMirvFovCalcs::Console_Remove(char const * name)
 {
-	std::list<IMirvFovCalc *>::iterator it;
-	GetIteratorByName(name, it);
+	CMirvCalcRegistry<IMirvFovCalc>::iterator it = m_Calcs.Find(name);
 	if (it != m_Calcs.end())
 	{
 		if (1 == (*it)->GetRefCount())
 		{
 			(*it)->Release();
-			m_Calcs.erase(it);
+			m_Calcs.Erase(it);
 		}
 		else
 			Tier0_Warning("Error: Cannot remove %s: Still in use.\n", (*it)->GetName());
@@ -4560,25 +4926,33 @@ bool CMirvFovCalcs::Console_CheckName(char const * name)
 
 void CMirvFovCalcs::Console_Print(void)
 {
-	for (std::list<IMirvFovCalc *>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	for (CMirvCalcRegistry<IMirvFovCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
 		(*it)->Console_PrintBegin(); (*it)->Console_PrintEnd(); Tier0_Msg(";\n");
 	}
 }
 
-void CMirvFovCalcs::GetIteratorByName(char const * name, std::list<IMirvFovCalc *>::iterator & outIt)
+void CMirvFovCalcs::Console_PrintStats(void)
 {
-	for (outIt = m_Calcs.begin(); outIt != m_Calcs.end(); ++outIt)
+	for (CMirvCalcRegistry<IMirvFovCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
-		if (0 == _stricmp(name, (*outIt)->GetName()))
-			break;
+		MirvCalcs_PrintStats("fov", *it);
 	}
 }
 
+void CMirvFovCalcs::ResetStats(void)
+{
+	for (CMirvCalcRegistry<IMirvFovCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	{
+		(*it)->ResetStats();
+	}
+}
+
+
 
 CMirvBoolCalcs::~CMirvBoolCalcs()
 {
-	for (std::list<IMirvBoolCalc *>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	for (CMirvCalcRegistry<IMirvBoolCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
 		(*it)->Release();
 	}
@@ -4586,8 +4960,7 @@ CMirvBoolCalcs::~CMirvBoolCalcs()
 
 IMirvBoolCalc * CMirvBoolCalcs::GetByName(char const * name)
 {
-	std::list<IMirvBoolCalc *>::iterator it;
-	GetIteratorByName(name, it);
+	CMirvCalcRegistry<IMirvBoolCalc>::iterator it = m_Calcs.Find(name);
 	if (it != m_Calcs.end())
 	{
 		return *it;
@@ -4596,6 +4969,16 @@ IMirvBoolCalc * CMirvBoolCalcs::GetByName(char const * name)
 	return 0;
 }
 
+IMirvBoolCalc * CMirvBoolCalcs::GetById(int id)
+{
+	return m_Calcs.GetById(id);
+}
+
+int CMirvBoolCalcs::GetId(char const * name)
+{
+	return m_Calcs.GetId(name);
+}
+
 IMirvBoolCalc * CMirvBoolCalcs::NewHandleCalc(char const * name, IMirvHandleCalc * handle)
 {
 	if (name && !Console_CheckName(name))
@@ -4607,7 +4990,7 @@ IMirvBoolCalc * CMirvBoolCalcs::NewHandleCalc(char const * name, IMirvHandleCalc
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4624,7 +5007,7 @@ IMirvBoolCalc * CMirvBoolCalcs::NewVecAngCalc(char const * name, IMirvVecAngCalc
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4641,7 +5024,7 @@ IMirvBoolCalc * CMirvBoolCalcs::NewAliveCalc(char const * name, IMirvHandleCalc
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4658,7 +5041,7 @@ IMirvBoolCalc * CMirvBoolCalcs::NewAndCalc(char const * name, IMirvBoolCalc * a,
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4675,7 +5058,7 @@ IMirvBoolCalc * CMirvBoolCalcs::NewOrCalc(char const * name, IMirvBoolCalc * a,
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4692,7 +5075,7 @@ IMirvBoolCalc * CMirvBoolCalcs::NewNotCalc(char const * name, IMirvBoolCalc * a)
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4709,7 +5092,7 @@ IMirvBoolCalc * CMirvBoolCalcs::NewHandlesEqualCalc(char const * name, IMirvHand
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4726,7 +5109,7 @@ IMirvBoolCalc * CMirvBoolCalcs::NewIntsEqualCalc(char const * name, IMirvIntCalc
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4743,7 +5126,7 @@ IMirvBoolCalc * CMirvBoolCalcs::NewClassnameMatchesCalc(char const * name, IMirv
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4751,14 +5134,13 @@ IMirvBoolCalc * CMirvBoolCalcs::NewClassnameMatchesCalc(char const * name, IMirv
 
 void CMirvBoolCalcs::Console_Remove(char const * name)
 {
-	std::list<IMirvBoolCalc *>::iterator it;
-	GetIteratorByName(name, it);
+	CMirvCalcRegistry<IMirvBoolCalc>::iterator it = m_Calcs.Find(name);
 	if (it != m_Calcs.end())
 	{
 		if (1 == (*it)->GetRefCount())
 		{
 			(*it)->Release();
-			m_Calcs.erase(it);
+			m_Calcs.Erase(it);
 		}
 		else
 			Tier0_Warning("Error: Cannot remove %s: Still in use.\n", (*it)->GetName());
@@ -4800,25 +5182,33 @@ bool CMirvBoolCalcs::Console_CheckName(char const * name)
 
 void CMirvBoolCalcs::Console_Print(void)
 {
-	for (std::list<IMirvBoolCalc *>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	for (CMirvCalcRegistry<IMirvBoolCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
 		(*it)->Console_PrintBegin(); (*it)->Console_PrintEnd(); Tier0_Msg(";\n");
 	}
 }
 
-void CMirvBoolCalcs::GetIteratorByName(char const * name, std::list<IMirvBoolCalc *>::iterator & outIt)
+void CMirvBoolCalcs::Console_PrintStats(void)
+{
+	for (CMirvCalcRegistry<IMirvBoolCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	{
+		MirvCalcs_PrintStats("bool", *it);
+	}
+}
+
+void CMirvBoolCalcs::ResetStats(void)
 {
-	for (outIt = m_Calcs.begin(); outIt != m_Calcs.end(); ++outIt)
+	for (CMirvCalcRegistry<IMirvBoolCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
-		if (0 == _stricmp(name, (*outIt)->GetName()))
-			break;
+		(*it)->ResetStats();
 	}
 }
 
 
+
 CMirvIntCalcs::~CMirvIntCalcs()
 {
-	for (std::list<IMirvIntCalc *>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	for (CMirvCalcRegistry<IMirvIntCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
 		(*it)->Release();
 	}
@@ -4826,8 +5216,7 @@ CMirvIntCalcs::~CMirvIntCalcs()
 
 IMirvIntCalc * CMirvIntCalcs::GetByName(char const * name)
 {
-	std::list<IMirvIntCalc *>::iterator it;
-	GetIteratorByName(name, it);
+	CMirvCalcRegistry<IMirvIntCalc>::iterator it = m_Calcs.Find(name);
 	if (it != m_Calcs.end())
 	{
 		return *it;
@@ -4836,6 +5225,16 @@ IMirvIntCalc * CMirvIntCalcs::GetByName(char const * name)
 	return 0;
 }
 
+IMirvIntCalc * CMirvIntCalcs::GetById(int id)
+{
+	return m_Calcs.GetById(id);
+}
+
+int CMirvIntCalcs::GetId(char const * name)
+{
+	return m_Calcs.GetId(name);
+}
+
 
 IMirvIntCalc * CMirvIntCalcs::NewValueCalc(char const * name, int value)
 {
@@ -4848,7 +5247,7 @@ IMirvIntCalc * CMirvIntCalcs::NewValueCalc(char const * name, int value)
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4865,7 +5264,7 @@ IMirvIntCalc * CMirvIntCalcs::NewTeamNumberCalc(char const * name, IMirvHandleCa
 	{
 		result->AddRef();
 
-		m_Calcs.push_back(result);
+		m_Calcs.Add(result);
 	}
 
 	return result;
@@ -4873,14 +5272,13 @@ IMirvIntCalc * CMirvIntCalcs::NewTeamNumberCalc(char const * name, IMirvHandleCa
 
 void CMirvIntCalcs::Console_Remove(char const * name)
 {
-	std::list<IMirvIntCalc *>::iterator it;
-	GetIteratorByName(name, it);
+	CMirvCalcRegistry<IMirvIntCalc>::iterator it = m_Calcs.Find(name);
 	if (it != m_Calcs.end())
 	{
 		if (1 == (*it)->GetRefCount())
 		{
 			(*it)->Release();
-			m_Calcs.erase(it);
+			m_Calcs.Erase(it);
 		}
 		else
 			Tier0_Warning("Error: Cannot remove %s: Still in use.\n", (*it)->GetName());
@@ -4922,21 +5320,29 @@ bool CMirvIntCalcs::Console_CheckName(char const * name)
 
 void CMirvIntCalcs::Console_Print(void)
 {
-	for (std::list<IMirvIntCalc *>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	for (CMirvCalcRegistry<IMirvIntCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
 		(*it)->Console_PrintBegin(); (*it)->Console_PrintEnd(); Tier0_Msg(";\n");
 	}
 }
 
-void CMirvIntCalcs::GetIteratorByName(char const * name, std::list<IMirvIntCalc *>::iterator & outIt)
+void CMirvIntCalcs::Console_PrintStats(void)
 {
-	for (outIt = m_Calcs.begin(); outIt != m_Calcs.end(); ++outIt)
+	for (CMirvCalcRegistry<IMirvIntCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
 	{
-		if (0 == _stricmp(name, (*outIt)->GetName()))
-			break;
+		MirvCalcs_PrintStats("int", *it);
 	}
 }
 
+void CMirvIntCalcs::ResetStats(void)
+{
+	for (CMirvCalcRegistry<IMirvIntCalc>::iterator it = m_Calcs.begin(); it != m_Calcs.end(); ++it)
+	{
+		(*it)->ResetStats();
+	}
+}
+
+
 void mirv_calcs_handle(IWrpCommandArgs * args)
 {
 	int argc = args->ArgC();
@@ -6109,6 +6515,38 @@ CON_COMMAND(mirv_calcs, "Expressions, currently mainly for usage mirv_calcs, mir
 			mirv_calcs_int(&sub);
 			return;
 		}
+		else if (0 == _stricmp("stats", arg1))
+		{
+			if (3 <= argc && 0 == _stricmp("reset", args->ArgV(2)))
+			{
+				g_MirvHandleCalcs.ResetStats();
+				g_MirvVecAngCalcs.ResetStats();
+				g_MirvCamCalcs.ResetStats();
+				g_MirvFovCalcs.ResetStats();
+				g_MirvBoolCalcs.ResetStats();
+				g_MirvIntCalcs.ResetStats();
+				return;
+			}
+			else if (2 == argc)
+			{
+				Tier0_Msg("%-6s %-32s %10s %10s\n", "type", "name", "evals", "cacheHits");
+				g_MirvHandleCalcs.Console_PrintStats();
+				g_MirvVecAngCalcs.Console_PrintStats();
+				g_MirvCamCalcs.Console_PrintStats();
+				g_MirvFovCalcs.Console_PrintStats();
+				g_MirvBoolCalcs.Console_PrintStats();
+				g_MirvIntCalcs.Console_PrintStats();
+				return;
+			}
+
+			Tier0_Msg(
+				"%s stats - Print how often each named calc was evaluated and how often its result was reused within the same frame.\n"
+				"%s stats reset - Reset these counters.\n"
+				, arg0
+				, arg0
+			);
+			return;
+		}
 	}
 
 	Tier0_Msg(
@@ -6118,6 +6556,8 @@ CON_COMMAND(mirv_calcs, "Expressions, currently mainly for usage mirv_calcs, mir
 		"%s cam [...] - Calcs that return a view (location, rotation and FOV).\n"
 		"%s bool [...] - Calc that returns true or false (if it could be evaluated that is).\n"
 		"%s int [...] - Calc that returns an integer or nothing.\n"
+		"%s stats [...] - Evaluation and cache statistics (calcs are evaluated at most once per frame).\n"
+		, arg0
 		, arg0
 		, arg0
 		, arg0
@@ -4,10 +4,18 @@
 
 #include "WrpConsole.h"
 
+#include "MirvCalcRegistry.h"
+
 #include <list>
 
 void CalcSmooth(double deltaT, double targetPos, double & lastPos, double & lastVel, double LimitVelocity, double LimitAcceleration);
 
+/// <summary>
+/// Starts a new frame for the calcs: each calc is evaluated at most once per frame,
+/// further Calc* calls in the same frame return the cached result.
+/// </summary>
+void MirvCalcs_OnBeforeFrameRenderStart(void);
+
 class IMirvCalc abstract
 {
 public:
@@ -18,6 +26,14 @@ public:
 
 	virtual  char const * GetName(void) abstract = 0;
 
+	/// <returns>Number of times the calc was actually evaluated.</returns>
+	virtual unsigned int GetEvaluations(void) abstract = 0;
+
+	/// <returns>Number of times a result cached from the same frame was returned.</returns>
+	virtual unsigned int GetCacheHits(void) abstract = 0;
+
+	virtual void ResetStats(void) abstract = 0;
+
 	virtual void Console_PrintBegin(void) abstract = 0;
 	virtual void Console_PrintEnd(void) abstract = 0;
 
@@ -68,6 +84,12 @@ public:
 
 	IMirvHandleCalc * GetByName(char const * name);
 
+	/// <returns>0 if not found.</returns>
+	IMirvHandleCalc * GetById(int id);
+
+	/// <returns>0 if not found, otherwise an id for GetById, that is valid until the calc is removed.</returns>
+	int GetId(char const * name);
+
 	IMirvHandleCalc * NewValueCalc(char const * name, int handle);
 	IMirvHandleCalc * NewIndexCalc(char const * name, int entityIndex);
 	IMirvHandleCalc * NewKeyCalc(char const * name, int slot);
@@ -79,11 +101,11 @@ public:
 	bool Console_CheckName(char const * name);
 	void Console_Remove(char const * name);
 	void Console_Print(void);
+	void Console_PrintStats(void);
+	void ResetStats(void);
 
 private:
-	std::list<IMirvHandleCalc *> m_Calcs;
-
-	void GetIteratorByName(char const * name, std::list<IMirvHandleCalc *>::iterator & outIt);
+	CMirvCalcRegistry<IMirvHandleCalc> m_Calcs;
 };
 
 extern CMirvHandleCalcs g_MirvHandleCalcs;
@@ -96,6 +118,12 @@ public:
 
 	IMirvVecAngCalc * GetByName(char const * name);
 
+	/// <returns>0 if not found.</returns>
+	IMirvVecAngCalc * GetById(int id);
+
+	/// <returns>0 if not found, otherwise an id for GetById, that is valid until the calc is removed.</returns>
+	int GetId(char const * name);
+
 	IMirvVecAngCalc * NewValueCalc(char const * name, float x, float y, float z, float rX, float rY, float rZ);
 	IMirvVecAngCalc * NewAddCalc(char const * name, IMirvVecAngCalc * a, IMirvVecAngCalc * b);
 	IMirvVecAngCalc * NewSubtractCalc(char const * name, IMirvVecAngCalc * a, IMirvVecAngCalc * b);
@@ -115,11 +143,11 @@ public:
 	bool Console_CheckName(char const * name);
 	void Console_Remove(char const * name);
 	void Console_Print(void);
+	void Console_PrintStats(void);
+	void ResetStats(void);
 
 private:
-	std::list<IMirvVecAngCalc *> m_Calcs;
-
-	void GetIteratorByName(char const * name, std::list<IMirvVecAngCalc *>::iterator & outIt);
+	CMirvCalcRegistry<IMirvVecAngCalc> m_Calcs;
 };
 
 extern CMirvVecAngCalcs g_MirvVecAngCalcs;
@@ -132,6 +160,12 @@ public:
 
 	IMirvCamCalc * GetByName(char const * name);
 
+	/// <returns>0 if not found.</returns>
+	IMirvCamCalc * GetById(int id);
+
+	/// <returns>0 if not found, otherwise an id for GetById, that is valid until the calc is removed.</returns>
+	int GetId(char const * name);
+
 	IMirvCamCalc * NewCamCalc(char const * name, const char * camFileName, const char * startClientTime);
 	IMirvCamCalc * NewGameCalc(char const * name);
 	IMirvCamCalc * NewCurrentCalc(char const * name);
@@ -141,11 +175,11 @@ public:
 	bool Console_CheckName(char const * name);
 	void Console_Remove(char const * name);
 	void Console_Print(void);
+	void Console_PrintStats(void);
+	void ResetStats(void);
 
 private:
-	std::list<IMirvCamCalc *> m_Calcs;
-
-	void GetIteratorByName(char const * name, std::list<IMirvCamCalc *>::iterator & outIt);
+	CMirvCalcRegistry<IMirvCamCalc> m_Calcs;
 };
 
 extern CMirvCamCalcs g_MirvCamCalcs;
@@ -158,16 +192,22 @@ public:
 
 	IMirvFovCalc * GetByName(char const * name);
 
+	/// <returns>0 if not found.</returns>
+	IMirvFovCalc * GetById(int id);
+
+	/// <returns>0 if not found, otherwise an id for GetById, that is valid until the calc is removed.</returns>
+	int GetId(char const * name);
+
 	IMirvFovCalc * NewCamCalc(char const * name, IMirvCamCalc * src);
 
 	bool Console_CheckName(char const * name);
 	void Console_Remove(char const * name);
 	void Console_Print(void);
+	void Console_PrintStats(void);
+	void ResetStats(void);
 
 private:
-	std::list<IMirvFovCalc *> m_Calcs;
-
-	void GetIteratorByName(char const * name, std::list<IMirvFovCalc *>::iterator & outIt);
+	CMirvCalcRegistry<IMirvFovCalc> m_Calcs;
 };
 
 extern CMirvFovCalcs g_MirvFovCalcs;
@@ -181,6 +221,12 @@ public:
 
 	IMirvBoolCalc * GetByName(char const * name);
 
+	/// <returns>0 if not found.</returns>
+	IMirvBoolCalc * GetById(int id);
+
+	/// <returns>0 if not found, otherwise an id for GetById, that is valid until the calc is removed.</returns>
+	int GetId(char const * name);
+
 	IMirvBoolCalc * NewHandleCalc(char const * name, IMirvHandleCalc * handle);
 	IMirvBoolCalc * NewVecAngCalc(char const * name, IMirvVecAngCalc * vecAng);
 	IMirvBoolCalc * NewAliveCalc(char const * name, IMirvHandleCalc * vecAng);
@@ -194,11 +240,11 @@ public:
 	bool Console_CheckName(char const * name);
 	void Console_Remove(char const * name);
 	void Console_Print(void);
+	void Console_PrintStats(void);
+	void ResetStats(void);
 
 private:
-	std::list<IMirvBoolCalc *> m_Calcs;
-
-	void GetIteratorByName(char const * name, std::list<IMirvBoolCalc *>::iterator & outIt);
+	CMirvCalcRegistry<IMirvBoolCalc> m_Calcs;
 };
 
 extern CMirvBoolCalcs g_MirvBoolCalcs;
@@ -211,17 +257,23 @@ public:
 
 	IMirvIntCalc * GetByName(char const * name);
 
+	/// <returns>0 if not found.</returns>
+	IMirvIntCalc * GetById(int id);
+
+	/// <returns>0 if not found, otherwise an id for GetById, that is valid until the calc is removed.</returns>
+	int GetId(char const * name);
+
 	IMirvIntCalc * NewValueCalc(const char * name, int value);
 	IMirvIntCalc * NewTeamNumberCalc(char const * name, IMirvHandleCalc * handle);
 
 	bool Console_CheckName(char const * name);
 	void Console_Remove(char const * name);
 	void Console_Print(void);
+	void Console_PrintStats(void);
+	void ResetStats(void);
 
 private:
-	std::list<IMirvIntCalc *> m_Calcs;
-
-	void GetIteratorByName(char const * name, std::list<IMirvIntCalc *>::iterator & outIt);
+	CMirvCalcRegistry<IMirvIntCalc> m_Calcs;
 };
 
 extern CMirvIntCalcs g_MirvIntCalcs;
@@ -840,6 +840,43 @@ CON_COMMAND(mirv_streams, "Access to streams system.")
 					);
 					return;
 				}
+				else if (!_stricmp(cmd2, "wavFormat"))
+				{
+					if (4 <= argc)
+					{
+						char const * cmd3 = args->ArgV(3);
+
+						if (!_stricmp(cmd3, "pcm16"))
+							g_AfxStreams.Console_WavFormat_set(CMirvWav::SF_PCM16);
+						else if (!_stricmp(cmd3, "pcm24"))
+							g_AfxStreams.Console_WavFormat_set(CMirvWav::SF_PCM24);
+						else if (!_stricmp(cmd3, "float"))
+							g_AfxStreams.Console_WavFormat_set(CMirvWav::SF_FLOAT);
+						else
+							Tier0_Warning("AFXERROR: %s is not a valid format.\n", cmd3);
+						return;
+					}
+
+					char const * curFormat = "pcm16";
+					switch (g_AfxStreams.Console_WavFormat_get())
+					{
+					case CMirvWav::SF_PCM24:
+						curFormat = "pcm24";
+						break;
+					case CMirvWav::SF_FLOAT:
+						curFormat = "float";
+						break;
+					default:
+						break;
+					}
+
+					Tier0_Msg(
+						"mirv_streams record wavFormat pcm16|pcm24|float - Sample format of the WAV audio (startMovieWav): 16 bit, 24 bit or 32 bit IEEE float (not clipped).\n"
+						"Current value: %s.\n",
+						curFormat
+					);
+					return;
+				}
 				else if (!_stricmp(cmd2, "voices"))
 				{
 					if (4 <= argc)
@@ -901,11 +938,27 @@ CON_COMMAND(mirv_streams, "Access to streams system.")
 							);
 							return;
 						}
+						else if (!_stricmp("binary", cmd3))
+						{
+							if (5 <= argc)
+							{
+								g_AfxStreams.CamExportBinary_set(0 != atoi(args->ArgV(4)));
+								return;
+							}
+
+							Tier0_Msg(
+								"mirv_streams record cam binary 0|1 - Write text (version 1, default) or binary (version 2, smaller and faster, but only mirv_camio import reads it) frames.\n"
+								"Current value: %i\n"
+								, g_AfxStreams.CamExportBinary_get() ? 1 : 0
+							);
+							return;
+						}
 					}
 
 					Tier0_Msg(
 						"mirv_streams record cam enabled [...]\n"
 						"mirv_streams record cam fovScaling [...]\n"
+						"mirv_streams record cam binary [...]\n"
 					);
 					return;
 				}
@@ -930,6 +983,7 @@ CON_COMMAND(mirv_streams, "Access to streams system.")
 				"mirv_streams record matMotionBlurEnabled [...] - Control forcing of mat_motion_blur_enabled.\n"
 				"mirv_streams record matForceTonemapScale [...] - Control forcing of mat_force_tonemap_scale.\n"
 				"mirv_streams record startMovieWav [...] - Controls WAV audio recording.\n"
+				"mirv_streams record wavFormat [...] - Controls WAV audio sample format.\n"
 				"mirv_streams record voices [...] - Controls voice WAV audio recording.\n"
 				"mirv_streams record bvh [...] - Controls the HLAE/BVH Camera motion data capture output.\n"
 				"mirv_streams record cam [...] - Controls the camera motion data capture output (can be imported with mirv_camio).\n"
@@ -1000,6 +1054,12 @@ CON_COMMAND(mirv_streams, "Access to streams system.")
 			g_AfxStreams.Console_MainStream(&subArgs);
 			return;
 		}
+		else if (0 == _stricmp("pipeline", cmd1))
+		{
+			CSubWrpCommandArgs subArgs(args, 2);
+			g_AfxStreams.Console_Pipeline(&subArgs);
+			return;
+		}
 	}
 
 	Tier0_Msg(
@@ -1015,6 +1075,7 @@ CON_COMMAND(mirv_streams, "Access to streams system.")
 		"mirv_streams actions [...] - Actions control (for baseFx based streams).\n"
 		"mirv_streams settings [...] - Recording settings.\n"
 		"mirv_streams mainStream [...] - Controls which stream is the main stream for caching full-scene state (default is first).\n"
+		"mirv_streams pipeline [...] - Capture pipeline statistics.\n"
 	);
 	return;
 }
@@ -23,6 +23,7 @@
 #include <math.h>
 
 #include <string>
+#include <deque>
 #include <list>
 #include <queue>
 #include <set>
@@ -32,6 +33,7 @@
 #include <shared_mutex>
 #include <condition_variable>
 #include <chrono>
+#include <type_traits>
 
 extern WrpVEngineClient * g_VEngineClient;
 
@@ -67,6 +69,9 @@ namespace MirvPgl
 	const int m_ThreadSleepMsIfNoData = 1;
 	const uint32_t m_Version = 2;
 
+	/// <summary>The send thread only hands more data to the socket while less than this is pending there.</summary>
+	const size_t m_SendSocketLowBytes = 64 * 1024;
+
 	// Version: 3.0.3 (2017-10-31T10:37Z)
 	// 
 	class CDrawing_Functor
@@ -896,6 +901,7 @@ namespace MirvPgl
 		{
 			m_IsCancelled = false;
 			m_Data = data;
+			m_CamOffset = data.size();
 		}
 
 		void Cancel()
@@ -913,9 +919,16 @@ namespace MirvPgl
 			return m_Data;
 		}
 
+		/// <returns>Where the &quot;cam&quot; messages added on the drawing thread start in the data.</returns>
+		size_t GetCamOffset()
+		{
+			return m_CamOffset;
+		}
+
 	private:
 		std::atomic_bool m_IsCancelled;
 		std::vector<uint8_t> m_Data;
+		size_t m_CamOffset = 0;
 	};
 
 	void DrawingThread_SupplyThreadData(CThreadData * threadData);
@@ -1016,9 +1029,291 @@ namespace MirvPgl
 
 	std::vector<uint8_t> m_SendThreadTempData;
 
-	std::vector<uint8_t> m_DataForSendThread;
-	std::condition_variable m_DataForSendThreadAvailableCondition;
-	std::mutex m_DataForSendThreadMutex;
+	enum SendPolicy
+	{
+		SendPolicy_Block,
+		SendPolicy_DropOldestCam,
+		SendPolicy_CoalesceCam
+	};
+
+	/// <summary>
+	///   Bounded queue of the data for the send thread.<br />
+	///   Only &quot;cam&quot; messages are ever dropped, all other messages
+	///   (i.e. &quot;levelInit&quot; or &quot;gameEvent&quot;) are queued even if
+	///   that exceeds the limit.
+	/// </summary>
+	class CSendQueue
+	{
+	public:
+		/// <summary>Clears the queue and accepts data again.</summary>
+		void Open(void)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			m_Items.clear();
+			m_Bytes = 0;
+			m_SocketBytes = 0;
+			m_Open = true;
+		}
+
+		/// <summary>Clears the queue, data queued afterwards is discarded, wakes up all waiting.</summary>
+		void Close(void)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+
+				m_Items.clear();
+				m_Bytes = 0;
+				m_SocketBytes = 0;
+				m_Open = false;
+			}
+
+			m_AvailableCondition.notify_all();
+			m_SpaceCondition.notify_all();
+		}
+
+		SendPolicy Policy_get(void)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			return m_Policy;
+		}
+
+		void Policy_set(SendPolicy value)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+
+				m_Policy = value;
+			}
+
+			m_SpaceCondition.notify_all();
+		}
+
+		size_t MaxBytes_get(void)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			return m_MaxBytes;
+		}
+
+		void MaxBytes_set(size_t value)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+
+				m_MaxBytes = value;
+			}
+
+			m_SpaceCondition.notify_all();
+		}
+
+		/// <summary>Queues the data of a frame, with SendPolicy_Block this waits until there is room.</summary>
+		/// <param name="camOffset">Bytes from here on are &quot;cam&quot; messages, which may be dropped.</param>
+		void Queue(std::vector<uint8_t> const & data, size_t camOffset)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			if (!m_Open)
+				return;
+
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+			if (SendPolicy_Block == m_Policy && !HasRoom(data.size()))
+			{
+				++m_BlockedCount;
+
+				m_SpaceCondition.wait(lock, [this, &data] { return !m_Open || SendPolicy_Block != m_Policy || HasRoom(data.size()); });
+
+				std::chrono::steady_clock::time_point blockedEnd = std::chrono::steady_clock::now();
+				m_BlockedSeconds += std::chrono::duration<double>(blockedEnd - now).count();
+				now = blockedEnd;
+
+				if (!m_Open)
+					return;
+			}
+
+			if (0 < camOffset)
+			{
+				PushBack(data.begin(), data.begin() + camOffset, false, now);
+			}
+
+			if (camOffset < data.size())
+			{
+				size_t camBytes = data.size() - camOffset;
+
+				if (SendPolicy_CoalesceCam == m_Policy)
+				{
+					// Only the latest cam is of interest:
+					for (std::deque<CItem>::iterator it = m_Items.begin(); it != m_Items.end(); )
+					{
+						if (it->Cam)
+						{
+							m_Bytes -= it->Data.size();
+							it = m_Items.erase(it);
+							++m_CoalescedCams;
+						}
+						else
+							++it;
+					}
+				}
+				else if (SendPolicy_DropOldestCam == m_Policy)
+				{
+					for (std::deque<CItem>::iterator it = m_Items.begin(); it != m_Items.end() && !HasRoom(camBytes); )
+					{
+						if (it->Cam)
+						{
+							m_Bytes -= it->Data.size();
+							it = m_Items.erase(it);
+							++m_DroppedCams;
+						}
+						else
+							++it;
+					}
+				}
+
+				if (SendPolicy_Block != m_Policy && !HasRoom(camBytes))
+					++m_DroppedCams;
+				else
+					PushBack(data.begin() + camOffset, data.end(), true, now);
+			}
+
+			lock.unlock();
+
+			m_AvailableCondition.notify_one();
+		}
+
+		/// <summary>Moves queued data to outData, waits up to waitMs if there is none.</summary>
+		/// <param name="maxBytes">Items are taken until this is reached, but at least one.</param>
+		/// <returns>true if data was taken.</returns>
+		bool Take(std::vector<uint8_t> & outData, size_t maxBytes, int waitMs)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			m_AvailableCondition.wait_for(lock, waitMs * 1ms, [this] { return !m_Items.empty() || !m_Open; });
+
+			if (m_Items.empty())
+				return false;
+
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+			do
+			{
+				CItem & item = m_Items.front();
+
+				outData.insert(outData.end(), item.Data.begin(), item.Data.end());
+
+				double latency = std::chrono::duration<double>(now - item.Queued).count();
+				m_LatencySum += latency;
+				if (m_LatencyMax < latency) m_LatencyMax = latency;
+				++m_SentItems;
+				m_SentBytes += item.Data.size();
+
+				m_Bytes -= item.Data.size();
+				m_Items.pop_front();
+			} while (!m_Items.empty() && outData.size() < maxBytes);
+
+			lock.unlock();
+
+			m_SpaceCondition.notify_all();
+
+			return true;
+		}
+
+		/// <param name="value">Bytes pending in the socket (not counted against the limit).</param>
+		void SocketBytes_set(size_t value)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			m_SocketBytes = value;
+		}
+
+		void PrintStats(void)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			Tier0_Msg(
+				"Queued: %llu bytes (%llu items), peak: %llu bytes, limit: %llu bytes\n"
+				"Pending in socket: %llu bytes\n"
+				"Sent: %llu bytes (%llu items)\n"
+				"Send latency (queued until handed to socket): avg %.3f ms, max %.3f ms\n"
+				"Cams dropped: %llu, coalesced: %llu\n"
+				"Blocked: %llu times, %.3f s total\n"
+				, (unsigned long long)m_Bytes, (unsigned long long)m_Items.size(), (unsigned long long)m_PeakBytes, (unsigned long long)m_MaxBytes
+				, (unsigned long long)m_SocketBytes
+				, m_SentBytes, m_SentItems
+				, 0 < m_SentItems ? 1000.0 * m_LatencySum / m_SentItems : 0.0, 1000.0 * m_LatencyMax
+				, m_DroppedCams, m_CoalescedCams
+				, m_BlockedCount, m_BlockedSeconds
+			);
+		}
+
+		void ResetStats(void)
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+
+			m_PeakBytes = m_Bytes;
+			m_SentBytes = 0;
+			m_SentItems = 0;
+			m_LatencySum = 0;
+			m_LatencyMax = 0;
+			m_DroppedCams = 0;
+			m_CoalescedCams = 0;
+			m_BlockedCount = 0;
+			m_BlockedSeconds = 0;
+		}
+
+	private:
+		struct CItem
+		{
+			std::vector<uint8_t> Data;
+			bool Cam;
+			std::chrono::steady_clock::time_point Queued;
+		};
+
+		std::mutex m_Mutex;
+		std::condition_variable m_AvailableCondition;
+		std::condition_variable m_SpaceCondition;
+
+		std::deque<CItem> m_Items;
+		size_t m_Bytes = 0;
+		bool m_Open = false;
+
+		SendPolicy m_Policy = SendPolicy_DropOldestCam;
+		size_t m_MaxBytes = 8 * 1024 * 1024;
+
+		size_t m_PeakBytes = 0;
+		size_t m_SocketBytes = 0;
+		unsigned long long m_SentBytes = 0;
+		unsigned long long m_SentItems = 0;
+		double m_LatencySum = 0;
+		double m_LatencyMax = 0;
+		unsigned long long m_DroppedCams = 0;
+		unsigned long long m_CoalescedCams = 0;
+		unsigned long long m_BlockedCount = 0;
+		double m_BlockedSeconds = 0;
+
+		/// <remarks>An empty queue always has room, so oversized data is not stuck forever.</remarks>
+		bool HasRoom(size_t bytes)
+		{
+			return m_Items.empty() || m_Bytes + bytes <= m_MaxBytes;
+		}
+
+		void PushBack(std::vector<uint8_t>::const_iterator first, std::vector<uint8_t>::const_iterator last, bool cam, std::chrono::steady_clock::time_point queued)
+		{
+			m_Items.emplace_back();
+
+			CItem & item = m_Items.back();
+
+			item.Data.assign(first, last);
+			item.Cam = cam;
+			item.Queued = queued;
+
+			m_Bytes += item.Data.size();
+			if (m_PeakBytes < m_Bytes) m_PeakBytes = m_Bytes;
+		}
+	} m_SendQueue;
+
 	bool m_InTransaction;
 
 	bool m_DataActive = false;
@@ -1182,6 +1477,19 @@ namespace MirvPgl
 		}
 	}
 
+	// easywsclient.cpp is compiled into this file, so we can look into its
+	// implementation. If easywsclient changes, this must fail to compile
+	// instead of reading something else:
+	static_assert(std::is_base_of<WebSocket, _RealWebSocket>::value, "GetWsPendingBytes: easywsclient's WebSocket is not implemented by _RealWebSocket anymore.");
+	static_assert(std::is_same<decltype(_RealWebSocket::txbuf), std::vector<uint8_t>>::value, "GetWsPendingBytes: easywsclient's _RealWebSocket::txbuf is not the send buffer anymore.");
+
+	/// <returns>Bytes the socket did not take yet.</returns>
+	/// <remarks>m_Ws is always created by WebSocket::from_url, which only creates _RealWebSocket (never create_dummy).</remarks>
+	size_t GetWsPendingBytes(WebSocket * ws)
+	{
+		return static_cast<_RealWebSocket *>(ws)->txbuf.size();
+	}
+
 	void Thread()
 	{
 		m_SendThreadTempData.clear();
@@ -1204,26 +1512,28 @@ namespace MirvPgl
 			// this would eat our shit: m_Ws->dispatch(Recv_String); 
 			m_Ws->dispatchBinary(Recv_Bytes);
 
-			std::unique_lock<std::mutex> dataLock(m_DataForSendThreadMutex);
+			size_t pendingBytes = GetWsPendingBytes(m_Ws);
 
-			m_DataForSendThreadAvailableCondition.wait_for(dataLock, m_ThreadSleepMsIfNoData * 1ms, [] { return !m_DataForSendThread.empty() || m_WantClose; }); // if we don't need to send data, we are a bit lazy in order to save some CPU. Of course this assumes, that the data we get from network can wait that long ;)
+			m_SendQueue.SocketBytes_set(pendingBytes);
 
-			if (!m_DataForSendThread.empty())
+			if (m_SendSocketLowBytes <= pendingBytes)
+			{
+				// The consumer is slow, leave the data in the queue (where the send policy applies) and wait until the socket can take more:
+				m_Ws->poll(m_ThreadSleepMsIfNoData);
+			}
+			else if (m_SendQueue.Take(m_SendThreadTempData, m_SendSocketLowBytes, m_ThreadSleepMsIfNoData)) // if we don't need to send data, we are a bit lazy in order to save some CPU. Of course this assumes, that the data we get from network can wait that long ;)
 			{
-				m_SendThreadTempData = std::move(m_DataForSendThread);
-				m_DataForSendThread.clear();
-				dataLock.unlock();
-
 				m_Ws->sendBinary(m_SendThreadTempData);
 
 				m_SendThreadTempData.clear();
 			}
-			else
-				dataLock.unlock();
 
 			if (m_WantClose)
 				m_Ws->close();
 		}
+
+		// Nobody takes data anymore, don't let the drawing thread wait:
+		m_SendQueue.Close();
 	}
 
 	void EndThread()
@@ -1232,7 +1542,7 @@ namespace MirvPgl
 		{
 			m_WantClose = true;
 			
-			m_DataForSendThreadAvailableCondition.notify_one();
+			m_SendQueue.Close();
 
 			m_Thread->join();
 			
@@ -1247,6 +1557,8 @@ namespace MirvPgl
 	{
 		EndThread();
 
+		m_SendQueue.Open();
+
 		m_InTransaction = false;
 		m_Thread = new std::thread(Thread);
 	}
@@ -1485,15 +1797,7 @@ namespace MirvPgl
 	{
 		if (m_DrawingThread_ThreadData && !m_DrawingThread_ThreadData->IsCancelled())
 		{
-			std::vector<uint8_t> & data = m_DrawingThread_ThreadData->AccessData();
-
-			std::unique_lock<std::mutex> lock(m_DataForSendThreadMutex);
-
-			m_DataForSendThread.insert(m_DataForSendThread.end(), data.begin(), data.end());
-
-			lock.unlock();
-
-			m_DataForSendThreadAvailableCondition.notify_one();
+			m_SendQueue.Queue(m_DrawingThread_ThreadData->AccessData(), m_DrawingThread_ThreadData->GetCamOffset());
 
 			m_ThreadDataPool.Return(m_DrawingThread_ThreadData);
 
@@ -1616,6 +1920,76 @@ CON_COMMAND(mirv_pgl, "PGL")
 			);
 			return;
 		}
+		else if (0 == _stricmp("sendQueue", cmd1))
+		{
+			if (3 <= argc)
+			{
+				const char * arg2 = args->ArgV(2);
+
+				if (0 == _stricmp(arg2, "policy"))
+				{
+					if (4 <= argc)
+					{
+						const char * arg3 = args->ArgV(3);
+
+						if (0 == _stricmp(arg3, "block"))
+							MirvPgl::m_SendQueue.Policy_set(MirvPgl::SendPolicy_Block);
+						else if (0 == _stricmp(arg3, "dropOldestCam"))
+							MirvPgl::m_SendQueue.Policy_set(MirvPgl::SendPolicy_DropOldestCam);
+						else if (0 == _stricmp(arg3, "coalesceCam"))
+							MirvPgl::m_SendQueue.Policy_set(MirvPgl::SendPolicy_CoalesceCam);
+						else
+							Tier0_Warning("AFXERROR: %s is not a valid value.\n", arg3);
+						return;
+					}
+
+					MirvPgl::SendPolicy policy = MirvPgl::m_SendQueue.Policy_get();
+
+					Tier0_Msg(
+						"mirv_pgl sendQueue policy block|dropOldestCam|coalesceCam - What to do if the queue is full (the server reads too slow):\n"
+						"\tblock - Wait until there is room (stalls the game, nothing is dropped).\n"
+						"\tdropOldestCam - Drop the oldest queued \"cam\" messages (default).\n"
+						"\tcoalesceCam - Keep only the latest \"cam\" message queued (regardless of the limit).\n"
+						"Other messages are never dropped.\n"
+						"Current value: %s\n"
+						, MirvPgl::SendPolicy_DropOldestCam == policy ? "dropOldestCam" : (MirvPgl::SendPolicy_CoalesceCam == policy ? "coalesceCam" : "block")
+					);
+					return;
+				}
+				else if (0 == _stricmp(arg2, "maxBytes"))
+				{
+					if (4 <= argc)
+					{
+						MirvPgl::m_SendQueue.MaxBytes_set((size_t)strtoul(args->ArgV(3), nullptr, 10));
+						return;
+					}
+
+					Tier0_Msg(
+						"mirv_pgl sendQueue maxBytes <n> - Limit of the queue in bytes.\n"
+						"Current value: %llu\n"
+						, (unsigned long long)MirvPgl::m_SendQueue.MaxBytes_get()
+					);
+					return;
+				}
+			}
+
+			Tier0_Msg(
+				"mirv_pgl sendQueue policy [...]\n"
+				"mirv_pgl sendQueue maxBytes [...]\n"
+			);
+			return;
+		}
+		else if (0 == _stricmp("stats", cmd1))
+		{
+			if (3 <= argc && 0 == _stricmp(args->ArgV(2), "reset"))
+			{
+				MirvPgl::m_SendQueue.ResetStats();
+				return;
+			}
+
+			MirvPgl::m_SendQueue.PrintStats();
+			return;
+		}
 		else if (0 == _stricmp("draw", cmd1))
 		{
 			CSubWrpCommandArgs subArgs(args, 2);
@@ -1772,6 +2146,8 @@ CON_COMMAND(mirv_pgl, "PGL")
 		"mirv_pgl dataStart - Start sending data.\n"
 		"mirv_pgl dataStop - Stop sending data.\n"
 		"mirv_pgl url [...] - Set url to use with start.\n"
+		"mirv_pgl sendQueue [...] - Limit and policy for data the server does not read fast enough.\n"
+		"mirv_pgl stats [reset] - Print (or reset) send queue statistics.\n"
 		"mirv_pgl draw [...] - Controls on-screen data drawing.\n"
 		"mirv_pgl events [...] - Control game event data (disabled by default, requires start with version 3 or newer).\n"
 	);
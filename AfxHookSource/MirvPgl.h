@@ -49,7 +49,15 @@ Usage:
 
 
 It is a good idea to run with the FPS limited (either by vsync or by fps_max).
-Otherwise the network / server will be flooded with "cam" messages or the send buffer will overflow eventually, since there is currently no throttling at all implemented so far.
+Otherwise the network / server will be flooded with "cam" messages.
+
+If the server reads slower than data is produced, the data is held in a send queue limited by "mirv_pgl sendQueue maxBytes" (default 8 MiB).
+What happens when it is full is set by "mirv_pgl sendQueue policy":
+- block: The game waits until there is room again, nothing is dropped.
+- dropOldestCam (default): The oldest queued "cam" messages are dropped.
+- coalesceCam: Only the latest "cam" message is kept queued (also when the queue is not full).
+Messages other than "cam" are never dropped (they are queued even if that exceeds the limit).
+"mirv_pgl stats" prints queued bytes, drops and latencies.
 
 
 Console commands:
@@ -57,6 +65,9 @@ Console commands:
 mirv_pgl url [<url>] - Set the server's URL, example: mirv_pgl url "ws://localhost:31337/mirv"
 mirv_pgl start - (Re-)Starts connectinion to server.
 mirv_pgl stop - Stops connection to server.
+mirv_pgl sendQueue policy block|dropOldestCam|coalesceCam - What to do if the send queue is full.
+mirv_pgl sendQueue maxBytes <n> - Limit of the send queue in bytes.
+mirv_pgl stats [reset] - Print (or reset) send queue statistics.
 
 It is safe to exec mirv_pgl stop from the server, but how will you reconnect then?
 
@@ -158,7 +169,6 @@ Purpose:
 
 
 Ideas for the future:
-- Implement throttling.
 - Implement black image command with feedback when presented.
 - Implement white image command with feedback when presented.
 - Implement optional time-code (float) graphic overlay at top of screen, this would allow syncing the images and the camdata on remote PC perfectly (as long as turned on).
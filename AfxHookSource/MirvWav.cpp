@@ -2,7 +2,13 @@
 
 #include "MirvWav.h"
 
-CMirvWav::CMirvWav(const wchar_t * fileName, int numChannels, DWORD dwSamplesPerSec)
+#include <cmath>
+
+#define MIRV_WAV_BUFFER_SIZE (64 * 1024)
+
+CMirvWav::CMirvWav(const wchar_t * fileName, int numChannels, DWORD dwSamplesPerSec, SampleFormat sampleFormat)
+: m_SampleFormat(sampleFormat)
+, m_BufferUsed(0)
 {
 	memset(&m_WaveHeader, 0, sizeof(m_WaveHeader)); // clear header
 
@@ -15,6 +21,27 @@ CMirvWav::CMirvWav(const wchar_t * fileName, int numChannels, DWORD dwSamplesPer
 		return;
 	}
 
+	WORD bitsPerSample;
+	WORD formatTag;
+
+	switch (m_SampleFormat)
+	{
+	case SF_PCM24:
+		bitsPerSample = 24;
+		formatTag = 0x0001; // Microsoft PCM
+		break;
+	case SF_FLOAT:
+		bitsPerSample = 32;
+		formatTag = 0x0003; // IEEE float
+		break;
+	case SF_PCM16:
+	default:
+		m_SampleFormat = SF_PCM16;
+		bitsPerSample = 16;
+		formatTag = 0x0001; // Microsoft PCM
+		break;
+	}
+
 	// write temporary header:
 	memcpy(m_WaveHeader.riff_hdr.id, "RIFF", 4);
 	m_WaveHeader.riff_hdr.len = 0;
@@ -24,17 +51,19 @@ CMirvWav::CMirvWav(const wchar_t * fileName, int numChannels, DWORD dwSamplesPer
 	memcpy(m_WaveHeader.fmt_chunk_hdr.id, "fmt ", 4);
 	m_WaveHeader.fmt_chunk_hdr.len = sizeof(m_WaveHeader.fmt_chunk_pcm);
 
-	m_WaveHeader.fmt_chunk_pcm.wFormatTag = 0x0001; // Microsoft PCM
+	m_WaveHeader.fmt_chunk_pcm.wFormatTag = formatTag;
 	m_WaveHeader.fmt_chunk_pcm.wChannels = numChannels;
 	m_WaveHeader.fmt_chunk_pcm.dwSamplesPerSec = dwSamplesPerSec;
-	m_WaveHeader.fmt_chunk_pcm.dwAvgBytesPerSec = numChannels * dwSamplesPerSec * (16 / 8);
-	m_WaveHeader.fmt_chunk_pcm.wBlockAlign = numChannels * (16 / 8);
-	m_WaveHeader.fmt_chunk_pcm.wBitsPerSample = 16;
+	m_WaveHeader.fmt_chunk_pcm.dwAvgBytesPerSec = numChannels * dwSamplesPerSec * (bitsPerSample / 8);
+	m_WaveHeader.fmt_chunk_pcm.wBlockAlign = numChannels * (bitsPerSample / 8);
+	m_WaveHeader.fmt_chunk_pcm.wBitsPerSample = bitsPerSample;
 
 	memcpy(m_WaveHeader.data_chunk_hdr.id, "data", 4);
 	m_WaveHeader.data_chunk_hdr.len = 0;
 
 	fwrite(&m_WaveHeader, sizeof(m_WaveHeader), 1, m_File);
+
+	m_Buffer.resize(MIRV_WAV_BUFFER_SIZE < m_WaveHeader.fmt_chunk_pcm.wBlockAlign ? m_WaveHeader.fmt_chunk_pcm.wBlockAlign : MIRV_WAV_BUFFER_SIZE);
 }
 
 void CMirvWav::Append(int numChannels, WORD * data)
@@ -42,31 +71,116 @@ void CMirvWav::Append(int numChannels, WORD * data)
 	if (!m_File)
 		return;
 
+	BeginBlock();
+
 	for (int i = 0; i < m_WaveHeader.fmt_chunk_pcm.wChannels; ++i)
 	{
 		WORD curData = i < numChannels ? data[i] : 0;
 
-		fwrite(&curData, sizeof(WORD), 1, m_File);
+		if (SF_PCM16 == m_SampleFormat)
+		{
+			// Keep 16 bit data as is.
+			m_Buffer[m_BufferUsed++] = (unsigned char)(curData & 0xff);
+			m_Buffer[m_BufferUsed++] = (unsigned char)(curData >> 8);
+		}
+		else
+			WriteValue((short)curData / 32768.0f);
 	}
 
 	++m_WaveSamplesWritten;
 }
 
+void CMirvWav::AppendPlanar(int numChannels, float const * data, size_t samples, float scale)
+{
+	if (!m_File)
+		return;
+
+	for (size_t j = 0; j < samples; ++j)
+	{
+		BeginBlock();
+
+		for (int i = 0; i < m_WaveHeader.fmt_chunk_pcm.wChannels; ++i)
+		{
+			WriteValue(i < numChannels ? scale * data[i * samples + j] : 0.0f);
+		}
+
+		++m_WaveSamplesWritten;
+	}
+}
+
 CMirvWav::~CMirvWav()
 {
 	if (!m_File) return;
 
-	long lfpos = ftell(m_File);
+	FlushBuffer();
 
-	fseek(m_File, 0, SEEK_SET);
+	// RIFF chunks have to be of even size:
+	if (m_WaveSamplesWritten * m_WaveHeader.fmt_chunk_pcm.wBlockAlign & 1)
+		fputc(0, m_File);
+
+	WriteHeader();
+
+	fclose(m_File);
+}
+
+void CMirvWav::FlushBuffer(void)
+{
+	if (0 < m_BufferUsed)
+	{
+		fwrite(&(m_Buffer[0]), m_BufferUsed, 1, m_File);
+		m_BufferUsed = 0;
+	}
+}
+
+void CMirvWav::WriteHeader(void)
+{
+	DWORD dataLen = m_WaveSamplesWritten * m_WaveHeader.fmt_chunk_pcm.wBlockAlign;
 
 	// we need fo finish the header:
-	m_WaveHeader.riff_hdr.len = lfpos - 4;
-	m_WaveHeader.data_chunk_hdr.len = m_WaveSamplesWritten * (m_WaveHeader.fmt_chunk_pcm.wBitsPerSample / 8) * m_WaveHeader.fmt_chunk_pcm.wChannels;
+	m_WaveHeader.riff_hdr.len = sizeof(m_WaveHeader) - sizeof(m_WaveHeader.riff_hdr) + dataLen + (dataLen & 1);
+	m_WaveHeader.data_chunk_hdr.len = dataLen;
 
 	// and write it:
+	fseek(m_File, 0, SEEK_SET);
 	fwrite(&m_WaveHeader, sizeof(m_WaveHeader), 1, m_File);
+}
 
-	fclose(m_File);
+void CMirvWav::BeginBlock(void)
+{
+	if (m_Buffer.size() - m_BufferUsed < m_WaveHeader.fmt_chunk_pcm.wBlockAlign)
+		FlushBuffer();
 }
 
+void CMirvWav::WriteValue(float value)
+{
+	unsigned char * p = &(m_Buffer[m_BufferUsed]);
+
+	switch (m_SampleFormat)
+	{
+	case SF_PCM16:
+		{
+			float fVal = value * 32768.0f;
+			fVal = fVal < -32768.0f ? -32768.0f : (32767.0f < fVal ? 32767.0f : fVal);
+			int iVal = (int)std::round(fVal);
+			p[0] = (unsigned char)(iVal & 0xff);
+			p[1] = (unsigned char)((iVal >> 8) & 0xff);
+			m_BufferUsed += 2;
+		}
+		break;
+	case SF_PCM24:
+		{
+			double dVal = value * 8388608.0;
+			dVal = dVal < -8388608.0 ? -8388608.0 : (8388607.0 < dVal ? 8388607.0 : dVal);
+			int iVal = (int)std::round(dVal);
+			p[0] = (unsigned char)(iVal & 0xff);
+			p[1] = (unsigned char)((iVal >> 8) & 0xff);
+			p[2] = (unsigned char)((iVal >> 16) & 0xff);
+			m_BufferUsed += 3;
+		}
+		break;
+	case SF_FLOAT:
+		memcpy(p, &value, sizeof(float));
+		m_BufferUsed += sizeof(float);
+		break;
+	}
+}
@@ -3,13 +3,29 @@
 #include <windows.h>
 #include <stdio.h>
 
+#include <vector>
+
 class CMirvWav
 {
 public:
-	CMirvWav(const wchar_t * fileName, int numChannels, DWORD samplesPerSec);
+	enum SampleFormat
+	{
+		SF_PCM16,
+		SF_PCM24,
+
+		/// <summary>IEEE 754 32 bit float</summary>
+		SF_FLOAT
+	};
+
+	CMirvWav(const wchar_t * fileName, int numChannels, DWORD samplesPerSec, SampleFormat sampleFormat = SF_PCM16);
 
+	/// <summary>Appends one 16 bit PCM sample per channel, missing channels are filled with silence.</summary>
 	void Append(int numChannels, WORD * data);
 
+	/// <summary>Appends samples stored per channel (all samples of channel 0, then all of channel 1, ...).</summary>
+	/// <param name="scale">Factor mapping data to full scale [-1.0, 1.0].</param>
+	void AppendPlanar(int numChannels, float const * data, size_t samples, float scale);
+
 	~CMirvWav();
 
 private:
@@ -55,5 +71,18 @@ private:
 	FILE * m_File;
 	wave_header_s m_WaveHeader;
 	DWORD m_WaveSamplesWritten;
-};
+	SampleFormat m_SampleFormat;
+
+	std::vector<unsigned char> m_Buffer;
+	size_t m_BufferUsed;
+
+	void FlushBuffer(void);
 
+	void WriteHeader(void);
+
+	/// <summary>Makes sure there is room for a whole block (one sample for all channels) in m_Buffer.</summary>
+	void BeginBlock(void);
+
+	/// <param name="value">[-1.0, 1.0] is full scale.</param>
+	void WriteValue(float value);
+};
@@ -2,7 +2,12 @@
 
 #include "addresses.h"
 
+#include "hlaeFolder.h"
+
 #include <shared/binutils.h>
+#include <shared/vcpp/AfxAddrCache.h>
+
+#include <string>
 
 SourceSdkVer g_SourceSdkVer = SourceSdkVer_Unknonw;
 
@@ -79,6 +84,8 @@ AFXADDR_DEF(csgo_RTTI_IGameEvent);
 
 void ErrorBox(char const * messageText);
 
+extern unsigned int g_ErrorBoxCount;
+
 #define STRINGIZE(x) STRINGIZE2(x)
 #define STRINGIZE2(x) #x
 #define MkErrStr(file,line) "Problem in " file ":" STRINGIZE(line)
@@ -155,7 +162,7 @@ void Addresses_InitShaderApiDll(AfxAddr shaderApiDll, SourceSdkVer sourceSdkVer)
 }
 */
 
-void Addresses_InitEngineDll(AfxAddr engineDll, SourceSdkVer sourceSdkVer)
+void Addresses_ScanEngineDll(AfxAddr engineDll, SourceSdkVer sourceSdkVer)
 {
 	if (SourceSdkVer_CSGO == sourceSdkVer)
 	{
@@ -575,7 +582,7 @@ void Addresses_InitEngineDll(AfxAddr engineDll, SourceSdkVer sourceSdkVer)
 	AFXADDR_SET(csgo_CVoiceWriter_AddDecompressedData_DSZ, 0x8);
 }
 
-void Addresses_InitPanoramaDll(AfxAddr panoramaDll, SourceSdkVer sourceSdkVer)
+void Addresses_ScanPanoramaDll(AfxAddr panoramaDll, SourceSdkVer sourceSdkVer)
 {
 	if(SourceSdkVer_CSGO == sourceSdkVer)
 	{
@@ -610,10 +617,41 @@ void Addresses_InitPanoramaDll(AfxAddr panoramaDll, SourceSdkVer sourceSdkVer)
 	}
 }
 
-void Addresses_InitClientDll(AfxAddr clientDll, SourceSdkVer sourceSdkVer)
+void Addresses_ScanClientDll(AfxAddr clientDll, SourceSdkVer sourceSdkVer)
 {
 	if(SourceSdkVer_CSGO == sourceSdkVer)
 	{
+		// The patterns searched for in the whole .text section are searched
+		// for in a single pass (they are independent of each other):
+
+		enum ClientTextPattern_e
+		{
+			CTP_CViewRender_RenderView_VGui_DrawHud,
+			CTP_Unknown_GetTeamsSwappedOnScreen,
+			CTP_CRendering3dView_DrawTranslucentRenderables,
+			CTP_Count
+		};
+
+		static char const * const clientTextPatterns[CTP_Count] = {
+			"0F 84 ?? ?? ?? ?? 8B 0D ?? ?? ?? ?? 8B 81 0C 10 00 00 89 44 24 40 85 C0 74 16 6A 04 6A 00 68 ?? ?? ?? ?? 6A 00 68 ?? ?? ?? ?? FF 15 ?? ?? ?? ?? E8 ?? ?? ?? ??",
+			"8B 0D ?? ?? ?? ?? 53 56 E8 ?? ?? ?? ?? 8B 15 ?? ?? ?? ??",
+			"55 8B EC 81 EC ?? ?? ?? ?? 83 3D ?? ?? ?? ?? 00 53 56 8B D9 57 89 5D ?? 74 ??"
+		};
+
+		bool clientTextOk = false;
+		MemRange clientTextRange;
+		MemRange clientTextResults[CTP_Count];
+		{
+			ImageSectionsReader sections((HMODULE)clientDll);
+			if (!sections.Eof())
+			{
+				clientTextOk = true;
+				clientTextRange = sections.GetMemRange();
+			}
+
+			FindPatternStrings(clientTextRange, CTP_Count, clientTextPatterns, clientTextResults);
+		}
+
 		// csgo_CCSGO_HudDeathNotice_FireGameEvent // Checked 2018-08-03.
 		{
 			AFXADDR_SET(csgo_CCSGO_HudDeathNotice_FireGameEvent, 0x0);
@@ -691,10 +729,8 @@ void Addresses_InitClientDll(AfxAddr clientDll, SourceSdkVer sourceSdkVer)
 			AFXADDR_SET(csgo_CViewRender_RenderView_VGui_DrawHud_In, 0);
 			AFXADDR_SET(csgo_CViewRender_RenderView_VGui_DrawHud_Out, 0);
 
-			ImageSectionsReader sections((HMODULE)clientDll);
-			
-			MemRange baseRange = sections.GetMemRange();
-			MemRange result = FindPatternString(baseRange, "0F 84 ?? ?? ?? ?? 8B 0D ?? ?? ?? ?? 8B 81 0C 10 00 00 89 44 24 40 85 C0 74 16 6A 04 6A 00 68 ?? ?? ?? ?? 6A 00 68 ?? ?? ?? ?? FF 15 ?? ?? ?? ?? E8 ?? ?? ?? ??");
+			MemRange baseRange = clientTextRange;
+			MemRange result = clientTextResults[CTP_CViewRender_RenderView_VGui_DrawHud];
 			if(!result.IsEmpty())
 			{
 				DWORD jzAddr = *(DWORD *)(result.Start + 2) + result.Start + 6;
@@ -1622,12 +1658,9 @@ void Addresses_InitClientDll(AfxAddr clientDll, SourceSdkVer sourceSdkVer)
 		{
 			DWORD addr = 0;
 
-			ImageSectionsReader sections((HMODULE)clientDll);
-			if (!sections.Eof())
+			if (clientTextOk)
 			{
-				MemRange textRange = sections.GetMemRange();
-
-				MemRange result = FindPatternString(textRange, "8B 0D ?? ?? ?? ?? 53 56 E8 ?? ?? ?? ?? 8B 15 ?? ?? ?? ??");
+				MemRange result = clientTextResults[CTP_Unknown_GetTeamsSwappedOnScreen];
 
 				if (!result.IsEmpty())
 					addr = result.Start;
@@ -1646,12 +1679,9 @@ void Addresses_InitClientDll(AfxAddr clientDll, SourceSdkVer sourceSdkVer)
 		{
 			DWORD addr = 0;
 
-			ImageSectionsReader sections((HMODULE)clientDll);
-			if (!sections.Eof())
+			if (clientTextOk)
 			{
-				MemRange textRange = sections.GetMemRange();
-
-				MemRange result = FindPatternString(textRange, "55 8B EC 81 EC ?? ?? ?? ?? 83 3D ?? ?? ?? ?? 00 53 56 8B D9 57 89 5D ?? 74 ??");
+				MemRange result = clientTextResults[CTP_CRendering3dView_DrawTranslucentRenderables];
 
 				if (!result.IsEmpty())
 					addr = result.Start;
@@ -1781,6 +1811,64 @@ void Addresses_InitClientDll(AfxAddr clientDll, SourceSdkVer sourceSdkVer)
 	AFXADDR_SET(csgo_CUnknown_GetPlayerName_DSZ, 0x0B);
 }
 
+/// <summary>Resolves the addresses of module with scan, unless they are in the cache (from an earlier launch) already.</summary>
+void Addresses_Resolve(char const * moduleName, SourceSdkVer sourceSdkVer, AfxAddr module, std::function<void(void)> const & scan)
+{
+	static CAfxAddrCache cache(__DATE__ " " __TIME__);
+	static bool cacheLoaded = false;
+
+	std::wstring fileName(GetHlaeFolderW());
+	fileName.append(L"AfxHookSource_addresses.cache");
+
+	if (!cacheLoaded)
+	{
+		cacheLoaded = true;
+
+		FILE * file = 0;
+		if (0 == _wfopen_s(&file, fileName.c_str(), L"rb") && file)
+		{
+			cache.Load(file);
+			fclose(file);
+		}
+	}
+
+	std::string key(moduleName);
+	key.append("/");
+	key.append(std::to_string((int)sourceSdkVer));
+
+	bool cached = cache.Resolve(key.c_str(), module, [&scan]()
+	{
+		unsigned int errorBoxCount = g_ErrorBoxCount;
+		scan();
+		return errorBoxCount == g_ErrorBoxCount;
+	});
+
+	if (!cached && cache.GetDirty())
+	{
+		FILE * file = 0;
+		if (0 == _wfopen_s(&file, fileName.c_str(), L"wb") && file)
+		{
+			cache.Save(file);
+			fclose(file);
+		}
+	}
+}
+
+void Addresses_InitEngineDll(AfxAddr engineDll, SourceSdkVer sourceSdkVer)
+{
+	Addresses_Resolve("engine.dll", sourceSdkVer, engineDll, [engineDll, sourceSdkVer]() { Addresses_ScanEngineDll(engineDll, sourceSdkVer); });
+}
+
+void Addresses_InitPanoramaDll(AfxAddr panoramaDll, SourceSdkVer sourceSdkVer)
+{
+	Addresses_Resolve("panorama.dll", sourceSdkVer, panoramaDll, [panoramaDll, sourceSdkVer]() { Addresses_ScanPanoramaDll(panoramaDll, sourceSdkVer); });
+}
+
+void Addresses_InitClientDll(AfxAddr clientDll, SourceSdkVer sourceSdkVer)
+{
+	Addresses_Resolve("client.dll", sourceSdkVer, clientDll, [clientDll, sourceSdkVer]() { Addresses_ScanClientDll(clientDll, sourceSdkVer); });
+}
+
 /*
 void Addresses_InitStdshader_dx9Dll(AfxAddr stdshader_dx9Dll, bool isCsgo)
 {
@@ -184,8 +184,7 @@ void CClientToolsCsgo::OnPostToolMessageCsgo(SOURCESDK::CSGO::HTOOLHANDLE hEntit
 
 				bool wasVisible = false;
 
-				WriteDictionary("entity_state");
-				Write((int)hEntity);
+				BeginEntityState((int)hEntity);
 				{
 					SOURCESDK::CSGO::BaseEntityRecordingState_t * pBaseEntityRs = (SOURCESDK::CSGO::BaseEntityRecordingState_t *)(msg->GetPtr("baseentity"));
 					if (pBaseEntityRs)
@@ -219,7 +218,7 @@ void CClientToolsCsgo::OnPostToolMessageCsgo(SOURCESDK::CSGO::HTOOLHANDLE hEntit
 					}
 				}
 
-				WriteDictionary("/");
+				EndEntityState();
 
 				bool viewModel = msg->GetBool("viewmodel");
 
@@ -234,8 +233,7 @@ void CClientToolsCsgo::OnPostToolMessageCsgo(SOURCESDK::CSGO::HTOOLHANDLE hEntit
 		{
 			if (GetRecording())
 			{
-				WriteDictionary("deleted");
-				Write((int)(it->first));
+				WriteDeleted((int)(it->first));
 			}
 
 			m_TrackedHandles.erase(it);
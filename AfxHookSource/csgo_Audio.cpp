@@ -28,10 +28,9 @@ double g_csgo_Audio_Remainder = 0;
 bool g_CAudioXAudio2_RecordAudio_Active = false;
 bool g_CAudioXAudio2_FirstCallInLoop = true;
 std::wstring g_CAudioXAudio2_RecordAudio_Dir;
+CMirvWav::SampleFormat g_CAudioXAudio2_RecordAudio_Format = CMirvWav::SF_PCM16;
 std::map<DWORD *, CMirvWav> g_CAudioXAudio2_RecordAudio_Files;
 
-std::vector<WORD> g_CAudioXAudio2_ChannelData;
-
 void __stdcall touring_CAudioXAudio2_UnkSupplyAudio(DWORD * this_ptr, int numChannels, float * audioData)
 {
 	if (g_CAudioXAudio2_RecordAudio_Active)
@@ -46,28 +45,13 @@ void __stdcall touring_CAudioXAudio2_UnkSupplyAudio(DWORD * this_ptr, int numCha
 			os << g_CAudioXAudio2_RecordAudio_Dir << L"\\audio_" << this_ptr << L".wav";
 			std::wstring fileName = os.str();
 
-			it = g_CAudioXAudio2_RecordAudio_Files.emplace(std::piecewise_construct, std::forward_as_tuple(this_ptr), std::forward_as_tuple(fileName.c_str(), numChannels, 44100)).first;
+			it = g_CAudioXAudio2_RecordAudio_Files.emplace(std::piecewise_construct, std::forward_as_tuple(this_ptr), std::forward_as_tuple(fileName.c_str(), numChannels, 44100, g_CAudioXAudio2_RecordAudio_Format)).first;
 		}
 
 		const int samples = 512;
 
-		if ((int)g_CAudioXAudio2_ChannelData.size() < numChannels)
-			g_CAudioXAudio2_ChannelData.resize(numChannels);
-
-		for (int j = 0; j < samples; ++j)
-		{
-			for (int i = 0; i < numChannels; ++i)
-			{
-				float fVal = audioData[i*samples + j];
-				fVal = min(max(fVal, -32768), 32767);
-				fVal = std::round(fVal);
-				int iVal = (int)fVal;
-				WORD wVal = (WORD)iVal;
-				g_CAudioXAudio2_ChannelData[i] = wVal;
-			}
-
-			it->second.Append(numChannels, &g_CAudioXAudio2_ChannelData[0]);
-		}
+		// audioData is 16 bit full scale:
+		it->second.AppendPlanar(numChannels, audioData, samples, 1.0f / 32768.0f);
 
 	}
 
@@ -139,7 +123,7 @@ bool csgo_Audio_Install(void)
 	return firstResult;
 }
 
-bool csgo_Audio_StartRecording(const wchar_t * ansiTakeDir)
+bool csgo_Audio_StartRecording(const wchar_t * ansiTakeDir, CMirvWav::SampleFormat sampleFormat)
 {
 	if (!csgo_Audio_Install())
 		return false;
@@ -149,6 +133,7 @@ bool csgo_Audio_StartRecording(const wchar_t * ansiTakeDir)
 	std::unique_lock<std::mutex> lock(g_csgo_Audio_Mutex);
 
 	g_CAudioXAudio2_RecordAudio_Dir = ansiTakeDir;
+	g_CAudioXAudio2_RecordAudio_Format = sampleFormat;
 	g_CAudioXAudio2_RecordAudio_Active = true;
 	g_csgo_Audio_TimeDue = 0;
 	g_csgo_Audio_Remainder = 0;
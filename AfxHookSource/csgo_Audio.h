@@ -1,8 +1,10 @@
 #pragma once
 
+#include "MirvWav.h"
+
 bool csgo_Audio_Install(void);
 
-bool csgo_Audio_StartRecording(const wchar_t * ansiTakeDir);
+bool csgo_Audio_StartRecording(const wchar_t * ansiTakeDir, CMirvWav::SampleFormat sampleFormat = CMirvWav::SF_PCM16);
 void csgo_Audio_EndRecording(void);
 
 void csgo_Audio_FRAME_RENDEREND(void);
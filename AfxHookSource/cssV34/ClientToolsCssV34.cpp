@@ -115,8 +115,7 @@ void CClientToolsCssV34::OnPostToolMessageCssV34(SOURCESDK::CSSV34::HTOOLHANDLE
 
 				bool wasVisible = false;
 
-				WriteDictionary("entity_state");
-				Write((int)hEntity);
+				BeginEntityState((int)hEntity);
 				{
 					SOURCESDK::CSSV34::BaseEntityRecordingState_t * pBaseEntityRs = (SOURCESDK::CSSV34::BaseEntityRecordingState_t *)(msg->GetPtr("baseentity"));
 					if (pBaseEntityRs)
@@ -150,7 +149,7 @@ void CClientToolsCssV34::OnPostToolMessageCssV34(SOURCESDK::CSSV34::HTOOLHANDLE
 					}
 				}
 
-				WriteDictionary("/");
+				EndEntityState();
 
 				bool viewModel = 0 != msg->GetInt("viewmodel");
 
@@ -165,8 +164,7 @@ void CClientToolsCssV34::OnPostToolMessageCssV34(SOURCESDK::CSSV34::HTOOLHANDLE
 		{
 			if (GetRecording())
 			{
-				WriteDictionary("deleted");
-				Write((int)(it->first));
+				WriteDeleted((int)(it->first));
 			}
 
 			m_TrackedHandles.erase(it);
@@ -54,6 +54,7 @@
 //#include <csgo/hooks/studiorender.h>
 #include <insurgency2/public/cdll_int.h>
 #include "MirvTime.h"
+#include "MirvCalcs.h"
 #include "csgo_CRendering3dView.h"
 
 #include <Windows.h>
@@ -79,7 +80,10 @@ SOURCESDK::L4D2::ICvar * SOURCESDK::L4D2::cvar = 0;
 SOURCESDK::L4D2::ICvar * SOURCESDK::L4D2::g_pCVar = 0;
 
 
+unsigned int g_ErrorBoxCount = 0;
+
 void ErrorBox(char const * messageText) {
+	++g_ErrorBoxCount;
 	MessageBoxA(0, messageText, "Error - AfxHookSource", MB_OK|MB_ICONERROR);
 }
 
@@ -466,6 +470,7 @@ int __stdcall new_CVClient_Init_Swarm(DWORD *this_ptr, SOURCESDK::CreateInterfac
 void Shared_BeforeFrameRenderStart(void)
 {
 	g_MirvTime.OnFrameRenderStart();
+	MirvCalcs_OnBeforeFrameRenderStart();
 
 	if (CClientTools * instance = CClientTools::Instance()) instance->OnBeforeFrameRenderStart();
 }
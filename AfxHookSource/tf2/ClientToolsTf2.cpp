@@ -108,8 +108,7 @@ void CClientToolsTf2::OnPostToolMessageTf2(SOURCESDK::TF2::HTOOLHANDLE hEntity,
 
 				bool wasVisible = false;
 
-				WriteDictionary("entity_state");
-				Write((int)hEntity);
+				BeginEntityState((int)hEntity);
 				{
 					SOURCESDK::TF2::BaseEntityRecordingState_t * pBaseEntityRs = (SOURCESDK::TF2::BaseEntityRecordingState_t *)(msg->GetPtr("baseentity"));
 					if (pBaseEntityRs)
@@ -143,7 +142,7 @@ void CClientToolsTf2::OnPostToolMessageTf2(SOURCESDK::TF2::HTOOLHANDLE hEntity,
 					}
 				}
 
-				WriteDictionary("/");
+				EndEntityState();
 
 				bool viewModel = msg->GetBool("viewmodel");
 
@@ -158,8 +157,7 @@ void CClientToolsTf2::OnPostToolMessageTf2(SOURCESDK::TF2::HTOOLHANDLE hEntity,
 		{
 			if (GetRecording())
 			{
-				WriteDictionary("deleted");
-				Write((int)(it->first));
+				WriteDeleted((int)(it->first));
 			}
 
 			m_TrackedHandles.erase(it);
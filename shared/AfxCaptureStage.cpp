@@ -0,0 +1,191 @@
+#include "stdafx.h"
+
+#include "AfxCaptureStage.h"
+
+#include <chrono>
+
+// CAfxCaptureStage ////////////////////////////////////////////////////////////
+
+class CAfxCaptureStage::CQueue
+{
+public:
+	std::deque<std::function<void(void)>> Jobs;
+
+	/// <summary>If in m_Ready or running a job.</summary>
+	bool Scheduled = false;
+
+	bool Deleted = false;
+};
+
+CAfxCaptureStage::CAfxCaptureStage(char const * name, size_t workerCount, size_t maxQueueDepth)
+	: m_Name(name)
+	, m_WorkerCount(workerCount < 1 ? 1 : workerCount)
+	, m_MaxQueueDepth(maxQueueDepth < 1 ? 1 : maxQueueDepth)
+{
+}
+
+CAfxCaptureStage::~CAfxCaptureStage()
+{
+	Shutdown();
+}
+
+CAfxCaptureStage::CQueue * CAfxCaptureStage::CreateQueue(void)
+{
+	return new CQueue();
+}
+
+void CAfxCaptureStage::DeleteQueue(CQueue * queue)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	if (queue->Scheduled)
+		queue->Deleted = true;
+	else
+		delete queue;
+}
+
+void CAfxCaptureStage::Queue(CQueue * queue, std::function<void(void)> && job)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	if (m_MaxQueueDepth <= queue->Jobs.size())
+	{
+		std::chrono::steady_clock::time_point stallStart = std::chrono::steady_clock::now();
+
+		m_SpaceCondition.wait(lock, [this, queue]() { return queue->Jobs.size() < m_MaxQueueDepth; });
+
+		++m_StallCount;
+		m_StallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - stallStart).count();
+	}
+
+	if (m_Threads.empty())
+	{
+		m_Quit = false;
+
+		for (size_t i = 0; i < m_WorkerCount; ++i)
+		{
+			m_Threads.emplace_back(&CAfxCaptureStage::Worker, this);
+		}
+	}
+
+	queue->Jobs.emplace_back(std::move(job));
+
+	++m_Queued;
+	if (m_MaxQueued < m_Queued) m_MaxQueued = m_Queued;
+
+	if (!queue->Scheduled)
+	{
+		queue->Scheduled = true;
+		m_Ready.push_back(queue);
+		m_ReadyCondition.notify_one();
+	}
+}
+
+void CAfxCaptureStage::Wait(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	m_IdleCondition.wait(lock, [this]() { return 0 == m_Queued; });
+}
+
+void CAfxCaptureStage::Shutdown(void)
+{
+	Wait();
+
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Quit = true;
+	}
+
+	m_ReadyCondition.notify_all();
+
+	for (auto it = m_Threads.begin(); it != m_Threads.end(); ++it)
+	{
+		it->join();
+	}
+
+	m_Threads.clear();
+}
+
+size_t CAfxCaptureStage::GetQueued(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	return m_Queued;
+}
+
+size_t CAfxCaptureStage::GetMaxQueued(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	return m_MaxQueued;
+}
+
+unsigned long long CAfxCaptureStage::GetDone(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	return m_Done;
+}
+
+void CAfxCaptureStage::GetStalls(unsigned long long & outCount, double & outSeconds)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	outCount = m_StallCount;
+	outSeconds = m_StallSeconds;
+}
+
+void CAfxCaptureStage::ResetStats(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	m_MaxQueued = m_Queued;
+	m_Done = 0;
+	m_StallCount = 0;
+	m_StallSeconds = 0.0;
+}
+
+void CAfxCaptureStage::Worker(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	while (true)
+	{
+		m_ReadyCondition.wait(lock, [this]() { return m_Quit || !m_Ready.empty(); });
+
+		if (m_Ready.empty()) break;
+
+		CQueue * queue = m_Ready.front();
+		m_Ready.pop_front();
+
+		std::function<void(void)> job(std::move(queue->Jobs.front()));
+		queue->Jobs.pop_front();
+
+		m_SpaceCondition.notify_all();
+
+		lock.unlock();
+
+		job();
+
+		lock.lock();
+
+		--m_Queued;
+		++m_Done;
+
+		if (queue->Jobs.empty())
+		{
+			queue->Scheduled = false;
+
+			if (queue->Deleted) delete queue;
+		}
+		else
+		{
+			// To the back, so other streams get their turn:
+			m_Ready.push_back(queue);
+			m_ReadyCondition.notify_one();
+		}
+
+		if (0 == m_Queued) m_IdleCondition.notify_all();
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// A stage of the capture pipeline with its own worker threads.
+/// Jobs of one queue (one per stream) run one at a time in the order queued,
+/// so frames leave a stage in the order they entered it.
+/// Jobs of different queues run in parallel.
+/// </summary>
+class CAfxCaptureStage
+{
+public:
+	class CQueue;
+
+	/// <param name="maxQueueDepth">Queue blocks while a queue has this many jobs waiting.</param>
+	CAfxCaptureStage(char const * name, size_t workerCount, size_t maxQueueDepth);
+
+	/// <remarks>Waits for all jobs to finish.</remarks>
+	~CAfxCaptureStage();
+
+	char const * GetName(void) const
+	{
+		return m_Name;
+	}
+
+	size_t GetWorkerCount(void) const
+	{
+		return m_WorkerCount;
+	}
+
+	CQueue * CreateQueue(void);
+
+	/// <summary>Deletes the queue as soon as the jobs queued on it are done.</summary>
+	void DeleteQueue(CQueue * queue);
+
+	/// <summary>Queues job on queue, blocks while queue is full.</summary>
+	/// <remarks>
+	/// Workers of a stage must only queue on later stages,
+	/// otherwise they can block on themselves.
+	/// The worker threads are started on first use.
+	/// </remarks>
+	void Queue(CQueue * queue, std::function<void(void)> && job);
+
+	/// <summary>Waits until all jobs queued so far are done.</summary>
+	void Wait(void);
+
+	/// <summary>Waits for all jobs and stops the worker threads.</summary>
+	void Shutdown(void);
+
+	//
+	// Statistics:
+
+	/// <summary>Jobs waiting or running.</summary>
+	size_t GetQueued(void);
+
+	size_t GetMaxQueued(void);
+
+	unsigned long long GetDone(void);
+
+	/// <summary>How often and for how long Queue blocked on a full queue.</summary>
+	void GetStalls(unsigned long long & outCount, double & outSeconds);
+
+	void ResetStats(void);
+
+private:
+	char const * m_Name;
+	size_t m_WorkerCount;
+	size_t m_MaxQueueDepth;
+
+	std::vector<std::thread> m_Threads;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_ReadyCondition;
+	std::condition_variable m_SpaceCondition;
+	std::condition_variable m_IdleCondition;
+
+	/// <summary>Queues that have jobs and are not running one.</summary>
+	std::deque<CQueue *> m_Ready;
+
+	size_t m_Queued = 0;
+	bool m_Quit = false;
+
+	size_t m_MaxQueued = 0;
+	unsigned long long m_Done = 0;
+	unsigned long long m_StallCount = 0;
+	double m_StallSeconds = 0.0;
+
+	void Worker(void);
+};
@@ -0,0 +1,206 @@
+#include "stdafx.h"
+
+#include "AfxFrameWriter.h"
+
+#include <stdlib.h>
+
+// CAfxFrameWriter::CFrame /////////////////////////////////////////////////////
+
+CAfxFrameWriter::CFrame::CFrame()
+	: Data(0)
+	, Bytes(0)
+	, m_BytesAllocated(0)
+{
+}
+
+CAfxFrameWriter::CFrame::~CFrame()
+{
+	free(Data);
+}
+
+bool CAfxFrameWriter::CFrame::AutoRealloc(size_t bytes)
+{
+	if (!Data || m_BytesAllocated < bytes)
+	{
+		unsigned char * data = (unsigned char *)realloc(Data, bytes);
+
+		if (!data) return false;
+
+		Data = data;
+		m_BytesAllocated = bytes;
+	}
+
+	Bytes = bytes;
+
+	return true;
+}
+
+// CAfxFrameWriter /////////////////////////////////////////////////////////////
+
+CAfxFrameWriter::CAfxFrameWriter(size_t maxFrames, size_t threadCount, Policy policy)
+	: m_MaxFrames(maxFrames < 1 ? 1 : maxFrames)
+	, m_Policy(policy)
+	, m_Writing(0)
+	, m_Quit(false)
+	, m_Dropped(0)
+	, m_Failed(0)
+	, m_Written(0)
+	, m_MaxQueued(0)
+{
+	if (threadCount < 1) threadCount = 1;
+
+	for (size_t i = 0; i < threadCount; ++i)
+	{
+		m_Threads.emplace_back(&CAfxFrameWriter::WriterThread, this);
+	}
+}
+
+CAfxFrameWriter::~CAfxFrameWriter()
+{
+	Flush();
+
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Quit = true;
+	}
+
+	m_QueuedCondition.notify_all();
+
+	for (auto it = m_Threads.begin(); it != m_Threads.end(); ++it)
+	{
+		it->join();
+	}
+
+	for (auto it = m_Frames.begin(); it != m_Frames.end(); ++it)
+	{
+		delete *it;
+	}
+}
+
+CAfxFrameWriter::CFrame * CAfxFrameWriter::AquireFrame(size_t bytes)
+{
+	CFrame * frame = 0;
+
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		if (m_FreeFrames.empty() && m_Frames.size() < m_MaxFrames)
+		{
+			// Grow the pool:
+			m_Frames.push_back(new CFrame());
+			m_FreeFrames.push(m_Frames.back());
+		}
+
+		if (m_FreeFrames.empty())
+		{
+			if (Policy_Drop == m_Policy)
+			{
+				++m_Dropped;
+				return 0;
+			}
+
+			m_FrameAvailableCondition.wait(lock, [this]() { return !m_FreeFrames.empty(); });
+		}
+
+		frame = m_FreeFrames.top();
+		m_FreeFrames.pop();
+	}
+
+	if (!frame->AutoRealloc(bytes))
+	{
+		Discard(frame);
+		return 0;
+	}
+
+	return frame;
+}
+
+void CAfxFrameWriter::Submit(CFrame * frame)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		m_Queue.push(frame);
+
+		if (m_MaxQueued < m_Queue.size()) m_MaxQueued = m_Queue.size();
+	}
+
+	m_QueuedCondition.notify_one();
+}
+
+void CAfxFrameWriter::Discard(CFrame * frame)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		frame->Write = nullptr;
+		m_FreeFrames.push(frame);
+	}
+
+	m_FrameAvailableCondition.notify_one();
+}
+
+void CAfxFrameWriter::Flush(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	m_IdleCondition.wait(lock, [this]() { return m_Queue.empty() && 0 == m_Writing; });
+}
+
+size_t CAfxFrameWriter::GetDroppedCount(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	return m_Dropped;
+}
+
+size_t CAfxFrameWriter::GetFailedCount(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	return m_Failed;
+}
+
+size_t CAfxFrameWriter::GetWrittenCount(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	return m_Written;
+}
+
+size_t CAfxFrameWriter::GetMaxQueued(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	return m_MaxQueued;
+}
+
+void CAfxFrameWriter::WriterThread(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	while (true)
+	{
+		m_QueuedCondition.wait(lock, [this]() { return m_Quit || !m_Queue.empty(); });
+
+		if (m_Queue.empty())
+			break; // m_Quit
+
+		CFrame * frame = m_Queue.front();
+		m_Queue.pop();
+		++m_Writing;
+
+		lock.unlock();
+
+		bool ok = !frame->Write || frame->Write(*frame);
+		frame->Write = nullptr;
+
+		lock.lock();
+
+		if (ok) ++m_Written;
+		else ++m_Failed;
+
+		--m_Writing;
+		m_FreeFrames.push(frame);
+
+		m_FrameAvailableCondition.notify_one();
+
+		if (m_Queue.empty() && 0 == m_Writing) m_IdleCondition.notify_all();
+	}
+}
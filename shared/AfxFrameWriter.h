@@ -0,0 +1,99 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <stack>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Bounded queue of recycled frame buffers that are written by a set of
+/// writer threads, so that disk stalls don't stall the thread capturing.
+/// Modelled after AfxHookSource's CAfxImageBufferPool.
+/// </summary>
+class CAfxFrameWriter
+{
+public:
+	enum Policy
+	{
+		/// <summary>AquireFrame waits until a frame buffer is available.</summary>
+		Policy_Block,
+
+		/// <summary>AquireFrame fails if no frame buffer is available.</summary>
+		Policy_Drop
+	};
+
+	class CFrame
+	{
+	public:
+		/// <summary>Memory for the frame, at least Bytes big.</summary>
+		unsigned char * Data;
+
+		size_t Bytes;
+
+		/// <summary>Called on a writer thread with the frame, the return value is counted for the stats.</summary>
+		std::function<bool(CFrame const & frame)> Write;
+
+	private:
+		friend class CAfxFrameWriter;
+
+		CFrame();
+		~CFrame();
+
+		bool AutoRealloc(size_t bytes);
+
+		size_t m_BytesAllocated;
+	};
+
+	/// <param name="maxFrames">Maximum number of frame buffers (queued + being written + aquired).</param>
+	/// <param name="threadCount">Number of writer threads.</param>
+	CAfxFrameWriter(size_t maxFrames, size_t threadCount, Policy policy);
+
+	/// <summary>Waits for all submitted frames to be written.</summary>
+	~CAfxFrameWriter();
+
+	/// <returns>nullptr if no buffer could be aquired (Policy_Drop only) or memory allocation failed, otherwise a frame with at least bytes Data.</returns>
+	CFrame * AquireFrame(size_t bytes);
+
+	/// <summary>Queues a frame aquired with AquireFrame for writing, frames are started to be written in the order they are submitted.</summary>
+	void Submit(CFrame * frame);
+
+	/// <summary>Returns a frame aquired with AquireFrame without writing it.</summary>
+	void Discard(CFrame * frame);
+
+	/// <summary>Waits until all submitted frames are written.</summary>
+	void Flush(void);
+
+	size_t GetDroppedCount(void);
+	size_t GetFailedCount(void);
+	size_t GetWrittenCount(void);
+
+	/// <returns>Maximum number of frames that have been queued at once.</returns>
+	size_t GetMaxQueued(void);
+
+private:
+	size_t m_MaxFrames;
+	Policy m_Policy;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_FrameAvailableCondition;
+	std::condition_variable m_QueuedCondition;
+	std::condition_variable m_IdleCondition;
+
+	std::vector<CFrame *> m_Frames;
+	std::stack<CFrame *> m_FreeFrames;
+	std::queue<CFrame *> m_Queue;
+	size_t m_Writing;
+	bool m_Quit;
+
+	size_t m_Dropped;
+	size_t m_Failed;
+	size_t m_Written;
+	size_t m_MaxQueued;
+
+	std::vector<std::thread> m_Threads;
+
+	void WriterThread(void);
+};
@@ -0,0 +1,883 @@
+#include "stdafx.h"
+
+#include "AfxGameRecord.h"
+
+#include "AfxPipeWriter.h"
+
+#include <string.h>
+#include <math.h>
+
+namespace {
+
+const char g_IndexMagic[8] = { 'a', 'f', 'x', 'I', 'd', 'x', '6', '\0' };
+
+inline uint64_t ZigZag(int64_t value)
+{
+	return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+inline int64_t UnZigZag(uint64_t value)
+{
+	return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+bool FileSeek(FILE * file, int64_t offset, int origin)
+{
+#ifdef _WIN32
+	return 0 == _fseeki64(file, offset, origin);
+#else
+	return 0 == fseeko(file, (off_t)offset, origin);
+#endif
+}
+
+} // namespace {
+
+// CAfxGameRecordWriter ////////////////////////////////////////////////////////
+
+CAfxGameRecordWriter::CAfxGameRecordWriter(int version, float epsilon)
+{
+	Reset(version, epsilon);
+}
+
+void CAfxGameRecordWriter::Reset(int version, float epsilon)
+{
+	m_Version = version;
+	m_Epsilon = 6 == version && 0 < epsilon ? epsilon : 0.0f;
+	m_Offset = 0;
+	m_Dictionary.clear();
+	m_Deltas.clear();
+	m_Delta = nullptr;
+	m_DeltaIndex = 0;
+	m_FrameOffsets.clear();
+}
+
+bool CAfxGameRecordWriter::PatchInt(size_t offset, int value)
+{
+	size_t bufferOffset = m_Offset - m_Buffer->size();
+
+	if (offset < bufferOffset || m_Offset < offset + sizeof(value))
+		return false;
+
+	memcpy(&(*m_Buffer)[offset - bufferOffset], &value, sizeof(value));
+	return true;
+}
+
+void CAfxGameRecordWriter::WriteHeader(void)
+{
+	Write("afxGameRecord");
+	Write(m_Version);
+
+	if (6 == m_Version) Write(m_Epsilon);
+}
+
+void CAfxGameRecordWriter::BeginFrame(void)
+{
+	if (6 == m_Version)
+	{
+		bool keyFrame = 0 == m_FrameOffsets.size() % KeyFrameInterval;
+
+		m_FrameOffsets.push_back((int64_t)m_Offset);
+
+		if (keyFrame)
+		{
+			m_Dictionary.clear();
+			m_Deltas.clear();
+			m_Delta = nullptr;
+
+			WriteDictionary("afxKeyFrame");
+		}
+	}
+
+	WriteDictionary("afxFrame");
+}
+
+void CAfxGameRecordWriter::WriteFooter(void)
+{
+	if (6 != m_Version)
+		return;
+
+	m_Delta = nullptr;
+
+	int64_t indexOffset = (int64_t)m_Offset;
+
+	WriteDictionary("afxFrameIndex");
+	Write((int)m_FrameOffsets.size());
+	Write((int)KeyFrameInterval);
+
+	if (!m_FrameOffsets.empty())
+		WriteBytes(&m_FrameOffsets[0], m_FrameOffsets.size() * sizeof(int64_t));
+
+	WriteBytes(&indexOffset, sizeof(indexOffset));
+	WriteBytes(g_IndexMagic, sizeof(g_IndexMagic));
+}
+
+void CAfxGameRecordWriter::BeginDelta(int key)
+{
+	if (6 != m_Version)
+		return;
+
+	m_Delta = &m_Deltas[key];
+	m_DeltaIndex = 0;
+}
+
+void CAfxGameRecordWriter::EndDelta(void)
+{
+	m_Delta = nullptr;
+}
+
+void CAfxGameRecordWriter::DeleteDelta(int key)
+{
+	std::unordered_map<int, std::vector<int64_t>>::iterator it = m_Deltas.find(key);
+
+	if (it != m_Deltas.end())
+	{
+		if (m_Delta == &it->second) m_Delta = nullptr;
+
+		m_Deltas.erase(it);
+	}
+}
+
+void CAfxGameRecordWriter::WriteDictionary(char const * value)
+{
+	std::pair<std::unordered_map<std::string, int>::iterator, bool> result = m_Dictionary.emplace(value, (int)m_Dictionary.size());
+
+	if (!result.second)
+	{
+		Write(result.first->second);
+		return;
+	}
+
+	Write((int)-1);
+	Write(value);
+}
+
+void CAfxGameRecordWriter::Write(bool value)
+{
+	WriteBytes(&value, sizeof(value));
+}
+
+void CAfxGameRecordWriter::Write(int value)
+{
+	WriteBytes(&value, sizeof(value));
+}
+
+void CAfxGameRecordWriter::Write(float value)
+{
+	if (nullptr == m_Delta)
+	{
+		WriteBytes(&value, sizeof(value));
+		return;
+	}
+
+	if (m_Delta->size() <= m_DeltaIndex) m_Delta->resize(m_DeltaIndex + 1, 0);
+
+	int64_t & previous = (*m_Delta)[m_DeltaIndex];
+	++m_DeltaIndex;
+
+	if (0 == m_Epsilon)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		WriteVarInt(bits ^ (uint32_t)previous);
+		previous = bits;
+		return;
+	}
+
+	double q = floor(value / (double)m_Epsilon + 0.5);
+
+	if (-4503599627370496.0 < q && q < 4503599627370496.0) // also false for NaN
+	{
+		int64_t qi = (int64_t)q;
+
+		WriteVarInt(ZigZag(qi - previous) << 1);
+		previous = qi;
+	}
+	else
+	{
+		WriteVarInt(1);
+		WriteBytes(&value, sizeof(value));
+	}
+}
+
+void CAfxGameRecordWriter::Write(double value)
+{
+	WriteBytes(&value, sizeof(value));
+}
+
+void CAfxGameRecordWriter::Write(char const * value)
+{
+	WriteBytes(value, strlen(value) + 1);
+}
+
+void CAfxGameRecordWriter::WriteBytes(void const * data, size_t size)
+{
+	m_Buffer->insert(m_Buffer->end(), (char const *)data, (char const *)data + size);
+	m_Offset += size;
+}
+
+void CAfxGameRecordWriter::WriteVarInt(uint64_t value)
+{
+	char bytes[10];
+	size_t count = 0;
+
+	while (0x80 <= value)
+	{
+		bytes[count++] = (char)(value | 0x80);
+		value >>= 7;
+	}
+	bytes[count++] = (char)value;
+
+	WriteBytes(bytes, count);
+}
+
+// CAfxGameRecording ///////////////////////////////////////////////////////////
+
+CAfxGameRecording::CAfxGameRecording()
+{
+}
+
+CAfxGameRecording::~CAfxGameRecording()
+{
+	End();
+
+	for (std::vector<std::vector<char> *>::iterator it = m_FreeBuffers.begin(); it != m_FreeBuffers.end(); ++it)
+	{
+		delete *it;
+	}
+}
+
+void CAfxGameRecording::Begin(FILE * file, int version, float epsilon)
+{
+	End();
+
+	m_HiddenOffset = 0;
+	m_Hidden.clear();
+
+	m_FileWriter = new CAfxPipeWriter(8, [file](void const * data, size_t bytes) {
+		return 1 == fwrite(data, bytes, 1, file);
+	});
+	m_Buffer = AquireBuffer();
+
+	m_Writer.Reset(6 == version ? 6 : 4, epsilon);
+	m_Writer.SetBuffer(m_Buffer);
+	m_Writer.WriteHeader();
+}
+
+bool CAfxGameRecording::End(void)
+{
+	if (nullptr == m_FileWriter)
+		return true;
+
+	m_Writer.WriteFooter();
+
+	Flush();
+
+	bool result = m_FileWriter->Finish();
+
+	delete m_FileWriter;
+	m_FileWriter = nullptr;
+
+	m_Writer.SetBuffer(nullptr);
+	ReleaseBuffer(m_Buffer);
+	m_Buffer = nullptr;
+
+	return result;
+}
+
+void CAfxGameRecording::BeginFrame(float frameTime)
+{
+	m_Writer.BeginFrame();
+	m_Writer.Write(frameTime);
+	m_HiddenOffset = m_Writer.GetOffset();
+	m_Writer.Write((int)0);
+}
+
+void CAfxGameRecording::MarkHidden(int value)
+{
+	m_Hidden.insert(value);
+}
+
+void CAfxGameRecording::EndFrame(void)
+{
+	if (m_HiddenOffset && 0 < m_Hidden.size())
+	{
+		m_Writer.WriteDictionary("afxHidden");
+
+		int offset = (int)(m_Writer.GetOffset() - m_HiddenOffset);
+
+		// The buffer is only flushed at frame end, so the placeholder is still in it:
+		m_Writer.PatchInt(m_HiddenOffset, offset);
+
+		m_Writer.Write((int)m_Hidden.size());
+
+		for (std::set<int>::iterator it = m_Hidden.begin(); it != m_Hidden.end(); ++it)
+		{
+			m_Writer.Write((int)(*it));
+		}
+
+		m_Hidden.clear();
+		m_HiddenOffset = 0;
+	}
+
+	m_Writer.WriteDictionary("afxFrameEnd");
+
+	Flush();
+}
+
+void CAfxGameRecording::Flush(void)
+{
+	if (m_Buffer->empty()) return;
+
+	std::vector<char> * buffer = m_Buffer;
+
+	m_Buffer = AquireBuffer();
+	m_Writer.SetBuffer(m_Buffer);
+
+	m_FileWriter->Queue(&(*buffer)[0], buffer->size(), [this, buffer]() {
+		ReleaseBuffer(buffer);
+	});
+}
+
+std::vector<char> * CAfxGameRecording::AquireBuffer(void)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_FreeBuffersMutex);
+
+		if (!m_FreeBuffers.empty())
+		{
+			std::vector<char> * buffer = m_FreeBuffers.back();
+			m_FreeBuffers.pop_back();
+			return buffer;
+		}
+	}
+
+	std::vector<char> * buffer = new std::vector<char>();
+	buffer->reserve(64 * 1024);
+	return buffer;
+}
+
+void CAfxGameRecording::ReleaseBuffer(std::vector<char> * buffer)
+{
+	buffer->clear();
+
+	std::unique_lock<std::mutex> lock(m_FreeBuffersMutex);
+
+	m_FreeBuffers.push_back(buffer);
+}
+
+// CAfxGameRecordReader ////////////////////////////////////////////////////////
+
+CAfxGameRecordReader::CAfxGameRecordReader()
+	: m_ReadBuffer(1024 * 1024)
+{
+}
+
+CAfxGameRecordReader::~CAfxGameRecordReader()
+{
+}
+
+bool CAfxGameRecordReader::Open(FILE * file)
+{
+	m_File = file;
+	m_Version = 0;
+	m_Epsilon = 0.0f;
+	m_EndOffset = -1;
+	m_FrameOffsets.clear();
+	ResetState();
+
+	if (!Seek(0))
+		return false;
+
+	std::string magic;
+	if (!Read(magic) || magic != "afxGameRecord" || !Read(m_Version))
+		return false;
+
+	if (4 == m_Version)
+		return true;
+
+	if (6 != m_Version || !Read(m_Epsilon))
+		return false;
+
+	int64_t recordsOffset = m_ReadBufferOffset + (int64_t)m_ReadPos;
+
+	// Frame index (missing if the recording was not ended properly):
+
+	int64_t indexOffset;
+	char indexMagic[sizeof(g_IndexMagic)];
+
+	if (FileSeek(m_File, -(int64_t)(sizeof(indexOffset) + sizeof(indexMagic)), SEEK_END)
+		&& 1 == fread(&indexOffset, sizeof(indexOffset), 1, m_File)
+		&& 1 == fread(indexMagic, sizeof(indexMagic), 1, m_File)
+		&& 0 == memcmp(indexMagic, g_IndexMagic, sizeof(indexMagic))
+		&& recordsOffset <= indexOffset
+		&& Seek(indexOffset))
+	{
+		int dictIndex;
+		std::string name;
+		int frameCount;
+		int keyFrameInterval;
+
+		if (Read(dictIndex) && -1 == dictIndex
+			&& Read(name) && name == "afxFrameIndex"
+			&& Read(frameCount) && 0 <= frameCount
+			&& Read(keyFrameInterval) && CAfxGameRecordWriter::KeyFrameInterval == keyFrameInterval)
+		{
+			m_FrameOffsets.resize(frameCount);
+
+			if (0 == frameCount || ReadBytes(&m_FrameOffsets[0], frameCount * sizeof(int64_t)))
+				m_EndOffset = indexOffset;
+			else
+				m_FrameOffsets.clear();
+		}
+	}
+
+	return Seek(recordsOffset);
+}
+
+int CAfxGameRecordReader::SeekKeyFrame(size_t frame)
+{
+	if (m_FrameOffsets.size() <= frame)
+		return -1;
+
+	size_t keyFrame = frame - frame % CAfxGameRecordWriter::KeyFrameInterval;
+
+	if (!Seek(m_FrameOffsets[keyFrame]))
+		return -1;
+
+	ResetState();
+
+	return (int)keyFrame;
+}
+
+bool CAfxGameRecordReader::Eof(void)
+{
+	if (0 <= m_EndOffset && m_EndOffset <= m_ReadBufferOffset + (int64_t)m_ReadPos)
+		return true;
+
+	if (m_ReadPos < m_ReadEnd)
+		return false;
+
+	m_ReadBufferOffset += m_ReadEnd;
+	m_ReadPos = 0;
+	m_ReadEnd = fread(&m_ReadBuffer[0], 1, m_ReadBuffer.size(), m_File);
+
+	return 0 == m_ReadEnd;
+}
+
+void CAfxGameRecordReader::BeginDelta(int key)
+{
+	if (6 != m_Version)
+		return;
+
+	m_Delta = &m_Deltas[key];
+	m_DeltaIndex = 0;
+}
+
+void CAfxGameRecordReader::EndDelta(void)
+{
+	m_Delta = nullptr;
+}
+
+void CAfxGameRecordReader::DeleteDelta(int key)
+{
+	std::unordered_map<int, std::vector<int64_t>>::iterator it = m_Deltas.find(key);
+
+	if (it != m_Deltas.end())
+	{
+		if (m_Delta == &it->second) m_Delta = nullptr;
+
+		m_Deltas.erase(it);
+	}
+}
+
+bool CAfxGameRecordReader::ReadDictionary(std::string const * & outValue)
+{
+	int index;
+
+	if (!Read(index))
+		return false;
+
+	if (-1 == index)
+	{
+		std::string value;
+
+		if (!Read(value))
+			return false;
+
+		if (6 == m_Version && value == "afxKeyFrame")
+			ResetState();
+
+		m_Dictionary.emplace_back(std::move(value));
+
+		outValue = &m_Dictionary.back();
+		return true;
+	}
+
+	if (index < 0 || (int)m_Dictionary.size() <= index)
+		return false;
+
+	outValue = &m_Dictionary[index];
+	return true;
+}
+
+bool CAfxGameRecordReader::Read(bool & outValue)
+{
+	return ReadBytes(&outValue, sizeof(outValue));
+}
+
+bool CAfxGameRecordReader::Read(int & outValue)
+{
+	return ReadBytes(&outValue, sizeof(outValue));
+}
+
+bool CAfxGameRecordReader::Read(float & outValue)
+{
+	if (nullptr == m_Delta)
+		return ReadBytes(&outValue, sizeof(outValue));
+
+	if (m_Delta->size() <= m_DeltaIndex) m_Delta->resize(m_DeltaIndex + 1, 0);
+
+	int64_t & previous = (*m_Delta)[m_DeltaIndex];
+	++m_DeltaIndex;
+
+	uint64_t value;
+
+	if (!ReadVarInt(value))
+		return false;
+
+	if (0 == m_Epsilon)
+	{
+		uint32_t bits = (uint32_t)value ^ (uint32_t)previous;
+
+		memcpy(&outValue, &bits, sizeof(outValue));
+		previous = bits;
+		return true;
+	}
+
+	if (value & 1)
+		return ReadBytes(&outValue, sizeof(outValue));
+
+	previous += UnZigZag(value >> 1);
+
+	outValue = (float)(previous * (double)m_Epsilon);
+	return true;
+}
+
+bool CAfxGameRecordReader::Read(double & outValue)
+{
+	return ReadBytes(&outValue, sizeof(outValue));
+}
+
+bool CAfxGameRecordReader::Read(std::string & outValue)
+{
+	outValue.clear();
+
+	while (true)
+	{
+		if (m_ReadPos == m_ReadEnd && Eof())
+			return false;
+
+		char const * start = &m_ReadBuffer[m_ReadPos];
+		char const * end = (char const *)memchr(start, 0, m_ReadEnd - m_ReadPos);
+
+		if (end)
+		{
+			outValue.append(start, end);
+			m_ReadPos += end - start + 1;
+			return true;
+		}
+
+		outValue.append(start, m_ReadEnd - m_ReadPos);
+		m_ReadPos = m_ReadEnd;
+	}
+}
+
+bool CAfxGameRecordReader::Seek(int64_t offset)
+{
+	if (!FileSeek(m_File, offset, SEEK_SET))
+		return false;
+
+	m_ReadBufferOffset = offset;
+	m_ReadPos = 0;
+	m_ReadEnd = 0;
+
+	return true;
+}
+
+bool CAfxGameRecordReader::ReadBytes(void * outData, size_t size)
+{
+	char * pOut = (char *)outData;
+
+	while (0 < size)
+	{
+		if (m_ReadPos == m_ReadEnd && Eof())
+			return false;
+
+		size_t count = m_ReadEnd - m_ReadPos;
+		if (size < count) count = size;
+
+		memcpy(pOut, &m_ReadBuffer[m_ReadPos], count);
+
+		m_ReadPos += count;
+		pOut += count;
+		size -= count;
+	}
+
+	return true;
+}
+
+bool CAfxGameRecordReader::ReadVarInt(uint64_t & outValue)
+{
+	outValue = 0;
+
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		unsigned char byte;
+
+		if (!ReadBytes(&byte, sizeof(byte)))
+			return false;
+
+		outValue |= (uint64_t)(byte & 0x7f) << shift;
+
+		if (0 == (byte & 0x80))
+			return true;
+	}
+
+	return false;
+}
+
+void CAfxGameRecordReader::ResetState(void)
+{
+	m_Dictionary.clear();
+	m_Deltas.clear();
+	m_Delta = nullptr;
+	m_DeltaIndex = 0;
+}
+
+// AfxGameRecord_Convert ///////////////////////////////////////////////////////
+
+bool AfxGameRecord_Convert(FILE * in, FILE * out, int version, float epsilon, std::string & outError, size_t & outFrames)
+{
+	outFrames = 0;
+
+	CAfxGameRecordReader reader;
+
+	if (!reader.Open(in))
+	{
+		outError = "Invalid or unsupported input file.";
+		return false;
+	}
+
+	std::vector<char> buffer;
+	CAfxGameRecordWriter writer(version, epsilon);
+	writer.SetBuffer(&buffer);
+	writer.WriteHeader();
+
+	size_t hiddenOffset = 0;
+
+	auto copyInt = [&reader, &writer]() {
+		int value;
+		if (!reader.Read(value)) return false;
+		writer.Write(value);
+		return true;
+	};
+
+	auto copyBool = [&reader, &writer]() {
+		bool value;
+		if (!reader.Read(value)) return false;
+		writer.Write(value);
+		return true;
+	};
+
+	auto copyFloats = [&reader, &writer](int count) {
+		for (int i = 0; i < count; ++i)
+		{
+			float value;
+			if (!reader.Read(value)) return false;
+			writer.Write(value);
+		}
+		return true;
+	};
+
+	auto flush = [&buffer, out]() {
+		bool result = buffer.empty() || 1 == fwrite(&buffer[0], buffer.size(), 1, out);
+		buffer.clear();
+		return result;
+	};
+
+	std::string const * token;
+
+	while (!reader.Eof())
+	{
+		if (!reader.ReadDictionary(token))
+		{
+			outError = "Invalid dictionary entry.";
+			return false;
+		}
+
+		bool okay = true;
+
+		if (*token == "afxFrame")
+		{
+			float frameTime;
+			int oldHiddenOffset;
+
+			okay = reader.Read(frameTime) && reader.Read(oldHiddenOffset);
+
+			writer.BeginFrame();
+			writer.Write(frameTime);
+			hiddenOffset = writer.GetOffset();
+			writer.Write((int)0);
+
+			++outFrames;
+		}
+		else if (*token == "afxHidden")
+		{
+			writer.WriteDictionary("afxHidden");
+
+			if (hiddenOffset)
+			{
+				writer.PatchInt(hiddenOffset, (int)(writer.GetOffset() - hiddenOffset));
+				hiddenOffset = 0;
+			}
+
+			int count;
+
+			okay = reader.Read(count);
+
+			if (okay)
+			{
+				writer.Write(count);
+
+				for (int i = 0; okay && i < count; ++i) okay = copyInt();
+			}
+		}
+		else if (*token == "afxCam")
+		{
+			writer.WriteDictionary("afxCam");
+			okay = copyFloats(7);
+		}
+		else if (*token == "afxFrameEnd")
+		{
+			writer.WriteDictionary("afxFrameEnd");
+			hiddenOffset = 0;
+			okay = flush();
+		}
+		else if (*token == "entity_state")
+		{
+			int handle;
+
+			okay = reader.Read(handle);
+
+			writer.WriteDictionary("entity_state");
+			writer.Write(handle);
+
+			reader.BeginDelta(handle);
+			writer.BeginDelta(handle);
+
+			while (okay)
+			{
+				if (!reader.ReadDictionary(token))
+				{
+					okay = false;
+				}
+				else if (*token == "baseentity")
+				{
+					std::string const * modelName;
+
+					writer.WriteDictionary("baseentity");
+
+					okay = reader.ReadDictionary(modelName);
+
+					if (okay)
+					{
+						writer.WriteDictionary(modelName->c_str());
+						okay = copyBool() && copyFloats(6);
+					}
+				}
+				else if (*token == "baseanimating")
+				{
+					bool hasBoneList;
+
+					writer.WriteDictionary("baseanimating");
+
+					okay = reader.Read(hasBoneList);
+
+					if (okay)
+					{
+						writer.Write(hasBoneList);
+
+						if (hasBoneList)
+						{
+							int bones;
+
+							okay = reader.Read(bones);
+
+							if (okay)
+							{
+								writer.Write(bones);
+								okay = copyFloats(7 * bones);
+							}
+						}
+					}
+				}
+				else if (*token == "/")
+				{
+					reader.EndDelta();
+					writer.EndDelta();
+
+					writer.WriteDictionary("/");
+					okay = copyBool();
+					break;
+				}
+				else
+				{
+					outError = "Unknown entity_state entry \"" + *token + "\".";
+					return false;
+				}
+			}
+		}
+		else if (*token == "deleted")
+		{
+			int handle;
+
+			okay = reader.Read(handle);
+
+			writer.WriteDictionary("deleted");
+			writer.Write(handle);
+
+			reader.DeleteDelta(handle);
+			writer.DeleteDelta(handle);
+		}
+		else if (*token == "afxKeyFrame")
+		{
+			// The writer places its own key frames.
+		}
+		else if (*token == "afxFrameIndex")
+		{
+			break;
+		}
+		else
+		{
+			outError = "Unknown entry \"" + *token + "\".";
+			return false;
+		}
+
+		if (!okay)
+		{
+			outError = "Unexpected end of input file or write error.";
+			return false;
+		}
+	}
+
+	writer.WriteFooter();
+
+	if (!flush())
+	{
+		outError = "Write error.";
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// afxGameRecord (.agr) ////////////////////////////////////////////////////////
+//
+// File layout:
+//   "afxGameRecord\0" int32 version
+//   followed by values: bool (1 byte), int32, float, double, strings (0
+//   terminated) and dictionary strings (int32 index, -1 means a new entry
+//   follows as string, entries are numbered from 0 in order of appearance).
+//
+// Version 6 additionally:
+// - Every KeyFrameInterval frames the frame is preceded by the new dictionary
+//   string "afxKeyFrame", the dictionary is cleared before adding it and all
+//   delta contexts are dropped, so decoding can start there.
+// - Floats inside a delta context (entity_state .. "/", keyed by the entity
+//   handle) are stored relative to the float at the same position of the
+//   previous state of that entity, as unsigned LEB128 varint:
+//   - epsilon == 0 (lossless): bits(value) XOR bits(previous).
+//   - epsilon > 0: q = round(value / epsilon), zigzag(q - previous q) << 1;
+//     values that can't be quantized are escaped as 1 followed by the raw
+//     float (the previous q is kept).
+//   The epsilon is stored as float after the version.
+// - The file ends with the dictionary string "afxFrameIndex", int32 frame
+//   count, int32 key frame interval, int64 file offset per frame, followed
+//   by the int64 file offset of the "afxFrameIndex" entry and the 8 bytes
+//   "afxIdx6\0", so the index can be found from the end of the file.
+
+// CAfxGameRecordWriter ////////////////////////////////////////////////////////
+
+class CAfxGameRecordWriter
+{
+public:
+	static const int KeyFrameInterval = 64;
+
+	/// <param name="version">4 or 6.</param>
+	/// <param name="epsilon">Quantization of floats in delta contexts (version 6 only), 0 means lossless.</param>
+	CAfxGameRecordWriter(int version = 4, float epsilon = 0.0f);
+
+	/// <summary>Clears all state, so a new file can be written.</summary>
+	void Reset(int version, float epsilon);
+
+	int GetVersion(void) const
+	{
+		return m_Version;
+	}
+
+	/// <summary>Sets where the values are appended to, can be changed anytime (i.e. to hand off buffers).</summary>
+	void SetBuffer(std::vector<char> * buffer)
+	{
+		m_Buffer = buffer;
+	}
+
+	/// <returns>Number of bytes written in total (file offset).</returns>
+	size_t GetOffset(void) const
+	{
+		return m_Offset;
+	}
+
+	/// <summary>Overwrites an int written earlier, offset must still be in the current buffer.</summary>
+	/// <returns>false if offset is not in the current buffer anymore.</returns>
+	bool PatchInt(size_t offset, int value);
+
+	void WriteHeader(void);
+
+	/// <summary>Writes the "afxFrame" dictionary string (preceded by a key frame if due).</summary>
+	void BeginFrame(void);
+
+	/// <summary>Writes the frame index (version 6 only).</summary>
+	void WriteFooter(void);
+
+	void BeginDelta(int key);
+	void EndDelta(void);
+	void DeleteDelta(int key);
+
+	void WriteDictionary(char const * value);
+
+	void Write(bool value);
+	void Write(int value);
+	void Write(float value);
+	void Write(double value);
+	void Write(char const * value);
+
+private:
+	int m_Version;
+	float m_Epsilon;
+
+	std::vector<char> * m_Buffer = nullptr;
+	size_t m_Offset = 0;
+
+	std::unordered_map<std::string, int> m_Dictionary;
+
+	std::unordered_map<int, std::vector<int64_t>> m_Deltas;
+	std::vector<int64_t> * m_Delta = nullptr;
+	size_t m_DeltaIndex = 0;
+
+	std::vector<int64_t> m_FrameOffsets;
+
+	void WriteBytes(void const * data, size_t size);
+	void WriteVarInt(uint64_t value);
+};
+
+// CAfxGameRecording ///////////////////////////////////////////////////////////
+
+class CAfxPipeWriter;
+
+/// <summary>
+///   Records a game record file the way CClientTools does: the records of a
+///   frame are collected in memory (so the afxHidden offset can be patched
+///   in place) and handed at frame end to a thread that writes them with a
+///   single fwrite.
+/// </summary>
+class CAfxGameRecording
+{
+public:
+	CAfxGameRecording();
+
+	/// <summary>Calls End.</summary>
+	~CAfxGameRecording();
+
+	/// <summary>Writes the header, file is not closed by the recording.</summary>
+	/// <param name="version">4 or 6.</param>
+	void Begin(FILE * file, int version, float epsilon);
+
+	/// <summary>Writes the footer (version 6) and waits until everything is written.</summary>
+	/// <returns>false if writing to the file failed.</returns>
+	bool End(void);
+
+	bool GetActive(void) const
+	{
+		return nullptr != m_FileWriter;
+	}
+
+	/// <summary>Use to write the records of the frame, between BeginFrame and EndFrame.</summary>
+	CAfxGameRecordWriter & GetWriter(void)
+	{
+		return m_Writer;
+	}
+
+	/// <summary>Writes "afxFrame", the frame time and the placeholder for the afxHidden offset.</summary>
+	void BeginFrame(float frameTime);
+
+	/// <summary>Marks an entity handle as hidden in the current frame.</summary>
+	void MarkHidden(int value);
+
+	/// <summary>Writes "afxHidden" (if there are marked entities) and "afxFrameEnd" and hands the frame off to be written.</summary>
+	void EndFrame(void);
+
+private:
+	CAfxGameRecordWriter m_Writer;
+
+	/// <summary>Writes the batches of records to the file in the background.</summary>
+	CAfxPipeWriter * m_FileWriter = nullptr;
+
+	/// <summary>Records of the current frame, handed to m_FileWriter at frame end.</summary>
+	std::vector<char> * m_Buffer = nullptr;
+
+	std::mutex m_FreeBuffersMutex;
+	std::vector<std::vector<char> *> m_FreeBuffers;
+
+	size_t m_HiddenOffset = 0;
+	std::set<int> m_Hidden;
+
+	void Flush(void);
+
+	std::vector<char> * AquireBuffer(void);
+
+	/// <remarks>Called from the writer thread.</remarks>
+	void ReleaseBuffer(std::vector<char> * buffer);
+};
+
+// CAfxGameRecordReader ////////////////////////////////////////////////////////
+
+/// <summary>
+///   Reads values the way CAfxGameRecordWriter writes them, the caller has
+///   to know what to read next (and call the delta functions accordingly).
+/// </summary>
+class CAfxGameRecordReader
+{
+public:
+	CAfxGameRecordReader();
+	~CAfxGameRecordReader();
+
+	/// <summary>Reads the header and (version 6) the frame index, file is not closed by the reader.</summary>
+	bool Open(FILE * file);
+
+	int GetVersion(void) const
+	{
+		return m_Version;
+	}
+
+	/// <returns>Number of frames in the index, 0 if there is none.</returns>
+	size_t GetFrameCount(void) const
+	{
+		return m_FrameOffsets.size();
+	}
+
+	/// <summary>Positions the reader on the last key frame at or before frame.</summary>
+	/// <returns>Frame positioned at (the caller has to read and skip the frames until the wanted one), or -1 on error.</returns>
+	int SeekKeyFrame(size_t frame);
+
+	/// <returns>true if the end of the records (file end or frame index) is reached.</returns>
+	bool Eof(void);
+
+	void BeginDelta(int key);
+	void EndDelta(void);
+	void DeleteDelta(int key);
+
+	/// <param name="outValue">Stays valid until the dictionary is reset (next key frame or seek).</param>
+	bool ReadDictionary(std::string const * & outValue);
+
+	bool Read(bool & outValue);
+	bool Read(int & outValue);
+	bool Read(float & outValue);
+	bool Read(double & outValue);
+	bool Read(std::string & outValue);
+
+private:
+	FILE * m_File = nullptr;
+	int m_Version = 0;
+	float m_Epsilon = 0.0f;
+
+	std::vector<char> m_ReadBuffer;
+	size_t m_ReadPos = 0;
+	size_t m_ReadEnd = 0;
+	int64_t m_ReadBufferOffset = 0;
+	int64_t m_EndOffset = -1;
+
+	std::deque<std::string> m_Dictionary;
+
+	std::unordered_map<int, std::vector<int64_t>> m_Deltas;
+	std::vector<int64_t> * m_Delta = nullptr;
+	size_t m_DeltaIndex = 0;
+
+	std::vector<int64_t> m_FrameOffsets;
+
+	bool Seek(int64_t offset);
+	bool ReadBytes(void * outData, size_t size);
+	bool ReadVarInt(uint64_t & outValue);
+	void ResetState(void);
+};
+
+/// <summary>
+///   Converts the game record in (any version) to out in the given version,
+///   this knows the records written by CClientTools.
+/// </summary>
+/// <param name="outFrames">Number of frames converted.</param>
+bool AfxGameRecord_Convert(FILE * in, FILE * out, int version, float epsilon, std::string & outError, size_t & outFrames);
@@ -0,0 +1,370 @@
+#include "stdafx.h"
+
+#include "AfxImageKernels.h"
+
+#include <emmintrin.h>
+#include <tmmintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AFXIMAGE_TARGET_SSE2
+#define AFXIMAGE_TARGET_SSSE3
+#else
+#include <cpuid.h>
+#define AFXIMAGE_TARGET_SSE2 __attribute__((target("sse2")))
+#define AFXIMAGE_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
+#define AFXIMAGE_DEPTH24_R (1.0f/16777215.0f)
+#define AFXIMAGE_DEPTH24_G (256.0f/16777215.0f)
+#define AFXIMAGE_DEPTH24_B (65536.0f/16777215.0f)
+
+// Scalar //////////////////////////////////////////////////////////////////////
+
+// The "Row" functions do the pixels [x0, x1) of a row, the SIMD versions use them for the tails.
+
+static void Scalar_SwapRows24(unsigned char * rowA, unsigned char * rowB, int x0, int x1)
+{
+	for (int x = x0; x < x1; ++x)
+	{
+		unsigned char * a = rowA + 3 * x;
+		unsigned char * b = rowB + 3 * x;
+
+		unsigned char r = b[0];
+		unsigned char g = b[1];
+		unsigned char bl = b[2];
+
+		b[0] = a[2];
+		b[1] = a[1];
+		b[2] = a[0];
+
+		a[0] = bl;
+		a[1] = g;
+		a[2] = r;
+	}
+}
+
+static void Scalar_FlipSwap24(unsigned char * image, int width, int height, int pitch)
+{
+	int lastLine = height >> 1;
+	if (height & 0x1) ++lastLine;
+
+	for (int y = 0; y < lastLine; ++y)
+	{
+		Scalar_SwapRows24(image + y * pitch, image + (height - 1 - y) * pitch, 0, width);
+	}
+}
+
+static void Scalar_DepthAffine(float * data, float scale, float offset, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		float depth = data[i];
+
+		depth *= scale;
+		depth += offset;
+
+		data[i] = depth;
+	}
+}
+
+/// <remarks>Goes from x1 - 1 down to x0, so it can work in place.</remarks>
+static void Scalar_Depth24ToFloatRow(unsigned char const * src, float * dst, int x0, int x1, float scale, float offset)
+{
+	for (int x = x1 - 1; x >= x0; --x)
+	{
+		unsigned char r = src[3 * x + 0];
+		unsigned char g = src[3 * x + 1];
+		unsigned char b = src[3 * x + 2];
+
+		float depth;
+
+		depth = AFXIMAGE_DEPTH24_R * r + AFXIMAGE_DEPTH24_G * g + AFXIMAGE_DEPTH24_B * b;
+
+		depth *= scale;
+		depth += offset;
+
+		dst[x] = depth;
+	}
+}
+
+static void Scalar_Depth24ToFloat(unsigned char * image, int width, int height, int srcPitch, int dstPitch, float scale, float offset)
+{
+	for (int y = height - 1; y >= 0; --y)
+	{
+		Scalar_Depth24ToFloatRow(image + y * srcPitch, (float *)(image + y * dstPitch), 0, width, scale, offset);
+	}
+}
+
+/// <remarks>Goes from x1 - 1 down to x0, so it can work in place.</remarks>
+static void Scalar_BgrMergeBlueToBgraRow(unsigned char const * src, unsigned char * dst, unsigned char const * alpha, int x0, int x1)
+{
+	for (int x = x1 - 1; x >= x0; --x)
+	{
+		unsigned char b = src[3 * x + 0];
+		unsigned char g = src[3 * x + 1];
+		unsigned char r = src[3 * x + 2];
+		unsigned char a = alpha[3 * x + 0];
+
+		dst[4 * x + 0] = b;
+		dst[4 * x + 1] = g;
+		dst[4 * x + 2] = r;
+		dst[4 * x + 3] = a;
+	}
+}
+
+static void Scalar_BgrMergeBlueToBgra(unsigned char * image, int width, int height, int srcPitch, int dstPitch, unsigned char const * alphaImage, int alphaPitch)
+{
+	for (int y = height - 1; y >= 0; --y)
+	{
+		Scalar_BgrMergeBlueToBgraRow(image + y * srcPitch, image + y * dstPitch, alphaImage + y * alphaPitch, 0, width);
+	}
+}
+
+// SSE2 ////////////////////////////////////////////////////////////////////////
+
+AFXIMAGE_TARGET_SSE2 static void Sse2_DepthAffine(float * data, float scale, float offset, size_t count)
+{
+	__m128 vScale = _mm_set1_ps(scale);
+	__m128 vOffset = _mm_set1_ps(offset);
+	size_t count4 = count & ~(size_t)3;
+
+	for (size_t i = 0; i < count4; i += 4)
+		_mm_storeu_ps(data + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(data + i), vScale), vOffset));
+
+	Scalar_DepthAffine(data + count4, scale, offset, count - count4);
+}
+
+// SSSE3 ///////////////////////////////////////////////////////////////////////
+
+// 16 RGB pixels are 3 registers, output register k gets bytes from input registers k-1, k and k+1.
+
+#define AFXIMAGE_Z -128
+
+AFXIMAGE_TARGET_SSSE3 static inline void Ssse3_Swap24(__m128i a, __m128i b, __m128i c, __m128i & outA, __m128i & outB, __m128i & outC)
+{
+	const __m128i m00 = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, AFXIMAGE_Z);
+	const __m128i m01 = _mm_setr_epi8(AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 1);
+	const __m128i m10 = _mm_setr_epi8(AFXIMAGE_Z, 15, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z);
+	const __m128i m11 = _mm_setr_epi8(0, AFXIMAGE_Z, 4, 3, 2, 7, 6, 5, 10, 9, 8, 13, 12, 11, AFXIMAGE_Z, 15);
+	const __m128i m12 = _mm_setr_epi8(AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 0, AFXIMAGE_Z);
+	const __m128i m21 = _mm_setr_epi8(14, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z);
+	const __m128i m22 = _mm_setr_epi8(AFXIMAGE_Z, 3, 2, 1, 6, 5, 4, 9, 8, 7, 12, 11, 10, 15, 14, 13);
+
+	outA = _mm_or_si128(_mm_shuffle_epi8(a, m00), _mm_shuffle_epi8(b, m01));
+	outB = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, m10), _mm_shuffle_epi8(b, m11)), _mm_shuffle_epi8(c, m12));
+	outC = _mm_or_si128(_mm_shuffle_epi8(b, m21), _mm_shuffle_epi8(c, m22));
+}
+
+AFXIMAGE_TARGET_SSSE3 static void Ssse3_FlipSwap24(unsigned char * image, int width, int height, int pitch)
+{
+	int width16 = width & ~15;
+
+	int lastLine = height >> 1;
+	if (height & 0x1) ++lastLine;
+
+	for (int y = 0; y < lastLine; ++y)
+	{
+		unsigned char * rowA = image + y * pitch;
+		unsigned char * rowB = image + (height - 1 - y) * pitch;
+
+		for (int x = 0; x < width16; x += 16)
+		{
+			__m128i * pA = (__m128i *)(rowA + 3 * x);
+			__m128i * pB = (__m128i *)(rowB + 3 * x);
+
+			__m128i a0 = _mm_loadu_si128(pA + 0);
+			__m128i a1 = _mm_loadu_si128(pA + 1);
+			__m128i a2 = _mm_loadu_si128(pA + 2);
+			__m128i b0 = _mm_loadu_si128(pB + 0);
+			__m128i b1 = _mm_loadu_si128(pB + 1);
+			__m128i b2 = _mm_loadu_si128(pB + 2);
+
+			Ssse3_Swap24(a0, a1, a2, a0, a1, a2);
+			Ssse3_Swap24(b0, b1, b2, b0, b1, b2);
+
+			_mm_storeu_si128(pA + 0, b0);
+			_mm_storeu_si128(pA + 1, b1);
+			_mm_storeu_si128(pA + 2, b2);
+			_mm_storeu_si128(pB + 0, a0);
+			_mm_storeu_si128(pB + 1, a1);
+			_mm_storeu_si128(pB + 2, a2);
+		}
+
+		Scalar_SwapRows24(rowA, rowB, width16, width);
+	}
+}
+
+/// <returns>Number of pixels that can be done in blocks of 4 with 16 byte loads not going past 3 * width bytes.</returns>
+static int Ssse3_Blocks24(int width)
+{
+	if (3 * width < 16)
+		return 0;
+
+	return (((3 * width - 16) / 3) & ~3) + 4;
+}
+
+AFXIMAGE_TARGET_SSSE3 static void Ssse3_Depth24ToFloat(unsigned char * image, int width, int height, int srcPitch, int dstPitch, float scale, float offset)
+{
+	const __m128i mR = _mm_setr_epi8(0, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 3, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 6, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 9, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z);
+	const __m128i mG = _mm_setr_epi8(1, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 4, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 7, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 10, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z);
+	const __m128i mB = _mm_setr_epi8(2, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 5, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 8, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 11, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z);
+	const __m128 fR = _mm_set1_ps(AFXIMAGE_DEPTH24_R);
+	const __m128 fG = _mm_set1_ps(AFXIMAGE_DEPTH24_G);
+	const __m128 fB = _mm_set1_ps(AFXIMAGE_DEPTH24_B);
+	const __m128 vScale = _mm_set1_ps(scale);
+	const __m128 vOffset = _mm_set1_ps(offset);
+
+	int blocks = Ssse3_Blocks24(width);
+
+	// Backwards, so that the wider floats don't overwrite bytes not read yet.
+
+	for (int y = height - 1; y >= 0; --y)
+	{
+		unsigned char const * src = image + y * srcPitch;
+		float * dst = (float *)(image + y * dstPitch);
+
+		Scalar_Depth24ToFloatRow(src, dst, blocks, width, scale, offset);
+
+		for (int x = blocks - 4; x >= 0; x -= 4)
+		{
+			__m128i c = _mm_loadu_si128((__m128i const *)(src + 3 * x));
+
+			__m128 depth = _mm_add_ps(
+				_mm_add_ps(
+					_mm_mul_ps(fR, _mm_cvtepi32_ps(_mm_shuffle_epi8(c, mR))),
+					_mm_mul_ps(fG, _mm_cvtepi32_ps(_mm_shuffle_epi8(c, mG)))),
+				_mm_mul_ps(fB, _mm_cvtepi32_ps(_mm_shuffle_epi8(c, mB))));
+
+			_mm_storeu_ps(dst + x, _mm_add_ps(_mm_mul_ps(depth, vScale), vOffset));
+		}
+	}
+}
+
+AFXIMAGE_TARGET_SSSE3 static void Ssse3_BgrMergeBlueToBgra(unsigned char * image, int width, int height, int srcPitch, int dstPitch, unsigned char const * alphaImage, int alphaPitch)
+{
+	const __m128i mBgr = _mm_setr_epi8(0, 1, 2, AFXIMAGE_Z, 3, 4, 5, AFXIMAGE_Z, 6, 7, 8, AFXIMAGE_Z, 9, 10, 11, AFXIMAGE_Z);
+	const __m128i mA = _mm_setr_epi8(AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 0, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 3, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 6, AFXIMAGE_Z, AFXIMAGE_Z, AFXIMAGE_Z, 9);
+
+	int blocks = Ssse3_Blocks24(width);
+
+	// Backwards, so that the wider pixels don't overwrite bytes not read yet.
+
+	for (int y = height - 1; y >= 0; --y)
+	{
+		unsigned char const * src = image + y * srcPitch;
+		unsigned char * dst = image + y * dstPitch;
+		unsigned char const * alpha = alphaImage + y * alphaPitch;
+
+		Scalar_BgrMergeBlueToBgraRow(src, dst, alpha, blocks, width);
+
+		for (int x = blocks - 4; x >= 0; x -= 4)
+		{
+			__m128i c = _mm_loadu_si128((__m128i const *)(src + 3 * x));
+			__m128i a = _mm_loadu_si128((__m128i const *)(alpha + 3 * x));
+
+			_mm_storeu_si128((__m128i *)(dst + 4 * x), _mm_or_si128(_mm_shuffle_epi8(c, mBgr), _mm_shuffle_epi8(a, mA)));
+		}
+	}
+}
+
+#undef AFXIMAGE_Z
+
+// AfxImageKernels /////////////////////////////////////////////////////////////
+
+static AfxImageKernels const g_AfxImageKernels_Scalar = {
+	AfxImageKernels::EK_Scalar,
+	Scalar_FlipSwap24, Scalar_DepthAffine, Scalar_Depth24ToFloat, Scalar_BgrMergeBlueToBgra
+};
+
+static AfxImageKernels const g_AfxImageKernels_Sse2 = {
+	AfxImageKernels::EK_Sse2,
+	Scalar_FlipSwap24, Sse2_DepthAffine, Scalar_Depth24ToFloat, Scalar_BgrMergeBlueToBgra
+};
+
+static AfxImageKernels const g_AfxImageKernels_Ssse3 = {
+	AfxImageKernels::EK_Ssse3,
+	Ssse3_FlipSwap24, Sse2_DepthAffine, Ssse3_Depth24ToFloat, Ssse3_BgrMergeBlueToBgra
+};
+
+static bool CpuHasSse2(void)
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	return 0 != (info[3] & (1 << 26));
+#else
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+	return 0 != (edx & (1 << 26));
+#endif
+}
+
+static bool CpuHasSsse3(void)
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	return 0 != (info[2] & (1 << 9));
+#else
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+	return 0 != (ecx & (1 << 9));
+#endif
+}
+
+AfxImageKernels const * AfxImageKernels::Get(Kind kind)
+{
+	if (EK_Auto == kind || !IsSupported(kind))
+		kind = GetBestSupported();
+
+	switch (kind)
+	{
+	case EK_Sse2:
+		return &g_AfxImageKernels_Sse2;
+	case EK_Ssse3:
+		return &g_AfxImageKernels_Ssse3;
+	default:
+		return &g_AfxImageKernels_Scalar;
+	}
+}
+
+AfxImageKernels::Kind AfxImageKernels::GetBestSupported(void)
+{
+	static Kind best = CpuHasSsse3() ? EK_Ssse3 : (CpuHasSse2() ? EK_Sse2 : EK_Scalar);
+
+	return best;
+}
+
+bool AfxImageKernels::IsSupported(Kind kind)
+{
+	switch (kind)
+	{
+	case EK_Auto:
+	case EK_Scalar:
+		return true;
+	case EK_Sse2:
+		return EK_Sse2 <= GetBestSupported();
+	case EK_Ssse3:
+		return EK_Ssse3 <= GetBestSupported();
+	}
+
+	return false;
+}
+
+char const * AfxImageKernels::GetName(Kind kind)
+{
+	switch (kind)
+	{
+	case EK_Auto:
+		return "auto";
+	case EK_Scalar:
+		return "scalar";
+	case EK_Sse2:
+		return "sse2";
+	case EK_Ssse3:
+		return "ssse3";
+	}
+
+	return "[n/a]";
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+
+// AfxImageKernels /////////////////////////////////////////////////////////////
+
+/// <summary>
+///   Conversions applied to captured images after read-back.<br />
+///   All implementations give bit-identical results to the scalar ones.
+/// </summary>
+struct AfxImageKernels
+{
+	enum Kind
+	{
+		/// <summary>Best kind supported by the CPU.</summary>
+		EK_Auto,
+		EK_Scalar,
+		EK_Sse2,
+		EK_Ssse3
+	};
+
+	/// <returns>Kernels for kind, EK_Auto or a kind not supported by the CPU is resolved to the best supported kind.</returns>
+	static AfxImageKernels const * Get(Kind kind);
+
+	static Kind GetBestSupported(void);
+
+	static bool IsSupported(Kind kind);
+
+	static char const * GetName(Kind kind);
+
+	Kind Type;
+
+	/// <summary>In place: flips the image vertically and swaps the 1st and 3rd byte of each 3 byte pixel (RGB &lt;-&gt; BGR).</summary>
+	void (*FlipSwap24)(unsigned char * image, int width, int height, int pitch);
+
+	/// <summary>In place: data = scale * data + offset</summary>
+	void (*DepthAffine)(float * data, float scale, float offset, size_t count);
+
+	/// <summary>
+	///   In place: 24 bit depth packed little endian into 3 byte pixels (rows srcPitch apart)
+	///   to scale * depth + offset floats (rows dstPitch apart, dstPitch &gt;= 4 * width).
+	/// </summary>
+	void (*Depth24ToFloat)(unsigned char * image, int width, int height, int srcPitch, int dstPitch, float scale, float offset);
+
+	/// <summary>
+	///   In place: 3 byte BGR pixels (rows srcPitch apart) to 4 byte BGRA pixels (rows dstPitch apart, dstPitch &gt;= 4 * width),
+	///   where A is the first (blue) byte of the 3 byte pixels in alphaImage.
+	/// </summary>
+	void (*BgrMergeBlueToBgra)(unsigned char * image, int width, int height, int srcPitch, int dstPitch, unsigned char const * alphaImage, int alphaPitch);
+};
@@ -0,0 +1,196 @@
+#include "stdafx.h"
+
+#include "AfxPipeProcess.h"
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+extern char ** environ;
+
+// CAfxPipeProcess /////////////////////////////////////////////////////////////
+
+CAfxPipeProcess::CAfxPipeProcess(char const * commandLine, size_t pipeBufferSize, Output_t && output)
+	: m_Output(std::move(output))
+{
+	int stdIn[2] = { -1, -1 };
+	int stdOut[2] = { -1, -1 };
+	int stdErr[2] = { -1, -1 };
+
+	// Our ends must not be inherited, else the child keeps its own stdin open:
+	bool okay = 0 == pipe(stdIn) && 0 == pipe(stdOut) && 0 == pipe(stdErr)
+		&& -1 != fcntl(stdIn[1], F_SETFD, FD_CLOEXEC)
+		&& -1 != fcntl(stdOut[0], F_SETFD, FD_CLOEXEC)
+		&& -1 != fcntl(stdErr[0], F_SETFD, FD_CLOEXEC);
+
+#ifdef F_SETPIPE_SZ
+	// The buffer should hold at least a full frame, so the consumer can read
+	// a frame while the next one is being written. Failing is not fatal,
+	// unprivileged processes are limited by /proc/sys/fs/pipe-max-size:
+	if (okay)
+	{
+		size_t maxSize = 64 * 1024 * 1024;
+		if (fcntl(stdIn[1], F_SETPIPE_SZ, (int)(pipeBufferSize < maxSize ? pipeBufferSize : maxSize)) < 0)
+			fcntl(stdIn[1], F_SETPIPE_SZ, 1024 * 1024);
+	}
+#endif
+
+	if (okay)
+	{
+		posix_spawn_file_actions_t fileActions;
+		posix_spawn_file_actions_init(&fileActions);
+		posix_spawn_file_actions_adddup2(&fileActions, stdIn[0], 0);
+		posix_spawn_file_actions_adddup2(&fileActions, stdOut[1], 1);
+		posix_spawn_file_actions_adddup2(&fileActions, stdErr[1], 2);
+
+		char const * argv[] = { "/bin/sh", "-c", commandLine, nullptr };
+
+		okay = 0 == posix_spawn(&m_Pid, "/bin/sh", &fileActions, nullptr, const_cast<char * const *>(argv), environ);
+
+		posix_spawn_file_actions_destroy(&fileActions);
+	}
+
+	// Close the child's ends, so the reads end when the process exits:
+	if (-1 != stdIn[0]) close(stdIn[0]);
+	if (-1 != stdOut[1]) close(stdOut[1]);
+	if (-1 != stdErr[1]) close(stdErr[1]);
+
+	m_StdInWr = stdIn[1];
+	m_StdOutRd = stdOut[0];
+	m_StdErrRd = stdErr[0];
+
+	if (!okay)
+	{
+		m_Pid = -1;
+		Close();
+		return;
+	}
+
+	m_Okay = true;
+
+	m_StdOutThread = std::thread(&CAfxPipeProcess::ReadPipeThread, this, m_StdOutRd, false);
+	m_StdErrThread = std::thread(&CAfxPipeProcess::ReadPipeThread, this, m_StdErrRd, true);
+}
+
+CAfxPipeProcess::~CAfxPipeProcess()
+{
+	Close();
+}
+
+bool CAfxPipeProcess::Write(void const * data, size_t bytes)
+{
+	if (-1 == m_StdInWr)
+		return false;
+
+	// Block SIGPIPE for this thread, so a process that exited fails the write
+	// with EPIPE instead of killing us:
+
+	sigset_t sigPipe;
+	sigemptyset(&sigPipe);
+	sigaddset(&sigPipe, SIGPIPE);
+
+	sigset_t oldMask;
+	pthread_sigmask(SIG_BLOCK, &sigPipe, &oldMask);
+
+	char const * pData = (char const *)data;
+	bool result = true;
+
+	while (0 < bytes)
+	{
+		ssize_t bytesWritten = write(m_StdInWr, pData, bytes);
+
+		if (bytesWritten < 0)
+		{
+			if (EINTR == errno)
+				continue;
+
+			if (EPIPE == errno && !sigismember(&oldMask, SIGPIPE))
+			{
+				// Consume the pending signal before it gets unblocked:
+				struct timespec zero = { 0, 0 };
+				while (0 < sigtimedwait(&sigPipe, nullptr, &zero) || EINTR == errno);
+			}
+
+			result = false;
+			break;
+		}
+
+		pData += bytesWritten;
+		bytes -= (size_t)bytesWritten;
+	}
+
+	pthread_sigmask(SIG_SETMASK, &oldMask, nullptr);
+
+	return result;
+}
+
+int CAfxPipeProcess::Close(void)
+{
+	if (-1 != m_StdInWr)
+	{
+		close(m_StdInWr);
+		m_StdInWr = -1;
+	}
+
+	if (-1 != m_Pid)
+	{
+		int status;
+
+		while (-1 == waitpid(m_Pid, &status, 0))
+		{
+			if (EINTR != errno)
+			{
+				status = -1;
+				break;
+			}
+		}
+
+		m_ExitCode = -1 != status && WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+		m_Pid = -1;
+	}
+
+	if (m_StdOutThread.joinable()) m_StdOutThread.join();
+	if (m_StdErrThread.joinable()) m_StdErrThread.join();
+
+	if (-1 != m_StdOutRd)
+	{
+		close(m_StdOutRd);
+		m_StdOutRd = -1;
+	}
+	if (-1 != m_StdErrRd)
+	{
+		close(m_StdErrRd);
+		m_StdErrRd = -1;
+	}
+
+	m_Okay = false;
+
+	return m_ExitCode;
+}
+
+void CAfxPipeProcess::ReadPipeThread(int fd, bool isStdErr)
+{
+	char buffer[4096];
+
+	// Ends when the process closes its end (exits):
+	while (true)
+	{
+		ssize_t bytesRead = read(fd, buffer, sizeof(buffer));
+
+		if (bytesRead < 0 && EINTR == errno)
+			continue;
+
+		if (bytesRead <= 0)
+			break;
+
+		if (m_Output) m_Output(buffer, (size_t)bytesRead, isStdErr);
+	}
+}
+
+#endif
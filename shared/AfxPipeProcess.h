@@ -0,0 +1,62 @@
+#pragma once
+
+#ifndef _WIN32
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <functional>
+#include <thread>
+
+// CAfxPipeProcess /////////////////////////////////////////////////////////////
+
+/// <summary>
+///   POSIX counterpart of the process handling in CAfxOutFFMPEGVideoStream:
+///   runs a command line through /bin/sh with its stdin connected to a pipe
+///   that is written with Write (e.g. from a CAfxPipeWriter) and its stdout /
+///   stderr drained by threads of their own.<br />
+///   Lets the pipe writer path be run (and benchmarked) on Linux, against
+///   ffmpeg or a stand-in consumer like "cat > /dev/null".
+/// </summary>
+class CAfxPipeProcess
+{
+public:
+	/// <summary>Called from the drain threads with output of the process.</summary>
+	typedef std::function<void(char const * data, size_t bytes, bool isStdErr)> Output_t;
+
+	/// <param name="pipeBufferSize">Requested size of the stdin pipe buffer, this is only a hint (Linux only).</param>
+	/// <param name="output">Can be empty, then the output is discarded.</param>
+	CAfxPipeProcess(char const * commandLine, size_t pipeBufferSize, Output_t && output);
+
+	/// <summary>Calls Close.</summary>
+	~CAfxPipeProcess();
+
+	bool GetOkay(void) const
+	{
+		return m_Okay;
+	}
+
+	/// <summary>Writes all bytes to stdin of the process (blocking).</summary>
+	/// <returns>false on error, e.g. if the process exited.</returns>
+	/// <remarks>Can be called from any (single) thread, SIGPIPE is not raised.</remarks>
+	bool Write(void const * data, size_t bytes);
+
+	/// <summary>Closes stdin of the process and waits for it to exit and its output to be drained.</summary>
+	/// <returns>Exit code of the process, -1 if it did not exit normally or wasn't started.</returns>
+	int Close(void);
+
+private:
+	bool m_Okay = false;
+	pid_t m_Pid = -1;
+	int m_StdInWr = -1;
+	int m_StdOutRd = -1;
+	int m_StdErrRd = -1;
+	int m_ExitCode = -1;
+	Output_t m_Output;
+	std::thread m_StdOutThread;
+	std::thread m_StdErrThread;
+
+	void ReadPipeThread(int fd, bool isStdErr);
+};
+
+#endif
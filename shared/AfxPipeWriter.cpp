@@ -0,0 +1,120 @@
+#include "stdafx.h"
+
+#include "AfxPipeWriter.h"
+
+#include <chrono>
+
+// CAfxPipeWriter //////////////////////////////////////////////////////////////
+
+CAfxPipeWriter::CAfxPipeWriter(size_t ringSize, Write_t && write)
+	: m_Write(std::move(write))
+	, m_Ring(0 < ringSize ? ringSize : 1)
+	, m_Failed(false)
+	, m_BytesWritten(0)
+{
+	m_Thread = std::thread(&CAfxPipeWriter::WriterThread, this);
+}
+
+CAfxPipeWriter::~CAfxPipeWriter()
+{
+	Finish();
+}
+
+bool CAfxPipeWriter::Queue(void const * data, size_t bytes, Done_t && done)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	if (m_Count == m_Ring.size() && !m_Finish && !m_Failed)
+	{
+		std::chrono::steady_clock::time_point stallStart = std::chrono::steady_clock::now();
+
+		m_DoneCondition.wait(lock, [this]() { return m_Count < m_Ring.size() || m_Finish || m_Failed; });
+
+		++m_StallCount;
+		m_StallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - stallStart).count();
+	}
+
+	if (m_Finish || m_Failed)
+	{
+		lock.unlock();
+
+		if (done) done();
+		return false;
+	}
+
+	CFrame & frame = m_Ring[(m_Head + m_Count) % m_Ring.size()];
+	frame.Data = data;
+	frame.Bytes = bytes;
+	frame.Done = std::move(done);
+
+	++m_Count;
+
+	lock.unlock();
+
+	m_QueuedCondition.notify_one();
+
+	return true;
+}
+
+bool CAfxPipeWriter::Finish(void)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		m_Finish = true;
+	}
+
+	m_QueuedCondition.notify_one();
+	m_DoneCondition.notify_all();
+
+	if (m_Thread.joinable()) m_Thread.join();
+
+	return !m_Failed;
+}
+
+void CAfxPipeWriter::GetStalls(unsigned long long & outCount, double & outSeconds)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	outCount = m_StallCount;
+	outSeconds = m_StallSeconds;
+}
+
+void CAfxPipeWriter::WriterThread(void)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	while (true)
+	{
+		m_QueuedCondition.wait(lock, [this]() { return 0 < m_Count || m_Finish; });
+
+		if (0 == m_Count)
+			break; // Finished.
+
+		CFrame & frame = m_Ring[m_Head];
+
+		void const * data = frame.Data;
+		size_t bytes = frame.Bytes;
+		Done_t done(std::move(frame.Done));
+
+		lock.unlock();
+
+		// After a failure the remaining frames are only completed:
+		if (!m_Failed)
+		{
+			if (m_Write(data, bytes))
+				m_BytesWritten += bytes;
+			else
+				m_Failed = true;
+		}
+
+		if (done) done();
+
+		lock.lock();
+
+		m_Head = (m_Head + 1) % m_Ring.size();
+		--m_Count;
+
+		m_DoneCondition.notify_all();
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// CAfxPipeWriter //////////////////////////////////////////////////////////////
+
+/// <summary>
+///   Writes frames to a (blocking) pipe from a dedicated thread.<br />
+///   Frames are not copied, the caller keeps the memory alive until the
+///   done callback of the frame is called. Frames are queued in a ring of
+///   fixed size, so a slow consumer only stalls the caller once the ring is
+///   full.<br />
+///   The writer itself is platform independent, the platform specific
+///   part is the write function passed in.
+/// </summary>
+class CAfxPipeWriter
+{
+public:
+	/// <summary>Must write all bytes (blocking), returns false on error.</summary>
+	typedef std::function<bool(void const * data, size_t bytes)> Write_t;
+
+	typedef std::function<void(void)> Done_t;
+
+	/// <param name="ringSize">Number of frames that can be queued, at least 1.</param>
+	CAfxPipeWriter(size_t ringSize, Write_t && write);
+
+	/// <summary>Calls Finish.</summary>
+	~CAfxPipeWriter();
+
+	/// <summary>
+	///   Queues a frame for writing, blocks while the ring is full.<br />
+	///   done is always called exactly once (from the writer thread, or
+	///   from the calling thread if the frame is not queued).
+	/// </summary>
+	/// <returns>false if the writer failed (frames after a failed write are not written anymore).</returns>
+	bool Queue(void const * data, size_t bytes, Done_t && done);
+
+	/// <summary>Waits until all queued frames are done and stops the thread.</summary>
+	/// <returns>false if the writer failed.</returns>
+	bool Finish(void);
+
+	bool GetFailed(void) const
+	{
+		return m_Failed;
+	}
+
+	unsigned long long GetBytesWritten(void) const
+	{
+		return m_BytesWritten;
+	}
+
+	/// <param name="outCount">Number of times Queue had to wait for room in the ring.</param>
+	/// <param name="outSeconds">Time Queue spent waiting for room in the ring.</param>
+	void GetStalls(unsigned long long & outCount, double & outSeconds);
+
+private:
+	struct CFrame
+	{
+		void const * Data;
+		size_t Bytes;
+		Done_t Done;
+	};
+
+	Write_t m_Write;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_QueuedCondition;
+	std::condition_variable m_DoneCondition;
+
+	std::vector<CFrame> m_Ring;
+	size_t m_Head = 0;
+	size_t m_Count = 0;
+	bool m_Finish = false;
+
+	std::thread m_Thread;
+
+	std::atomic_bool m_Failed;
+	std::atomic<unsigned long long> m_BytesWritten;
+
+	unsigned long long m_StallCount = 0;
+	double m_StallSeconds = 0.0;
+
+	void WriterThread(void);
+};
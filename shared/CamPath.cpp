@@ -20,6 +20,11 @@
 #undef max
 #endif
 
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define AFX_CAMPATH_SSE2
+#include <emmintrin.h>
+#endif
+
 bool CamPath::DoubleInterp_FromString(char const * value, DoubleInterp & outValue)
 {
 	if(!_stricmp(value,"default"))
@@ -284,8 +289,25 @@ void CamPath::Add(double time, CamPathValue value)
 	Changed();
 }
 
+void CamPath::AddMany(double const * times, size_t n, CamPathValue const * values)
+{
+	CInterpolationMap<CamPathValue>::iterator hint = m_Map.end();
+
+	for(size_t i = 0; i < n; ++i)
+	{
+		hint = m_Map.insert(hint, CInterpolationMap<CamPathValue>::value_type(times[i], values[i]));
+		hint->second = values[i]; // in case the time existed already
+		++hint;
+	}
+
+	DoInterpolationMapChangedAll();
+	Changed();
+}
+
 void CamPath::Changed()
 {
+	m_Baked.Valid = false;
+
 	if(m_OnChanged) m_OnChanged->CamPathChanged(this);
 }
 
@@ -360,17 +382,383 @@ bool CamPath::CanEval(void)
 CamPathValue CamPath::Eval(double t)
 {
 	CamPathValue val;
-	
-	val.X = m_XInterp->Eval(t);
-	val.Y = m_YInterp->Eval(t);
-	val.Z = m_ZInterp->Eval(t);
-	val.R = m_RInterp->Eval(t);
-	val.Fov = m_FovInterp->Eval(t);
-	val.Selected = m_SelectedInterp->Eval(t);
+
+	if(!m_Baked.Valid) Bake();
+
+	size_t segment;
+
+	if(!FindBakedSegment(t, segment))
+	{
+		val.X = m_XInterp->Eval(t);
+		val.Y = m_YInterp->Eval(t);
+		val.Z = m_ZInterp->Eval(t);
+		val.R = m_RInterp->Eval(t);
+		val.Fov = m_FovInterp->Eval(t);
+		val.Selected = m_SelectedInterp->Eval(t);
+
+		return val;
+	}
+
+	double t0 = m_Baked.Times[segment];
+	double t1 = m_Baked.Times[segment +1];
+	double u = (t - t0) / (t1 - t0);
+
+	double channels[CBaked::_Channel_COUNT];
+
+	for(int i = 0; i < CBaked::_Channel_COUNT; ++i)
+	{
+		if(m_Baked.ChannelBaked[i])
+		{
+			std::vector<double> (& c)[4] = m_Baked.C[i];
+			channels[i] = c[0][segment] + u * (c[1][segment] + u * (c[2][segment] + u * c[3][segment]));
+		}
+	}
+
+	val.X = m_Baked.ChannelBaked[CBaked::Channel_X] ? channels[CBaked::Channel_X] : m_XInterp->Eval(t);
+	val.Y = m_Baked.ChannelBaked[CBaked::Channel_Y] ? channels[CBaked::Channel_Y] : m_YInterp->Eval(t);
+	val.Z = m_Baked.ChannelBaked[CBaked::Channel_Z] ? channels[CBaked::Channel_Z] : m_ZInterp->Eval(t);
+	val.R = m_Baked.RBaked ? m_Baked.R0[segment].Slerp(m_Baked.R1[segment], u) : m_RInterp->Eval(t);
+	val.Fov = m_Baked.ChannelBaked[CBaked::Channel_Fov] ? channels[CBaked::Channel_Fov] : m_FovInterp->Eval(t);
+
+	if(m_Baked.SelectedBaked)
+		val.Selected = t == t0 ? m_Baked.KeySelected[segment] : (t == t1 ? m_Baked.KeySelected[segment +1] : m_Baked.SegmentSelected[segment]);
+	else
+		val.Selected = m_SelectedInterp->Eval(t);
 
 	return val;
 }
 
+void CamPath::EvalMany(double const * t, size_t n, CamPathValue * out)
+{
+	const size_t blockSize = 256;
+
+	double x[blockSize];
+	double y[blockSize];
+	double z[blockSize];
+	Quaternion r[blockSize];
+	double fov[blockSize];
+	bool selected[blockSize];
+
+	for(size_t first = 0; first < n; first += blockSize)
+	{
+		size_t count = std::min(blockSize, n - first);
+
+		EvalMany(t + first, count, x, y, z, r, fov, selected);
+
+		for(size_t i = 0; i < count; ++i)
+		{
+			CamPathValue & val = out[first + i];
+
+			val.X = x[i];
+			val.Y = y[i];
+			val.Z = z[i];
+			val.R = r[i];
+			val.Fov = fov[i];
+			val.Selected = selected[i];
+		}
+	}
+}
+
+void CamPath::EvalMany(double const * t, size_t n, double * outX, double * outY, double * outZ, Quaternion * outR, double * outFov, bool * outSelected)
+{
+	const size_t blockSize = 256;
+
+	if(!m_Baked.Valid) Bake();
+
+	double * outChannels[CBaked::_Channel_COUNT] = { outX, outY, outZ, outFov };
+	CInterpolation<double> * interps[CBaked::_Channel_COUNT] = { m_XInterp, m_YInterp, m_ZInterp, m_FovInterp };
+
+	size_t segments[blockSize];
+	double us[blockSize];
+	bool inRange[blockSize];
+
+	for(size_t first = 0; first < n; first += blockSize)
+	{
+		size_t count = std::min(blockSize, n - first);
+		double const * blockT = t + first;
+		bool allInRange = true;
+
+		for(size_t i = 0; i < count; ++i)
+		{
+			size_t segment;
+
+			if(FindBakedSegment(blockT[i], segment))
+			{
+				double t0 = m_Baked.Times[segment];
+				double t1 = m_Baked.Times[segment +1];
+
+				segments[i] = segment;
+				us[i] = (blockT[i] - t0) / (t1 - t0);
+				inRange[i] = true;
+			}
+			else
+			{
+				// Any valid segment, the result is replaced below.
+				segments[i] = 0;
+				us[i] = 0.0;
+				inRange[i] = false;
+				allInRange = false;
+			}
+		}
+
+		for(int c = 0; c < CBaked::_Channel_COUNT; ++c)
+		{
+			if(nullptr == outChannels[c])
+				continue;
+
+			double * out = outChannels[c] + first;
+
+			if(m_Baked.ChannelBaked[c])
+			{
+				EvalBakedChannel(c, count, segments, us, out);
+
+				if(!allInRange)
+				{
+					for(size_t i = 0; i < count; ++i)
+					{
+						if(!inRange[i]) out[i] = interps[c]->Eval(blockT[i]);
+					}
+				}
+			}
+			else
+			{
+				for(size_t i = 0; i < count; ++i)
+				{
+					out[i] = interps[c]->Eval(blockT[i]);
+				}
+			}
+		}
+
+		if(outR)
+		{
+			Quaternion * out = outR + first;
+
+			for(size_t i = 0; i < count; ++i)
+			{
+				out[i] = m_Baked.RBaked && inRange[i] ? m_Baked.R0[segments[i]].Slerp(m_Baked.R1[segments[i]], us[i]) : m_RInterp->Eval(blockT[i]);
+			}
+		}
+
+		if(outSelected)
+		{
+			bool * out = outSelected + first;
+
+			for(size_t i = 0; i < count; ++i)
+			{
+				if(m_Baked.SelectedBaked && inRange[i])
+				{
+					size_t segment = segments[i];
+
+					out[i] = blockT[i] == m_Baked.Times[segment] ? m_Baked.KeySelected[segment] : (blockT[i] == m_Baked.Times[segment +1] ? m_Baked.KeySelected[segment +1] : m_Baked.SegmentSelected[segment]);
+				}
+				else
+					out[i] = m_SelectedInterp->Eval(blockT[i]);
+			}
+		}
+	}
+}
+
+void CamPath::EvalBakedChannel(int channel, size_t n, size_t const * segments, double const * u, double * out)
+{
+	double const * c0 = m_Baked.C[channel][0].data();
+	double const * c1 = m_Baked.C[channel][1].data();
+	double const * c2 = m_Baked.C[channel][2].data();
+	double const * c3 = m_Baked.C[channel][3].data();
+
+	size_t i = 0;
+
+#ifdef AFX_CAMPATH_SSE2
+	// Two at a time, same order of operations as the scalar code (and Eval):
+	for(; i +2 <= n; i += 2)
+	{
+		size_t s0 = segments[i];
+		size_t s1 = segments[i +1];
+
+		__m128d vu = _mm_loadu_pd(u + i);
+		__m128d r = _mm_set_pd(c3[s1], c3[s0]);
+
+		r = _mm_add_pd(_mm_set_pd(c2[s1], c2[s0]), _mm_mul_pd(vu, r));
+		r = _mm_add_pd(_mm_set_pd(c1[s1], c1[s0]), _mm_mul_pd(vu, r));
+		r = _mm_add_pd(_mm_set_pd(c0[s1], c0[s0]), _mm_mul_pd(vu, r));
+
+		_mm_storeu_pd(out + i, r);
+	}
+#endif
+
+	for(; i < n; ++i)
+	{
+		size_t s = segments[i];
+
+		out[i] = c0[s] + u[i] * (c1[s] + u[i] * (c2[s] + u[i] * c3[s]));
+	}
+}
+
+bool CamPath::FindBakedSegment(double t, size_t & outSegment)
+{
+	std::vector<double> const & times = m_Baked.Times;
+
+	if(times.size() < 2 || !(times.front() <= t && t <= times.back()))
+		return false;
+
+	size_t segment = m_Baked.Cursor;
+
+	if(!(segment +1 < times.size() && times[segment] <= t && t <= times[segment +1]))
+	{
+		if(segment +2 < times.size() && times[segment +1] <= t && t <= times[segment +2])
+		{
+			// Next segment (monotonic time).
+			++segment;
+		}
+		else
+		{
+			segment = std::upper_bound(times.begin(), times.end(), t) - times.begin();
+			segment = segment < 1 ? 0 : std::min(segment -1, times.size() -2);
+		}
+
+		m_Baked.Cursor = segment;
+	}
+
+	outSegment = segment;
+	return true;
+}
+
+namespace {
+
+bool BakedNear(double a, double b, double scale)
+{
+	return fabs(a - b) <= 1e-9 * (1.0 + scale);
+}
+
+bool BakedNear(Quaternion const & a, Quaternion const & b)
+{
+	// q and -q are the same rotation:
+	return 1.0 - 1e-12 <= fabs(DotProduct(a, b)) / sqrt(DotProduct(a, a) * DotProduct(b, b));
+}
+
+} // namespace {
+
+void CamPath::Bake(void)
+{
+	m_Baked.Valid = true;
+	m_Baked.Cursor = 0;
+	m_Baked.Times.clear();
+
+	for(int i = 0; i < CBaked::_Channel_COUNT; ++i)
+	{
+		m_Baked.ChannelBaked[i] = false;
+		for(int j = 0; j < 4; ++j) m_Baked.C[i][j].clear();
+	}
+
+	m_Baked.RBaked = false;
+	m_Baked.R0.clear();
+	m_Baked.R1.clear();
+
+	m_Baked.SelectedBaked = false;
+	m_Baked.KeySelected.clear();
+	m_Baked.SegmentSelected.clear();
+
+	if(m_Map.size() < 2 || !CanEval())
+		return;
+
+	for(CInterpolationMap<CamPathValue>::const_iterator it = m_Map.begin(); it != m_Map.end(); ++it)
+	{
+		m_Baked.Times.push_back(it->first);
+	}
+
+	size_t segments = m_Baked.Times.size() -1;
+
+	CInterpolation<double> * interps[CBaked::_Channel_COUNT] = { m_XInterp, m_YInterp, m_ZInterp, m_FovInterp };
+
+	for(int i = 0; i < CBaked::_Channel_COUNT; ++i)
+	{
+		bool baked = true;
+
+		for(size_t j = 0; baked && j < segments; ++j)
+		{
+			double t0 = m_Baked.Times[j];
+			double dt = m_Baked.Times[j +1] - t0;
+
+			// Cubic through u = 0, 1/3, 2/3, 1:
+			double v0 = interps[i]->Eval(t0);
+			double v1 = interps[i]->Eval(t0 + dt / 3.0);
+			double v2 = interps[i]->Eval(t0 + dt * 2.0 / 3.0);
+			double v3 = interps[i]->Eval(t0 + dt);
+
+			double c0 = v0;
+			double c1 = (-11.0 * v0 + 18.0 * v1 - 9.0 * v2 + 2.0 * v3) / 2.0;
+			double c2 = 9.0 * (2.0 * v0 - 5.0 * v1 + 4.0 * v2 - v3) / 2.0;
+			double c3 = 9.0 * (-v0 + 3.0 * v1 - 3.0 * v2 + v3) / 2.0;
+
+			double scale = std::max(std::max(fabs(v0), fabs(v1)), std::max(fabs(v2), fabs(v3)));
+
+			for(double u = 0.125; baked && u < 1.0; u += 0.25)
+			{
+				baked = BakedNear(c0 + u * (c1 + u * (c2 + u * c3)), interps[i]->Eval(t0 + dt * u), scale);
+			}
+
+			m_Baked.C[i][0].push_back(c0);
+			m_Baked.C[i][1].push_back(c1);
+			m_Baked.C[i][2].push_back(c2);
+			m_Baked.C[i][3].push_back(c3);
+		}
+
+		m_Baked.ChannelBaked[i] = baked;
+	}
+
+	if(QI_SLINEAR == m_RotationInterpMethod)
+	{
+		bool baked = true;
+
+		for(size_t j = 0; baked && j < segments; ++j)
+		{
+			double t0 = m_Baked.Times[j];
+			double dt = m_Baked.Times[j +1] - t0;
+
+			Quaternion q0 = m_RInterp->Eval(t0);
+			Quaternion q1 = m_RInterp->Eval(t0 + dt);
+
+			// Travel the short way:
+			if(DotProduct(q0, q1) < 0.0) q1 = -1.0 * q1;
+
+			for(double u = 0.125; baked && u < 1.0; u += 0.25)
+			{
+				baked = BakedNear(q0.Slerp(q1, u), m_RInterp->Eval(t0 + dt * u));
+			}
+
+			m_Baked.R0.push_back(q0);
+			m_Baked.R1.push_back(q1);
+		}
+
+		m_Baked.RBaked = baked;
+	}
+
+	{
+		bool baked = true;
+
+		for(size_t j = 0; j <= segments; ++j)
+		{
+			m_Baked.KeySelected.push_back(m_SelectedInterp->Eval(m_Baked.Times[j]));
+		}
+
+		for(size_t j = 0; baked && j < segments; ++j)
+		{
+			double t0 = m_Baked.Times[j];
+			double dt = m_Baked.Times[j +1] - t0;
+
+			bool selected = m_SelectedInterp->Eval(t0 + dt * 0.5);
+
+			for(double u = 0.125; baked && u < 1.0; u += 0.25)
+			{
+				baked = selected == m_SelectedInterp->Eval(t0 + dt * u);
+			}
+
+			m_Baked.SegmentSelected.push_back(selected);
+		}
+
+		m_Baked.SelectedBaked = baked;
+	}
+}
+
 void CamPath::OnChanged_set(ICamPathChanged * value)
 {
 	m_OnChanged = value;
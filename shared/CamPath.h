@@ -3,6 +3,8 @@
 #include "RefCounted.h"
 #include <shared/AfxMath.h>
 
+#include <vector>
+
 using namespace Afx;
 using namespace Afx::Math;
 
@@ -92,6 +94,10 @@ public:
 
 	void Add(double time, CamPathValue value);
 
+	/// <summary>Like calling Add for each of the n values, but notifies about the change only once.</summary>
+	/// <remarks>Fastest if times are increasing.</remarks>
+	void AddMany(double const * times, size_t n, CamPathValue const * values);
+
 	void Remove(double time);
 	void Clear();
 
@@ -110,9 +116,21 @@ public:
 
 	/// <remarks>
 	/// Must not be called if CanEval() returns false!<br />
+	/// Uses the baked path (see CBaked), which is fastest when t is increasing.
 	/// </remarks>
 	CamPathValue Eval(double t);
 
+	/// <summary>Evaluates the path at the n times t into out, same results as Eval.</summary>
+	/// <remarks>
+	/// Must not be called if CanEval() returns false!<br />
+	/// Faster than calling Eval n times, especially if t is increasing.
+	/// </remarks>
+	void EvalMany(double const * t, size_t n, CamPathValue * out);
+
+	/// <summary>Like EvalMany above, but with an array per channel, channels with a nullptr array are not evaluated.</summary>
+	/// <remarks>Must not be called if CanEval() returns false!</remarks>
+	void EvalMany(double const * t, size_t n, double * outX, double * outY, double * outZ, Quaternion * outR, double * outFov, bool * outSelected);
+
 	bool Save(wchar_t const * fileName);
 	bool Load(wchar_t const * fileName);
 	
@@ -213,6 +231,57 @@ private:
 	CInterpolation<double> * m_FovInterp;
 	CInterpolation<bool> * m_SelectedInterp;
 
+	/// <summary>
+	///   Baked form of the interpolations for fast evaluation, built on the
+	///   first Eval after a change.<br />
+	///   Per segment between two key frames the position and fov are stored as
+	///   cubic polynomials in the segment's relative time u (0 .. 1), the
+	///   rotation (sLinear only) as the quaternions to slerp between.
+	///   Each channel is only baked if it reproduces the interpolation at
+	///   test points of every segment, otherwise Eval keeps using the
+	///   interpolation for it.
+	/// </summary>
+	struct CBaked
+	{
+		enum Channel_e {
+			Channel_X = 0,
+			Channel_Y,
+			Channel_Z,
+			Channel_Fov,
+			_Channel_COUNT
+		};
+
+		bool Valid = false;
+
+		std::vector<double> Times;
+
+		bool ChannelBaked[_Channel_COUNT];
+
+		/// <summary>Per segment: value = C[0] + u * (C[1] + u * (C[2] + u * C[3])).</summary>
+		std::vector<double> C[_Channel_COUNT][4];
+
+		bool RBaked;
+		std::vector<Quaternion> R0;
+		std::vector<Quaternion> R1;
+
+		bool SelectedBaked;
+		std::vector<bool> KeySelected;
+		std::vector<bool> SegmentSelected;
+
+		/// <summary>Segment of the last Eval.</summary>
+		size_t Cursor = 0;
+	};
+
+	CBaked m_Baked;
+
+	void Bake(void);
+
+	/// <returns>false if t is outside the key frames.</returns>
+	bool FindBakedSegment(double t, size_t & outSegment);
+
+	/// <summary>Evaluates the baked polynomials of channel for n segments and relative times u.</summary>
+	void EvalBakedChannel(int channel, size_t n, size_t const * segments, double const * u, double * out);
+
 	void Changed();
 	void CopyMap(CInterpolationMap<CamPathValue> & dst, CInterpolationMap<CamPathValue> & src);
 
@@ -0,0 +1,216 @@
+#include "stdafx.h"
+
+#include "CamPathTrajectory.h"
+
+#include <string.h>
+
+#include <utility>
+
+// CCamPathTrajectoryCache /////////////////////////////////////////////////////
+
+CCamPathTrajectoryCache::CCamPathTrajectoryCache()
+: m_PointsPerInterval(0)
+, m_Epsilon(0)
+, m_ReducedCount(0)
+{
+}
+
+void CCamPathTrajectoryCache::Clear(void)
+{
+	m_PointsPerInterval = 0;
+	m_Epsilon = 0;
+	m_ReducedCount = 0;
+	m_Intervals.clear();
+}
+
+size_t CCamPathTrajectoryCache::GetReducedCount(void) const
+{
+	return m_ReducedCount;
+}
+
+/// <summary>FNV-1a over the bits of the values, so any change counts.</summary>
+static uint64_t CamPathTrajectory_Hash(uint64_t hash, double const * values, size_t count)
+{
+	for(size_t i = 0; i < count; ++i)
+	{
+		uint64_t bits;
+		memcpy(&bits, &(values[i]), sizeof(bits));
+
+		for(int j = 0; j < 8; ++j)
+		{
+			hash ^= (bits >> (8 * j)) & 0xff;
+			hash *= 1099511628211ULL;
+		}
+	}
+
+	return hash;
+}
+
+// CamPathTrajectory ///////////////////////////////////////////////////////////
+
+void CamPathTrajectory_Build(CamPath & camPath, size_t pointsPerInterval, double epsilon, CCamPathTrajectoryCache & cache, std::vector<double> & outTimes)
+{
+	outTimes.clear();
+
+	if(pointsPerInterval != cache.m_PointsPerInterval || epsilon != cache.m_Epsilon)
+	{
+		cache.Clear();
+		cache.m_PointsPerInterval = pointsPerInterval;
+		cache.m_Epsilon = epsilon;
+	}
+
+	cache.m_ReducedCount = 0;
+
+	std::vector<CCamPathTrajectoryCache::CInterval> intervals;
+	intervals.reserve(camPath.GetSize());
+
+	// Old intervals are ordered by time too, so they are matched in one pass:
+	std::vector<CCamPathTrajectoryCache::CInterval>::iterator itCached = cache.m_Intervals.begin();
+
+	std::vector<double> ptsT(pointsPerInterval);
+	std::vector<double> ptsX(pointsPerInterval);
+	std::vector<double> ptsY(pointsPerInterval);
+	std::vector<double> ptsZ(pointsPerInterval);
+	std::vector<size_t> indices;
+
+	CamPathIterator last = camPath.GetBegin();
+	CamPathIterator it = last;
+
+	for(++it; it != camPath.GetEnd(); ++it)
+	{
+		double t0 = last.GetTime();
+		double t1 = it.GetTime();
+		double delta = t1 - t0;
+
+		for(size_t i = 0; i < pointsPerInterval; ++i)
+		{
+			ptsT[i] = t0 + delta*((double)i/(pointsPerInterval-1));
+		}
+
+		// Only the position is needed here:
+		camPath.EvalMany(&(ptsT[0]), pointsPerInterval, &(ptsX[0]), &(ptsY[0]), &(ptsZ[0]), nullptr, nullptr, nullptr);
+
+		uint64_t hash = 14695981039346656037ULL;
+		hash = CamPathTrajectory_Hash(hash, &(ptsX[0]), pointsPerInterval);
+		hash = CamPathTrajectory_Hash(hash, &(ptsY[0]), pointsPerInterval);
+		hash = CamPathTrajectory_Hash(hash, &(ptsZ[0]), pointsPerInterval);
+
+		while(itCached != cache.m_Intervals.end() && itCached->T0 < t0) ++itCached;
+
+		intervals.emplace_back();
+		CCamPathTrajectoryCache::CInterval & interval = intervals.back();
+
+		if(itCached != cache.m_Intervals.end() && itCached->T0 == t0 && itCached->T1 == t1 && itCached->Hash == hash)
+		{
+			interval = std::move(*itCached);
+		}
+		else
+		{
+			interval.T0 = t0;
+			interval.T1 = t1;
+			interval.Hash = hash;
+
+			CamPathTrajectory_RamerDouglasPeucker(&(ptsX[0]), &(ptsY[0]), &(ptsZ[0]), pointsPerInterval, epsilon, indices);
+
+			// all points except the last one (to avoid duplicates):
+			for(size_t i = 0; i +1 < indices.size(); ++i)
+			{
+				interval.Times.push_back(ptsT[indices[i]]);
+			}
+
+			++cache.m_ReducedCount;
+		}
+
+		outTimes.insert(outTimes.end(), interval.Times.begin(), interval.Times.end());
+
+		last = it;
+	}
+
+	// add last point:
+	outTimes.push_back(ptsT[pointsPerInterval-1]);
+
+	cache.m_Intervals.swap(intervals);
+}
+
+void CamPathTrajectory_Build(CamPath & camPath, size_t pointsPerInterval, double epsilon, std::vector<double> & outTimes)
+{
+	CCamPathTrajectoryCache cache;
+
+	CamPathTrajectory_Build(camPath, pointsPerInterval, epsilon, cache, outTimes);
+}
+
+void CamPathTrajectory_RamerDouglasPeucker(double const * x, double const * y, double const * z, size_t count, double epsilon, std::vector<size_t> & outIndices)
+{
+	outIndices.clear();
+
+	if(count < 1)
+		return;
+
+	std::vector<bool> keep(count, false);
+	keep[0] = true;
+	keep[count -1] = true;
+
+	// Ranges still to simplify (iterative instead of recursive):
+	std::vector<std::pair<size_t, size_t>> ranges;
+	ranges.push_back(std::pair<size_t, size_t>(0, count -1));
+
+	double epsilonSq = epsilon * epsilon;
+
+	while(!ranges.empty())
+	{
+		size_t start = ranges.back().first;
+		size_t end = ranges.back().second;
+		ranges.pop_back();
+
+		double Sx = x[start];
+		double Sy = y[start];
+		double Sz = z[start];
+		double ESx = x[end] - Sx;
+		double ESy = y[end] - Sy;
+		double ESz = z[end] - Sz;
+		double dESdES = ESx*ESx + ESy*ESy + ESz*ESz;
+
+		double dmax = 0;
+		size_t index = start;
+
+		for(size_t i = start +1; i < end; ++i)
+		{
+			// Squared shortest distance to the segment from start to end:
+
+			double Px = x[i] - Sx;
+			double Py = y[i] - Sy;
+			double Pz = z[i] - Sz;
+			double t = dESdES ? (Px*ESx + Py*ESy + Pz*ESz) / dESdES : 0.0;
+
+			if(t <= 0.0)
+				t = 0.0;
+			else
+			if(1.0 <= t)
+				t = 1.0;
+
+			double Dx = Px - t*ESx;
+			double Dy = Py - t*ESy;
+			double Dz = Pz - t*ESz;
+			double d = Dx*Dx + Dy*Dy + Dz*Dz;
+
+			if(d > dmax)
+			{
+				index = i;
+				dmax = d;
+			}
+		}
+
+		// If max distance is greater than epsilon, simplify both sides
+		if(dmax > epsilonSq)
+		{
+			keep[index] = true;
+			ranges.push_back(std::pair<size_t, size_t>(index, end));
+			ranges.push_back(std::pair<size_t, size_t>(start, index));
+		}
+	}
+
+	for(size_t i = 0; i < count; ++i)
+	{
+		if(keep[i]) outIndices.push_back(i);
+	}
+}
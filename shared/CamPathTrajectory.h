@@ -0,0 +1,66 @@
+#pragma once
+
+#include "CamPath.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+/// <summary>
+///   Reduced points of each interval from the last CamPathTrajectory_Build,
+///   keyed by the interval's key frame times and a hash of its samples.
+/// </summary>
+class CCamPathTrajectoryCache
+{
+public:
+	CCamPathTrajectoryCache();
+
+	void Clear(void);
+
+	/// <returns>Number of intervals the last build had to reduce, the others came from the cache.</returns>
+	size_t GetReducedCount(void) const;
+
+private:
+	friend void CamPathTrajectory_Build(CamPath & camPath, size_t pointsPerInterval, double epsilon, CCamPathTrajectoryCache & cache, std::vector<double> & outTimes);
+
+	struct CInterval
+	{
+		double T0;
+		double T1;
+		uint64_t Hash;
+
+		/// <summary>Times of the kept points, except the last one (T1).</summary>
+		std::vector<double> Times;
+	};
+
+	size_t m_PointsPerInterval;
+	double m_Epsilon;
+	size_t m_ReducedCount;
+	std::vector<CInterval> m_Intervals;
+};
+
+/// <summary>
+///   Times of the points for drawing the trajectory of camPath's position
+///   (e.g. by CCampathDrawer): each interval between two key frames is
+///   sampled at pointsPerInterval points and reduced with
+///   CamPathTrajectory_RamerDouglasPeucker.
+/// </summary>
+/// <remarks>
+///   Every interval is sampled again, since the interpolation of an interval
+///   can depend on any of the key frames, but only intervals whose times or
+///   samples differ from the cache are reduced again.<br />
+///   camPath must have at least 2 key frames and CanEval must be true.
+/// </remarks>
+/// <param name="pointsPerInterval">Must be at least 2.</param>
+/// <param name="epsilon">In world units, must be at least 0.0.</param>
+/// <param name="cache">Results of the last build, updated for this one.</param>
+/// <param name="outTimes">Times of the points in order, including the first and last key frame.</param>
+void CamPathTrajectory_Build(CamPath & camPath, size_t pointsPerInterval, double epsilon, CCamPathTrajectoryCache & cache, std::vector<double> & outTimes);
+
+/// <summary>Like above, but without reusing any results.</summary>
+void CamPathTrajectory_Build(CamPath & camPath, size_t pointsPerInterval, double epsilon, std::vector<double> & outTimes);
+
+/// <summary>For reducing the number of points, iterative and comparing squared distances.</summary>
+/// <param name="outIndices">Indices of the points kept, in order, always including the first and last one.</param>
+void CamPathTrajectory_RamerDouglasPeucker(double const * x, double const * y, double const * z, size_t count, double epsilon, std::vector<size_t> & outIndices);
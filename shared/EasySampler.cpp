@@ -32,8 +32,11 @@ EasyByteSampler::EasyByteSampler(
 	m_Pitch = pitch;
 	m_Frame = new Frame(height * width);
 	m_FramePrinter = framePrinter;
+	m_CurSampleWeight = 0;
 	m_HasLastSample = false;
+	m_Kernels = EasySamplerKernels::Get(settings.Kernels_get());
 	m_LastSample = twoPoint ? new unsigned char[height * pitch] : 0;
+	m_LastSampleWeight = 0;
 	m_PrintMem = new unsigned char[height * pitch];
 }
 
@@ -63,72 +66,21 @@ void EasyByteSampler::ClearFrame(float frameStrength)
 
 void EasyByteSampler::Fn_1(void const * sample)
 {
-	int height = m_Settings.Height_get();
-	int width = m_Settings.Width_get();
-	int deltaPitch = m_Pitch -width;
-	float *fdata = m_Frame->Data;
-	unsigned char const * cdata = (unsigned char const *)sample;
-
-	for( int iy=0; iy < height; iy++ )
-	{
-		for( int ix=0; ix < width; ix++ ) 
-		{
-			*fdata = *fdata + *cdata;
-			
-			fdata++;
-			cdata++;
-		}
-		cdata += deltaPitch;
-	}
+	m_Kernels->Byte_Fn_1(m_Frame->Data, (unsigned char const *)sample, m_Settings.Width_get(), m_Settings.Height_get(), m_Pitch);
 
 	m_Frame->WhitePoint += 255.0f;
 }
 
 void EasyByteSampler::Fn_2(void const * sample, float w)
 {
-	int height = m_Settings.Height_get();
-	int width = m_Settings.Width_get();
-	int deltaPitch = m_Pitch -width;
-	float *fdata = m_Frame->Data;
-	unsigned char const * cdata = (unsigned char const *)sample;
-
-	for( int iy=0; iy < height; iy++ )
-	{
-		for( int ix=0; ix < width; ix++ ) 
-		{
-			*fdata = *fdata + w * *cdata;
-			
-			fdata++;
-			cdata++;
-		}
-		cdata += deltaPitch;
-	}
+	m_Kernels->Byte_Fn_2(m_Frame->Data, (unsigned char const *)sample, w, m_Settings.Width_get(), m_Settings.Height_get(), m_Pitch);
 
 	m_Frame->WhitePoint += w * 255.0f;
 }
 
 void EasyByteSampler::Fn_4(void const * sampleA, void const * sampleB, float w)
 {
-	int height = m_Settings.Height_get();
-	int width = m_Settings.Width_get();
-	int deltaPitch = m_Pitch -width;
-	float *fdata = m_Frame->Data;
-	unsigned char const * cdataA = (unsigned char const *)sampleA;
-	unsigned char const * cdataB = (unsigned char const *)sampleB;
-
-	for( int iy=0; iy < height; iy++ )
-	{
-		for( int ix=0; ix < width; ix++ ) 
-		{
-			*fdata = *fdata + w * ((unsigned int)*cdataA +(unsigned int)*cdataB);
-			
-			fdata++;
-			cdataA++;
-			cdataB++;
-		}
-		cdataA += deltaPitch;
-		cdataB += deltaPitch;
-	}
+	m_Kernels->Byte_Fn_4(m_Frame->Data, (unsigned char const *)sampleA, (unsigned char const *)sampleB, w, m_Settings.Width_get(), m_Settings.Height_get(), m_Pitch);
 
 	m_Frame->WhitePoint += w * 2.0f * 255.0f;
 }
@@ -146,26 +98,9 @@ void EasyByteSampler::PrintFrame()
 	}
 	else
 	{
-		float * fdata = m_Frame->Data;
-
-		int height = m_Settings.Height_get();
-		int width = m_Settings.Width_get();
-		int deltaPitch = m_Pitch - width;
-
 		w = 255.0f / w;
 
-		for( int iy=0; iy < height; iy++ )
-		{
-			for( int ix=0; ix < width; ix++ )
-			{
-				*data = (unsigned char)(w * *fdata);
-
-				fdata++;
-				data++;
-			}
-
-			data += deltaPitch;
-		}
+		m_Kernels->Byte_Print(data, m_Frame->Data, w, m_Settings.Width_get(), m_Settings.Height_get(), m_Pitch);
 	}
 
 	m_FramePrinter->Print(m_PrintMem);
@@ -175,16 +110,35 @@ void EasyByteSampler::PrintFrame()
 void EasyByteSampler::Sample(unsigned char const * data, double time)
 {
 	m_CurSample = data;
+	m_CurSampleWeight = 0;
 
 	EasySamplerBase::Sample(time);
 
 	if(m_LastSample && data)
 	{
+		// The weight of the current sample is not final yet, it's kept as the next last sample:
+
+		Integrator_Flush(this,
+			m_HasLastSample ? m_LastSample : 0, m_LastSampleWeight,
+			0, m_CurSampleWeight
+		);
+
 		memcpy(m_LastSample, data, m_Settings.Height_get() * m_Pitch * sizeof(unsigned char));
 		m_HasLastSample = true;
+		m_LastSampleWeight = m_CurSampleWeight;
 	}
 	else
+	{
+		Integrator_Flush(this,
+			m_HasLastSample ? m_LastSample : 0, m_LastSampleWeight,
+			data, m_CurSampleWeight
+		);
+
 		m_HasLastSample = false;
+	}
+
+	m_CurSample = 0;
+	m_CurSampleWeight = 0;
 }
 
 
@@ -206,21 +160,9 @@ void EasyByteSampler::ScaleFrame(float factor)
 		return;
 	}
 	
-	float * fdata = m_Frame->Data;
-
-	int height = m_Settings.Height_get();
-	int width = m_Settings.Width_get();
-
 	m_Frame->WhitePoint *= factor;
 
-	for( int iy=0; iy < height; iy++ )
-	{
-		for( int ix=0; ix < width; ix++ )
-		{
-			*fdata = factor * *fdata;
-			fdata++;
-		}
-	}
+	m_Kernels->Scale(m_Frame->Data, factor, (size_t)m_Settings.Height_get() * m_Settings.Width_get());
 }
 
 
@@ -240,10 +182,14 @@ EasyFloatSampler::EasyFloatSampler(
 	bool twoPoint = EasySamplerSettings::ESM_Trapezoid == settings.Method_get();
 
 	m_FrameData = new float[height * width];
+	memset(m_FrameData, 0, sizeof(float) * height * width);
 	m_FramePrinter = framePrinter;
 	m_FrameWhitePoint = 0;
+	m_CurSampleWeight = 0;
 	m_HasLastSample = false;
+	m_Kernels = EasySamplerKernels::Get(settings.Kernels_get());
 	m_LastSample = twoPoint ? new float[height * width] : 0;
+	m_LastSampleWeight = 0;
 	m_PrintMem = new float[height * width];
 }
 
@@ -273,65 +219,21 @@ void EasyFloatSampler::ClearFrame(float frameStrength)
 
 void EasyFloatSampler::Fn_1(void const * sample)
 {
-	int height = m_Settings.Height_get();
-	int width = m_Settings.Width_get();
-	float *fdata = m_FrameData;
-	float const * cdata = (float const *)sample;
-
-	for( int iy=0; iy < height; iy++ )
-	{
-		for( int ix=0; ix < width; ix++ ) 
-		{
-			*fdata = *fdata + *cdata;
-			
-			fdata++;
-			cdata++;
-		}
-	}
+	m_Kernels->Float_Fn_1(m_FrameData, (float const *)sample, (size_t)m_Settings.Height_get() * m_Settings.Width_get());
 
 	m_FrameWhitePoint += 1.0f;
 }
 
 void EasyFloatSampler::Fn_2(void const * sample, float w)
 {
-	int height = m_Settings.Height_get();
-	int width = m_Settings.Width_get();
-	float *fdata = m_FrameData;
-	float const * cdata = (float const *)sample;
-
-	for( int iy=0; iy < height; iy++ )
-	{
-		for( int ix=0; ix < width; ix++ ) 
-		{
-			*fdata = *fdata + w * *cdata;
-			
-			fdata++;
-			cdata++;
-		}
-	}
+	m_Kernels->Float_Fn_2(m_FrameData, (float const *)sample, w, (size_t)m_Settings.Height_get() * m_Settings.Width_get());
 
 	m_FrameWhitePoint += w * 1.0f;
 }
 
 void EasyFloatSampler::Fn_4(void const * sampleA, void const * sampleB, float w)
 {
-	int height = m_Settings.Height_get();
-	int width = m_Settings.Width_get();
-	float *fdata = m_FrameData;
-	float const * cdataA = (float const *)sampleA;
-	float const * cdataB = (float const *)sampleB;
-
-	for( int iy=0; iy < height; iy++ )
-	{
-		for( int ix=0; ix < width; ix++ ) 
-		{
-			*fdata = *fdata + w * (*cdataA + *cdataB);
-			
-			fdata++;
-			cdataA++;
-			cdataB++;
-		}
-	}
+	m_Kernels->Float_Fn_4(m_FrameData, (float const *)sampleA, (float const *)sampleB, w, (size_t)m_Settings.Height_get() * m_Settings.Width_get());
 
 	m_FrameWhitePoint += w * 2.0f * 1.0f;
 }
@@ -348,23 +250,9 @@ void EasyFloatSampler::PrintFrame()
 	}
 	else
 	{
-		float * fdata = m_FrameData;
-
-		int height = m_Settings.Height_get();
-		int width = m_Settings.Width_get();
-
 		w = 1.0f / w;
 
-		for( int iy=0; iy < height; iy++ )
-		{
-			for( int ix=0; ix < width; ix++ )
-			{
-				*data = w * *fdata;
-
-				fdata++;
-				data++;
-			}
-		}
+		m_Kernels->Float_Print(data, m_FrameData, w, (size_t)m_Settings.Height_get() * m_Settings.Width_get());
 	}
 
 	m_FramePrinter->Print(m_PrintMem);
@@ -374,16 +262,35 @@ void EasyFloatSampler::PrintFrame()
 void EasyFloatSampler::Sample(float const * data, double time)
 {
 	m_CurSample = data;
+	m_CurSampleWeight = 0;
 
 	EasySamplerBase::Sample(time);
 
 	if(m_LastSample && data)
 	{
+		// The weight of the current sample is not final yet, it's kept as the next last sample:
+
+		Integrator_Flush(this,
+			m_HasLastSample ? m_LastSample : 0, m_LastSampleWeight,
+			0, m_CurSampleWeight
+		);
+
 		memcpy(m_LastSample, data, m_Settings.Height_get() * m_Settings.Width_get() * sizeof(float));
 		m_HasLastSample = true;
+		m_LastSampleWeight = m_CurSampleWeight;
 	}
 	else
+	{
+		Integrator_Flush(this,
+			m_HasLastSample ? m_LastSample : 0, m_LastSampleWeight,
+			data, m_CurSampleWeight
+		);
+
 		m_HasLastSample = false;
+	}
+
+	m_CurSample = 0;
+	m_CurSampleWeight = 0;
 }
 
 
@@ -405,21 +312,9 @@ void EasyFloatSampler::ScaleFrame(float factor)
 		return;
 	}
 	
-	float * fdata = m_FrameData;
-
-	int height = m_Settings.Height_get();
-	int width = m_Settings.Width_get();
-
 	m_FrameWhitePoint *= factor;
 
-	for( int iy=0; iy < height; iy++ )
-	{
-		for( int ix=0; ix < width; ix++ )
-		{
-			*fdata = factor * *fdata;
-			fdata++;
-		}
-	}
+	m_Kernels->Scale(m_FrameData, factor, (size_t)m_Settings.Height_get() * m_Settings.Width_get());
 }
 
 
@@ -453,121 +348,74 @@ bool EasySamplerBase::CanSkipConstant(double time, double durationPerSample, int
 }
 
 
-void EasySamplerBase::Integrator_Fn(ISampleFns *fns, void const * sampleA, void const *sampleB, double timeA, double timeB, double subTimeA, double subTimeB)
+void EasySamplerBase::Integrator_Accumulate(bool hasSampleA, bool hasSampleB, double timeA, double timeB, double subTimeA, double subTimeB, double & weightA, double & weightB)
 {
-	double weightA;
-	double weightB;
+	double wA;
+	double wB;
 
 	{
 		// Calculate weigths:
 		double dAB = timeB -timeA;
 		double w1 = (subTimeB -subTimeA) / 2.0;
 		double w2 = dAB ? (subTimeA +subTimeB -2.0 * timeA) / dAB : 0.0;
-		weightA = w1 * (2 -w2);
-		weightB = w1 * w2;
+		wA = w1 * (2 -w2);
+		wB = w1 * w2;
 	}
 
 #ifdef DEBUG_EASYSAMPLER
-	pEngfuncs->Con_Printf(" (wA=%f, SA:%s, wB=%f, SB:%s)", weightA, sampleA ? "Y" : "N", weightB, sampleB? "Y" : "N");
+	pEngfuncs->Con_Printf(" (wA=%f, SA:%s, wB=%f, SB:%s)", wA, hasSampleA ? "Y" : "N", wB, hasSampleB ? "Y" : "N");
 #endif
 
-
-	//
-	// optimize / combine the function:
-
-	if(0 == weightA)
+	if(hasSampleA)
 	{
-		weightA = weightB;
-		weightB = 0;
-		sampleA = sampleB;
-		sampleB = 0;
-	}
+		// 2 point sampling, if there is no sample B, it's weight is dropped.
 
-	if(0 == weightA)
-	{
-		// zero weights.
+		weightA += wA;
 
-		return;  // done;
+		if(hasSampleB)
+			weightB += wB;
 	}
-
-	assert(0 != weightA);
-
-	if(0 == sampleA)
+	else if(hasSampleB)
 	{
 		// switch to 1 point sampling.
 
-		sampleA = sampleB;
-		sampleB = 0;
-
-		weightA = weightA + weightB;
-		weightB = 0;
+		weightB += wA + wB;
 	}
 
-	if(0 == sampleA)
-	{
-		// 0 point sampling.
+	// else: 0 point sampling.
+}
 
-		return; // done.
-	}
 
-	assert(0 != weightA);
-	assert(0 != sampleA);
+void EasySamplerBase::Integrator_Flush(ISampleFns *fns, void const *sampleA, double & weightA, void const *sampleB, double & weightB)
+{
+	double wA = sampleA ? weightA : 0;
+	double wB = sampleB ? weightB : 0;
 
-	if(0 == sampleB || 0 == weightB)
+	if(0 != wA && 0 != wB && wA == wB && 1 != wA)
 	{
-		if(1 == weightA)
-		{
-			fns->Fn_1(sampleA);
-		}
-		else
-		{
-			fns->Fn_2(sampleA, (float)weightA);
-		}
+		fns->Fn_4(sampleA, sampleB, (float)wA);
 	}
 	else
 	{
-		// 2 points.
-
-		assert(0 != weightB && 0 != sampleB);
-
-		if(weightA == weightB)
+		if(0 != wA)
 		{
-			if(1 == weightA)
-			{
+			if(1 == wA)
 				fns->Fn_1(sampleA);
-				fns->Fn_1(sampleB);
-			}
 			else
-			{
-				fns->Fn_4(sampleA, sampleB, (float)weightA);
-			}
+				fns->Fn_2(sampleA, (float)wA);
 		}
-		else
-		{
-			if(1 == weightB)
-			{
-				void const *tS = sampleA;
-				double tW = weightA;
 
-				sampleA = sampleB;
-				sampleB = tS;
-
-				weightA = weightB;
-				weightB = tW;
-			}
-
-			if(1 == weightA)
-			{
-				fns->Fn_1(sampleA);
-				fns->Fn_2(sampleB, (float)weightB);
-			}
+		if(0 != wB)
+		{
+			if(1 == wB)
+				fns->Fn_1(sampleB);
 			else
-			{
-				fns->Fn_2(sampleA, (float)weightA);
-				fns->Fn_2(sampleB, (float)weightB);
-			}
+				fns->Fn_2(sampleB, (float)wB);
 		}
 	}
+
+	if(0 != wA) weightA = 0;
+	if(0 != wB) weightB = 0;
 }
 
 
@@ -658,7 +506,8 @@ EasySamplerSettings::EasySamplerSettings(
 	double frameDuration,
 	double startTime,
 	double exposure,
-	float frameStrength
+	float frameStrength,
+	EasySamplerKernels::Kind kernels
 )
 {
 	assert(0 <= height);
@@ -668,6 +517,7 @@ EasySamplerSettings::EasySamplerSettings(
 	m_FrameDuration = frameDuration;
 	m_FrameStrength = frameStrength;
 	m_Height = height;
+	m_Kernels = kernels;
 	m_Method = method;
 	m_StartTime = startTime;
 	m_Width = width;	
@@ -679,6 +529,7 @@ EasySamplerSettings::EasySamplerSettings(EasySamplerSettings const & settings)
 	m_FrameDuration = settings.FrameDuration_get();
 	m_FrameStrength = settings.FrameStrength_get();
 	m_Height = settings.Height_get();
+	m_Kernels = settings.Kernels_get();
 	m_Method = settings.Method_get();
 	m_StartTime = settings.StartTime_get();
 	m_Width = settings.Width_get();
@@ -700,6 +551,10 @@ int EasySamplerSettings::Height_get() const
 {
 	return m_Height;	
 }
+EasySamplerKernels::Kind EasySamplerSettings::Kernels_get() const
+{
+	return m_Kernels;
+}
 EasySamplerSettings::Method EasySamplerSettings::Method_get() const
 {
 	return m_Method;
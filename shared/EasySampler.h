@@ -1,12 +1,16 @@
 #pragma once
 
-// TODO:
+// Remarks:
 //
-// In the average case where the full range of a sample is
-// used (within a frame), CPU power is wasted, because the same multiplication
-// is done twice when interpolating from the next sample.
-// (First it's the new one, then the old one and factors
-// are about the same, this is a waste).
+// The weights of a sample are accumulated over all the sub-intervals it takes
+// part in and only applied when the sample is about to go away or the frame
+// is finished (Integrator_Accumulate / Integrator_Flush), so in the average
+// case each sample is multiplied into the frame only once, instead of once as
+// the new and once more as the old sample of the next interval.
+// Summing the weights first changes the float rounding slightly compared to
+// applying each sub-interval on its own (see EasySamplerTest.cpp).
+
+#include "EasySamplerKernels.h"
 
 #include <memory.h>
 
@@ -94,11 +98,21 @@ protected:
 protected:
 	/// <summary>
 	///	  Auto 2 (trapezium) / 1 (rectangle) / 0 point sampling by integration.<br />
-	///   Selects, optimizes and combines the integration using a given set of base functions.
+	///   Instead of applying the integration this only adds the weights
+	///   for the samples to weightA and weightB, use Integrator_Flush to
+	///   apply them.
+	/// </summary>
+	/// <param name="hasSampleA">if there is a sample A</param>
+	/// <param name="hasSampleB">if there is a sample B</param>
+	static void Integrator_Accumulate(bool hasSampleA, bool hasSampleB, double timeA, double timeB, double subTimeA, double subTimeB, double & weightA, double & weightB);
+
+	/// <summary>
+	///   Applies the weights accumulated by Integrator_Accumulate using a given set of base functions.<br />
+	///   The weight of each sample that is not 0 is reset to 0.
 	/// </summary>
 	/// <param name="sampleA">can be 0</param>
 	/// <param name="sampleB">can be 0</param>
-	static void Integrator_Fn(ISampleFns *fns, void const *sampleA, void const *sampleB, double timeA, double timeB, double subTimeA, double subTimeB);
+	static void Integrator_Flush(ISampleFns *fns, void const *sampleA, double & weightA, void const *sampleB, double & weightB);
 
 private:
 	double m_FrameDuration;
@@ -131,7 +145,8 @@ public:
 		double frameDuration,
 		double startTime,
 		double exposure,
-		float frameStrength
+		float frameStrength,
+		EasySamplerKernels::Kind kernels = EasySamplerKernels::EK_Auto
 	);
 
 	EasySamplerSettings(EasySamplerSettings const & settings);
@@ -140,6 +155,7 @@ public:
 	double FrameDuration_get() const;
 	float FrameStrength_get() const;
 	int Height_get() const;
+	EasySamplerKernels::Kind Kernels_get() const;
 	Method Method_get() const;
 	double StartTime_get() const;
 	int Width_get() const;
@@ -149,6 +165,7 @@ private:
 	double m_FrameDuration;
 	float m_FrameStrength;
 	int m_Height;
+	EasySamplerKernels::Kind m_Kernels;
 	Method m_Method;
 	double m_StartTime;
 	int m_Width;
@@ -179,21 +196,26 @@ public:
 	void Sample(unsigned char const * data, double time);
 
 protected:
-	virtual void EasySamplerBase::MakeFrame()
+	virtual void MakeFrame() override
 	{
+		Integrator_Flush(this,
+			m_HasLastSample ? m_LastSample : 0, m_LastSampleWeight,
+			m_CurSample, m_CurSampleWeight
+		);
 		PrintFrame();
 		ClearFrame(m_Settings.FrameStrength_get());
 	}
 
-	virtual void EasySamplerBase::SubSample(
+	virtual void SubSample(
 		double timeA,
 		double timeB,
 		double subTimeA,
-		double subTimeB)
+		double subTimeB) override
 	{
-		Integrator_Fn(this,
-			m_HasLastSample ? m_LastSample : 0, m_CurSample,
-			timeA, timeB, subTimeA, subTimeB
+		Integrator_Accumulate(
+			m_HasLastSample, 0 != m_CurSample,
+			timeA, timeB, subTimeA, subTimeB,
+			m_LastSampleWeight, m_CurSampleWeight
 		);
 	}
 
@@ -220,11 +242,14 @@ private:
 	};
 
 	unsigned char const * m_CurSample;
+	double m_CurSampleWeight;
 	EasySamplerSettings m_Settings;
 	Frame * m_Frame;
 	IFramePrinter * m_FramePrinter;
 	bool m_HasLastSample;
+	EasySamplerKernels const * m_Kernels;
 	unsigned char * m_LastSample;
+	double m_LastSampleWeight;
 	int m_Pitch;
 	unsigned char * m_PrintMem;
 
@@ -265,33 +290,41 @@ public:
 	void Sample(float const * data, double time);
 
 protected:
-	virtual void EasySamplerBase::MakeFrame()
+	virtual void MakeFrame() override
 	{
+		Integrator_Flush(this,
+			m_HasLastSample ? m_LastSample : 0, m_LastSampleWeight,
+			m_CurSample, m_CurSampleWeight
+		);
 		PrintFrame();
 		ClearFrame(m_Settings.FrameStrength_get());
 	}
 
-	virtual void EasySamplerBase::SubSample(
+	virtual void SubSample(
 		double timeA,
 		double timeB,
 		double subTimeA,
-		double subTimeB)
+		double subTimeB) override
 	{
-		Integrator_Fn(this,
-			m_HasLastSample ? m_LastSample : 0, m_CurSample,
-			timeA, timeB, subTimeA, subTimeB
+		Integrator_Accumulate(
+			m_HasLastSample, 0 != m_CurSample,
+			timeA, timeB, subTimeA, subTimeB,
+			m_LastSampleWeight, m_CurSampleWeight
 		);
 	}
 
 private:
 	float const * m_CurSample;
+	double m_CurSampleWeight;
 	float * m_FrameData;
 	IFloatFramePrinter * m_FramePrinter;
 	float m_FrameWhitePoint;
+	EasySamplerKernels const * m_Kernels;
 	float * m_PrintMem;
 	EasySamplerSettings m_Settings;
 	bool m_HasLastSample;
 	float * m_LastSample;
+	double m_LastSampleWeight;
 
 	void ClearFrame(float frameStrength);
 
@@ -0,0 +1,577 @@
+#include "stdafx.h"
+
+#include "EasySamplerKernels.h"
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define EASYSAMPLER_TARGET_SSE2
+#define EASYSAMPLER_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define EASYSAMPLER_TARGET_SSE2 __attribute__((target("sse2")))
+#define EASYSAMPLER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Scalar //////////////////////////////////////////////////////////////////////
+
+static void Scalar_Byte_Fn_1(float * frame, unsigned char const * sample, int width, int height, int pitch)
+{
+	int deltaPitch = pitch - width;
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		for (int ix = 0; ix < width; ix++)
+		{
+			*frame = *frame + *sample;
+
+			frame++;
+			sample++;
+		}
+		sample += deltaPitch;
+	}
+}
+
+static void Scalar_Byte_Fn_2(float * frame, unsigned char const * sample, float w, int width, int height, int pitch)
+{
+	int deltaPitch = pitch - width;
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		for (int ix = 0; ix < width; ix++)
+		{
+			*frame = *frame + w * *sample;
+
+			frame++;
+			sample++;
+		}
+		sample += deltaPitch;
+	}
+}
+
+static void Scalar_Byte_Fn_4(float * frame, unsigned char const * sampleA, unsigned char const * sampleB, float w, int width, int height, int pitch)
+{
+	int deltaPitch = pitch - width;
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		for (int ix = 0; ix < width; ix++)
+		{
+			*frame = *frame + w * ((unsigned int)*sampleA + (unsigned int)*sampleB);
+
+			frame++;
+			sampleA++;
+			sampleB++;
+		}
+		sampleA += deltaPitch;
+		sampleB += deltaPitch;
+	}
+}
+
+static void Scalar_Byte_Print(unsigned char * out, float const * frame, float w, int width, int height, int pitch)
+{
+	int deltaPitch = pitch - width;
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		for (int ix = 0; ix < width; ix++)
+		{
+			*out = (unsigned char)(w * *frame);
+
+			frame++;
+			out++;
+		}
+		out += deltaPitch;
+	}
+}
+
+static void Scalar_Float_Fn_1(float * frame, float const * sample, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		frame[i] = frame[i] + sample[i];
+}
+
+static void Scalar_Float_Fn_2(float * frame, float const * sample, float w, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		frame[i] = frame[i] + w * sample[i];
+}
+
+static void Scalar_Float_Fn_4(float * frame, float const * sampleA, float const * sampleB, float w, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		frame[i] = frame[i] + w * (sampleA[i] + sampleB[i]);
+}
+
+static void Scalar_Float_Print(float * out, float const * frame, float w, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		out[i] = w * frame[i];
+}
+
+static void Scalar_Scale(float * frame, float factor, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		frame[i] = factor * frame[i];
+}
+
+// SSE2 ////////////////////////////////////////////////////////////////////////
+
+// The tails (width % 16) are handled by the scalar functions on a 1 row image.
+
+EASYSAMPLER_TARGET_SSE2 static void Sse2_Byte_Fn_1(float * frame, unsigned char const * sample, int width, int height, int pitch)
+{
+	__m128i zero = _mm_setzero_si128();
+	int width16 = width & ~15;
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		for (int ix = 0; ix < width16; ix += 16)
+		{
+			__m128i c = _mm_loadu_si128((__m128i const *)(sample + ix));
+			__m128i lo = _mm_unpacklo_epi8(c, zero);
+			__m128i hi = _mm_unpackhi_epi8(c, zero);
+
+			float * f = frame + ix;
+			_mm_storeu_ps(f + 0, _mm_add_ps(_mm_loadu_ps(f + 0), _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero))));
+			_mm_storeu_ps(f + 4, _mm_add_ps(_mm_loadu_ps(f + 4), _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero))));
+			_mm_storeu_ps(f + 8, _mm_add_ps(_mm_loadu_ps(f + 8), _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero))));
+			_mm_storeu_ps(f + 12, _mm_add_ps(_mm_loadu_ps(f + 12), _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero))));
+		}
+
+		if (width16 < width) Scalar_Byte_Fn_1(frame + width16, sample + width16, width - width16, 1, pitch);
+
+		frame += width;
+		sample += pitch;
+	}
+}
+
+EASYSAMPLER_TARGET_SSE2 static void Sse2_Byte_Fn_2(float * frame, unsigned char const * sample, float w, int width, int height, int pitch)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128 vw = _mm_set1_ps(w);
+	int width16 = width & ~15;
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		for (int ix = 0; ix < width16; ix += 16)
+		{
+			__m128i c = _mm_loadu_si128((__m128i const *)(sample + ix));
+			__m128i lo = _mm_unpacklo_epi8(c, zero);
+			__m128i hi = _mm_unpackhi_epi8(c, zero);
+
+			float * f = frame + ix;
+			_mm_storeu_ps(f + 0, _mm_add_ps(_mm_loadu_ps(f + 0), _mm_mul_ps(vw, _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)))));
+			_mm_storeu_ps(f + 4, _mm_add_ps(_mm_loadu_ps(f + 4), _mm_mul_ps(vw, _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)))));
+			_mm_storeu_ps(f + 8, _mm_add_ps(_mm_loadu_ps(f + 8), _mm_mul_ps(vw, _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)))));
+			_mm_storeu_ps(f + 12, _mm_add_ps(_mm_loadu_ps(f + 12), _mm_mul_ps(vw, _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)))));
+		}
+
+		if (width16 < width) Scalar_Byte_Fn_2(frame + width16, sample + width16, w, width - width16, 1, pitch);
+
+		frame += width;
+		sample += pitch;
+	}
+}
+
+EASYSAMPLER_TARGET_SSE2 static void Sse2_Byte_Fn_4(float * frame, unsigned char const * sampleA, unsigned char const * sampleB, float w, int width, int height, int pitch)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128 vw = _mm_set1_ps(w);
+	int width16 = width & ~15;
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		for (int ix = 0; ix < width16; ix += 16)
+		{
+			__m128i a = _mm_loadu_si128((__m128i const *)(sampleA + ix));
+			__m128i b = _mm_loadu_si128((__m128i const *)(sampleB + ix));
+			__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+			__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+			float * f = frame + ix;
+			_mm_storeu_ps(f + 0, _mm_add_ps(_mm_loadu_ps(f + 0), _mm_mul_ps(vw, _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)))));
+			_mm_storeu_ps(f + 4, _mm_add_ps(_mm_loadu_ps(f + 4), _mm_mul_ps(vw, _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)))));
+			_mm_storeu_ps(f + 8, _mm_add_ps(_mm_loadu_ps(f + 8), _mm_mul_ps(vw, _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)))));
+			_mm_storeu_ps(f + 12, _mm_add_ps(_mm_loadu_ps(f + 12), _mm_mul_ps(vw, _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)))));
+		}
+
+		if (width16 < width) Scalar_Byte_Fn_4(frame + width16, sampleA + width16, sampleB + width16, w, width - width16, 1, pitch);
+
+		frame += width;
+		sampleA += pitch;
+		sampleB += pitch;
+	}
+}
+
+EASYSAMPLER_TARGET_SSE2 static void Sse2_Byte_Print(unsigned char * out, float const * frame, float w, int width, int height, int pitch)
+{
+	// (unsigned char) keeps the low byte of the truncated integer, hence the mask before packing.
+	__m128i mask = _mm_set1_epi32(0xff);
+	__m128 vw = _mm_set1_ps(w);
+	int width16 = width & ~15;
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		for (int ix = 0; ix < width16; ix += 16)
+		{
+			float const * f = frame + ix;
+			__m128i i0 = _mm_and_si128(mask, _mm_cvttps_epi32(_mm_mul_ps(vw, _mm_loadu_ps(f + 0))));
+			__m128i i1 = _mm_and_si128(mask, _mm_cvttps_epi32(_mm_mul_ps(vw, _mm_loadu_ps(f + 4))));
+			__m128i i2 = _mm_and_si128(mask, _mm_cvttps_epi32(_mm_mul_ps(vw, _mm_loadu_ps(f + 8))));
+			__m128i i3 = _mm_and_si128(mask, _mm_cvttps_epi32(_mm_mul_ps(vw, _mm_loadu_ps(f + 12))));
+
+			_mm_storeu_si128((__m128i *)(out + ix), _mm_packus_epi16(_mm_packs_epi32(i0, i1), _mm_packs_epi32(i2, i3)));
+		}
+
+		if (width16 < width) Scalar_Byte_Print(out + width16, frame + width16, w, width - width16, 1, pitch);
+
+		frame += width;
+		out += pitch;
+	}
+}
+
+EASYSAMPLER_TARGET_SSE2 static void Sse2_Float_Fn_1(float * frame, float const * sample, size_t count)
+{
+	size_t count4 = count & ~(size_t)3;
+
+	for (size_t i = 0; i < count4; i += 4)
+		_mm_storeu_ps(frame + i, _mm_add_ps(_mm_loadu_ps(frame + i), _mm_loadu_ps(sample + i)));
+
+	Scalar_Float_Fn_1(frame + count4, sample + count4, count - count4);
+}
+
+EASYSAMPLER_TARGET_SSE2 static void Sse2_Float_Fn_2(float * frame, float const * sample, float w, size_t count)
+{
+	__m128 vw = _mm_set1_ps(w);
+	size_t count4 = count & ~(size_t)3;
+
+	for (size_t i = 0; i < count4; i += 4)
+		_mm_storeu_ps(frame + i, _mm_add_ps(_mm_loadu_ps(frame + i), _mm_mul_ps(vw, _mm_loadu_ps(sample + i))));
+
+	Scalar_Float_Fn_2(frame + count4, sample + count4, w, count - count4);
+}
+
+EASYSAMPLER_TARGET_SSE2 static void Sse2_Float_Fn_4(float * frame, float const * sampleA, float const * sampleB, float w, size_t count)
+{
+	__m128 vw = _mm_set1_ps(w);
+	size_t count4 = count & ~(size_t)3;
+
+	for (size_t i = 0; i < count4; i += 4)
+		_mm_storeu_ps(frame + i, _mm_add_ps(_mm_loadu_ps(frame + i), _mm_mul_ps(vw, _mm_add_ps(_mm_loadu_ps(sampleA + i), _mm_loadu_ps(sampleB + i)))));
+
+	Scalar_Float_Fn_4(frame + count4, sampleA + count4, sampleB + count4, w, count - count4);
+}
+
+EASYSAMPLER_TARGET_SSE2 static void Sse2_Float_Print(float * out, float const * frame, float w, size_t count)
+{
+	__m128 vw = _mm_set1_ps(w);
+	size_t count4 = count & ~(size_t)3;
+
+	for (size_t i = 0; i < count4; i += 4)
+		_mm_storeu_ps(out + i, _mm_mul_ps(vw, _mm_loadu_ps(frame + i)));
+
+	Scalar_Float_Print(out + count4, frame + count4, w, count - count4);
+}
+
+EASYSAMPLER_TARGET_SSE2 static void Sse2_Scale(float * frame, float factor, size_t count)
+{
+	__m128 vf = _mm_set1_ps(factor);
+	size_t count4 = count & ~(size_t)3;
+
+	for (size_t i = 0; i < count4; i += 4)
+		_mm_storeu_ps(frame + i, _mm_mul_ps(vf, _mm_loadu_ps(frame + i)));
+
+	Scalar_Scale(frame + count4, factor, count - count4);
+}
+
+// AVX2 ////////////////////////////////////////////////////////////////////////
+
+// No FMA is used on purpose, it would round differently than the scalar code.
+
+EASYSAMPLER_TARGET_AVX2 static void Avx2_Byte_Fn_1(float * frame, unsigned char const * sample, int width, int height, int pitch)
+{
+	int width16 = width & ~15;
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		for (int ix = 0; ix < width16; ix += 16)
+		{
+			__m128i c = _mm_loadu_si128((__m128i const *)(sample + ix));
+
+			float * f = frame + ix;
+			_mm256_storeu_ps(f + 0, _mm256_add_ps(_mm256_loadu_ps(f + 0), _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(c))));
+			_mm256_storeu_ps(f + 8, _mm256_add_ps(_mm256_loadu_ps(f + 8), _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(c, 8)))));
+		}
+
+		if (width16 < width) Scalar_Byte_Fn_1(frame + width16, sample + width16, width - width16, 1, pitch);
+
+		frame += width;
+		sample += pitch;
+	}
+
+	_mm256_zeroupper();
+}
+
+EASYSAMPLER_TARGET_AVX2 static void Avx2_Byte_Fn_2(float * frame, unsigned char const * sample, float w, int width, int height, int pitch)
+{
+	__m256 vw = _mm256_set1_ps(w);
+	int width16 = width & ~15;
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		for (int ix = 0; ix < width16; ix += 16)
+		{
+			__m128i c = _mm_loadu_si128((__m128i const *)(sample + ix));
+
+			float * f = frame + ix;
+			_mm256_storeu_ps(f + 0, _mm256_add_ps(_mm256_loadu_ps(f + 0), _mm256_mul_ps(vw, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(c)))));
+			_mm256_storeu_ps(f + 8, _mm256_add_ps(_mm256_loadu_ps(f + 8), _mm256_mul_ps(vw, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(c, 8))))));
+		}
+
+		if (width16 < width) Scalar_Byte_Fn_2(frame + width16, sample + width16, w, width - width16, 1, pitch);
+
+		frame += width;
+		sample += pitch;
+	}
+
+	_mm256_zeroupper();
+}
+
+EASYSAMPLER_TARGET_AVX2 static void Avx2_Byte_Fn_4(float * frame, unsigned char const * sampleA, unsigned char const * sampleB, float w, int width, int height, int pitch)
+{
+	__m256 vw = _mm256_set1_ps(w);
+	int width16 = width & ~15;
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		for (int ix = 0; ix < width16; ix += 16)
+		{
+			__m256i ab = _mm256_add_epi16(
+				_mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i const *)(sampleA + ix))),
+				_mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i const *)(sampleB + ix))));
+
+			float * f = frame + ix;
+			_mm256_storeu_ps(f + 0, _mm256_add_ps(_mm256_loadu_ps(f + 0), _mm256_mul_ps(vw, _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(ab))))));
+			_mm256_storeu_ps(f + 8, _mm256_add_ps(_mm256_loadu_ps(f + 8), _mm256_mul_ps(vw, _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(ab, 1))))));
+		}
+
+		if (width16 < width) Scalar_Byte_Fn_4(frame + width16, sampleA + width16, sampleB + width16, w, width - width16, 1, pitch);
+
+		frame += width;
+		sampleA += pitch;
+		sampleB += pitch;
+	}
+
+	_mm256_zeroupper();
+}
+
+EASYSAMPLER_TARGET_AVX2 static void Avx2_Byte_Print(unsigned char * out, float const * frame, float w, int width, int height, int pitch)
+{
+	__m256i mask = _mm256_set1_epi32(0xff);
+	__m256 vw = _mm256_set1_ps(w);
+	int width16 = width & ~15;
+
+	for (int iy = 0; iy < height; iy++)
+	{
+		for (int ix = 0; ix < width16; ix += 16)
+		{
+			float const * f = frame + ix;
+			__m256i i0 = _mm256_and_si256(mask, _mm256_cvttps_epi32(_mm256_mul_ps(vw, _mm256_loadu_ps(f + 0))));
+			__m256i i1 = _mm256_and_si256(mask, _mm256_cvttps_epi32(_mm256_mul_ps(vw, _mm256_loadu_ps(f + 8))));
+
+			// packs work per 128 bit lane, so fix up the order afterwards.
+			__m256i s = _mm256_permute4x64_epi64(_mm256_packs_epi32(i0, i1), 0xd8);
+
+			_mm_storeu_si128((__m128i *)(out + ix), _mm_packus_epi16(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1)));
+		}
+
+		if (width16 < width) Scalar_Byte_Print(out + width16, frame + width16, w, width - width16, 1, pitch);
+
+		frame += width;
+		out += pitch;
+	}
+
+	_mm256_zeroupper();
+}
+
+EASYSAMPLER_TARGET_AVX2 static void Avx2_Float_Fn_1(float * frame, float const * sample, size_t count)
+{
+	size_t count8 = count & ~(size_t)7;
+
+	for (size_t i = 0; i < count8; i += 8)
+		_mm256_storeu_ps(frame + i, _mm256_add_ps(_mm256_loadu_ps(frame + i), _mm256_loadu_ps(sample + i)));
+
+	_mm256_zeroupper();
+
+	Scalar_Float_Fn_1(frame + count8, sample + count8, count - count8);
+}
+
+EASYSAMPLER_TARGET_AVX2 static void Avx2_Float_Fn_2(float * frame, float const * sample, float w, size_t count)
+{
+	__m256 vw = _mm256_set1_ps(w);
+	size_t count8 = count & ~(size_t)7;
+
+	for (size_t i = 0; i < count8; i += 8)
+		_mm256_storeu_ps(frame + i, _mm256_add_ps(_mm256_loadu_ps(frame + i), _mm256_mul_ps(vw, _mm256_loadu_ps(sample + i))));
+
+	_mm256_zeroupper();
+
+	Scalar_Float_Fn_2(frame + count8, sample + count8, w, count - count8);
+}
+
+EASYSAMPLER_TARGET_AVX2 static void Avx2_Float_Fn_4(float * frame, float const * sampleA, float const * sampleB, float w, size_t count)
+{
+	__m256 vw = _mm256_set1_ps(w);
+	size_t count8 = count & ~(size_t)7;
+
+	for (size_t i = 0; i < count8; i += 8)
+		_mm256_storeu_ps(frame + i, _mm256_add_ps(_mm256_loadu_ps(frame + i), _mm256_mul_ps(vw, _mm256_add_ps(_mm256_loadu_ps(sampleA + i), _mm256_loadu_ps(sampleB + i)))));
+
+	_mm256_zeroupper();
+
+	Scalar_Float_Fn_4(frame + count8, sampleA + count8, sampleB + count8, w, count - count8);
+}
+
+EASYSAMPLER_TARGET_AVX2 static void Avx2_Float_Print(float * out, float const * frame, float w, size_t count)
+{
+	__m256 vw = _mm256_set1_ps(w);
+	size_t count8 = count & ~(size_t)7;
+
+	for (size_t i = 0; i < count8; i += 8)
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(vw, _mm256_loadu_ps(frame + i)));
+
+	_mm256_zeroupper();
+
+	Scalar_Float_Print(out + count8, frame + count8, w, count - count8);
+}
+
+EASYSAMPLER_TARGET_AVX2 static void Avx2_Scale(float * frame, float factor, size_t count)
+{
+	__m256 vf = _mm256_set1_ps(factor);
+	size_t count8 = count & ~(size_t)7;
+
+	for (size_t i = 0; i < count8; i += 8)
+		_mm256_storeu_ps(frame + i, _mm256_mul_ps(vf, _mm256_loadu_ps(frame + i)));
+
+	_mm256_zeroupper();
+
+	Scalar_Scale(frame + count8, factor, count - count8);
+}
+
+// EasySamplerKernels //////////////////////////////////////////////////////////
+
+static EasySamplerKernels const g_EasySamplerKernels_Scalar = {
+	EasySamplerKernels::EK_Scalar,
+	Scalar_Byte_Fn_1, Scalar_Byte_Fn_2, Scalar_Byte_Fn_4, Scalar_Byte_Print,
+	Scalar_Float_Fn_1, Scalar_Float_Fn_2, Scalar_Float_Fn_4, Scalar_Float_Print,
+	Scalar_Scale
+};
+
+static EasySamplerKernels const g_EasySamplerKernels_Sse2 = {
+	EasySamplerKernels::EK_Sse2,
+	Sse2_Byte_Fn_1, Sse2_Byte_Fn_2, Sse2_Byte_Fn_4, Sse2_Byte_Print,
+	Sse2_Float_Fn_1, Sse2_Float_Fn_2, Sse2_Float_Fn_4, Sse2_Float_Print,
+	Sse2_Scale
+};
+
+static EasySamplerKernels const g_EasySamplerKernels_Avx2 = {
+	EasySamplerKernels::EK_Avx2,
+	Avx2_Byte_Fn_1, Avx2_Byte_Fn_2, Avx2_Byte_Fn_4, Avx2_Byte_Print,
+	Avx2_Float_Fn_1, Avx2_Float_Fn_2, Avx2_Float_Fn_4, Avx2_Float_Print,
+	Avx2_Scale
+};
+
+static bool CpuHasSse2(void)
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	return 0 != (info[3] & (1 << 26));
+#else
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+	return 0 != (edx & (1 << 26));
+#endif
+}
+
+static bool CpuHasAvx2(void)
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+
+	__cpuid(info, 1);
+	bool osxsave = 0 != (info[2] & (1 << 27));
+	bool avx = 0 != (info[2] & (1 << 28));
+	if (!(osxsave && avx)) return false;
+
+	// The OS has to save the YMM registers:
+	if (6 != (_xgetbv(0) & 6)) return false;
+
+	__cpuidex(info, 7, 0);
+	return 0 != (info[1] & (1 << 5));
+#else
+	__builtin_cpu_init();
+	return 0 != __builtin_cpu_supports("avx2");
+#endif
+}
+
+EasySamplerKernels const * EasySamplerKernels::Get(Kind kind)
+{
+	if (EK_Auto == kind || !IsSupported(kind))
+		kind = GetBestSupported();
+
+	switch (kind)
+	{
+	case EK_Sse2:
+		return &g_EasySamplerKernels_Sse2;
+	case EK_Avx2:
+		return &g_EasySamplerKernels_Avx2;
+	default:
+		return &g_EasySamplerKernels_Scalar;
+	}
+}
+
+EasySamplerKernels::Kind EasySamplerKernels::GetBestSupported(void)
+{
+	static Kind best = CpuHasAvx2() ? EK_Avx2 : (CpuHasSse2() ? EK_Sse2 : EK_Scalar);
+
+	return best;
+}
+
+bool EasySamplerKernels::IsSupported(Kind kind)
+{
+	switch (kind)
+	{
+	case EK_Auto:
+	case EK_Scalar:
+		return true;
+	case EK_Sse2:
+		return EK_Sse2 <= GetBestSupported();
+	case EK_Avx2:
+		return EK_Avx2 <= GetBestSupported();
+	}
+
+	return false;
+}
+
+char const * EasySamplerKernels::GetName(Kind kind)
+{
+	switch (kind)
+	{
+	case EK_Auto:
+		return "auto";
+	case EK_Scalar:
+		return "scalar";
+	case EK_Sse2:
+		return "sse2";
+	case EK_Avx2:
+		return "avx2";
+	}
+
+	return "[n/a]";
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+
+// EasySamplerKernels //////////////////////////////////////////////////////////
+
+/// <summary>
+///   Inner loops of EasyByteSampler and EasyFloatSampler.<br />
+///   All implementations give bit-identical results to the scalar ones,
+///   the vectorized ones only do the same float operations in the same order.
+/// </summary>
+struct EasySamplerKernels
+{
+	enum Kind
+	{
+		/// <summary>Best kind supported by the CPU.</summary>
+		EK_Auto,
+		EK_Scalar,
+		EK_Sse2,
+		EK_Avx2
+	};
+
+	/// <returns>Kernels for kind, EK_Auto or a kind not supported by the CPU is resolved to the best supported kind.</returns>
+	static EasySamplerKernels const * Get(Kind kind);
+
+	static Kind GetBestSupported(void);
+
+	static bool IsSupported(Kind kind);
+
+	static char const * GetName(Kind kind);
+
+	Kind Type;
+
+	/// <summary>frame += sample</summary>
+	/// <param name="frame">width * height floats</param>
+	/// <param name="pitch">bytes of memory to skip for a row in sample</param>
+	void (*Byte_Fn_1)(float * frame, unsigned char const * sample, int width, int height, int pitch);
+
+	/// <summary>frame += w * sample</summary>
+	void (*Byte_Fn_2)(float * frame, unsigned char const * sample, float w, int width, int height, int pitch);
+
+	/// <summary>frame += w * (sampleA + sampleB)</summary>
+	void (*Byte_Fn_4)(float * frame, unsigned char const * sampleA, unsigned char const * sampleB, float w, int width, int height, int pitch);
+
+	/// <summary>out = (unsigned char)(w * frame), the bytes between width and pitch are not touched.</summary>
+	void (*Byte_Print)(unsigned char * out, float const * frame, float w, int width, int height, int pitch);
+
+	/// <summary>frame += sample</summary>
+	void (*Float_Fn_1)(float * frame, float const * sample, size_t count);
+
+	/// <summary>frame += w * sample</summary>
+	void (*Float_Fn_2)(float * frame, float const * sample, float w, size_t count);
+
+	/// <summary>frame += w * (sampleA + sampleB)</summary>
+	void (*Float_Fn_4)(float * frame, float const * sampleA, float const * sampleB, float w, size_t count);
+
+	/// <summary>out = w * frame</summary>
+	void (*Float_Print)(float * out, float const * frame, float w, size_t count);
+
+	/// <summary>frame = factor * frame</summary>
+	void (*Scale)(float * frame, float factor, size_t count);
+};
@@ -0,0 +1,298 @@
+#include "stdafx.h"
+
+#include "PatternScanner.h"
+
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define AFX_PATTERNSCANNER_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace Afx {
+namespace BinUtils {
+
+namespace {
+
+/// <returns>Rough frequency of the byte in x86 code / data, lower means rarer.</returns>
+int ByteCommonness(unsigned char value)
+{
+	switch (value)
+	{
+	case 0x00:
+	case 0xff:
+		return 64;
+	case 0x8b:
+	case 0xcc:
+		return 32;
+	case 0x89:
+	case 0xe8:
+	case 0x83:
+	case 0x24:
+	case 0x04:
+	case 0x08:
+	case 0x0c:
+	case 0x10:
+	case 0xc4:
+	case 0x85:
+	case 0xc0:
+	case 0x90:
+	case 0x01:
+		return 16;
+	case 0x55:
+	case 0xec:
+	case 0x50:
+	case 0x51:
+	case 0x52:
+	case 0x53:
+	case 0x56:
+	case 0x57:
+	case 0x5d:
+	case 0x5e:
+	case 0x5f:
+	case 0xc3:
+	case 0x0f:
+	case 0x8d:
+	case 0x74:
+	case 0x75:
+	case 0x6a:
+	case 0x68:
+	case 0x45:
+	case 0x4d:
+	case 0x44:
+	case 0x33:
+	case 0xeb:
+		return 8;
+	}
+
+	return 1;
+}
+
+unsigned char HexNibble(char value)
+{
+	return (unsigned char)(('0' <= value && value <= '9') ? value - '0' : ('A' <= value && value <= 'Z' ? value - 'A' + '\xa' : value - 'a' + '\xa')) & 0xf;
+}
+
+#ifdef AFX_PATTERNSCANNER_SSE2
+inline unsigned int CountTrailingZeros(unsigned int value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return index;
+#else
+	return (unsigned int)__builtin_ctz(value);
+#endif
+}
+#endif
+
+} // namespace {
+
+// BytePattern /////////////////////////////////////////////////////////////////
+
+BytePattern::BytePattern(char const * hexBytePattern)
+{
+	bool hasHi = false;
+	unsigned char byte = 0;
+	unsigned char mask = 0;
+
+	for (; *hexBytePattern; ++hexBytePattern)
+	{
+		char cur = *hexBytePattern;
+
+		if (' ' == cur)
+			continue;
+
+		bool wild = '?' == cur;
+		unsigned char nibble = wild ? 0 : HexNibble(cur);
+
+		if (!hasHi)
+		{
+			byte = nibble << 4;
+			mask = wild ? 0x00 : 0xf0;
+			hasHi = true;
+		}
+		else
+		{
+			byte |= nibble;
+			if (!wild) mask |= 0x0f;
+
+			m_Bytes.push_back(byte & mask);
+			m_Mask.push_back(mask);
+			hasHi = false;
+		}
+	}
+
+	if (hasHi)
+	{
+		m_Bytes.push_back(byte & mask);
+		m_Mask.push_back(mask);
+	}
+
+	ChooseAnchors();
+}
+
+BytePattern::BytePattern(void const * bytes, size_t size)
+	: m_Bytes((unsigned char const *)bytes, (unsigned char const *)bytes + size)
+	, m_Mask(size, 0xff)
+{
+	ChooseAnchors();
+}
+
+void BytePattern::ChooseAnchors(void)
+{
+	int best1 = 0;
+	int best2 = 0;
+
+	for (size_t i = 0; i < m_Bytes.size(); ++i)
+	{
+		if (0xff != m_Mask[i])
+			continue;
+
+		int commonness = ByteCommonness(m_Bytes[i]);
+
+		if (!m_HasAnchor || commonness < best1)
+		{
+			m_Anchor2 = m_Anchor1;
+			best2 = best1;
+			m_Anchor1 = i;
+			best1 = commonness;
+
+			if (!m_HasAnchor)
+			{
+				m_Anchor2 = i;
+				best2 = 1024;
+				m_HasAnchor = true;
+			}
+		}
+		else if (commonness < best2 || m_Anchor2 == m_Anchor1)
+		{
+			m_Anchor2 = i;
+			best2 = commonness;
+		}
+	}
+}
+
+unsigned char const * BytePattern::Find(unsigned char const * first, unsigned char const * last) const
+{
+	size_t size = m_Bytes.size();
+
+	if (last < first || (size_t)(last - first) < size)
+		return nullptr;
+
+	// Last position a match can start at:
+	unsigned char const * lastStart = last - size;
+
+	unsigned char const * p = first;
+
+	if (!m_HasAnchor)
+	{
+		for (; p <= lastStart; ++p)
+		{
+			if (Matches(p))
+				return p;
+		}
+
+		return nullptr;
+	}
+
+#ifdef AFX_PATTERNSCANNER_SSE2
+	__m128i anchor1 = _mm_set1_epi8((char)m_Bytes[m_Anchor1]);
+	__m128i anchor2 = _mm_set1_epi8((char)m_Bytes[m_Anchor2]);
+
+	// 16 starts at a time, the loads stay below last since the anchors are inside the pattern:
+	for (; 15 <= lastStart - p; p += 16)
+	{
+		__m128i eq1 = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i const *)(p + m_Anchor1)), anchor1);
+		__m128i eq2 = _mm_cmpeq_epi8(_mm_loadu_si128((__m128i const *)(p + m_Anchor2)), anchor2);
+
+		unsigned int candidates = (unsigned int)_mm_movemask_epi8(_mm_and_si128(eq1, eq2));
+
+		while (candidates)
+		{
+			unsigned char const * candidate = p + CountTrailingZeros(candidates);
+
+			if (Matches(candidate))
+				return candidate;
+
+			candidates &= candidates - 1;
+		}
+	}
+#endif
+
+	unsigned char anchor = m_Bytes[m_Anchor1];
+
+	while (p <= lastStart)
+	{
+		unsigned char const * found = (unsigned char const *)memchr(p + m_Anchor1, anchor, lastStart - p + 1);
+
+		if (nullptr == found)
+			break;
+
+		p = found - m_Anchor1;
+
+		if (Matches(p))
+			return p;
+
+		++p;
+	}
+
+	return nullptr;
+}
+
+// PatternScanner //////////////////////////////////////////////////////////////
+
+size_t PatternScanner::Add(char const * hexBytePattern)
+{
+	m_Patterns.emplace_back(hexBytePattern);
+	m_Results.push_back(nullptr);
+
+	return m_Patterns.size() - 1;
+}
+
+size_t PatternScanner::Add(void const * bytes, size_t size)
+{
+	m_Patterns.emplace_back(bytes, size);
+	m_Results.push_back(nullptr);
+
+	return m_Patterns.size() - 1;
+}
+
+void PatternScanner::Scan(unsigned char const * first, unsigned char const * last)
+{
+	const size_t blockSize = 256 * 1024;
+
+	for (size_t i = 0; i < m_Results.size(); ++i)
+	{
+		m_Results[i] = nullptr;
+	}
+
+	size_t patternsLeft = m_Patterns.size();
+
+	for (unsigned char const * block = first; 0 < patternsLeft && block < last; block += (size_t)(last - block) < blockSize ? (size_t)(last - block) : blockSize)
+	{
+		unsigned char const * blockEnd = (size_t)(last - block) < blockSize ? last : block + blockSize;
+
+		for (size_t i = 0; i < m_Patterns.size(); ++i)
+		{
+			if (m_Results[i])
+				continue;
+
+			// Matches starting in this block (they may end in the next one):
+			size_t extra = 0 < m_Patterns[i].GetSize() ? m_Patterns[i].GetSize() - 1 : 0;
+			unsigned char const * searchEnd = (size_t)(last - blockEnd) < extra ? last : blockEnd + extra;
+
+			if (unsigned char const * result = m_Patterns[i].Find(block, searchEnd))
+			{
+				m_Results[i] = result;
+				--patternsLeft;
+			}
+		}
+	}
+}
+
+} // namespace BinUtils {
+} // namespace Afx {
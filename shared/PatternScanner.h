@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <vector>
+
+namespace Afx {
+namespace BinUtils {
+
+/// <summary>
+///   A byte pattern where each nibble can be a wildcard, compiled once so it
+///   can be searched for quickly.<br />
+///   The search looks for two fixed bytes of the pattern (the ones likely
+///   rarest in x86 code) 16 positions at a time with SSE2 and only verifies
+///   the whole pattern at the candidates.
+/// </summary>
+class BytePattern
+{
+public:
+	/// <param name="hexBytePattern">
+	///   A pattern like &quot;00 de ?? be e?&quot;, spaces are ignored,
+	///   a missing last nibble is a wildcard.
+	/// </param>
+	explicit BytePattern(char const * hexBytePattern);
+
+	/// <summary>Pattern matching exactly size bytes.</summary>
+	BytePattern(void const * bytes, size_t size);
+
+	size_t GetSize(void) const
+	{
+		return m_Bytes.size();
+	}
+
+	/// <returns>First match that lies fully in [first, last), or nullptr.</returns>
+	unsigned char const * Find(unsigned char const * first, unsigned char const * last) const;
+
+private:
+	std::vector<unsigned char> m_Bytes;
+	std::vector<unsigned char> m_Mask;
+
+	/// <summary>Offsets of the fixed bytes used for finding candidates, m_HasAnchor is false if there are none.</summary>
+	size_t m_Anchor1 = 0;
+	size_t m_Anchor2 = 0;
+	bool m_HasAnchor = false;
+
+	void ChooseAnchors(void);
+
+	bool Matches(unsigned char const * p) const
+	{
+		for (size_t i = 0; i < m_Bytes.size(); ++i)
+		{
+			if ((p[i] & m_Mask[i]) != m_Bytes[i])
+				return false;
+		}
+
+		return true;
+	}
+};
+
+/// <summary>
+///   Finds the first match of several patterns with a single pass over the
+///   memory: it is processed block by block and all patterns not found yet
+///   are searched in a block while it is in the cache.
+/// </summary>
+class PatternScanner
+{
+public:
+	/// <returns>Index of the pattern.</returns>
+	size_t Add(char const * hexBytePattern);
+
+	/// <returns>Index of the pattern.</returns>
+	size_t Add(void const * bytes, size_t size);
+
+	void Scan(unsigned char const * first, unsigned char const * last);
+
+	/// <returns>Match of the pattern at index from the last Scan, or nullptr.</returns>
+	unsigned char const * GetResult(size_t index) const
+	{
+		return m_Results[index];
+	}
+
+	size_t GetSize(size_t index) const
+	{
+		return m_Patterns[index].GetSize();
+	}
+
+private:
+	std::vector<BytePattern> m_Patterns;
+	std::vector<unsigned char const *> m_Results;
+};
+
+} // namespace BinUtils {
+} // namespace Afx {
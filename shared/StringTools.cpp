@@ -4,6 +4,7 @@
 
 #include <windows.h>
 
+#include <algorithm>
 #include <list>
 
 
@@ -358,3 +359,178 @@ bool StringWildCard1Matched( const char * sz_Mask, const char * sz_Target )
 
 	return true;
 }
+
+StringWildCard1Matcher::StringWildCard1Matcher(const char * sz_Mask)
+: m_Mask(sz_Mask)
+, m_LeadingWildCard(false)
+, m_TrailingWildCard(false)
+{
+	bool firstMatch = true;
+	bool lastWasWildCard = false;
+	std::string curWord;
+	bool hasWord = false;
+
+	for(const char * curMask = sz_Mask; *curMask; curMask++)
+	{
+		if('\\' == *curMask && curMask[1])
+		{
+			curMask++;
+
+			if('*' == *curMask)
+			{
+				if(firstMatch)
+				{
+					firstMatch = false;
+					m_LeadingWildCard = true;
+				}
+
+				if(hasWord)
+				{
+					m_Words.push_back(curWord);
+					hasWord = false;
+				}
+
+				lastWasWildCard = true;
+
+				continue;
+			}
+		}
+
+		firstMatch = false;
+		lastWasWildCard = false;
+		if(!hasWord) curWord.assign("");
+		hasWord = true;
+		curWord.push_back(*curMask);
+	}
+
+	if(hasWord) m_Words.push_back(curWord);
+	m_TrailingWildCard = lastWasWildCard;
+}
+
+bool StringWildCard1Matcher::Matches(const char * sz_Target) const
+{
+	if(m_Words.empty())
+		return (m_LeadingWildCard && m_TrailingWildCard) || 0 == *sz_Target;
+
+	size_t count = m_Words.size();
+
+	for(size_t idx = 0; idx < count; ++idx)
+	{
+		const std::string & word = m_Words[idx];
+
+		const char * matchPos = strstr(sz_Target, word.c_str());
+		
+		if(!matchPos)
+			return false;
+
+		if(0 == idx && !m_LeadingWildCard && 0 < matchPos - sz_Target)
+			return false;
+
+		if(idx + 1 == count && !m_TrailingWildCard)
+		{
+			return StringEndsWith(sz_Target, word.c_str());
+		}
+
+		sz_Target = matchPos + word.size(); // words don't overlap
+	}
+
+	return true;
+}
+
+std::string StringWildCard1Matcher::GetLiteralPrefix(void) const
+{
+	if(m_LeadingWildCard || m_Words.empty())
+		return std::string();
+
+	return m_Words[0];
+}
+
+StringWildCard1Index::StringWildCard1Index()
+{
+	Clear();
+}
+
+void StringWildCard1Index::Clear(void)
+{
+	m_Matchers.clear();
+	m_Nodes.clear();
+	m_Nodes.emplace_back(); // root
+}
+
+void StringWildCard1Index::Add(const StringWildCard1Matcher & matcher)
+{
+	std::string prefix(matcher.GetLiteralPrefix());
+
+	size_t node = 0;
+
+	for(size_t i = 0; i < prefix.size(); ++i)
+	{
+		size_t child = FindChild(node, prefix[i]);
+
+		if(0 == child)
+		{
+			child = m_Nodes.size();
+			m_Nodes.emplace_back();
+			m_Nodes[node].Children.emplace_back(prefix[i], child);
+		}
+
+		node = child;
+	}
+
+	m_Nodes[node].Masks.push_back(m_Matchers.size());
+	m_Matchers.push_back(matcher);
+}
+
+void StringWildCard1Index::FindCandidates(const char * sz_Target, std::vector<size_t> & outIndices) const
+{
+	outIndices.clear();
+
+	size_t node = 0;
+	const char * curTarget = sz_Target;
+
+	while(true)
+	{
+		const std::vector<size_t> & masks = m_Nodes[node].Masks;
+		outIndices.insert(outIndices.end(), masks.begin(), masks.end());
+
+		if(0 == *curTarget)
+			break;
+
+		node = FindChild(node, *curTarget);
+		if(0 == node)
+			break;
+
+		++curTarget;
+	}
+
+	// The candidates of each node are ascending, but not across nodes:
+	std::sort(outIndices.begin(), outIndices.end());
+}
+
+void StringWildCard1Index::FindMatches(const char * sz_Target, std::vector<size_t> & outIndices) const
+{
+	FindCandidates(sz_Target, outIndices);
+
+	size_t count = 0;
+
+	for(size_t i = 0; i < outIndices.size(); ++i)
+	{
+		if(m_Matchers[outIndices[i]].Matches(sz_Target))
+			outIndices[count++] = outIndices[i];
+	}
+
+	outIndices.resize(count);
+}
+
+size_t StringWildCard1Index::FindChild(size_t node, char c) const
+{
+	const std::vector<std::pair<char, size_t>> & children = m_Nodes[node].Children;
+
+	for(size_t i = 0; i < children.size(); ++i)
+	{
+		if(children[i].first == c)
+			return children[i].second;
+	}
+
+	return 0; // the root is never a child
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 bool WideStringToUTF8String(wchar_t const * wideChars, std::string & outAnsiString);
 
@@ -43,3 +44,72 @@ bool StringIsNull(char const * value);
 /// <param name="sz_Target">The target string to match against the mask.</param>
 /// <returns>Returns true if matched, false otherwise.</returns>
 bool StringWildCard1Matched( const char * sz_Mask, const char * sz_Target );
+
+/// <summary>
+/// Same as StringWildCard1Matched, but the mask is only parsed once
+/// (and a mask that is only wildcards matches without looking at the target).
+/// </summary>
+class StringWildCard1Matcher
+{
+public:
+	StringWildCard1Matcher(const char * sz_Mask);
+
+	const std::string & GetMask(void) const
+	{
+		return m_Mask;
+	}
+
+	bool Matches(const char * sz_Target) const;
+
+	/// <returns>The characters every matching target starts with.</returns>
+	std::string GetLiteralPrefix(void) const;
+
+private:
+	std::string m_Mask;
+	std::vector<std::string> m_Words;
+	bool m_LeadingWildCard;
+	bool m_TrailingWildCard;
+};
+
+/// <summary>
+/// Ordered list of masks compiled into a trie over their literal prefixes,
+/// so for a target only the masks with a prefix of the target are tested.
+/// </summary>
+class StringWildCard1Index
+{
+public:
+	StringWildCard1Index();
+
+	void Clear(void);
+
+	/// <summary>Adds a mask, masks are numbered in the order they were added, starting with 0.</summary>
+	void Add(const StringWildCard1Matcher & matcher);
+
+	size_t GetCount(void) const
+	{
+		return m_Matchers.size();
+	}
+
+	/// <summary>Finds the masks whose literal prefix sz_Target starts with, these are the only ones that can match.</summary>
+	/// <param name="outIndices">Is set to the numbers of the candidates, ascending (so the first match has the highest priority).</param>
+	/// <remarks>Use this if the caller tests the candidates in order anyway and can stop at the first match.</remarks>
+	void FindCandidates(const char * sz_Target, std::vector<size_t> & outIndices) const;
+
+	/// <summary>Finds the masks that match sz_Target.</summary>
+	/// <param name="outIndices">Is set to the numbers of the matching masks, ascending.</param>
+	void FindMatches(const char * sz_Target, std::vector<size_t> & outIndices) const;
+
+private:
+	struct CNode
+	{
+		std::vector<std::pair<char, size_t>> Children;
+
+		/// <summary>Masks whose literal prefix ends at this node, ascending.</summary>
+		std::vector<size_t> Masks;
+	};
+
+	std::vector<StringWildCard1Matcher> m_Matchers;
+	std::vector<CNode> m_Nodes;
+
+	size_t FindChild(size_t node, char c) const;
+};
@@ -2,6 +2,8 @@
 
 #include "binutils.h"
 
+#include "PatternScanner.h"
+
 #include <algorithm>
 
 #define PtrFromRva( base, rva ) ( ( ( PBYTE ) base ) + rva )
@@ -11,36 +13,30 @@ namespace BinUtils {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-// TODO: optimize this.
-MemRange FindBytes(MemRange memRange, char const * pattern, DWORD patternSize)
-{
-	DWORD matchDepth = 0;
-	DWORD oldMemRangeStart = memRange.Start;
+namespace {
 
-	if(!pattern)
-		return MemRange(oldMemRangeStart, min(oldMemRangeStart, memRange.End));
+MemRange Find(MemRange memRange, BytePattern const & pattern)
+{
+	if (!memRange.IsEmpty())
+	{
+		if (unsigned char const * result = pattern.Find((unsigned char const *)memRange.Start, (unsigned char const *)memRange.End))
+			return MemRange::FromSize((DWORD)result, (DWORD)pattern.GetSize());
+	}
 
-	if(1 > patternSize)
-		return MemRange(oldMemRangeStart, min(oldMemRangeStart +1, memRange.End));
+	return MemRange(memRange.Start, min(memRange.Start, memRange.End));
+}
 
-	for(;memRange.Start < memRange.End;memRange.Start++)
-	{
-		char cur = *(char const *)memRange.Start;
+} // namespace {
 
-		if(cur == pattern[matchDepth])
-			matchDepth++;
-		else
-		{
-			memRange.Start -= matchDepth;
-			matchDepth = 0;
-			continue;
-		}
+MemRange FindBytes(MemRange memRange, char const * pattern, DWORD patternSize)
+{
+	if(!pattern)
+		return MemRange(memRange.Start, min(memRange.Start, memRange.End));
 
-		if(matchDepth == patternSize)
-			return MemRange(memRange.Start-matchDepth+1, memRange.Start+1);
-	}
+	if(1 > patternSize)
+		return MemRange(memRange.Start, min(memRange.Start +1, memRange.End));
 
-	return MemRange(oldMemRangeStart, min(oldMemRangeStart, memRange.End));
+	return Find(memRange, BytePattern(pattern, patternSize));
 }
 
 MemRange FindCString(MemRange memRange, char const * pattern)
@@ -55,66 +51,37 @@ MemRange FindWCString(MemRange memRange, wchar_t const * pattern)
 
 MemRange FindPatternString(MemRange memRange, char const * hexBytePattern)
 {
-	DWORD matchDepth = 0;
-	DWORD oldMemRangeStart = memRange.Start;
-	size_t patternPos = 0;
-
 	if (!hexBytePattern)
-		return MemRange(oldMemRangeStart, min(oldMemRangeStart, memRange.End));
+		return MemRange(memRange.Start, min(memRange.Start, memRange.End));
 
-	for (; memRange.Start < memRange.End; ++memRange.Start)
-	{
-		char cur = *(char const *)memRange.Start;
-
-		char pat0;
-		do
-		{
-			pat0 = hexBytePattern[patternPos];
-			++patternPos;
-		}
-		while (' ' == pat0);
-
-		char pat1 = 0;
-		if (pat0)
-		{
-			do
-			{
-				pat1 = hexBytePattern[patternPos];
-				++patternPos;
-			} while (' ' == pat1);
-		}
-
-		bool endHi = !pat0;
-		bool endLo = !pat1;
+	BytePattern pattern(hexBytePattern);
 
-		if (endHi)
-			return MemRange(memRange.Start - matchDepth + 1, memRange.Start + 1);
+	if (0 == pattern.GetSize() && !memRange.IsEmpty())
+		return MemRange(memRange.Start + 1, memRange.Start + 1);
 
-		bool wildHi = '?' == pat0 || endHi;
-		bool wildLo = '?' == pat1 || endLo;
+	return Find(memRange, pattern);
+}
 
-		pat0 = ('0' <= pat0 && pat0 <= '9') ? pat0 - '0' : ('A' <= pat0 && pat0 <= 'Z' ? pat0 - 'A' + '\xa' : pat0 - 'a' + '\xa');
-		pat1 = ('0' <= pat1 && pat1 <= '9') ? pat1 - '0' : ('A' <= pat1 && pat1 <= 'Z' ? pat1 - 'A' + '\xa' : pat1 - 'a' + '\xa');
+void FindPatternStrings(MemRange memRange, size_t count, char const * const hexBytePatterns[], MemRange outResults[])
+{
+	PatternScanner scanner;
 
-		char matchval = ((pat0 & 0xf) << 4) | (pat1 & 0xF);
+	for (size_t i = 0; i < count; ++i)
+	{
+		scanner.Add(hexBytePatterns[i]);
+	}
 
-		bool match = (wildHi || ((matchval & 0xf0) == (cur & 0xf0))) && (wildLo || ((matchval & 0xf) == (cur & 0xf)));
+	if (!memRange.IsEmpty())
+		scanner.Scan((unsigned char const *)memRange.Start, (unsigned char const *)memRange.End);
 
-		if (match)
-			++matchDepth;
-		else
-		{
-			memRange.Start -= matchDepth;
-			matchDepth = 0;
-			patternPos = 0;
-			continue;
-		}
+	for (size_t i = 0; i < count; ++i)
+	{
+		unsigned char const * result = memRange.IsEmpty() ? nullptr : scanner.GetResult(i);
 
-		if (endHi || endLo || !hexBytePattern[patternPos])
-			return MemRange(memRange.Start - matchDepth + 1, memRange.Start + 1);
+		outResults[i] = result
+			? MemRange::FromSize((DWORD)result, (DWORD)scanner.GetSize(i))
+			: MemRange(memRange.Start, min(memRange.Start, memRange.End));
 	}
-
-	return MemRange(oldMemRangeStart, min(oldMemRangeStart, memRange.End));
 }
 
 DWORD FindClassVtable(HMODULE hModule, const char * name, DWORD rttiBaseClassArrayOffset, DWORD completeObjectLocatorOffset)
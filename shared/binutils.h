@@ -63,6 +63,14 @@ MemRange FindWCString(MemRange memRange, wchar_t const * pattern);
 /// </param>
 MemRange FindPatternString(MemRange memRange, char const * hexBytePattern);
 
+/// <summary>
+/// Like FindPatternString for count patterns at once, but memRange is only read
+/// once, which is a lot faster than separate calls for independent patterns.
+/// </summary>
+/// <remarks>The memory specified by memRange must be readable.</remarks>
+/// <param name="outResults">Receives count results in the order of hexBytePatterns.</param>
+void FindPatternStrings(MemRange memRange, size_t count, char const * const hexBytePatterns[], MemRange outResults[]);
+
 /// <returns>0 if not found, otherwise address of vtable</returns>
 DWORD FindClassVtable(HMODULE hModule, const char * name, DWORD rttiBaseClassArrayOffset, DWORD completeObjectLocatorOffset);
 
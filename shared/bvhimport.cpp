@@ -3,6 +3,7 @@
 #include "bvhimport.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <windows.h>
 
 
@@ -48,7 +49,8 @@ void BvhImport::CloseMotionFile()
 	if(m_Active)
 	{
 		m_Active = false;
-		fclose(m_File);
+		m_Values.clear();
+		m_Values.shrink_to_fit();
 	}
 }
 
@@ -82,76 +84,35 @@ bool BvhImport::CopyToCampath(double timeOfs, double fov, CamPath & camPath)
 {
 	camPath.Clear();
 
-	if(!m_Active)
+	if(!m_Active || m_Frames <= 0)
 		return true;
 
-	// we start at the first frame
-	if(fseek(m_File,m_MotionFPos,SEEK_SET))
-	{
-		// read error
-		CloseMotionFile();
-		return false;
-	}
+	std::vector<double> times(m_Frames);
+	std::vector<CamPathValue> values;
+	values.reserve(m_Frames);
 
-	for(m_LastFrame = 0; m_LastFrame < m_Frames; ++m_LastFrame)
+	for(int frame = 0; frame < m_Frames; ++frame)
 	{
-		char * pc;
-
-		// read current frame:
-		pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-		if(!pc)
-		{
-			// read error
-			CloseMotionFile();
-			return false;
-		}
-
-		// decode frame:
-		int ichan;
-		char tc = 0;
-		char * pc2;
-		double fff;
-
-		pc = ms_readbuff;
-		for(ichan = 0; ichan < 6; ichan++)
-		{
-			pc2 = strchr(pc,' ');
-			if(!pc2)
-				pc2 = strchr(pc,'\t');
-			if(!pc2)
-				pc2 = pc + strlen(pc);
+		double const * cache = &(m_Values[6 * (size_t)frame]);
 
-			tc = *pc2;
-			*pc2 = 0;
+		double Ty = (-cache[0]);
+		double Tz = (+cache[1]);
+		double Tx = (-cache[2]);
+		double Rz = (-cache[3]);
+		double Rx = (-cache[4]);
+		double Ry = (+cache[5]);
 
-			fff = 0;
-			fff = atof(pc);
-
-			m_Cache[channelcode[ichan]] = fff;
-
-			*pc2 = tc;
-			pc = pc2;
-
-			while(0 != *pc && (' ' == *pc || '\t' == *pc)) pc++;
-		}
-
-		double Ty = (-m_Cache[0]);
-		double Tz = (+m_Cache[1]);
-		double Tx = (-m_Cache[2]);
-		double Rz = (-m_Cache[3]);
-		double Rx = (-m_Cache[4]);
-		double Ry = (+m_Cache[5]);
-
-		camPath.Add(timeOfs +m_LastFrame * m_FrameTime, CamPathValue(Tx, Ty, Tz, Rx, Ry, Rz, fov));
+		times[frame] = timeOfs +frame * m_FrameTime;
+		values.push_back(CamPathValue(Tx, Ty, Tz, Rx, Ry, Rz, fov));
 	}
 
+	camPath.AddMany(&(times[0]), times.size(), &(values[0]));
+
 	return true;
 }
 
 bool BvhImport::GetCamPosition(double fTimeOfs, double outCamdata[6])
 {
-	char * pc;
-
 	if(!m_Active || !outCamdata)
 		return false; // not active
 
@@ -160,126 +121,7 @@ bool BvhImport::GetCamPosition(double fTimeOfs, double outCamdata[6])
 	if(iCurFrame < 0 || iCurFrame >= m_Frames)
 		return false; // out of range
 
-	if(	iCurFrame == m_LastFrame)
-	{
-		// pEngfuncs->Con_DPrintf("Using cached cam motion frame: %i (%f)\n",iCurFrame,fTimeOfs);
-		memcpy(outCamdata,m_Cache,sizeof(m_Cache));
-		return true;
-	}
-
-	if(0 == iCurFrame)
-	{
-		// we start at the first frame
-		if(fseek(m_File,m_MotionFPos,SEEK_SET))
-		{
-			// read error
-			CloseMotionFile();
-			return false;
-		}
-	} else {
-		// seek to frame position:
-		pc = 0;
-		
-		int iSeekFrames;
-		if(0 <= m_LastFrame)
-			iSeekFrames = iCurFrame - m_LastFrame -1;
-		else
-			iSeekFrames = iCurFrame;
-		
-		while(iSeekFrames)
-		{
-			if(0<iSeekFrames)
-			{
-				// seek forward
-				pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-				if(!pc)
-				{
-					// read error
-					CloseMotionFile();
-					return false;
-				}
-				iSeekFrames--;
-			}
-			else
-			{
-				// seek backward
-				char ac=0;
-				bool bReadErr = false;
-				int iReadBreaks = 2;
-
-				while(!bReadErr && 0<iReadBreaks)
-				{
-					if(!bReadErr)
-						bReadErr = 0 != fseek(m_File,-1,SEEK_CUR);
-
-					if(!bReadErr)
-						bReadErr = 1 != fread(&ac,sizeof(char),1,m_File);
-
-					bReadErr = bReadErr || ftell(m_File)<m_MotionFPos;
-
-					if('\n' == ac)
-						iReadBreaks--;
-
-					if(!bReadErr)
-						bReadErr = 0 != fseek(m_File,-1,SEEK_CUR);
-				}
-
-				bReadErr = bReadErr || 0 != fseek(m_File,+1,SEEK_CUR);
-
-				if(bReadErr)
-				{
-					// read error
-					CloseMotionFile();
-					return false;
-				}
-
-				iSeekFrames++;
-			}
-		}
-	}
-
-	// read current frame:
-	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
-	if(!pc)
-	{
-		// read error
-		CloseMotionFile();
-		return false;
-	}
-
-	m_LastFrame = iCurFrame;
-
-	// decode frame:
-	int ichan;
-	char tc = 0;
-	char * pc2;
-	double fff;
-
-	pc = ms_readbuff;
-	for(ichan = 0; ichan < 6; ichan++)
-	{
-		pc2 = strchr(pc,' ');
-		if(!pc2)
-			pc2 = strchr(pc,'\t');
-		if(!pc2)
-			pc2 = pc + strlen(pc);
-
-		tc = *pc2;
-		*pc2 = 0;
-
-		fff = 0;
-		fff = atof(pc);
-
-		m_Cache[channelcode[ichan]] = fff;
-
-		*pc2 = tc;
-		pc = pc2;
-
-		while(0 != *pc && (' ' == *pc || '\t' == *pc)) pc++;
-	}
-
-	// pEngfuncs->Con_DPrintf("Imported cam motion frame: %i (%f)\n",iCurFrame,fTimeOfs);
-	memcpy(outCamdata,m_Cache,sizeof(m_Cache));
+	memcpy(outCamdata, &(m_Values[6 * (size_t)iCurFrame]), 6 * sizeof(double));
 	return true;
 }
 
@@ -294,19 +136,21 @@ bool BvhImport::LoadMotionFile(wchar_t const * fileName)
 	char * pc;
 	char * pc2;
 
+	FILE * file;
+
 	if(m_Active)
 		CloseMotionFile();
 
-	_wfopen_s(&m_File, fileName, L"rb");
+	_wfopen_s(&file, fileName, L"rb");
 
-	if(!m_File)
+	if(!file)
 		return false;
 
 	// check if this could be a valid BVH file:
-	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
+	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),file));
 	if(!pc || strcmp(ms_readbuff,"HIERARCHY\n"))
 	{
-		fclose(m_File);
+		fclose(file);
 		return false;
 	}
 
@@ -314,10 +158,10 @@ bool BvhImport::LoadMotionFile(wchar_t const * fileName)
 	pc2 = 0;
 	while(!pc2)
 	{
-		pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
+		pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),file));
 		if(!pc)
 		{
-			fclose(m_File);
+			fclose(file);
 			return false;
 		}
 
@@ -341,7 +185,7 @@ bool BvhImport::LoadMotionFile(wchar_t const * fileName)
 	{
 		if(channelcode[i]<0)
 		{
-			fclose(m_File);
+			fclose(file);
 			return false;
 		}
 	}
@@ -350,10 +194,10 @@ bool BvhImport::LoadMotionFile(wchar_t const * fileName)
 	pc2 = 0;
 	while(!pc2)
 	{
-		pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
+		pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),file));
 		if(!pc)
 		{
-			fclose(m_File);
+			fclose(file);
 			return false;
 		}
 
@@ -361,37 +205,106 @@ bool BvhImport::LoadMotionFile(wchar_t const * fileName)
 	}
 
 	// read frames:
-	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
+	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),file));
 	if(!pc || strcmp(ms_readbuff,"Frames:") <= 0)
 	{
-		fclose(m_File);
+		fclose(file);
 		return false;
 	}
 	pc += strlen("Frames:");
 	m_Frames = atoi(pc);
 
 	// read frame time:
-	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),m_File));
+	pc = CrLfZ2LfZ(fgets(ms_readbuff,sizeof(ms_readbuff)/sizeof(char),file));
 	if(!pc || strcmp(ms_readbuff,"Frame Time:") <= 0)
 	{
-		fclose(m_File);
+		fclose(file);
 		return false;
 	}
 	pc += strlen("Frame Time:");
 	m_FrameTime = atof(pc);
 	if(m_FrameTime <= 0)
 	{
-		fclose(m_File);
+		fclose(file);
+		return false;
+	}
+
+	// read the motion data at once:
+	long motionFPos = ftell(file);
+	if(motionFPos < 0 || fseek(file, 0, SEEK_END))
+	{
+		fclose(file);
+		return false;
+	}
+	long fileEnd = ftell(file);
+	if(fileEnd < motionFPos || fseek(file, motionFPos, SEEK_SET))
+	{
+		fclose(file);
 		return false;
 	}
 
-	m_MotionFPos = ftell(m_File);
-	m_LastFrame = -1;
+	std::vector<char> motion((size_t)(fileEnd -motionFPos) +1);
+	if((size_t)(fileEnd -motionFPos) != fread(&(motion[0]), sizeof(char), (size_t)(fileEnd -motionFPos), file))
+	{
+		fclose(file);
+		return false;
+	}
+	motion.back() = '\0';
+
+	fclose(file);
+
+	// parse the frames, if the file has less than announced, the ones present are used:
+	m_Values.clear();
+	m_Frames = ParseMotion(&(motion[0]), motion.size() -1);
 	m_Active = true;
 
 	return true;
 }
 
+int BvhImport::ParseMotion(char const * data, size_t size)
+{
+	char const * pc = data;
+	int frames = 0;
+
+	// Don't trust Frames: for the reserve, a frame takes at least 12 chars
+	// ("0 0 0 0 0 0\n"), so this also can't overflow:
+	size_t maxFrames = size / 12 +1;
+	if(0 < m_Frames) m_Values.reserve(6 * ((size_t)m_Frames < maxFrames ? (size_t)m_Frames : maxFrames));
+
+	while(frames < m_Frames && *pc)
+	{
+		double values[6];
+
+		for(int ichan = 0; ichan < 6; ichan++)
+		{
+			double fff = 0;
+
+			while(' ' == *pc || '\t' == *pc) pc++;
+
+			if(*pc && '\r' != *pc && '\n' != *pc)
+			{
+				char * pc2;
+				fff = strtod(pc, &pc2);
+				if(pc2 == pc) fff = 0;
+				pc = pc2;
+
+				// skip rest of token:
+				while(*pc && ' ' != *pc && '\t' != *pc && '\r' != *pc && '\n' != *pc) pc++;
+			}
+
+			values[channelcode[ichan]] = fff;
+		}
+
+		m_Values.insert(m_Values.end(), values, values +6);
+		++frames;
+
+		// skip rest of line:
+		while(*pc && '\n' != *pc) pc++;
+		if('\n' == *pc) pc++;
+	}
+
+	return frames;
+}
 
 char BvhImport::ms_readbuff[1024];
 
@@ -5,6 +5,8 @@
 
 #include "CamPath.h"
 
+#include <vector>
+
 /// <remarks> not thread safe, due to ms_readbuff </remarks>
 class BvhImport
 {
@@ -19,6 +21,7 @@ public:
 
 	// outformat: see BvhChannel_t
 	// return: true on success, false otherwise
+	// This is O(1), the motion is parsed completely by LoadMotionFile.
 	bool GetCamPosition(double fTimeOfs, double outCamdata[6]);
 
 	bool CopyToCampath(double timeOfs, double fov, CamPath & camPath);
@@ -28,13 +31,18 @@ private:
 
 	int channelcode[6];
 	bool m_Active;
-	FILE * m_File;
-	double m_Cache[6];
 	int m_Frames;
-	int m_LastFrame;
 	double m_FrameTime;
-	long m_MotionFPos;
+
+	/// <summary>6 values per frame, in BvhChannel_t order.</summary>
+	std::vector<double> m_Values;
+
 	static char ms_readbuff[1024];
 
 	int DecodeBvhChannel(char * pszRemainder, char * & aoutNewRemainder);
+
+	/// <summary>Parses the frames from the 0 terminated MOTION data (after Frame Time) into m_Values.</summary>
+	/// <param name="size">Length of data, without the terminating 0.</param>
+	/// <returns>Number of frames parsed (at most m_Frames).</returns>
+	int ParseMotion(char const * data, size_t size);
 };
@@ -0,0 +1,247 @@
+#include "stdafx.h"
+
+#include "AfxAddrCache.h"
+
+#include "AfxPeImage.h"
+
+#include <string.h>
+
+namespace {
+
+const char g_Magic[] = "afxAddrCache";
+const uint32_t g_Version = 1;
+
+void WriteString(FILE * file, std::string const & value)
+{
+	fwrite(value.c_str(), value.size() + 1, 1, file);
+}
+
+bool ReadString(FILE * file, std::string & outValue)
+{
+	outValue.clear();
+
+	while (true)
+	{
+		int c = fgetc(file);
+
+		if (EOF == c)
+			return false;
+
+		if (0 == c)
+			return true;
+
+		outValue.push_back((char)c);
+	}
+}
+
+template<typename T> bool Read(FILE * file, T & outValue)
+{
+	return 1 == fread(&outValue, sizeof(outValue), 1, file);
+}
+
+template<typename T> void Write(FILE * file, T const & value)
+{
+	fwrite(&value, sizeof(value), 1, file);
+}
+
+} // namespace {
+
+// CAfxAddrCache ///////////////////////////////////////////////////////////////
+
+CAfxAddrCache::CAfxAddrCache(char const * buildId)
+	: m_BuildId(buildId)
+{
+}
+
+bool CAfxAddrCache::Load(FILE * file)
+{
+	m_Modules.clear();
+	m_Dirty = false;
+
+	std::string magic;
+	uint32_t version;
+	std::string buildId;
+	uint32_t moduleCount;
+
+	if (!(ReadString(file, magic) && 0 == magic.compare(g_Magic)
+		&& Read(file, version) && g_Version == version
+		&& ReadString(file, buildId) && buildId == m_BuildId
+		&& Read(file, moduleCount)))
+		return false;
+
+	for (uint32_t i = 0; i < moduleCount; ++i)
+	{
+		std::string key;
+		CModule entry;
+		uint32_t count;
+
+		if (!(ReadString(file, key) && Read(file, entry.Hash) && Read(file, count) && count <= AfxAddr_Debug_GetCount()))
+		{
+			m_Modules.clear();
+			return false;
+		}
+
+		entry.Addresses.resize(count);
+
+		for (uint32_t j = 0; j < count; ++j)
+		{
+			CAddress & address = entry.Addresses[j];
+			unsigned char relative;
+			uint32_t value;
+			unsigned char spotSize;
+
+			if (!(ReadString(file, address.Name) && Read(file, relative) && Read(file, value) && Read(file, spotSize) && spotSize <= SpotSize))
+			{
+				m_Modules.clear();
+				return false;
+			}
+
+			address.Relative = 0 != relative;
+			address.Value = address.Relative ? (AfxAddr)value : (AfxAddr)(int32_t)value;
+			address.Spot.resize(spotSize);
+
+			if (0 < spotSize && 1 != fread(&address.Spot[0], spotSize, 1, file))
+			{
+				m_Modules.clear();
+				return false;
+			}
+		}
+
+		m_Modules[key] = std::move(entry);
+	}
+
+	return true;
+}
+
+bool CAfxAddrCache::Save(FILE * file)
+{
+	WriteString(file, g_Magic);
+	Write(file, g_Version);
+	WriteString(file, m_BuildId);
+	Write(file, (uint32_t)m_Modules.size());
+
+	for (std::map<std::string, CModule>::const_iterator it = m_Modules.begin(); it != m_Modules.end(); ++it)
+	{
+		WriteString(file, it->first);
+		Write(file, it->second.Hash);
+		Write(file, (uint32_t)it->second.Addresses.size());
+
+		for (std::vector<CAddress>::const_iterator itAddr = it->second.Addresses.begin(); itAddr != it->second.Addresses.end(); ++itAddr)
+		{
+			WriteString(file, itAddr->Name);
+			Write(file, (unsigned char)(itAddr->Relative ? 1 : 0));
+			Write(file, (uint32_t)itAddr->Value);
+			Write(file, (unsigned char)itAddr->Spot.size());
+			if (!itAddr->Spot.empty()) fwrite(&itAddr->Spot[0], itAddr->Spot.size(), 1, file);
+		}
+	}
+
+	if (0 != ferror(file))
+		return false;
+
+	m_Dirty = false;
+	return true;
+}
+
+bool CAfxAddrCache::Resolve(char const * key, AfxAddr module, std::function<bool(void)> const & init)
+{
+	CAfxPeImage image((unsigned char const *)module);
+	uint64_t hash = image.GetValid() ? image.GetHash() : 0;
+
+	if (image.GetValid())
+	{
+		std::map<std::string, CModule>::iterator it = m_Modules.find(key);
+
+		if (it != m_Modules.end() && it->second.Hash == hash && Verify(image, it->second))
+		{
+			for (std::vector<CAddress>::iterator itAddr = it->second.Addresses.begin(); itAddr != it->second.Addresses.end(); ++itAddr)
+			{
+				*AfxAddr_GetByName(itAddr->Name.c_str()) = itAddr->Relative ? module + itAddr->Value : itAddr->Value;
+			}
+
+			++m_Hits;
+			return true;
+		}
+	}
+
+	++m_Misses;
+
+	unsigned int addrCount = AfxAddr_Debug_GetCount();
+	std::vector<AfxAddr> oldValues(addrCount);
+
+	for (unsigned int i = 0; i < addrCount; ++i)
+	{
+		char const * name;
+		AfxAddr_Debug_GetAt(i, oldValues[i], name);
+	}
+
+	bool cacheable = init() && image.GetValid();
+
+	CModule entry;
+	entry.Hash = hash;
+
+	for (unsigned int i = 0; cacheable && i < addrCount; ++i)
+	{
+		AfxAddr value;
+		char const * name;
+		AfxAddr_Debug_GetAt(i, value, name);
+
+		if (value == oldValues[i])
+			continue;
+
+		CAddress address;
+		address.Name = name;
+
+		if (module <= value && value - module < image.GetSizeOfImage())
+		{
+			address.Relative = true;
+			address.Value = value - module;
+
+			image.ReadStable((uint32_t)address.Value, image.GetStableSize((uint32_t)address.Value, SpotSize), address.Spot);
+		}
+		else if (value < 0x10000 || (AfxAddr)0 - value <= 0x10000)
+		{
+			address.Relative = false;
+			address.Value = value;
+		}
+		else
+			cacheable = false; // Points outside the module.
+
+		entry.Addresses.push_back(std::move(address));
+	}
+
+	if (cacheable)
+	{
+		m_Modules[key] = std::move(entry);
+		m_Dirty = true;
+	}
+	else if (0 < m_Modules.erase(key))
+		m_Dirty = true;
+
+	return false;
+}
+
+bool CAfxAddrCache::Verify(CAfxPeImage const & image, CModule const & entry) const
+{
+	std::vector<unsigned char> spot;
+
+	for (std::vector<CAddress>::const_iterator it = entry.Addresses.begin(); it != entry.Addresses.end(); ++it)
+	{
+		if (nullptr == AfxAddr_GetByName(it->Name.c_str()))
+			return false;
+
+		if (it->Relative)
+		{
+			if (image.GetSizeOfImage() <= it->Value
+				|| image.GetStableSize((uint32_t)it->Value, SpotSize) != it->Spot.size())
+				return false;
+
+			image.ReadStable((uint32_t)it->Value, it->Spot.size(), spot);
+
+			if (spot != it->Spot)
+				return false;
+		}
+	}
+
+	return true;
+}
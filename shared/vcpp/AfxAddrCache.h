@@ -0,0 +1,89 @@
+#pragma once
+
+#include "AfxAddr.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+class CAfxPeImage;
+
+/// <summary>
+///   Persistent cache for the addresses (AFXADDR_*) the address
+///   initialization of a module resolves, so the signature scans can be
+///   skipped when the module has not changed.<br />
+///   An entry is keyed by a hash of the module's PE headers (time stamp,
+///   check sum, image size and section layout). On a hit the bytes at each
+///   cached address that lies in a read-only section of the module are
+///   compared with the ones recorded (relocated bytes excluded), any
+///   mismatch falls back to a full scan which replaces the entry.
+/// </summary>
+/// <remarks>
+///   Addresses inside the module are stored relative to its base, small
+///   values (offsets, sizes, -1) as they are. If the initialization sets an
+///   address pointing outside the module, the result is not cached.
+/// </remarks>
+class CAfxAddrCache
+{
+public:
+	/// <param name="buildId">Identifies the signatures used (e.g. build date of the code), entries of a different build are discarded on Load.</param>
+	CAfxAddrCache(char const * buildId);
+
+	/// <summary>Replaces the entries with the ones from file, the file is not closed.</summary>
+	/// <returns>false if the file is not a cache of this build (entries are cleared then).</returns>
+	bool Load(FILE * file);
+
+	bool Save(FILE * file);
+
+	/// <returns>true if the entries changed since Load / Save.</returns>
+	bool GetDirty(void) const
+	{
+		return m_Dirty;
+	}
+
+	/// <summary>Restores the addresses for key from the cache if still valid, otherwise calls init and caches its result.</summary>
+	/// <param name="key">Identifies the module and the variant of the initialization, e.g. &quot;engine.dll/1&quot;.</param>
+	/// <param name="module">Base address of the module's image.</param>
+	/// <param name="init">Resolves the addresses, returns false if the result must not be cached (i.e. something was not found).</param>
+	/// <returns>true if the addresses were restored from the cache.</returns>
+	bool Resolve(char const * key, AfxAddr module, std::function<bool(void)> const & init);
+
+	unsigned int GetHits(void) const
+	{
+		return m_Hits;
+	}
+
+	unsigned int GetMisses(void) const
+	{
+		return m_Misses;
+	}
+
+private:
+	static const size_t SpotSize = 8;
+
+	struct CAddress
+	{
+		std::string Name;
+		bool Relative;
+		AfxAddr Value;
+		std::vector<unsigned char> Spot;
+	};
+
+	struct CModule
+	{
+		uint64_t Hash;
+		std::vector<CAddress> Addresses;
+	};
+
+	std::string m_BuildId;
+	std::map<std::string, CModule> m_Modules;
+	bool m_Dirty = false;
+	unsigned int m_Hits = 0;
+	unsigned int m_Misses = 0;
+
+	bool Verify(CAfxPeImage const & image, CModule const & entry) const;
+};
@@ -0,0 +1,215 @@
+#include "stdafx.h"
+
+#include "AfxPeImage.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+namespace {
+
+// Offsets and values from the PE format specification (winnt.h):
+
+const uint16_t g_DosSignature = 0x5A4D; // MZ
+const size_t g_DosOfsLfanew = 0x3c;
+
+const uint32_t g_NtSignature = 0x00004550; // PE\0\0
+const size_t g_NtOfsFileHeader = 4;
+const size_t g_FileHeaderSize = 20;
+const size_t g_FileOfsNumberOfSections = 2;
+const size_t g_FileOfsSizeOfOptionalHeader = 16;
+
+const uint16_t g_OptMagicPe32Plus = 0x20b;
+const size_t g_OptOfsSizeOfCode = 4;
+const size_t g_OptOfsAddressOfEntryPoint = 16;
+const size_t g_OptOfsSizeOfImage = 56;
+const size_t g_OptOfsSizeOfHeaders = 60;
+const size_t g_OptOfsCheckSum = 64;
+const size_t g_OptOfsNumberOfRvaAndSizes = 92; // +16 for PE32+
+const size_t g_OptOfsDataDirectory = 96; // +16 for PE32+
+const uint32_t g_DirectoryEntryBaseReloc = 5;
+
+const size_t g_SectionSize = 40;
+const size_t g_SectionOfsVirtualSize = 8;
+const size_t g_SectionOfsVirtualAddress = 12;
+const size_t g_SectionOfsCharacteristics = 36;
+const uint32_t g_ScnMemRead = 0x40000000;
+const uint32_t g_ScnMemWrite = 0x80000000;
+
+const size_t g_BaseRelocSize = 8;
+const uint16_t g_RelBasedHigh = 1;
+const uint16_t g_RelBasedLow = 2;
+const uint16_t g_RelBasedHighLow = 3;
+const uint16_t g_RelBasedDir64 = 10;
+
+template<typename T> T Get(unsigned char const * p)
+{
+	T result;
+	memcpy(&result, p, sizeof(result));
+	return result;
+}
+
+uint64_t Fnv1a(uint64_t hash, void const * data, size_t size)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= ((unsigned char const *)data)[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+} // namespace {
+
+// CAfxPeImage /////////////////////////////////////////////////////////////////
+
+CAfxPeImage::CAfxPeImage(unsigned char const * image)
+	: m_Image(image)
+{
+	if (!image || g_DosSignature != Get<uint16_t>(image))
+		return;
+
+	unsigned char const * ntHeaders = image + Get<int32_t>(image + g_DosOfsLfanew);
+	if (g_NtSignature != Get<uint32_t>(ntHeaders))
+		return;
+
+	m_NtHeaders = ntHeaders;
+}
+
+uint32_t CAfxPeImage::GetSizeOfImage(void) const
+{
+	return Get<uint32_t>(GetOptionalHeader() + g_OptOfsSizeOfImage);
+}
+
+uint64_t CAfxPeImage::GetHash(void) const
+{
+	unsigned char const * optionalHeader = GetOptionalHeader();
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	hash = Fnv1a(hash, m_NtHeaders + g_NtOfsFileHeader, g_FileHeaderSize);
+	hash = Fnv1a(hash, optionalHeader + g_OptOfsAddressOfEntryPoint, sizeof(uint32_t));
+	hash = Fnv1a(hash, optionalHeader + g_OptOfsSizeOfCode, sizeof(uint32_t));
+	hash = Fnv1a(hash, optionalHeader + g_OptOfsSizeOfImage, sizeof(uint32_t));
+	hash = Fnv1a(hash, optionalHeader + g_OptOfsCheckSum, sizeof(uint32_t));
+	hash = Fnv1a(hash, GetFirstSection(), GetNumberOfSections() * g_SectionSize);
+
+	return hash;
+}
+
+size_t CAfxPeImage::GetStableSize(uint32_t rva, size_t maxSize) const
+{
+	uint32_t end = 0;
+	uint32_t sizeOfHeaders = Get<uint32_t>(GetOptionalHeader() + g_OptOfsSizeOfHeaders);
+
+	if (rva < sizeOfHeaders)
+	{
+		end = sizeOfHeaders;
+	}
+	else
+	{
+		unsigned char const * section = GetFirstSection();
+		uint16_t numberOfSections = GetNumberOfSections();
+
+		for (uint16_t i = 0; i < numberOfSections; ++i, section += g_SectionSize)
+		{
+			uint32_t virtualAddress = Get<uint32_t>(section + g_SectionOfsVirtualAddress);
+			uint32_t virtualSize = Get<uint32_t>(section + g_SectionOfsVirtualSize);
+
+			if (virtualAddress <= rva && rva < virtualAddress + virtualSize)
+			{
+				if (g_ScnMemRead == (Get<uint32_t>(section + g_SectionOfsCharacteristics) & (g_ScnMemRead | g_ScnMemWrite)))
+					end = virtualAddress + virtualSize;
+				break;
+			}
+		}
+	}
+
+	return rva < end ? std::min((size_t)(end - rva), maxSize) : 0;
+}
+
+void CAfxPeImage::ReadStable(uint32_t rva, size_t size, std::vector<unsigned char> & outBytes) const
+{
+	outBytes.assign(m_Image + rva, m_Image + rva + size);
+
+	uint32_t relocsRva;
+	uint32_t relocsSize;
+
+	if (!GetBaseRelocs(relocsRva, relocsSize))
+		return;
+
+	uint32_t pos = 0;
+
+	while (pos + g_BaseRelocSize <= relocsSize)
+	{
+		unsigned char const * block = m_Image + relocsRva + pos;
+		uint32_t blockRva = Get<uint32_t>(block);
+		uint32_t blockSize = Get<uint32_t>(block + 4);
+
+		if (blockSize < g_BaseRelocSize)
+			break;
+
+		// A relocation (at most 8 bytes) in this block's page can touch the bytes:
+		if (rva < blockRva + 0x1000 + 8 && blockRva < rva + size)
+		{
+			size_t count = (blockSize - g_BaseRelocSize) / sizeof(uint16_t);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				uint16_t entry = Get<uint16_t>(block + g_BaseRelocSize + i * sizeof(uint16_t));
+				uint32_t entryRva = blockRva + (entry & 0xfff);
+				uint32_t entrySize;
+
+				switch (entry >> 12)
+				{
+				case g_RelBasedHigh:
+				case g_RelBasedLow:
+					entrySize = 2;
+					break;
+				case g_RelBasedHighLow:
+					entrySize = 4;
+					break;
+				case g_RelBasedDir64:
+					entrySize = 8;
+					break;
+				default:
+					entrySize = 0;
+					break;
+				}
+
+				for (uint32_t j = std::max(entryRva, rva); j < entryRva + entrySize && j < rva + size; ++j)
+				{
+					outBytes[j - rva] = 0;
+				}
+			}
+		}
+
+		pos += blockSize;
+	}
+}
+
+uint16_t CAfxPeImage::GetNumberOfSections(void) const
+{
+	return Get<uint16_t>(m_NtHeaders + g_NtOfsFileHeader + g_FileOfsNumberOfSections);
+}
+
+unsigned char const * CAfxPeImage::GetFirstSection(void) const
+{
+	return GetOptionalHeader() + Get<uint16_t>(m_NtHeaders + g_NtOfsFileHeader + g_FileOfsSizeOfOptionalHeader);
+}
+
+bool CAfxPeImage::GetBaseRelocs(uint32_t & outRva, uint32_t & outSize) const
+{
+	unsigned char const * optionalHeader = GetOptionalHeader();
+	size_t plus = g_OptMagicPe32Plus == Get<uint16_t>(optionalHeader) ? 16 : 0;
+
+	if (Get<uint32_t>(optionalHeader + g_OptOfsNumberOfRvaAndSizes + plus) <= g_DirectoryEntryBaseReloc)
+		return false;
+
+	unsigned char const * directory = optionalHeader + g_OptOfsDataDirectory + plus + 8 * g_DirectoryEntryBaseReloc;
+
+	outRva = Get<uint32_t>(directory);
+	outSize = Get<uint32_t>(directory + 4);
+
+	return true;
+}
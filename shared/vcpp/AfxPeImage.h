@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+/// <summary>
+///   Read-only view of a PE image mapped by the loader (e.g. a module
+///   handle), giving what CAfxAddrCache needs to tell if a module changed.<br />
+///   The headers are read at their documented offsets instead of through the
+///   Win32 structs, so this doesn't depend on &lt;windows.h&gt; and can be
+///   tested on synthetic images on any platform.
+/// </summary>
+class CAfxPeImage
+{
+public:
+	/// <param name="image">Base address of the mapped image, can be nullptr.</param>
+	explicit CAfxPeImage(unsigned char const * image);
+
+	/// <returns>false if image does not start with DOS and NT headers.</returns>
+	bool GetValid(void) const
+	{
+		return nullptr != m_NtHeaders;
+	}
+
+	uint32_t GetSizeOfImage(void) const;
+
+	/// <summary>Hash of the headers that change when the module is rebuilt: file header (time stamp), entry point, sizes, check sum and section table.</summary>
+	/// <remarks>
+	///   The image contents can't be hashed, since they change with the
+	///   relocation (and ImageBase in the headers can be updated by the loader).
+	/// </remarks>
+	uint64_t GetHash(void) const;
+
+	/// <returns>Number of bytes at rva that are stable (headers or a section that is not writable), at most maxSize.</returns>
+	size_t GetStableSize(uint32_t rva, size_t maxSize) const;
+
+	/// <summary>Copies size bytes at rva, bytes touched by base relocations are zeroed.</summary>
+	void ReadStable(uint32_t rva, size_t size, std::vector<unsigned char> & outBytes) const;
+
+private:
+	unsigned char const * m_Image;
+	unsigned char const * m_NtHeaders = nullptr;
+
+	unsigned char const * GetOptionalHeader(void) const
+	{
+		return m_NtHeaders + 24;
+	}
+
+	uint16_t GetNumberOfSections(void) const;
+
+	unsigned char const * GetFirstSection(void) const;
+
+	/// <returns>false if the image has no base relocation directory.</returns>
+	bool GetBaseRelocs(uint32_t & outRva, uint32_t & outSize) const;
+};
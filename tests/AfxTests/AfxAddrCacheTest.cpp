@@ -0,0 +1,299 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+#include <shared/vcpp/AfxAddrCache.h>
+#include <shared/vcpp/AfxPeImage.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+AFXADDR_DEF(afxTest_func)
+AFXADDR_DEF(afxTest_code)
+AFXADDR_DEF(afxTest_ofs)
+AFXADDR_DEF(afxTest_neg)
+AFXADDR_DEF(afxTest_header)
+AFXADDR_DEF(afxTest_outside)
+
+/// <summary>
+///   A mapped 32 bit PE image: headers, .text at 0x1000 (read / execute),
+///   .data at 0x2000 (read / write) and .reloc at 0x3000 with HIGHLOW
+///   relocations at 0x1102 and 0x1ffe.
+/// </summary>
+class CAfxAddrCacheTestImage
+{
+public:
+	std::vector<unsigned char> Bytes;
+
+	CAfxAddrCacheTestImage(uint32_t timeDateStamp)
+		: Bytes(0x4000, 0)
+	{
+		const size_t nt = 0x40;
+		const size_t optionalHeader = nt + 24;
+		const size_t sections = optionalHeader + 224;
+
+		Set<uint16_t>(0, 0x5A4D);
+		Set<int32_t>(0x3c, (int32_t)nt);
+
+		Set<uint32_t>(nt, 0x00004550);
+		Set<uint16_t>(nt + 4 + 2, 3); // NumberOfSections
+		Set<uint32_t>(nt + 4 + 4, timeDateStamp);
+		Set<uint16_t>(nt + 4 + 16, 224); // SizeOfOptionalHeader
+
+		Set<uint16_t>(optionalHeader, 0x10b);
+		Set<uint32_t>(optionalHeader + 56, 0x4000); // SizeOfImage
+		Set<uint32_t>(optionalHeader + 60, 0x400); // SizeOfHeaders
+		Set<uint32_t>(optionalHeader + 92, 16); // NumberOfRvaAndSizes
+		Set<uint32_t>(optionalHeader + 96 + 8 * 5, 0x3000); // Base relocations
+		Set<uint32_t>(optionalHeader + 96 + 8 * 5 + 4, 8 + 3 * 2);
+
+		SetSection(sections, 0x1000, 0x1000, 0x40000000 | 0x20000000);
+		SetSection(sections + 40, 0x2000, 0x800, 0x40000000 | 0x80000000);
+		SetSection(sections + 80, 0x3000, 0x100, 0x40000000);
+
+		for (size_t i = 0x1000; i < 0x2000; ++i) Bytes[i] = (unsigned char)(i * 7 + 3);
+
+		Set<uint32_t>(0x3000, 0x1000);
+		Set<uint32_t>(0x3004, 8 + 3 * 2);
+		Set<uint16_t>(0x3008, (3 << 12) | 0x102);
+		Set<uint16_t>(0x300a, (3 << 12) | 0xffe);
+		Set<uint16_t>(0x300c, 0); // Padding (IMAGE_REL_BASED_ABSOLUTE).
+	}
+
+	AfxAddr GetBase(void) const
+	{
+		return (AfxAddr)Bytes.data();
+	}
+
+	/// <summary>Applies the relocations like the loader does when the image is not at its preferred base.</summary>
+	void Relocate(uint32_t delta)
+	{
+		Set<uint32_t>(0x1102, Get<uint32_t>(0x1102) + delta);
+		Set<uint32_t>(0x1ffe, Get<uint32_t>(0x1ffe) + delta);
+	}
+
+	template<typename T> T Get(size_t offset) const
+	{
+		T result;
+		memcpy(&result, &Bytes[offset], sizeof(result));
+		return result;
+	}
+
+	template<typename T> void Set(size_t offset, T value)
+	{
+		memcpy(&Bytes[offset], &value, sizeof(value));
+	}
+
+private:
+	void SetSection(size_t offset, uint32_t virtualAddress, uint32_t virtualSize, uint32_t characteristics)
+	{
+		Set<uint32_t>(offset + 8, virtualSize);
+		Set<uint32_t>(offset + 12, virtualAddress);
+		Set<uint32_t>(offset + 36, characteristics);
+	}
+};
+
+static int g_AfxAddrCacheTest_InitCalls;
+
+static bool AfxAddrCacheTest_Init(AfxAddr base, bool okay = true, bool outside = false)
+{
+	++g_AfxAddrCacheTest_InitCalls;
+
+	AFXADDR_SET(afxTest_func, base + 0x1100);
+	AFXADDR_SET(afxTest_code, base + 0x1ffc);
+	AFXADDR_SET(afxTest_ofs, 0x24);
+	AFXADDR_SET(afxTest_neg, (AfxAddr)-1);
+	AFXADDR_SET(afxTest_header, base);
+	if (outside) AFXADDR_SET(afxTest_outside, 0x7fff0000);
+
+	return okay;
+}
+
+static void AfxAddrCacheTest_Clear(void)
+{
+	AFXADDR_SET(afxTest_func, 0);
+	AFXADDR_SET(afxTest_code, 0);
+	AFXADDR_SET(afxTest_ofs, 0);
+	AFXADDR_SET(afxTest_neg, 0);
+	AFXADDR_SET(afxTest_header, 0);
+	AFXADDR_SET(afxTest_outside, 0);
+}
+
+static bool AfxAddrCacheTest_Check(AfxAddr base)
+{
+	return AFXADDR_GET(afxTest_func) == base + 0x1100
+		&& AFXADDR_GET(afxTest_code) == base + 0x1ffc
+		&& AFXADDR_GET(afxTest_ofs) == 0x24
+		&& AFXADDR_GET(afxTest_neg) == (AfxAddr)-1
+		&& AFXADDR_GET(afxTest_header) == base;
+}
+
+/// <returns>true if the addresses were restored from the cache.</returns>
+static bool AfxAddrCacheTest_Resolve(CAfxAddrCache & cache, char const * key, CAfxAddrCacheTestImage const & image, bool okay = true, bool outside = false)
+{
+	AfxAddr base = image.GetBase();
+
+	AfxAddrCacheTest_Clear();
+	bool result = cache.Resolve(key, base, [base, okay, outside]() { return AfxAddrCacheTest_Init(base, okay, outside); });
+
+	if (!AfxAddrCacheTest_Check(base))
+		return false;
+
+	return result;
+}
+
+static std::vector<char> AfxAddrCacheTest_Save(CAfxAddrCache & cache)
+{
+	std::vector<char> result;
+
+	FILE * file = tmpfile();
+	if (!file)
+		return result;
+
+	if (cache.Save(file))
+	{
+		result.resize((size_t)ftell(file));
+		rewind(file);
+		if (!result.empty() && 1 != fread(result.data(), result.size(), 1, file)) result.clear();
+	}
+
+	fclose(file);
+	return result;
+}
+
+static bool AfxAddrCacheTest_Load(CAfxAddrCache & cache, std::vector<char> const & data, size_t size)
+{
+	FILE * file = tmpfile();
+	if (!file)
+		return false;
+
+	if (0 < size) fwrite(data.data(), size, 1, file);
+	rewind(file);
+	bool result = cache.Load(file);
+	fclose(file);
+
+	return result;
+}
+
+AFX_TEST(AfxPeImage_StableBytes)
+{
+	CAfxAddrCacheTestImage image(1);
+	CAfxPeImage peImage(image.Bytes.data());
+
+	AFX_CHECK(peImage.GetValid());
+	AFX_CHECK(0x4000 == peImage.GetSizeOfImage());
+
+	// Headers and read-only sections are stable up to their end, writable ones not at all:
+	AFX_CHECK(8 == peImage.GetStableSize(0x10, 8));
+	AFX_CHECK(8 == peImage.GetStableSize(0x1100, 8));
+	AFX_CHECK(4 == peImage.GetStableSize(0x1ffc, 8));
+	AFX_CHECK(0 == peImage.GetStableSize(0x2004, 8));
+	AFX_CHECK(0 == peImage.GetStableSize(0x2900, 8));
+
+	// Relocated bytes are zeroed, also the parts of relocations that start before the range:
+	std::vector<unsigned char> bytes;
+	peImage.ReadStable(0x1100, 8, bytes);
+	AFX_CHECK(8 == bytes.size());
+	for (size_t i = 0; i < bytes.size(); ++i) AFX_CHECK((2 <= i && i < 6 ? 0 : image.Bytes[0x1100 + i]) == bytes[i]);
+
+	peImage.ReadStable(0x1100 + 4, 4, bytes);
+	AFX_CHECK(0 == bytes[0] && 0 == bytes[1] && image.Bytes[0x1106] == bytes[2]);
+
+	// The hash depends on the headers only:
+	CAfxAddrCacheTestImage relocated(1);
+	relocated.Relocate(0x10000);
+	relocated.Bytes[0x2004] ^= 0xff;
+	AFX_CHECK(peImage.GetHash() == CAfxPeImage(relocated.Bytes.data()).GetHash());
+	AFX_CHECK(peImage.GetHash() != CAfxPeImage(CAfxAddrCacheTestImage(2).Bytes.data()).GetHash());
+
+	std::vector<unsigned char> junk(0x100, 0);
+	AFX_CHECK(!CAfxPeImage(junk.data()).GetValid());
+	AFX_CHECK(!CAfxPeImage(nullptr).GetValid());
+
+	return true;
+}
+
+AFX_TEST(AfxAddrCache_HitAfterReload)
+{
+	CAfxAddrCacheTestImage image(1);
+	CAfxAddrCache cache("build1");
+
+	g_AfxAddrCacheTest_InitCalls = 0;
+	AFX_CHECK(!AfxAddrCacheTest_Resolve(cache, "test.dll/1", image));
+	AFX_CHECK(1 == g_AfxAddrCacheTest_InitCalls);
+	AFX_CHECK(cache.GetDirty());
+
+	std::vector<char> data = AfxAddrCacheTest_Save(cache);
+	AFX_CHECK(!data.empty());
+	AFX_CHECK(!cache.GetDirty());
+
+	CAfxAddrCache loaded("build1");
+	AFX_CHECK(AfxAddrCacheTest_Load(loaded, data, data.size()));
+	AFX_CHECK(AfxAddrCacheTest_Resolve(loaded, "test.dll/1", image));
+	AFX_CHECK(1 == g_AfxAddrCacheTest_InitCalls);
+
+	// Other key:
+	AFX_CHECK(!AfxAddrCacheTest_Resolve(loaded, "test.dll/2", image));
+	AFX_CHECK(2 == g_AfxAddrCacheTest_InitCalls);
+
+	// Same module loaded at another base, the addresses are rebased:
+	CAfxAddrCacheTestImage relocated(1);
+	relocated.Relocate((uint32_t)(relocated.GetBase() - image.GetBase()));
+	AFX_CHECK(AfxAddrCacheTest_Resolve(loaded, "test.dll/1", relocated));
+	AFX_CHECK(2 == g_AfxAddrCacheTest_InitCalls);
+
+	// Other build:
+	CAfxAddrCache otherBuild("build2");
+	AFX_CHECK(!AfxAddrCacheTest_Load(otherBuild, data, data.size()));
+	AFX_CHECK(!AfxAddrCacheTest_Resolve(otherBuild, "test.dll/1", image));
+
+	// Truncated files are rejected:
+	for (size_t size = 0; size < data.size(); ++size)
+	{
+		CAfxAddrCache truncated("build1");
+		AFX_CHECK(!AfxAddrCacheTest_Load(truncated, data, size));
+	}
+
+	return true;
+}
+
+AFX_TEST(AfxAddrCache_Invalidation)
+{
+	CAfxAddrCacheTestImage image(1);
+	CAfxAddrCache cache("build1");
+
+	g_AfxAddrCacheTest_InitCalls = 0;
+	AFX_CHECK(!AfxAddrCacheTest_Resolve(cache, "test.dll", image));
+	AFX_CHECK(AfxAddrCacheTest_Resolve(cache, "test.dll", image));
+
+	// Writable data changing doesn't matter, code changing does:
+	image.Bytes[0x2004] ^= 0xff;
+	AFX_CHECK(AfxAddrCacheTest_Resolve(cache, "test.dll", image));
+	image.Bytes[0x1101] ^= 0xff;
+	AFX_CHECK(!AfxAddrCacheTest_Resolve(cache, "test.dll", image));
+	AFX_CHECK(AfxAddrCacheTest_Resolve(cache, "test.dll", image));
+	AFX_CHECK(2 == g_AfxAddrCacheTest_InitCalls);
+
+	// Headers changing:
+	CAfxAddrCacheTestImage rebuilt(2);
+	AFX_CHECK(!AfxAddrCacheTest_Resolve(cache, "test.dll", rebuilt));
+	AFX_CHECK(AfxAddrCacheTest_Resolve(cache, "test.dll", rebuilt));
+	AFX_CHECK(3 == g_AfxAddrCacheTest_InitCalls);
+
+	// Failed initialization is not cached:
+	AFX_CHECK(!AfxAddrCacheTest_Resolve(cache, "failed.dll", image, false));
+	AFX_CHECK(!AfxAddrCacheTest_Resolve(cache, "failed.dll", image));
+	AFX_CHECK(AfxAddrCacheTest_Resolve(cache, "failed.dll", image, false));
+	AFX_CHECK(5 == g_AfxAddrCacheTest_InitCalls);
+
+	// Address outside the module is not cached:
+	AFX_CHECK(!AfxAddrCacheTest_Resolve(cache, "outside.dll", image, true, true));
+	AFX_CHECK(!AfxAddrCacheTest_Resolve(cache, "outside.dll", image, true, true));
+	AFX_CHECK(7 == g_AfxAddrCacheTest_InitCalls);
+
+	AFX_CHECK(5 == cache.GetHits());
+	AFX_CHECK(7 == cache.GetMisses());
+
+	return true;
+}
@@ -0,0 +1,229 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+#include <shared/AfxCaptureStage.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+// Build with -fsanitize=thread to also check these for data races (see main.cpp).
+
+/// <summary>Three stages chained like CAfxCapturePipeline chains convert, sample and output.</summary>
+class CStageChain
+{
+public:
+	CAfxCaptureStage Convert;
+	CAfxCaptureStage Sample;
+	CAfxCaptureStage Output;
+
+	CStageChain(size_t maxQueueDepth)
+		: Convert("convert", 2, maxQueueDepth)
+		, Sample("sample", 2, maxQueueDepth)
+		, Output("output", 4, maxQueueDepth)
+	{
+	}
+
+	void Wait(void)
+	{
+		Convert.Wait();
+		Sample.Wait();
+		Output.Wait();
+	}
+};
+
+/// <summary>Per stream state, only touched by the jobs of the stream's queues.</summary>
+struct CStreamState
+{
+	CAfxCaptureStage::CQueue * ConvertQueue;
+	CAfxCaptureStage::CQueue * SampleQueue;
+	CAfxCaptureStage::CQueue * OutputQueue;
+
+	// Not atomic on purpose, the queues must serialize the jobs of a stream:
+	int Converted = 0;
+	int Sampled = 0;
+	std::vector<int> Output;
+	bool OutOfOrder = false;
+};
+
+AFX_TEST(AfxCaptureStage_StreamsStayInOrder)
+{
+	const int streams = 8;
+	const int frames = 500;
+
+	CStageChain chain(3);
+	std::vector<CStreamState> states(streams);
+
+	for (int s = 0; s < streams; ++s)
+	{
+		states[s].ConvertQueue = chain.Convert.CreateQueue();
+		states[s].SampleQueue = chain.Sample.CreateQueue();
+		states[s].OutputQueue = chain.Output.CreateQueue();
+	}
+
+	for (int f = 0; f < frames; ++f)
+	{
+		for (int s = 0; s < streams; ++s)
+		{
+			CStreamState * state = &states[s];
+
+			chain.Convert.Queue(state->ConvertQueue, [&chain, state, f]() {
+				if (state->Converted++ != f) state->OutOfOrder = true;
+
+				chain.Sample.Queue(state->SampleQueue, [&chain, state, f]() {
+					if (state->Sampled++ != f) state->OutOfOrder = true;
+
+					chain.Output.Queue(state->OutputQueue, [state, f]() {
+						state->Output.push_back(f);
+						if (0 == f % 50) std::this_thread::sleep_for(std::chrono::microseconds(200)); // let the queues fill up
+					});
+				});
+			});
+		}
+	}
+
+	// Queues are deleted with jobs still pending, like when a recording ends:
+	for (int s = 0; s < streams; ++s)
+		chain.Convert.DeleteQueue(states[s].ConvertQueue);
+
+	chain.Wait();
+
+	for (int s = 0; s < streams; ++s)
+	{
+		chain.Sample.DeleteQueue(states[s].SampleQueue);
+		chain.Output.DeleteQueue(states[s].OutputQueue);
+	}
+
+	for (int s = 0; s < streams; ++s)
+	{
+		AFX_CHECK(!states[s].OutOfOrder);
+		AFX_CHECK(frames == (int)states[s].Output.size());
+
+		for (int f = 0; f < frames; ++f) AFX_CHECK(f == states[s].Output[f]);
+	}
+
+	AFX_CHECK(0 == chain.Output.GetQueued());
+	AFX_CHECK((unsigned long long)streams * frames == chain.Convert.GetDone());
+	AFX_CHECK((unsigned long long)streams * frames == chain.Output.GetDone());
+
+	return true;
+}
+
+AFX_TEST(AfxCaptureStage_QueuesRunInParallel)
+{
+	CAfxCaptureStage stage("test", 2, 4);
+
+	CAfxCaptureStage::CQueue * queueA = stage.CreateQueue();
+	CAfxCaptureStage::CQueue * queueB = stage.CreateQueue();
+
+	std::mutex mutex;
+	int running = 0;
+	int maxRunning = 0;
+
+	auto job = [&mutex, &running, &maxRunning]() {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			++running;
+			if (maxRunning < running) maxRunning = running;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			--running;
+		}
+	};
+
+	for (int i = 0; i < 4; ++i)
+	{
+		stage.Queue(queueA, job);
+		stage.Queue(queueB, job);
+	}
+
+	stage.Wait();
+
+	stage.DeleteQueue(queueA);
+	stage.DeleteQueue(queueB);
+
+	// Jobs of one queue never overlap, jobs of two queues do:
+	AFX_CHECK(2 == maxRunning);
+
+	return true;
+}
+
+AFX_TEST(AfxCaptureStage_FullQueueBlocks)
+{
+	const size_t maxQueueDepth = 2;
+
+	CAfxCaptureStage stage("test", 1, maxQueueDepth);
+	CAfxCaptureStage::CQueue * queue = stage.CreateQueue();
+
+	std::atomic_int started(0);
+	std::atomic_bool release(false);
+
+	auto job = [&started, &release]() {
+		++started;
+		while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	};
+
+	stage.Queue(queue, job); // runs and blocks the worker
+
+	while (0 == started) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	for (size_t i = 0; i < maxQueueDepth; ++i) stage.Queue(queue, job); // waiting
+
+	std::thread releaser([&release]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		release = true;
+	});
+
+	double t0 = AfxTest_Seconds();
+	stage.Queue(queue, job); // has to wait for the first job to finish
+	double t1 = AfxTest_Seconds();
+
+	releaser.join();
+	stage.Wait();
+	stage.DeleteQueue(queue);
+
+	unsigned long long stallCount;
+	double stallSeconds;
+	stage.GetStalls(stallCount, stallSeconds);
+
+	AFX_CHECK(0.03 < t1 - t0);
+	AFX_CHECK(1 == stallCount);
+	AFX_CHECK(0.03 < stallSeconds);
+	AFX_CHECK(maxQueueDepth + 1 == stage.GetMaxQueued());
+	AFX_CHECK(4 == stage.GetDone());
+
+	stage.ResetStats();
+	AFX_CHECK(0 == stage.GetDone());
+	AFX_CHECK(0 == stage.GetMaxQueued());
+
+	return true;
+}
+
+AFX_TEST(AfxCaptureStage_RestartsAfterShutdown)
+{
+	CAfxCaptureStage stage("test", 3, 2);
+	CAfxCaptureStage::CQueue * queue = stage.CreateQueue();
+
+	std::atomic_int count(0);
+
+	for (int round = 0; round < 3; ++round)
+	{
+		for (int i = 0; i < 10; ++i) stage.Queue(queue, [&count]() { ++count; });
+
+		stage.Shutdown(); // waits for the jobs
+
+		AFX_CHECK(10 * (round + 1) == count);
+	}
+
+	stage.DeleteQueue(queue);
+
+	return true;
+}
@@ -0,0 +1,235 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+#include <shared/AfxFrameWriter.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+/// <summary>Blocks writers until opened, to get the writer into a known state.</summary>
+class CGate
+{
+public:
+	void Wait(void)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Condition.wait(lock, [this]() { return m_Open; });
+	}
+
+	void Open(void)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Open = true;
+		}
+		m_Condition.notify_all();
+	}
+
+private:
+	std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	bool m_Open = false;
+};
+
+AFX_TEST(AfxFrameWriter_WritesInOrder)
+{
+	std::vector<int> written;
+
+	{
+		CAfxFrameWriter writer(4, 1, CAfxFrameWriter::Policy_Block);
+
+		for (int i = 0; i < 200; ++i)
+		{
+			CAfxFrameWriter::CFrame * frame = writer.AquireFrame(1000 + i);
+			AFX_CHECK(nullptr != frame);
+			AFX_CHECK(1000 + (size_t)i <= frame->Bytes);
+
+			memset(frame->Data, i & 0xff, 1000 + i);
+
+			frame->Write = [i, &written](CAfxFrameWriter::CFrame const & frame) {
+				for (size_t j = 0; j < 1000 + (size_t)i; ++j)
+					if (frame.Data[j] != (unsigned char)(i & 0xff)) return false;
+
+				written.push_back(i); // Only one writer thread.
+				return true;
+			};
+
+			writer.Submit(frame);
+		}
+
+		writer.Flush();
+
+		AFX_CHECK(200 == writer.GetWrittenCount());
+		AFX_CHECK(0 == writer.GetFailedCount());
+		AFX_CHECK(0 == writer.GetDroppedCount());
+		AFX_CHECK(writer.GetMaxQueued() <= 4);
+	}
+
+	AFX_CHECK(200 == written.size());
+
+	for (int i = 0; i < 200; ++i) AFX_CHECK(i == written[i]);
+
+	return true;
+}
+
+AFX_TEST(AfxFrameWriter_ManyThreads)
+{
+	std::mutex mutex;
+	std::vector<bool> written(500, false);
+
+	CAfxFrameWriter writer(8, 4, CAfxFrameWriter::Policy_Block);
+
+	for (int i = 0; i < 500; ++i)
+	{
+		CAfxFrameWriter::CFrame * frame = writer.AquireFrame(64);
+		AFX_CHECK(nullptr != frame);
+
+		memcpy(frame->Data, &i, sizeof(i));
+
+		frame->Write = [i, &mutex, &written](CAfxFrameWriter::CFrame const & frame) {
+			int value;
+			memcpy(&value, frame.Data, sizeof(value));
+
+			std::unique_lock<std::mutex> lock(mutex);
+			if (value != i || written[i]) return false;
+			written[i] = true;
+			return true;
+		};
+
+		writer.Submit(frame);
+	}
+
+	writer.Flush();
+
+	AFX_CHECK(500 == writer.GetWrittenCount());
+	AFX_CHECK(0 == writer.GetFailedCount());
+
+	for (int i = 0; i < 500; ++i) AFX_CHECK(written[i]);
+
+	return true;
+}
+
+AFX_TEST(AfxFrameWriter_PolicyDrop)
+{
+	CGate gate;
+	CAfxFrameWriter writer(2, 1, CAfxFrameWriter::Policy_Drop);
+
+	for (int i = 0; i < 2; ++i)
+	{
+		CAfxFrameWriter::CFrame * frame = writer.AquireFrame(16);
+		AFX_CHECK(nullptr != frame);
+		frame->Write = [&gate](CAfxFrameWriter::CFrame const &) { gate.Wait(); return true; };
+		writer.Submit(frame);
+	}
+
+	// Both buffers are in use now:
+	AFX_CHECK(nullptr == writer.AquireFrame(16));
+	AFX_CHECK(nullptr == writer.AquireFrame(16));
+	AFX_CHECK(2 == writer.GetDroppedCount());
+
+	gate.Open();
+	writer.Flush();
+
+	AFX_CHECK(2 == writer.GetWrittenCount());
+
+	CAfxFrameWriter::CFrame * frame = writer.AquireFrame(16);
+	AFX_CHECK(nullptr != frame);
+	writer.Discard(frame);
+
+	return true;
+}
+
+AFX_TEST(AfxFrameWriter_PolicyBlock)
+{
+	CGate gate;
+	CAfxFrameWriter writer(1, 1, CAfxFrameWriter::Policy_Block);
+
+	CAfxFrameWriter::CFrame * frame = writer.AquireFrame(16);
+	AFX_CHECK(nullptr != frame);
+	frame->Write = [&gate](CAfxFrameWriter::CFrame const &) { gate.Wait(); return false; };
+	writer.Submit(frame);
+
+	std::thread opener([&gate]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		gate.Open();
+	});
+
+	// Has to wait for the only buffer to be written:
+	double t0 = AfxTest_Seconds();
+	CAfxFrameWriter::CFrame * next = writer.AquireFrame(32);
+	double t1 = AfxTest_Seconds();
+
+	opener.join();
+
+	AFX_CHECK(nullptr != next);
+	AFX_CHECK(next == frame); // recycled
+	AFX_CHECK(32 <= next->Bytes);
+	AFX_CHECK(0.03 < t1 - t0);
+	AFX_CHECK(1 == writer.GetFailedCount());
+	AFX_CHECK(0 == writer.GetDroppedCount());
+
+	writer.Discard(next);
+	writer.Flush();
+
+	AFX_CHECK(0 == writer.GetWrittenCount());
+
+	return true;
+}
+
+AFX_BENCHMARK(AfxFrameWriter)
+{
+	// Simulates a disk that takes 4 ms per 1080p frame, the game thread only
+	// pays for the copy as long as the writers keep up.
+
+	const size_t bytes = 1920 * 1080 * 3;
+	const int frames = 100;
+	std::vector<unsigned char> capture(bytes, 0x80);
+	std::vector<unsigned char> copy(bytes);
+
+	auto write = [](CAfxFrameWriter::CFrame const &) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(4));
+		return true;
+	};
+
+	{
+		double t0 = AfxTest_Seconds();
+		for (int i = 0; i < frames; ++i)
+		{
+			memcpy(copy.data(), capture.data(), bytes);
+			std::this_thread::sleep_for(std::chrono::milliseconds(4));
+		}
+		double t1 = AfxTest_Seconds();
+
+		printf("synchronous:         %7.3f ms per frame\n", 1000.0 * (t1 - t0) / frames);
+	}
+
+	static const size_t threadCounts[] = { 1, 2, 4 };
+
+	for (size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t)
+	{
+		CAfxFrameWriter writer(8, threadCounts[t], CAfxFrameWriter::Policy_Block);
+
+		double t0 = AfxTest_Seconds();
+		for (int i = 0; i < frames; ++i)
+		{
+			CAfxFrameWriter::CFrame * frame = writer.AquireFrame(bytes);
+			AFX_CHECK(nullptr != frame);
+			memcpy(frame->Data, capture.data(), bytes);
+			frame->Write = write;
+			writer.Submit(frame);
+		}
+		double t1 = AfxTest_Seconds();
+		writer.Flush();
+		double t2 = AfxTest_Seconds();
+
+		printf("%i writer thread(s): %7.3f ms per frame (%7.3f ms including flush)\n", (int)threadCounts[t], 1000.0 * (t1 - t0) / frames, 1000.0 * (t2 - t0) / frames);
+	}
+
+	return true;
+}
@@ -0,0 +1,428 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+#include <shared/AfxGameRecord.h>
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#define AFX_GAME_RECORD_TEST_FILE "AfxTests_GameRecord.agr"
+#define AFX_GAME_RECORD_TEST_FILE_6 "AfxTests_GameRecord6.agr"
+#define AFX_GAME_RECORD_TEST_FILE_4 "AfxTests_GameRecord4.agr"
+
+static bool AfxGameRecordTest_ReadFile(char const * fileName, std::vector<char> & outData)
+{
+	FILE * file = fopen(fileName, "rb");
+	if (!file) return false;
+
+	fseek(file, 0, SEEK_END);
+	outData.resize((size_t)ftell(file));
+	fseek(file, 0, SEEK_SET);
+
+	bool ok = outData.empty() || 1 == fread(&outData[0], outData.size(), 1, file);
+
+	fclose(file);
+
+	return ok;
+}
+
+/// <summary>
+///   Records frames the way CClientTools and its game specific subclasses do:
+///   entity states with dictionary strings, deleted entities, hidden marks
+///   and the camera.
+/// </summary>
+static void AfxGameRecordTest_RecordFrame(CAfxGameRecording & recording, int f)
+{
+	CAfxGameRecordWriter & writer = recording.GetWriter();
+
+	recording.BeginFrame(0.01f * f);
+
+	for (int e = 0; e < 20; ++e)
+	{
+		if (0 == (e + f) % 13)
+		{
+			writer.WriteDictionary("deleted");
+			writer.Write(e);
+			writer.DeleteDelta(e);
+			continue;
+		}
+
+		writer.WriteDictionary("entity_state");
+		writer.Write(e);
+		writer.BeginDelta(e);
+		writer.Write(0 == (e + f) % 2);
+		writer.Write(0.5f * e);
+		writer.Write(1.0 / (e + 1));
+		writer.WriteDictionary(("models/player/" + std::to_string((e * 7 + f) % 37) + ".mdl").c_str());
+		writer.Write(1.0f * e); writer.Write(2.0f); writer.Write(3.0f); // Vector
+		writer.Write(4.0f); writer.Write(5.0f); writer.Write(1.0f * f); // QAngle
+		writer.Write(0.0f); writer.Write(0.0f); writer.Write(0.0f); writer.Write(1.0f); // Quaternion
+		writer.Write("plain");
+		writer.EndDelta();
+		writer.WriteDictionary("/");
+
+		if (0 == (e + f) % 11) recording.MarkHidden(e);
+	}
+
+	writer.WriteDictionary("afxCam");
+	for (int i = 0; i < 3; ++i) writer.Write((float)(f + i));
+	for (int i = 0; i < 3; ++i) writer.Write((float)(f * i));
+	writer.Write(90.0f);
+
+	recording.EndFrame();
+}
+
+typedef void (*AfxGameRecordTest_RecordFrame_t)(CAfxGameRecording & recording, int f);
+
+static bool AfxGameRecordTest_Record(CAfxGameRecording & recording, int version, float epsilon, int frames, AfxGameRecordTest_RecordFrame_t recordFrame = AfxGameRecordTest_RecordFrame)
+{
+	FILE * file = fopen(AFX_GAME_RECORD_TEST_FILE, "wb");
+	if (!file) return false;
+
+	recording.Begin(file, version, epsilon);
+
+	for (int f = 0; f < frames; ++f) recordFrame(recording, f);
+
+	bool ok = recording.End();
+
+	fclose(file);
+
+	return ok;
+}
+
+AFX_TEST(AfxGameRecord_GoldenVersion4)
+{
+	// data/ClientTools_v4.agr was recorded with CClientTools as it was before
+	// records were buffered per frame (one fwrite per value, hidden offset
+	// patched with ftell / fseek), from the same frames as above.
+
+	std::vector<char> golden;
+	AFX_CHECK(AfxGameRecordTest_ReadFile("data/ClientTools_v4.agr", golden));
+
+	CAfxGameRecording recording;
+	std::vector<char> data;
+
+	AFX_CHECK(AfxGameRecordTest_Record(recording, 4, 0.0f, 40));
+	AFX_CHECK(AfxGameRecordTest_ReadFile(AFX_GAME_RECORD_TEST_FILE, data));
+	AFX_CHECK(golden == data);
+
+	// A second recording with the same object starts from scratch (dictionary):
+	AFX_CHECK(AfxGameRecordTest_Record(recording, 4, 0.0f, 5));
+	AFX_CHECK(AfxGameRecordTest_ReadFile(AFX_GAME_RECORD_TEST_FILE, data));
+	AFX_CHECK(data.size() < golden.size());
+	AFX_CHECK(std::vector<char>(golden.begin(), golden.begin() + data.size()) == data);
+
+	remove(AFX_GAME_RECORD_TEST_FILE);
+
+	return true;
+}
+
+// Version 6 ///////////////////////////////////////////////////////////////////
+
+static const int g_AfxGameRecordTest_Entities = 12;
+static const int g_AfxGameRecordTest_Bones = 10;
+
+/// <returns>Smoothly moving value i of entity e in frame f.</returns>
+static float AfxGameRecordTest_Value(int f, int e, int i)
+{
+	return (float)(100.0 * sin(0.01 * f + 0.7 * e + 0.3 * i));
+}
+
+/// <summary>Records frames with the entity_state entries CClientToolsCsgo writes, so AfxGameRecord_Convert understands them.</summary>
+/// <returns>If value is what a recording with epsilon gives for expected.</returns>
+static bool AfxGameRecordTest_Near(float value, float expected, float epsilon)
+{
+	// Quantized values are off by epsilon / 2 at most, plus float rounding:
+	return fabs(value - expected) <= epsilon / 2 + (0 < epsilon ? fabs(expected) * FLT_EPSILON : 0);
+}
+
+static void AfxGameRecordTest_RecordEntityFrame(CAfxGameRecording & recording, int f)
+{
+	CAfxGameRecordWriter & writer = recording.GetWriter();
+
+	recording.BeginFrame(0.01f * f);
+
+	for (int e = 0; e < g_AfxGameRecordTest_Entities; ++e)
+	{
+		// Entity 5 is deleted every 50 frames and comes back in the next:
+		if (5 == e && 0 == f % 50)
+		{
+			writer.WriteDictionary("deleted");
+			writer.Write(e);
+			writer.DeleteDelta(e);
+			continue;
+		}
+
+		writer.WriteDictionary("entity_state");
+		writer.Write(e);
+		writer.BeginDelta(e);
+
+		writer.WriteDictionary("baseentity");
+		writer.WriteDictionary(0 == e % 2 ? "models/player/ctm_sas.mdl" : "models/weapons/w_rif_ak47.mdl");
+		writer.Write(0 != (e + f) % 7);
+		for (int i = 0; i < 6; ++i) writer.Write(AfxGameRecordTest_Value(f, e, i));
+
+		if (0 == e % 2)
+		{
+			writer.WriteDictionary("baseanimating");
+			writer.Write(true);
+			writer.Write(g_AfxGameRecordTest_Bones);
+			for (int i = 0; i < 7 * g_AfxGameRecordTest_Bones; ++i) writer.Write(AfxGameRecordTest_Value(f, e, 6 + i));
+		}
+
+		writer.EndDelta();
+		writer.WriteDictionary("/");
+		writer.Write(1 == e);
+
+		if (3 == e && 0 == f % 10) recording.MarkHidden(e);
+	}
+
+	writer.WriteDictionary("afxCam");
+	for (int i = 0; i < 7; ++i) writer.Write(AfxGameRecordTest_Value(f, -1, i));
+
+	recording.EndFrame();
+}
+
+static bool AfxGameRecordTest_Convert(char const * inFileName, char const * outFileName, int version, float epsilon, size_t & outFrames)
+{
+	FILE * in = fopen(inFileName, "rb");
+	FILE * out = fopen(outFileName, "wb");
+
+	std::string error;
+	bool ok = in && out && AfxGameRecord_Convert(in, out, version, epsilon, error, outFrames);
+
+	if (!error.empty()) printf("%s\n", error.c_str());
+
+	if (in) fclose(in);
+	if (out) fclose(out);
+
+	return ok;
+}
+
+AFX_TEST(AfxGameRecord_ConvertRoundTrip)
+{
+	const int frames = 200;
+
+	CAfxGameRecording recording;
+	std::vector<char> version4;
+	std::vector<char> version6;
+	std::vector<char> data;
+	size_t convertedFrames;
+
+	AFX_CHECK(AfxGameRecordTest_Record(recording, 4, 0.0f, frames, AfxGameRecordTest_RecordEntityFrame));
+	AFX_CHECK(AfxGameRecordTest_ReadFile(AFX_GAME_RECORD_TEST_FILE, version4));
+
+	// 4 -> 6 is the same as recording version 6 directly:
+	AFX_CHECK(AfxGameRecordTest_Convert(AFX_GAME_RECORD_TEST_FILE, AFX_GAME_RECORD_TEST_FILE_6, 6, 0.0f, convertedFrames));
+	AFX_CHECK(frames == convertedFrames);
+	AFX_CHECK(AfxGameRecordTest_ReadFile(AFX_GAME_RECORD_TEST_FILE_6, version6));
+	AFX_CHECK(version6.size() < version4.size());
+
+	AFX_CHECK(AfxGameRecordTest_Record(recording, 6, 0.0f, frames, AfxGameRecordTest_RecordEntityFrame));
+	AFX_CHECK(AfxGameRecordTest_ReadFile(AFX_GAME_RECORD_TEST_FILE, data));
+	AFX_CHECK(version6 == data);
+
+	// Lossless 6 -> 4 gives back the original:
+	AFX_CHECK(AfxGameRecordTest_Convert(AFX_GAME_RECORD_TEST_FILE_6, AFX_GAME_RECORD_TEST_FILE_4, 4, 0.0f, convertedFrames));
+	AFX_CHECK(frames == convertedFrames);
+	AFX_CHECK(AfxGameRecordTest_ReadFile(AFX_GAME_RECORD_TEST_FILE_4, data));
+	AFX_CHECK(version4 == data);
+
+	// Quantized 6 -> 4 keeps the layout, so it's the same size:
+	AFX_CHECK(AfxGameRecordTest_Convert(AFX_GAME_RECORD_TEST_FILE, AFX_GAME_RECORD_TEST_FILE_6, 6, 0.001f, convertedFrames));
+	AFX_CHECK(AfxGameRecordTest_ReadFile(AFX_GAME_RECORD_TEST_FILE_6, data));
+	AFX_CHECK(data.size() < version6.size());
+	AFX_CHECK(AfxGameRecordTest_Convert(AFX_GAME_RECORD_TEST_FILE_6, AFX_GAME_RECORD_TEST_FILE_4, 4, 0.0f, convertedFrames));
+	AFX_CHECK(frames == convertedFrames);
+	AFX_CHECK(AfxGameRecordTest_ReadFile(AFX_GAME_RECORD_TEST_FILE_4, data));
+	AFX_CHECK(version4.size() == data.size());
+
+	remove(AFX_GAME_RECORD_TEST_FILE);
+	remove(AFX_GAME_RECORD_TEST_FILE_6);
+	remove(AFX_GAME_RECORD_TEST_FILE_4);
+
+	return true;
+}
+
+AFX_TEST(AfxGameRecord_SeekKeyFrame)
+{
+	const int frames = 200;
+
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		float epsilon = 0 == pass ? 0.0f : 0.001f;
+
+		CAfxGameRecording recording;
+		AFX_CHECK(AfxGameRecordTest_Record(recording, 6, epsilon, frames, AfxGameRecordTest_RecordEntityFrame));
+
+		FILE * file = fopen(AFX_GAME_RECORD_TEST_FILE, "rb");
+		AFX_CHECK(file);
+
+		CAfxGameRecordReader reader;
+		bool ok = reader.Open(file);
+
+		// Every frame decodes from its key frame, regardless of what was read before:
+		static const int seekFrames[] = { 130, 0, 63, 64, 100, 199 };
+
+		for (size_t i = 0; ok && i < sizeof(seekFrames) / sizeof(seekFrames[0]); ++i)
+		{
+			int frame = seekFrames[i];
+			int keyFrame = frame - frame % CAfxGameRecordWriter::KeyFrameInterval;
+
+			ok = 6 == reader.GetVersion()
+				&& frames == reader.GetFrameCount()
+				&& keyFrame == reader.SeekKeyFrame(frame);
+
+			std::string const * token;
+
+			ok = ok && reader.ReadDictionary(token) && "afxKeyFrame" == *token;
+
+			for (int f = keyFrame; ok && f <= frame; ++f)
+			{
+				float frameTime;
+				int hiddenOffset;
+
+				ok = reader.ReadDictionary(token) && "afxFrame" == *token
+					&& reader.Read(frameTime) && 0.01f * f == frameTime
+					&& reader.Read(hiddenOffset);
+
+				// Read the entities up to the frame end:
+				int e = 0;
+
+				while (ok && reader.ReadDictionary(token) && "afxCam" != *token)
+				{
+					int handle;
+					ok = reader.Read(handle) && e == handle;
+
+					if (ok && "deleted" == *token)
+					{
+						reader.DeleteDelta(handle);
+						++e;
+						continue;
+					}
+
+					ok = ok && "entity_state" == *token;
+
+					std::string const * modelName;
+					bool visible;
+
+					reader.BeginDelta(handle);
+
+					ok = ok && reader.ReadDictionary(token) && "baseentity" == *token
+						&& reader.ReadDictionary(modelName)
+						&& reader.Read(visible) && (0 != (e + f) % 7) == visible;
+
+					for (int j = 0; ok && j < 6; ++j)
+					{
+						float value;
+						ok = reader.Read(value) && AfxGameRecordTest_Near(value, AfxGameRecordTest_Value(f, e, j), epsilon);
+					}
+
+					if (ok && 0 == e % 2)
+					{
+						bool hasBoneList;
+						int bones;
+
+						ok = reader.ReadDictionary(token) && "baseanimating" == *token
+							&& reader.Read(hasBoneList) && hasBoneList
+							&& reader.Read(bones) && g_AfxGameRecordTest_Bones == bones;
+
+						for (int j = 0; ok && j < 7 * bones; ++j)
+						{
+							float value;
+							ok = reader.Read(value) && AfxGameRecordTest_Near(value, AfxGameRecordTest_Value(f, e, 6 + j), epsilon);
+						}
+					}
+
+					reader.EndDelta();
+
+					bool viewModel;
+					ok = ok && reader.ReadDictionary(token) && "/" == *token
+						&& reader.Read(viewModel) && (1 == e) == viewModel;
+
+					++e;
+				}
+
+				ok = ok && g_AfxGameRecordTest_Entities == e;
+
+				// Camera, hidden and frame end:
+				for (int j = 0; ok && j < 7; ++j)
+				{
+					float value;
+					ok = reader.Read(value) && AfxGameRecordTest_Value(f, -1, j) == value;
+				}
+
+				if (ok && 0 == f % 10)
+				{
+					int count;
+					int hidden;
+
+					ok = reader.ReadDictionary(token) && "afxHidden" == *token
+						&& reader.Read(count) && 1 == count
+						&& reader.Read(hidden) && 3 == hidden;
+				}
+
+				ok = ok && reader.ReadDictionary(token) && "afxFrameEnd" == *token;
+			}
+
+			if (!ok) printf("Seeking to frame %i failed.\n", frame);
+		}
+
+		AFX_CHECK(ok);
+		AFX_CHECK(-1 == reader.SeekKeyFrame(frames));
+
+		// The last frame is followed by the index:
+		AFX_CHECK(reader.Eof());
+
+		fclose(file);
+	}
+
+	remove(AFX_GAME_RECORD_TEST_FILE);
+
+	return true;
+}
+
+AFX_BENCHMARK(AfxGameRecord_Convert)
+{
+	const int frames = 3000;
+
+	CAfxGameRecording recording;
+	AFX_CHECK(AfxGameRecordTest_Record(recording, 4, 0.0f, frames, AfxGameRecordTest_RecordEntityFrame));
+
+	std::vector<char> version4;
+	AFX_CHECK(AfxGameRecordTest_ReadFile(AFX_GAME_RECORD_TEST_FILE, version4));
+
+	const double toMiB = 1.0 / (1024 * 1024);
+
+	printf("%i frames, %i entities, version 4: %.1f MiB\n", frames, g_AfxGameRecordTest_Entities, toMiB * version4.size());
+
+	static const float epsilons[] = { 0.0f, 0.001f };
+
+	for (size_t i = 0; i < sizeof(epsilons) / sizeof(epsilons[0]); ++i)
+	{
+		size_t convertedFrames;
+		std::vector<char> data;
+
+		double t0 = AfxTest_Seconds();
+		AFX_CHECK(AfxGameRecordTest_Convert(AFX_GAME_RECORD_TEST_FILE, AFX_GAME_RECORD_TEST_FILE_6, 6, epsilons[i], convertedFrames));
+		double t1 = AfxTest_Seconds();
+		AFX_CHECK(AfxGameRecordTest_Convert(AFX_GAME_RECORD_TEST_FILE_6, AFX_GAME_RECORD_TEST_FILE_4, 4, 0.0f, convertedFrames));
+		double t2 = AfxTest_Seconds();
+
+		AFX_CHECK(AfxGameRecordTest_ReadFile(AFX_GAME_RECORD_TEST_FILE_6, data));
+
+		printf("version 6 (epsilon %g): %.1f MiB (%.0f %%), 4 -> 6: %.1f MiB/s, 6 -> 4: %.1f MiB/s\n"
+			, epsilons[i], toMiB * data.size(), 100.0 * data.size() / version4.size()
+			, toMiB * version4.size() / (t1 - t0), toMiB * version4.size() / (t2 - t1));
+	}
+
+	remove(AFX_GAME_RECORD_TEST_FILE);
+	remove(AFX_GAME_RECORD_TEST_FILE_6);
+	remove(AFX_GAME_RECORD_TEST_FILE_4);
+
+	return true;
+}
@@ -0,0 +1,273 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+#include <shared/AfxImageKernels.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// Golden implementations //////////////////////////////////////////////////////
+
+// The loops the kernels replaced (from CAfxStreams / CAfxImageBuffer), kept
+// as they were, so every kind is checked against the old output.
+
+static void Golden_FlipSwap24(unsigned char * pBuffer, int width, int height, int imagePitch)
+{
+	int lastLine = height >> 1;
+	if (height & 0x1) ++lastLine;
+
+	for (int y = 0; y < lastLine; ++y)
+	{
+		int srcLine = y;
+		int dstLine = height - 1 - y;
+
+		for (int x = 0; x < width; ++x)
+		{
+			unsigned char r = pBuffer[dstLine * imagePitch + 3 * x + 0];
+			unsigned char g = pBuffer[dstLine * imagePitch + 3 * x + 1];
+			unsigned char b = pBuffer[dstLine * imagePitch + 3 * x + 2];
+
+			pBuffer[dstLine * imagePitch + 3 * x + 0] = pBuffer[srcLine * imagePitch + 3 * x + 2];
+			pBuffer[dstLine * imagePitch + 3 * x + 1] = pBuffer[srcLine * imagePitch + 3 * x + 1];
+			pBuffer[dstLine * imagePitch + 3 * x + 2] = pBuffer[srcLine * imagePitch + 3 * x + 0];
+
+			pBuffer[srcLine * imagePitch + 3 * x + 0] = b;
+			pBuffer[srcLine * imagePitch + 3 * x + 1] = g;
+			pBuffer[srcLine * imagePitch + 3 * x + 2] = r;
+		}
+	}
+}
+
+static void Golden_DepthAffine(float * data, float depthScale, float depthOfs, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		float depth = data[i];
+
+		depth *= depthScale;
+		depth += depthOfs;
+
+		data[i] = depth;
+	}
+}
+
+static void Golden_Depth24ToFloat(unsigned char * pBuffer, int width, int height, int oldImagePitch, int imagePitch, float depthScale, float depthOfs)
+{
+	for (int y = height - 1; y >= 0; --y)
+	{
+		for (int x = width - 1; x >= 0; --x)
+		{
+			unsigned char r = pBuffer[y * oldImagePitch + 3 * x + 0];
+			unsigned char g = pBuffer[y * oldImagePitch + 3 * x + 1];
+			unsigned char b = pBuffer[y * oldImagePitch + 3 * x + 2];
+
+			float depth;
+
+			depth = (1.0f / 16777215.0f) * r + (256.0f / 16777215.0f) * g + (65536.0f / 16777215.0f) * b;
+
+			depth *= depthScale;
+			depth += depthOfs;
+
+			*(float *)(pBuffer + y * imagePitch + x * sizeof(float)) = depth;
+		}
+	}
+}
+
+static void Golden_BgrMergeBlueToBgra(unsigned char * pBuffer, int width, int height, int oldImagePitch, int imagePitch, unsigned char const * pAlpha, int alphaPitch)
+{
+	for (int y = height - 1; y >= 0; --y)
+	{
+		for (int x = width - 1; x >= 0; --x)
+		{
+			unsigned char b = pBuffer[y * oldImagePitch + 3 * x + 0];
+			unsigned char g = pBuffer[y * oldImagePitch + 3 * x + 1];
+			unsigned char r = pBuffer[y * oldImagePitch + 3 * x + 2];
+			unsigned char a = pAlpha[y * alphaPitch + 3 * x + 0];
+
+			pBuffer[y * imagePitch + 4 * x + 0] = b;
+			pBuffer[y * imagePitch + 4 * x + 1] = g;
+			pBuffer[y * imagePitch + 4 * x + 2] = r;
+			pBuffer[y * imagePitch + 4 * x + 3] = a;
+		}
+	}
+}
+
+// Tests ///////////////////////////////////////////////////////////////////////
+
+static const AfxImageKernels::Kind g_AfxImageKernelsTest_Kinds[] = { AfxImageKernels::EK_Scalar, AfxImageKernels::EK_Sse2, AfxImageKernels::EK_Ssse3 };
+
+static void AfxImageKernelsTest_Fill(CAfxTestRandom & random, std::vector<unsigned char> & data)
+{
+	for (size_t i = 0; i < data.size(); ++i) data[i] = (unsigned char)random.Next();
+}
+
+static bool AfxImageKernelsTest_Check(AfxImageKernels const * kernels, int width, int height)
+{
+	CAfxTestRandom random(width * 131 + height);
+
+	// 24 bit rows padded to 4 bytes, as GL packs them:
+	int pitch24 = (3 * width + 3) & ~3;
+	int pitch32 = 4 * width;
+
+	std::vector<unsigned char> expected((size_t)height * pitch32);
+	std::vector<unsigned char> actual;
+	std::vector<unsigned char> alpha((size_t)height * pitch24);
+
+	AfxImageKernelsTest_Fill(random, expected);
+	actual = expected;
+	Golden_FlipSwap24(expected.data(), width, height, pitch24);
+	kernels->FlipSwap24(actual.data(), width, height, pitch24);
+	AFX_CHECK(expected == actual);
+
+	AfxImageKernelsTest_Fill(random, expected);
+	actual = expected;
+	Golden_Depth24ToFloat(expected.data(), width, height, pitch24, pitch32, 0.7f, 0.1f);
+	kernels->Depth24ToFloat(actual.data(), width, height, pitch24, pitch32, 0.7f, 0.1f);
+	AFX_CHECK(expected == actual);
+
+	AfxImageKernelsTest_Fill(random, expected);
+	AfxImageKernelsTest_Fill(random, alpha);
+	actual = expected;
+	Golden_BgrMergeBlueToBgra(expected.data(), width, height, pitch24, pitch32, alpha.data(), pitch24);
+	kernels->BgrMergeBlueToBgra(actual.data(), width, height, pitch24, pitch32, alpha.data(), pitch24);
+	AFX_CHECK(expected == actual);
+
+	size_t count = (size_t)width * height;
+	for (size_t i = 0; i < count; ++i)
+	{
+		float value = (float)random.NextDouble();
+		memcpy(&expected[i * sizeof(float)], &value, sizeof(float));
+	}
+	actual = expected;
+	Golden_DepthAffine((float *)expected.data(), 3.3f, 0.2f, count);
+	kernels->DepthAffine((float *)actual.data(), 3.3f, 0.2f, count);
+	AFX_CHECK(expected == actual);
+
+	return true;
+}
+
+AFX_TEST(AfxImageKernels_SameAsGolden)
+{
+	// Covers the tails of the SIMD loops and images narrower than a SIMD block:
+	static const int sizes[][2] = { { 1, 1 }, { 2, 3 }, { 5, 1 }, { 5, 2 }, { 6, 3 }, { 7, 7 }, { 15, 4 }, { 16, 5 }, { 17, 9 }, { 31, 2 }, { 33, 3 }, { 64, 1 }, { 101, 33 }, { 640, 361 } };
+
+	for (size_t k = 0; k < sizeof(g_AfxImageKernelsTest_Kinds) / sizeof(g_AfxImageKernelsTest_Kinds[0]); ++k)
+	{
+		AfxImageKernels::Kind kind = g_AfxImageKernelsTest_Kinds[k];
+
+		if (!AfxImageKernels::IsSupported(kind))
+		{
+			printf("%s not supported by the CPU, skipped.\n", AfxImageKernels::GetName(kind));
+			continue;
+		}
+
+		AfxImageKernels const * kernels = AfxImageKernels::Get(kind);
+		AFX_CHECK(kind == kernels->Type);
+
+		for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+		{
+			if (!AfxImageKernelsTest_Check(kernels, sizes[i][0], sizes[i][1]))
+			{
+				printf("Failed for %s, %ix%i.\n", AfxImageKernels::GetName(kind), sizes[i][0], sizes[i][1]);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+AFX_TEST(AfxImageKernels_KnownValues)
+{
+	AfxImageKernels const * kernels = AfxImageKernels::Get(AfxImageKernels::EK_Auto);
+
+	{
+		// 1x2 image: rows are swapped and RGB becomes BGR.
+		unsigned char image[] = { 1, 2, 3, 0, 4, 5, 6, 0 };
+		kernels->FlipSwap24(image, 1, 2, 4);
+		unsigned char expected[] = { 6, 5, 4, 0, 3, 2, 1, 0 };
+		AFX_CHECK(0 == memcmp(image, expected, sizeof(image)));
+	}
+
+	{
+		// 0 maps to offset, 0xffffff to about scale + offset:
+		unsigned char image[8] = { 0, 0, 0, 0xff, 0xff, 0xff };
+		kernels->Depth24ToFloat(image, 2, 1, 6, 8, 2.0f, 0.5f);
+		float depth[2];
+		memcpy(depth, image, sizeof(depth));
+		AFX_CHECK(0.5f == depth[0]);
+		AFX_CHECK(2.5f - 1e-6f < depth[1] && depth[1] < 2.5f + 1e-6f);
+	}
+
+	{
+		unsigned char image[8] = { 10, 20, 30, 40, 50, 60 };
+		unsigned char alpha[6] = { 200, 1, 1, 100, 1, 1 };
+		kernels->BgrMergeBlueToBgra(image, 2, 1, 6, 8, alpha, 6);
+		unsigned char expected[] = { 10, 20, 30, 200, 40, 50, 60, 100 };
+		AFX_CHECK(0 == memcmp(image, expected, sizeof(image)));
+	}
+
+	{
+		float data[5] = { 0.0f, 1.0f, 2.0f, 3.0f, 4.0f };
+		kernels->DepthAffine(data, 2.0f, 1.0f, 5);
+		for (int i = 0; i < 5; ++i) AFX_CHECK(2.0f * i + 1.0f == data[i]);
+	}
+
+	return true;
+}
+
+AFX_TEST(AfxImageKernels_Get)
+{
+	AFX_CHECK(AfxImageKernels::GetBestSupported() == AfxImageKernels::Get(AfxImageKernels::EK_Auto)->Type);
+	AFX_CHECK(AfxImageKernels::EK_Scalar == AfxImageKernels::Get(AfxImageKernels::EK_Scalar)->Type);
+
+	// Invalid kinds are not supported, so they resolve to the best supported one:
+	AFX_CHECK(!AfxImageKernels::IsSupported((AfxImageKernels::Kind)99));
+	AFX_CHECK(AfxImageKernels::GetBestSupported() == AfxImageKernels::Get((AfxImageKernels::Kind)99)->Type);
+
+	return true;
+}
+
+AFX_BENCHMARK(AfxImageKernels)
+{
+	const int width = 1920;
+	const int height = 1080;
+	const int rounds = 50;
+
+	CAfxTestRandom random;
+	std::vector<unsigned char> image((size_t)width * height * 4);
+	std::vector<unsigned char> alpha((size_t)width * height * 3);
+	AfxImageKernelsTest_Fill(random, image);
+	AfxImageKernelsTest_Fill(random, alpha);
+
+	for (size_t k = 0; k < sizeof(g_AfxImageKernelsTest_Kinds) / sizeof(g_AfxImageKernelsTest_Kinds[0]); ++k)
+	{
+		AfxImageKernels::Kind kind = g_AfxImageKernelsTest_Kinds[k];
+
+		if (!AfxImageKernels::IsSupported(kind))
+			continue;
+
+		AfxImageKernels const * kernels = AfxImageKernels::Get(kind);
+
+		double t0 = AfxTest_Seconds();
+		for (int i = 0; i < rounds; ++i) kernels->FlipSwap24(image.data(), width, height, 3 * width);
+		double t1 = AfxTest_Seconds();
+		for (int i = 0; i < rounds; ++i) kernels->Depth24ToFloat(image.data(), width, height, 3 * width, 4 * width, 0.5f, 0.1f);
+		double t2 = AfxTest_Seconds();
+		for (int i = 0; i < rounds; ++i) kernels->BgrMergeBlueToBgra(image.data(), width, height, 3 * width, 4 * width, alpha.data(), 3 * width);
+		double t3 = AfxTest_Seconds();
+		for (int i = 0; i < rounds; ++i) kernels->DepthAffine((float *)image.data(), 1.0f, 0.0f, (size_t)width * height);
+		double t4 = AfxTest_Seconds();
+
+		printf("1080p %-6s FlipSwap24 %6.3f ms, Depth24ToFloat %6.3f ms, BgrMergeBlueToBgra %6.3f ms, DepthAffine %6.3f ms\n",
+			AfxImageKernels::GetName(kind),
+			1000.0 * (t1 - t0) / rounds,
+			1000.0 * (t2 - t1) / rounds,
+			1000.0 * (t3 - t2) / rounds,
+			1000.0 * (t4 - t3) / rounds);
+	}
+
+	return true;
+}
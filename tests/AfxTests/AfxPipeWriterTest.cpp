@@ -0,0 +1,241 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+#include <shared/AfxPipeWriter.h>
+#include <shared/AfxPipeProcess.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+AFX_TEST(AfxPipeWriter_WritesInOrder)
+{
+	std::vector<int> written;
+	std::atomic_int done(0);
+
+	std::vector<int> frames(1000);
+	for (size_t i = 0; i < frames.size(); ++i) frames[i] = (int)i;
+
+	{
+		CAfxPipeWriter writer(3, [&written](void const * data, size_t bytes) {
+			if (0 == *(int const *)data % 100) std::this_thread::sleep_for(std::chrono::milliseconds(1)); // let the ring fill up
+			written.push_back(*(int const *)data);
+			return sizeof(int) == bytes;
+		});
+
+		for (size_t i = 0; i < frames.size(); ++i)
+			AFX_CHECK(writer.Queue(&frames[i], sizeof(int), [&done]() { ++done; }));
+
+		AFX_CHECK(writer.Finish());
+		AFX_CHECK(frames.size() * sizeof(int) == writer.GetBytesWritten());
+	}
+
+	AFX_CHECK(frames.size() == (size_t)done);
+	AFX_CHECK(frames.size() == written.size());
+	for (size_t i = 0; i < written.size(); ++i) AFX_CHECK((int)i == written[i]);
+
+	return true;
+}
+
+AFX_TEST(AfxPipeWriter_FailedWriteCompletesFrames)
+{
+	std::atomic_int writes(0);
+	std::atomic_int done(0);
+
+	CAfxPipeWriter writer(2, [&writes](void const *, size_t) {
+		return 5 != ++writes;
+	});
+
+	int frame = 0;
+	int queued = 0;
+
+	for (int i = 0; i < 100; ++i)
+		if (writer.Queue(&frame, sizeof(frame), [&done]() { ++done; })) ++queued;
+
+	AFX_CHECK(!writer.Finish());
+	AFX_CHECK(writer.GetFailed());
+
+	// Nothing is written after the failed write, but every done is called exactly once:
+	AFX_CHECK(5 == writes);
+	AFX_CHECK(5 <= queued && queued < 100);
+	AFX_CHECK(100 == done);
+	AFX_CHECK(4 * sizeof(frame) == writer.GetBytesWritten());
+
+	AFX_CHECK(!writer.Queue(&frame, sizeof(frame), [&done]() { ++done; }));
+	AFX_CHECK(101 == done);
+
+	return true;
+}
+
+#ifndef _WIN32
+
+// CAfxPipeProcess /////////////////////////////////////////////////////////////
+
+/// <summary>Collects the output of a process.</summary>
+struct CPipeProcessOutput
+{
+	std::mutex Mutex;
+	std::string StdOut;
+	std::string StdErr;
+
+	CAfxPipeProcess::Output_t Get(void)
+	{
+		return [this](char const * data, size_t bytes, bool isStdErr) {
+			std::unique_lock<std::mutex> lock(Mutex);
+			(isStdErr ? StdErr : StdOut).append(data, bytes);
+		};
+	}
+};
+
+AFX_TEST(AfxPipeProcess_WriterRoundTrip)
+{
+	CPipeProcessOutput output;
+	CAfxPipeProcess process("wc -c && echo done 1>&2", 1024 * 1024, output.Get());
+
+	AFX_CHECK(process.GetOkay());
+
+	std::vector<unsigned char> frame(3 * 1000 * 1001);
+	for (size_t i = 0; i < frame.size(); ++i) frame[i] = (unsigned char)i;
+
+	const int frames = 20;
+
+	{
+		CAfxPipeWriter writer(3, [&process](void const * data, size_t bytes) {
+			return process.Write(data, bytes);
+		});
+
+		for (int i = 0; i < frames; ++i)
+			AFX_CHECK(writer.Queue(frame.data(), frame.size(), nullptr));
+
+		AFX_CHECK(writer.Finish());
+	}
+
+	AFX_CHECK(0 == process.Close());
+
+	AFX_CHECK((unsigned long long)frames * frame.size() == strtoull(output.StdOut.c_str(), nullptr, 10));
+	AFX_CHECK("done\n" == output.StdErr);
+
+	return true;
+}
+
+AFX_TEST(AfxPipeProcess_ExitedProcessFailsWrite)
+{
+	CAfxPipeProcess process("exit 3", 64 * 1024, nullptr);
+
+	AFX_CHECK(process.GetOkay());
+
+	// Writes fail with EPIPE once the process is gone (and don't raise SIGPIPE):
+	std::vector<unsigned char> frame(1024 * 1024);
+	bool failed = false;
+	for (int i = 0; i < 1000 && !failed; ++i)
+		failed = !process.Write(frame.data(), frame.size());
+
+	AFX_CHECK(failed);
+	AFX_CHECK(3 == process.Close());
+	AFX_CHECK(!process.Write(frame.data(), frame.size()));
+
+	return true;
+}
+
+/// <summary>Busy waits, like the game does when rendering the next frame.</summary>
+static void AfxPipeWriterTest_Work(double seconds)
+{
+	double t0 = AfxTest_Seconds();
+	while (AfxTest_Seconds() - t0 < seconds);
+}
+
+AFX_BENCHMARK(AfxPipeProcess_CatToDevNull)
+{
+	// 1080p BGR frames like CAfxOutFFMPEGVideoStream pipes them, with the time
+	// a frame takes to render on the calling thread:
+
+	const size_t frameBytes = 3 * 1920 * 1080;
+	const int frames = 300;
+	const double workSeconds = 0.002;
+
+	std::vector<std::vector<unsigned char>> buffers(4, std::vector<unsigned char>(frameBytes));
+	for (size_t i = 0; i < buffers.size(); ++i)
+		for (size_t j = 0; j < frameBytes; ++j) buffers[i][j] = (unsigned char)(i + j);
+
+	printf("%i frames of %.1f MiB, %.1f ms work per frame:\n", frames, frameBytes / (1024.0 * 1024.0), 1000.0 * workSeconds);
+
+	// Writing from the calling thread, as before the pipe writer:
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		size_t pipeBufferSize = 0 == pass ? 64 * 1024 : frameBytes;
+
+		CAfxPipeProcess process("cat > /dev/null", pipeBufferSize, nullptr);
+		AFX_CHECK(process.GetOkay());
+
+		double t0 = AfxTest_Seconds();
+		for (int i = 0; i < frames; ++i)
+		{
+			AfxPipeWriterTest_Work(workSeconds);
+			AFX_CHECK(process.Write(buffers[i % buffers.size()].data(), frameBytes));
+		}
+		AFX_CHECK(0 == process.Close());
+		double t1 = AfxTest_Seconds();
+
+		printf("synchronous, %5u KiB pipe: %7.1f frames/s, %7.1f MiB/s\n", (unsigned int)(pipeBufferSize / 1024), frames / (t1 - t0), frames * frameBytes / (1024.0 * 1024.0) / (t1 - t0));
+	}
+
+	// Writing from the writer thread, the caller only waits for a free buffer:
+	{
+		CAfxPipeProcess process("cat > /dev/null", frameBytes, nullptr);
+		AFX_CHECK(process.GetOkay());
+
+		std::mutex mutex;
+		std::condition_variable freeCondition;
+		std::vector<bool> inUse(buffers.size(), false);
+
+		double t0 = AfxTest_Seconds();
+		{
+			CAfxPipeWriter writer(buffers.size() - 1, [&process](void const * data, size_t bytes) {
+				return process.Write(data, bytes);
+			});
+
+			for (int i = 0; i < frames; ++i)
+			{
+				size_t index = i % buffers.size();
+
+				AfxPipeWriterTest_Work(workSeconds);
+
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					freeCondition.wait(lock, [&inUse, index]() { return !inUse[index]; });
+					inUse[index] = true;
+				}
+
+				AFX_CHECK(writer.Queue(buffers[index].data(), frameBytes, [&mutex, &freeCondition, &inUse, index]() {
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						inUse[index] = false;
+					}
+					freeCondition.notify_one();
+				}));
+			}
+
+			AFX_CHECK(writer.Finish());
+
+			unsigned long long stallCount;
+			double stallSeconds;
+			writer.GetStalls(stallCount, stallSeconds);
+			printf("CAfxPipeWriter stalls: %llu, stallMs: %.1f\n", stallCount, 1000.0 * stallSeconds);
+		}
+		AFX_CHECK(0 == process.Close());
+		double t1 = AfxTest_Seconds();
+
+		printf("CAfxPipeWriter, %5u KiB pipe: %7.1f frames/s, %7.1f MiB/s\n", (unsigned int)(frameBytes / 1024), frames / (t1 - t0), frames * frameBytes / (1024.0 * 1024.0) / (t1 - t0));
+	}
+
+	return true;
+}
+
+#endif
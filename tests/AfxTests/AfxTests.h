@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+
+// CAfxTest ////////////////////////////////////////////////////////////////////
+
+/// <summary>
+///   Tests and benchmarks register themselves with AFX_TEST / AFX_BENCHMARK
+///   and are run by main.cpp.<br />
+///   A test or benchmark returns false when it failed.
+/// </summary>
+class CAfxTest
+{
+public:
+	typedef bool (*Fn_t)(void);
+
+	CAfxTest(char const * name, bool benchmark, Fn_t fn);
+
+	/// <param name="filter">Only run tests which name contains filter, can be nullptr.</param>
+	/// <returns>Number of failed tests.</returns>
+	static int RunAll(bool benchmarks, char const * filter);
+
+private:
+	char const * m_Name;
+	bool m_Benchmark;
+	Fn_t m_Fn;
+	CAfxTest * m_Next;
+
+	static CAfxTest * & GetFirst(void);
+};
+
+#define AFX_TEST(name) \
+	static bool AfxTest_##name(void); \
+	static CAfxTest g_AfxTest_##name(#name, false, AfxTest_##name); \
+	static bool AfxTest_##name(void)
+
+#define AFX_BENCHMARK(name) \
+	static bool AfxBenchmark_##name(void); \
+	static CAfxTest g_AfxBenchmark_##name(#name, true, AfxBenchmark_##name); \
+	static bool AfxBenchmark_##name(void)
+
+/// <summary>Fails the current test if expr is false.</summary>
+#define AFX_CHECK(expr) \
+	do { if (!(expr)) { AfxTest_Failed(__FILE__, __LINE__, #expr); return false; } } while(0)
+
+void AfxTest_Failed(char const * file, int line, char const * expr);
+
+/// <returns>Seconds since an arbitrary fixed point in time.</returns>
+inline double AfxTest_Seconds(void)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// <summary>Deterministic pseudo random numbers, so failures can be reproduced.</summary>
+class CAfxTestRandom
+{
+public:
+	CAfxTestRandom(unsigned int seed = 1)
+		: m_State(seed ? seed : 1)
+	{
+	}
+
+	unsigned int Next(void)
+	{
+		// xorshift32
+		m_State ^= m_State << 13;
+		m_State ^= m_State >> 17;
+		m_State ^= m_State << 5;
+		return m_State;
+	}
+
+	/// <returns>Value in [0, 1).</returns>
+	double NextDouble(void)
+	{
+		return (Next() >> 8) / 16777216.0;
+	}
+
+private:
+	unsigned int m_State;
+};
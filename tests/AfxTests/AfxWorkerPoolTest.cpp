@@ -0,0 +1,214 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+#include <AfxHookSource/AfxWorkerPool.h>
+#include <shared/EasySampler.h>
+
+#include <atomic>
+#include <deque>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+AFX_TEST(AfxWorkerPool_RunsEachIndexOnce)
+{
+	CAfxWorkerPool pool(3);
+
+	AFX_CHECK(3 == pool.GetWorkerCount());
+
+	static const size_t counts[] = { 0, 1, 2, 4, 5, 100, 1000 };
+
+	for (int round = 0; round < 50; ++round)
+	{
+		for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+		{
+			size_t count = counts[c];
+			std::vector<std::atomic<int>> calls(count);
+			for (size_t i = 0; i < count; ++i) calls[i] = 0;
+
+			pool.Run(count, [&calls](size_t index) {
+				++calls[index];
+			});
+
+			// Run must only return when all calls are done:
+			for (size_t i = 0; i < count; ++i) AFX_CHECK(1 == calls[i]);
+		}
+	}
+
+	return true;
+}
+
+// Sampling in bands ///////////////////////////////////////////////////////////
+
+// Same split and buffer handling as CAfxOutSamplingStream, so the test covers
+// what the stream does without needing the game's image buffers.
+
+class CBandPrinter : public IFramePrinter
+{
+public:
+	CBandPrinter(std::vector<std::vector<unsigned char>> & frames, int row, int rows, int pitch)
+		: m_Frames(frames), m_Row(row), m_Rows(rows), m_Pitch(pitch)
+	{
+	}
+
+	virtual void Print(unsigned char const * data) override
+	{
+		// The frames are allocated by the caller in advance, so no locking is needed.
+		memcpy(&m_Frames[m_PrintCount][(size_t)m_Row * m_Pitch], data, (size_t)m_Rows * m_Pitch);
+		++m_PrintCount;
+	}
+
+	size_t m_PrintCount = 0;
+
+private:
+	std::vector<std::vector<unsigned char>> & m_Frames;
+	int m_Row;
+	int m_Rows;
+	int m_Pitch;
+};
+
+class CBandedSampler
+{
+public:
+	CBandedSampler(int byteWidth, int height, int pitch, EasySamplerSettings::Method method, double frameDuration, int threads)
+		: m_Pitch(pitch)
+		, m_Height(height)
+	{
+		for (int i = 0; i < threads; ++i)
+		{
+			int row = (int)((long long)height * i / threads);
+			int nextRow = (int)((long long)height * (i + 1) / threads);
+
+			m_Printers.emplace_back(Frames, row, nextRow - row, pitch);
+			m_Rows.push_back(row);
+			m_Samplers.emplace_back(EasySamplerSettings(byteWidth, nextRow - row, method, frameDuration, 0, 1.0, 1.0f), pitch, &m_Printers.back());
+		}
+
+		if (1 < threads) m_Pool = new CAfxWorkerPool(threads - 1);
+	}
+
+	~CBandedSampler()
+	{
+		delete m_Pool;
+	}
+
+	void Sample(unsigned char const * data, double time)
+	{
+		// Room for the frames printed by this sample (the inputs are never longer than an output frame):
+		if (Frames.size() < GetFrameCount() + 2) Frames.resize(GetFrameCount() + 2, std::vector<unsigned char>((size_t)m_Height * m_Pitch, 0));
+
+		auto fn = [this, data, time](size_t index) {
+			m_Samplers[index].Sample(data + (size_t)m_Rows[index] * m_Pitch, time);
+		};
+
+		if (m_Pool) m_Pool->Run(m_Samplers.size(), fn);
+		else for (size_t i = 0; i < m_Samplers.size(); ++i) fn(i);
+
+		// All bands printed the same number of frames:
+		for (size_t i = 1; i < m_Printers.size(); ++i)
+			if (m_Printers[i].m_PrintCount != m_Printers[0].m_PrintCount) BandsOutOfSync = true;
+	}
+
+	size_t GetFrameCount() const
+	{
+		return m_Printers[0].m_PrintCount;
+	}
+
+	/// <remarks>Only the first GetFrameCount() frames are valid.</remarks>
+	std::vector<std::vector<unsigned char>> Frames;
+	bool BandsOutOfSync = false;
+
+private:
+	int m_Pitch;
+	int m_Height;
+	std::vector<int> m_Rows;
+	// By value, neither has a virtual destructor. A deque never moves its
+	// elements when growing, so the samplers can point to the printers:
+	std::deque<CBandPrinter> m_Printers;
+	std::deque<EasyByteSampler> m_Samplers;
+	CAfxWorkerPool * m_Pool = nullptr;
+};
+
+static void FillImage(CAfxTestRandom & random, std::vector<unsigned char> & image)
+{
+	for (size_t i = 0; i < image.size(); ++i) image[i] = (unsigned char)random.Next();
+}
+
+AFX_TEST(AfxWorkerPool_BandsMatchSingleThread)
+{
+	const int width = 97;
+	const int byteWidth = width * 3;
+	const int height = 41;
+	const int pitch = 292;
+
+	static const int threadCounts[] = { 2, 3, 4, 7, 41 };
+
+	for (int method = EasySamplerSettings::ESM_Rectangle; method <= EasySamplerSettings::ESM_Trapezoid; ++method)
+	{
+		CBandedSampler single(byteWidth, height, pitch, (EasySamplerSettings::Method)method, 1.0 / 60, 1);
+
+		std::vector<CBandedSampler *> banded;
+		for (size_t i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); ++i)
+			banded.push_back(new CBandedSampler(byteWidth, height, pitch, (EasySamplerSettings::Method)method, 1.0 / 60, threadCounts[i]));
+
+		CAfxTestRandom random(3);
+		std::vector<unsigned char> image((size_t)height * pitch);
+
+		bool ok = true;
+
+		for (int i = 1; i <= 120; ++i)
+		{
+			FillImage(random, image);
+			single.Sample(image.data(), i / 173.0);
+			for (size_t j = 0; j < banded.size(); ++j) banded[j]->Sample(image.data(), i / 173.0);
+		}
+
+		for (size_t j = 0; j < banded.size() && ok; ++j)
+		{
+			ok = ok && !banded[j]->BandsOutOfSync;
+			ok = ok && single.GetFrameCount() == banded[j]->GetFrameCount();
+
+			for (size_t k = 0; ok && k < single.GetFrameCount(); ++k)
+				for (int iy = 0; ok && iy < height; ++iy)
+					ok = 0 == memcmp(&single.Frames[k][(size_t)iy * pitch], &banded[j]->Frames[k][(size_t)iy * pitch], byteWidth);
+
+			if (!ok) printf("Mismatch for %i threads, method %i.\n", threadCounts[j], method);
+		}
+
+		for (size_t j = 0; j < banded.size(); ++j) delete banded[j];
+
+		AFX_CHECK(ok);
+		AFX_CHECK(0 < single.GetFrameCount());
+	}
+
+	return true;
+}
+
+AFX_BENCHMARK(AfxWorkerPool_SampleBands)
+{
+	const int width = 1920;
+	const int byteWidth = width * 3;
+	const int height = 1080;
+	const int inputs = 60;
+
+	CAfxTestRandom random;
+	std::vector<unsigned char> image((size_t)height * byteWidth);
+	FillImage(random, image);
+
+	int maxThreads = (int)std::thread::hardware_concurrency();
+	if (maxThreads < 1) maxThreads = 1;
+
+	for (int threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		CBandedSampler sampler(byteWidth, height, byteWidth, EasySamplerSettings::ESM_Trapezoid, 1.0 / 60, threads);
+
+		double t0 = AfxTest_Seconds();
+		for (int i = 1; i <= inputs; ++i) sampler.Sample(image.data(), i / 600.0);
+		double t1 = AfxTest_Seconds();
+
+		printf("1080p BGR trapezoid, %2i thread(s): %7.3f ms per input frame\n", threads, 1000.0 * (t1 - t0) / inputs);
+	}
+
+	return true;
+}
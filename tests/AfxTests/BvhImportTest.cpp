@@ -0,0 +1,145 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+// BvhImport needs CamPath (prop submodule) and MSVC's CRT, so these are only
+// built by AfxTests.vcxproj.
+#ifdef _WIN32
+
+#include <shared/bvhimport.h>
+
+#include <stdio.h>
+#include <vector>
+
+#define BVHIMPORTTEST_FILE "AfxTests_BvhImport.bvh"
+
+/// <summary>Value of channel (in file order) in frame.</summary>
+static double BvhImportTest_Value(int frame, int channel)
+{
+	return frame * 10.0 + channel + 0.25;
+}
+
+/// <summary>Writes a BVH file like mirv_campath export / HLAE's cam export, with the channels in the given order.</summary>
+static bool BvhImportTest_Write(char const * channels, int announcedFrames, int frames, bool crLf)
+{
+	FILE * file = fopen(BVHIMPORTTEST_FILE, "wb");
+	if (!file)
+		return false;
+
+	char const * nl = crLf ? "\r\n" : "\n";
+
+	fprintf(file, "HIERARCHY%sROOT MdtCam%s{%s\tOFFSET 0.00 0.00 0.00%s\tCHANNELS 6 %s%s\tEnd Site%s\t{%s\t\tOFFSET 0.00 0.00 -1.00%s\t}%s}%s", nl, nl, nl, nl, channels, nl, nl, nl, nl, nl, nl);
+	fprintf(file, "MOTION%sFrames: %i%sFrame Time: %f%s", nl, announcedFrames, nl, 1.0 / 64, nl);
+
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		fprintf(file, "%f %f %f %f %f %f%s", BvhImportTest_Value(frame, 0), BvhImportTest_Value(frame, 1), BvhImportTest_Value(frame, 2), BvhImportTest_Value(frame, 3), BvhImportTest_Value(frame, 4), BvhImportTest_Value(frame, 5), nl);
+	}
+
+	return 0 == fclose(file);
+}
+
+AFX_TEST(BvhImport_ParsesFrames)
+{
+	// Channel in file order -> BvhChannel_t (Xposition, Yposition, Zposition, Zrotation, Xrotation, Yrotation):
+	static const int channelCodes[6] = { 3, 0, 4, 1, 5, 2 };
+
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		// 100 frames present, more announced, so the ones present are used:
+		AFX_CHECK(BvhImportTest_Write("Zrotation Xposition Xrotation Yposition Yrotation Zposition", 120, 100, 0 == pass));
+
+		BvhImport bvhImport;
+		bool loaded = bvhImport.LoadMotionFile(L"" BVHIMPORTTEST_FILE);
+		remove(BVHIMPORTTEST_FILE);
+		AFX_CHECK(loaded);
+		AFX_CHECK(bvhImport.IsActive());
+
+		double values[6];
+
+		for (int frame = 0; frame < 100; ++frame)
+		{
+			AFX_CHECK(bvhImport.GetCamPosition(frame / 64.0, values));
+
+			for (int channel = 0; channel < 6; ++channel)
+				AFX_CHECK(BvhImportTest_Value(frame, channel) == values[channelCodes[channel]]);
+		}
+
+		AFX_CHECK(!bvhImport.GetCamPosition(-1.0 / 64.0, values));
+		AFX_CHECK(!bvhImport.GetCamPosition(100.0 / 64.0, values));
+
+		CamPath camPath;
+		AFX_CHECK(bvhImport.CopyToCampath(1.0, 90.0, camPath));
+		AFX_CHECK(100 == camPath.GetSize());
+		AFX_CHECK(1.0 == camPath.GetLowerBound());
+		AFX_CHECK(1.0 + 99.0 / 64.0 == camPath.GetUpperBound());
+
+		bvhImport.CloseMotionFile();
+		AFX_CHECK(!bvhImport.IsActive());
+	}
+
+	return true;
+}
+
+AFX_TEST(BvhImport_InflatedFrames)
+{
+	// Way more frames announced than present (and than fit into memory on 32 bit):
+	AFX_CHECK(BvhImportTest_Write("Xposition Yposition Zposition Zrotation Xrotation Yrotation", 2000000000, 10, true));
+
+	BvhImport bvhImport;
+	bool loaded = bvhImport.LoadMotionFile(L"" BVHIMPORTTEST_FILE);
+	remove(BVHIMPORTTEST_FILE);
+	AFX_CHECK(loaded);
+
+	double values[6];
+	AFX_CHECK(bvhImport.GetCamPosition(9.0 / 64.0, values));
+	AFX_CHECK(BvhImportTest_Value(9, 0) == values[0]);
+	AFX_CHECK(!bvhImport.GetCamPosition(10.0 / 64.0, values));
+
+	return true;
+}
+
+AFX_BENCHMARK(BvhImport_Parse)
+{
+	// A long recording, about 52 minutes at 64 fps:
+
+	const int frames = 200000;
+	const int lookups = 1000000;
+
+	AFX_CHECK(BvhImportTest_Write("Xposition Yposition Zposition Zrotation Xrotation Yrotation", frames, frames, true));
+
+	BvhImport bvhImport;
+	CamPath camPath;
+	CAfxTestRandom random(1);
+	double values[6];
+	double sum = 0;
+
+	double t0 = AfxTest_Seconds();
+	bool loaded = bvhImport.LoadMotionFile(L"" BVHIMPORTTEST_FILE);
+
+	double t1 = AfxTest_Seconds();
+	for (int i = 0; i < lookups; ++i)
+	{
+		if (bvhImport.GetCamPosition((random.Next() % frames) / 64.0, values)) sum += values[0];
+	}
+
+	double t2 = AfxTest_Seconds();
+	bool copied = bvhImport.CopyToCampath(0.0, 90.0, camPath);
+
+	double t3 = AfxTest_Seconds();
+
+	remove(BVHIMPORTTEST_FILE);
+
+	AFX_CHECK(loaded && copied);
+	AFX_CHECK(frames == camPath.GetSize());
+	AFX_CHECK(0 != sum);
+
+	printf("%i frames:\n", frames);
+	printf("LoadMotionFile (read and parse): %7.1f ms\n", 1000.0 * (t1 - t0));
+	printf("%i random GetCamPosition:   %7.1f ms\n", lookups, 1000.0 * (t2 - t1));
+	printf("CopyToCampath:                   %7.1f ms\n", 1000.0 * (t3 - t2));
+
+	return true;
+}
+
+#endif
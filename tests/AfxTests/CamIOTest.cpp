@@ -0,0 +1,221 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+// CamIO needs AfxMath (prop submodule) and MSVC's CRT, so these are only
+// built by AfxTests.vcxproj.
+#ifdef _WIN32
+
+#include <AfxHookSource/CamIO.h>
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define CAMIOTEST_FILE "AfxTests_CamIO.cam"
+#define CAMIOTEST_CACHEFILE CAMIOTEST_FILE ".afxcache"
+
+// FovScaling.cpp needs the game, the tests only use SF_None:
+
+double AlienSwarm_FovScaling(double width, double height, double fov)
+{
+	return fov;
+}
+
+double AlienSwarm_InverseFovScaling(double width, double height, double fov)
+{
+	return fov;
+}
+
+/// <summary>Values that are exact in the text format.</summary>
+static void CamIOTest_Frame(int frame, CamIO::CamData & outCamData)
+{
+	outCamData.Time = frame / 64.0;
+	outCamData.XPosition = frame * 0.25;
+	outCamData.YPosition = -frame * 0.5;
+	outCamData.ZPosition = 64.0 + (frame % 100);
+	outCamData.XRotation = 0;
+	outCamData.YRotation = (frame % 40) - 20.0;
+	outCamData.ZRotation = (frame % 100) * 0.5;
+	outCamData.Fov = 90.0 + (frame % 3);
+}
+
+static bool CamIOTest_Write(int frames, bool binary)
+{
+	CamExport camExport(L"" CAMIOTEST_FILE, CamIO::SF_None, binary);
+
+	for (int frame = 0; frame < frames; ++frame)
+	{
+		CamIO::CamData camData;
+		CamIOTest_Frame(frame, camData);
+		camExport.WriteFrame(1920, 1080, camData);
+	}
+
+	return !camExport.IsBad();
+}
+
+static bool CamIOTest_Check(CamImport & camImport, int frames)
+{
+	AFX_CHECK(!camImport.IsBad());
+
+	for (int frame = 0; frame < frames; frame += 7)
+	{
+		CamIO::CamData expected;
+		CamIO::CamData camData;
+		CamIOTest_Frame(frame, expected);
+
+		AFX_CHECK(camImport.GetCamData(expected.Time, 1920, 1080, camData));
+		AFX_CHECK(expected.XPosition == camData.XPosition);
+		AFX_CHECK(expected.YPosition == camData.YPosition);
+		AFX_CHECK(expected.ZPosition == camData.ZPosition);
+		AFX_CHECK(expected.Fov == camData.Fov);
+	}
+
+	CamIO::CamData camData;
+	AFX_CHECK(!camImport.GetCamData(frames / 64.0, 1920, 1080, camData));
+
+	return true;
+}
+
+AFX_TEST(CamImport_BadCacheFrameCount)
+{
+	// Big enough (> 1 MiB) to be cached:
+	const int frames = 20000;
+
+	AFX_CHECK(CamIOTest_Write(frames, false));
+
+	{
+		CamImport camImport(CAMIOTEST_FILE, 0);
+		AFX_CHECK(CamIOTest_Check(camImport, frames));
+	}
+
+	// Frame count follows magic, version, scaleFov, source size and time:
+	const long frameCountOffset = 12 + 4 + 4 + 8 + 8;
+	const int64_t badFrameCounts[3] = { INT64_MAX / 9, frames + 1, frames - 1 };
+
+	for (int i = 0; i < 3; ++i)
+	{
+		FILE * file = fopen(CAMIOTEST_CACHEFILE, "r+b");
+		AFX_CHECK(nullptr != file);
+		AFX_CHECK(0 == fseek(file, frameCountOffset, SEEK_SET));
+		AFX_CHECK(1 == fwrite(&(badFrameCounts[i]), sizeof(int64_t), 1, file));
+		AFX_CHECK(0 == fclose(file));
+
+		// Cache is rejected, the file is parsed (and the cache written) again:
+		CamImport camImport(CAMIOTEST_FILE, 0);
+		AFX_CHECK(CamIOTest_Check(camImport, frames));
+	}
+
+	remove(CAMIOTEST_FILE);
+	remove(CAMIOTEST_CACHEFILE);
+
+	return true;
+}
+
+AFX_BENCHMARK(CamImport_Parse)
+{
+	// About 2 hours at 64 fps:
+
+	const int frames = 500000;
+	const int lookups = 1000000;
+
+	AFX_CHECK(CamIOTest_Write(frames, false));
+	remove(CAMIOTEST_CACHEFILE);
+
+	CAfxTestRandom random(1);
+	CamIO::CamData camData;
+	double sum = 0;
+
+	double t0 = AfxTest_Seconds();
+	CamImport * camImport = new CamImport(CAMIOTEST_FILE, 0); // parses and writes the cache
+
+	double t1 = AfxTest_Seconds();
+	bool bad = camImport->IsBad();
+	delete camImport;
+
+	double t2 = AfxTest_Seconds();
+	camImport = new CamImport(CAMIOTEST_FILE, 0); // loads the cache
+
+	double t3 = AfxTest_Seconds();
+	for (int i = 0; i < lookups; ++i)
+	{
+		if (camImport->GetCamData((random.Next() % frames) / 64.0, 1920, 1080, camData)) sum += camData.XPosition;
+	}
+
+	double t4 = AfxTest_Seconds();
+	bad = bad || camImport->IsBad();
+	delete camImport;
+
+	AFX_CHECK(CamIOTest_Write(frames, true));
+
+	double t5 = AfxTest_Seconds();
+	camImport = new CamImport(CAMIOTEST_FILE, 0);
+
+	double t6 = AfxTest_Seconds();
+	bad = bad || camImport->IsBad();
+	delete camImport;
+
+	remove(CAMIOTEST_FILE);
+	remove(CAMIOTEST_CACHEFILE);
+
+	AFX_CHECK(!bad);
+	AFX_CHECK(0 != sum);
+
+	printf("%i frames:\n", frames);
+	printf("Text (parse and write cache): %7.1f ms\n", 1000.0 * (t1 - t0));
+	printf("Text (load cache):            %7.1f ms\n", 1000.0 * (t3 - t2));
+	printf("Binary:                       %7.1f ms\n", 1000.0 * (t6 - t5));
+	printf("%i random GetCamData:    %7.1f ms\n", lookups, 1000.0 * (t4 - t3));
+
+	return true;
+}
+
+AFX_BENCHMARK(CamExport_WriteFrame)
+{
+	// About 55 minutes at 300 fps:
+
+	const int frames = 1000000;
+
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		bool binary = 1 == pass;
+		double maxWriteFrame = 0;
+
+		double t0 = AfxTest_Seconds();
+		CamExport * camExport = new CamExport(L"" CAMIOTEST_FILE, CamIO::SF_None, binary);
+
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			CamIO::CamData camData;
+			CamIOTest_Frame(frame, camData);
+
+			double t = AfxTest_Seconds();
+			camExport->WriteFrame(1920, 1080, camData);
+			t = AfxTest_Seconds() - t;
+
+			if (maxWriteFrame < t) maxWriteFrame = t;
+		}
+
+		double t1 = AfxTest_Seconds();
+		bool bad = camExport->IsBad();
+		delete camExport; // writes the remaining frames
+
+		double t2 = AfxTest_Seconds();
+
+		CamImport camImport(CAMIOTEST_FILE, 0);
+		bool imported = CamIOTest_Check(camImport, frames);
+
+		remove(CAMIOTEST_FILE);
+		remove(CAMIOTEST_CACHEFILE);
+
+		AFX_CHECK(!bad);
+		AFX_CHECK(imported);
+
+		printf("%s, %i frames:\n", binary ? "Binary" : "Text", frames);
+		printf("WriteFrame:       %7.1f ms, %6.2f M frames/s, max %.3f ms\n", 1000.0 * (t1 - t0), frames / (t1 - t0) / 1000000.0, 1000.0 * maxWriteFrame);
+		printf("Until closed:     %7.1f ms, %6.2f M frames/s\n", 1000.0 * (t2 - t0), frames / (t2 - t0) / 1000000.0);
+	}
+
+	return true;
+}
+
+#endif
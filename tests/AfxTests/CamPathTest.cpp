@@ -0,0 +1,724 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+// CamPath needs AfxMath and rapidxml from the prop submodule and MSVC's CRT,
+// so these are only built by AfxTests.vcxproj.
+#ifdef _WIN32
+
+#include <shared/CamPath.h>
+#include <shared/CamPathTrajectory.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+/// <summary>Path through count random key frames, times increasing by 0.01 to 3 seconds.</summary>
+static void CamPathTest_RandomPath(CAfxTestRandom & random, size_t count, CamPath & outPath)
+{
+	std::vector<double> times(count);
+	std::vector<CamPathValue> values(count);
+
+	double t = 10.0 * random.NextDouble();
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		t += 0.01 + 3.0 * random.NextDouble();
+		times[i] = t;
+		values[i] = CamPathValue(2000.0 * random.NextDouble() - 1000.0, 2000.0 * random.NextDouble() - 1000.0, 500.0 * random.NextDouble()
+			, 180.0 * random.NextDouble() - 90.0, 360.0 * random.NextDouble() - 180.0, 40.0 * random.NextDouble() - 20.0
+			, 60.0 + 50.0 * random.NextDouble());
+		values[i].Selected = random.NextDouble() < 0.5;
+	}
+
+	outPath.AddMany(times.data(), count, values.data());
+}
+
+static void CamPathTest_SetMethods(CamPath & path, int variant)
+{
+	path.PositionInterpMethod_set(1 == variant % 4 || 3 == variant % 4 ? CamPath::DI_LINEAR : CamPath::DI_CUBIC);
+	path.RotationInterpMethod_set(2 == variant % 4 || 3 == variant % 4 ? CamPath::QI_SLINEAR : CamPath::QI_SCUBIC);
+	path.FovInterpMethod_set(3 == variant % 4 ? CamPath::DI_LINEAR : CamPath::DI_CUBIC);
+}
+
+AFX_TEST(CamPath_EvalManySameAsEval)
+{
+	CAfxTestRandom random(20);
+
+	for (int iteration = 0; iteration < 200; ++iteration)
+	{
+		CamPath path;
+		CamPathTest_RandomPath(random, 2 + random.Next() % 40, path);
+		CamPathTest_SetMethods(path, iteration);
+
+		if (!path.CanEval())
+			continue;
+
+		double lower = path.GetLowerBound();
+		double upper = path.GetUpperBound();
+
+		// Increasing times, random times (also outside the key frames) and the key frames themselves:
+		std::vector<double> times(1 + random.Next() % 1000);
+		for (size_t i = 0; i < times.size(); ++i)
+		{
+			switch (iteration % 3)
+			{
+			case 0:
+				times[i] = lower + (upper - lower) * i / (1 < times.size() ? times.size() - 1 : 1);
+				break;
+			case 1:
+				times[i] = lower - 1.0 + (upper - lower + 2.0) * random.NextDouble();
+				break;
+			default:
+				{
+					CamPathIterator it = path.GetBegin();
+					for (size_t j = i % path.GetSize(); 0 < j; --j) ++it;
+					times[i] = it.GetTime();
+				}
+				break;
+			}
+		}
+
+		std::vector<CamPathValue> values(times.size());
+		path.EvalMany(times.data(), times.size(), values.data());
+
+		std::vector<double> x(times.size());
+		std::vector<double> fov(times.size());
+		path.EvalMany(times.data(), times.size(), x.data(), nullptr, nullptr, nullptr, fov.data(), nullptr);
+
+		for (size_t i = 0; i < times.size(); ++i)
+		{
+			CamPathValue expected = path.Eval(times[i]);
+			CamPathValue const & value = values[i];
+
+			AFX_CHECK(expected.X == value.X && expected.Y == value.Y && expected.Z == value.Z && expected.Fov == value.Fov);
+			AFX_CHECK(expected.R.W == value.R.W && expected.R.X == value.R.X && expected.R.Y == value.R.Y && expected.R.Z == value.R.Z);
+			AFX_CHECK(expected.Selected == value.Selected);
+			AFX_CHECK(expected.X == x[i] && expected.Fov == fov[i]);
+		}
+	}
+
+	return true;
+}
+
+/// <summary>
+/// Evaluates a copy of a path's key frames with the AfxMath interpolators
+/// directly, so without the baked segments of CamPath::Eval.
+/// </summary>
+class CCamPathTestReference
+{
+public:
+	CCamPathTestReference(CamPath & path)
+		: m_XView(&m_Map, XSelector)
+		, m_YView(&m_Map, YSelector)
+		, m_ZView(&m_Map, ZSelector)
+		, m_RView(&m_Map, RSelector)
+		, m_FovView(&m_Map, FovSelector)
+		, m_SelectedView(&m_Map, SelectedSelector)
+	{
+		for (CamPathIterator it = path.GetBegin(); it != path.GetEnd(); ++it)
+		{
+			m_Map[it.GetTime()] = it.GetValue();
+		}
+
+		m_XInterp = NewDoubleInterp(path.PositionInterpMethod_get(), &m_XView);
+		m_YInterp = NewDoubleInterp(path.PositionInterpMethod_get(), &m_YView);
+		m_ZInterp = NewDoubleInterp(path.PositionInterpMethod_get(), &m_ZView);
+		m_FovInterp = NewDoubleInterp(path.FovInterpMethod_get(), &m_FovView);
+
+		if (CamPath::QI_SLINEAR == path.RotationInterpMethod_get())
+			m_RInterp = new CSLinearQuaternionInterpolation<CamPathValue>(&m_RView);
+		else
+			m_RInterp = new CSCubicQuaternionInterpolation<CamPathValue>(&m_RView);
+
+		m_SelectedInterp = new CBoolAndInterpolation<CamPathValue>(&m_SelectedView);
+	}
+
+	~CCamPathTestReference()
+	{
+		delete m_SelectedInterp;
+		delete m_FovInterp;
+		delete m_RInterp;
+		delete m_ZInterp;
+		delete m_YInterp;
+		delete m_XInterp;
+	}
+
+	bool CanEval(void)
+	{
+		return m_XInterp->CanEval() && m_YInterp->CanEval() && m_ZInterp->CanEval() && m_RInterp->CanEval() && m_FovInterp->CanEval() && m_SelectedInterp->CanEval();
+	}
+
+	CamPathValue Eval(double t)
+	{
+		CamPathValue result;
+
+		result.X = m_XInterp->Eval(t);
+		result.Y = m_YInterp->Eval(t);
+		result.Z = m_ZInterp->Eval(t);
+		result.R = m_RInterp->Eval(t);
+		result.Fov = m_FovInterp->Eval(t);
+		result.Selected = m_SelectedInterp->Eval(t);
+
+		return result;
+	}
+
+private:
+	static double XSelector(CamPathValue const & value) { return value.X; }
+	static double YSelector(CamPathValue const & value) { return value.Y; }
+	static double ZSelector(CamPathValue const & value) { return value.Z; }
+	static Quaternion RSelector(CamPathValue const & value) { return value.R; }
+	static double FovSelector(CamPathValue const & value) { return value.Fov; }
+	static bool SelectedSelector(CamPathValue const & value) { return value.Selected; }
+
+	static CInterpolation<double> * NewDoubleInterp(CamPath::DoubleInterp method, CInterpolationMapView<CamPathValue, double> * view)
+	{
+		if (CamPath::DI_LINEAR == method)
+			return new CLinearDoubleInterpolation<CamPathValue>(view);
+
+		return new CCubicDoubleInterpolation<CamPathValue>(view);
+	}
+
+	CInterpolationMap<CamPathValue> m_Map;
+
+	CInterpolationMapView<CamPathValue, double> m_XView;
+	CInterpolationMapView<CamPathValue, double> m_YView;
+	CInterpolationMapView<CamPathValue, double> m_ZView;
+	CInterpolationMapView<CamPathValue, Quaternion> m_RView;
+	CInterpolationMapView<CamPathValue, double> m_FovView;
+	CInterpolationMapView<CamPathValue, bool> m_SelectedView;
+
+	CInterpolation<double> * m_XInterp;
+	CInterpolation<double> * m_YInterp;
+	CInterpolation<double> * m_ZInterp;
+	CInterpolation<Quaternion> * m_RInterp;
+	CInterpolation<double> * m_FovInterp;
+	CInterpolation<bool> * m_SelectedInterp;
+};
+
+/// <summary>Positions and fov are world units / degrees up to 1000, this is well below anything visible.</summary>
+const double g_CamPathTestTolerance = 1e-6;
+
+static bool CamPathTest_Near(CamPathValue const & expected, CamPathValue const & value)
+{
+	AFX_CHECK(fabs(expected.X - value.X) <= g_CamPathTestTolerance);
+	AFX_CHECK(fabs(expected.Y - value.Y) <= g_CamPathTestTolerance);
+	AFX_CHECK(fabs(expected.Z - value.Z) <= g_CamPathTestTolerance);
+	AFX_CHECK(fabs(expected.Fov - value.Fov) <= g_CamPathTestTolerance);
+
+	// q and -q are the same rotation:
+	double dot = fabs(DotProduct(expected.R, value.R)) / sqrt(DotProduct(expected.R, expected.R) * DotProduct(value.R, value.R));
+	AFX_CHECK(1.0 - 1e-9 <= dot);
+
+	AFX_CHECK(expected.Selected == value.Selected);
+
+	return true;
+}
+
+/// <summary>Compares Eval and EvalMany against the reference, 64 times per key frame interval, the key frames and outside.</summary>
+static bool CamPathTest_CheckAgainstReference(CamPath & path)
+{
+	CCamPathTestReference reference(path);
+
+	AFX_CHECK(reference.CanEval() == path.CanEval());
+
+	if (!path.CanEval())
+		return true;
+
+	std::vector<double> times;
+
+	double lower = path.GetLowerBound();
+	double upper = path.GetUpperBound();
+
+	times.push_back(lower - 1.0);
+
+	CamPathIterator it = path.GetBegin();
+	double t0 = it.GetTime();
+	for (++it; it != path.GetEnd(); ++it)
+	{
+		double t1 = it.GetTime();
+		for (int i = 0; i < 64; ++i) times.push_back(t0 + (t1 - t0) * i / 64.0);
+		t0 = t1;
+	}
+
+	times.push_back(upper);
+	times.push_back(upper + 1.0);
+
+	std::vector<CamPathValue> values(times.size());
+	path.EvalMany(times.data(), times.size(), values.data());
+
+	for (size_t i = 0; i < times.size(); ++i)
+	{
+		CamPathValue expected = reference.Eval(times[i]);
+
+		AFX_CHECK(CamPathTest_Near(expected, path.Eval(times[i])));
+		AFX_CHECK(CamPathTest_Near(expected, values[i]));
+	}
+
+	return true;
+}
+
+AFX_TEST(CamPath_BakedSameAsInterpolators)
+{
+	CAfxTestRandom random(21);
+
+	for (int iteration = 0; iteration < 80; ++iteration)
+	{
+		CamPath path;
+		CamPathTest_RandomPath(random, 4 + random.Next() % 30, path);
+
+		// All combinations of position, rotation and fov method:
+		path.PositionInterpMethod_set(0 == (iteration & 1) ? CamPath::DI_CUBIC : CamPath::DI_LINEAR);
+		path.RotationInterpMethod_set(0 == (iteration & 2) ? CamPath::QI_SCUBIC : CamPath::QI_SLINEAR);
+		path.FovInterpMethod_set(0 == (iteration & 4) ? CamPath::DI_CUBIC : CamPath::DI_LINEAR);
+
+		AFX_CHECK(path.CanEval());
+		AFX_CHECK(CamPathTest_CheckAgainstReference(path));
+	}
+
+	return true;
+}
+
+class CCamPathTestChanged : public ICamPathChanged
+{
+public:
+	int Count = 0;
+
+	virtual void CamPathChanged(CamPath *) override
+	{
+		++Count;
+	}
+};
+
+AFX_TEST(CamPath_BakedInvalidation)
+{
+	CAfxTestRandom random(22);
+
+	for (int iteration = 0; iteration < 20; ++iteration)
+	{
+		CamPath path;
+		CCamPathTestChanged changed;
+
+		CamPathTest_RandomPath(random, 6 + random.Next() % 20, path);
+		CamPathTest_SetMethods(path, iteration);
+		path.OnChanged_set(&changed);
+
+		// Each edit after the path has been baked by the check before:
+
+		AFX_CHECK(CamPathTest_CheckAgainstReference(path));
+
+		int count = changed.Count;
+		double lower = path.GetLowerBound();
+		double upper = path.GetUpperBound();
+		path.Add(lower + (upper - lower) * random.NextDouble(), CamPathValue(0, 0, 0, 10.0, 20.0, 30.0, 90.0));
+		AFX_CHECK(count < changed.Count);
+		AFX_CHECK(CamPathTest_CheckAgainstReference(path));
+
+		count = changed.Count;
+		{
+			CamPathIterator it = path.GetBegin();
+			for (size_t j = random.Next() % path.GetSize(); 0 < j; --j) ++it;
+			path.Remove(it.GetTime());
+		}
+		AFX_CHECK(count < changed.Count);
+		AFX_CHECK(CamPathTest_CheckAgainstReference(path));
+
+		count = changed.Count;
+		path.SelectAll();
+		path.SetPosition(100.0, -200.0, 300.0);
+		AFX_CHECK(count < changed.Count);
+		AFX_CHECK(CamPathTest_CheckAgainstReference(path));
+
+		count = changed.Count;
+		path.SetFov(75.0);
+		AFX_CHECK(count < changed.Count);
+		AFX_CHECK(CamPathTest_CheckAgainstReference(path));
+
+		count = changed.Count;
+		path.Rotate(5.0, 10.0, -15.0);
+		AFX_CHECK(count < changed.Count);
+		AFX_CHECK(CamPathTest_CheckAgainstReference(path));
+
+		count = changed.Count;
+		CamPathTest_SetMethods(path, iteration + 1);
+		AFX_CHECK(count < changed.Count);
+		AFX_CHECK(CamPathTest_CheckAgainstReference(path));
+
+		count = changed.Count;
+		path.PositionInterpMethod_set(CamPath::DI_LINEAR == path.PositionInterpMethod_get() ? CamPath::DI_CUBIC : CamPath::DI_LINEAR);
+		AFX_CHECK(count < changed.Count);
+		AFX_CHECK(CamPathTest_CheckAgainstReference(path));
+
+		count = changed.Count;
+		path.RotationInterpMethod_set(CamPath::QI_SLINEAR == path.RotationInterpMethod_get() ? CamPath::QI_SCUBIC : CamPath::QI_SLINEAR);
+		AFX_CHECK(count < changed.Count);
+		AFX_CHECK(CamPathTest_CheckAgainstReference(path));
+
+		path.OnChanged_set(nullptr);
+	}
+
+	return true;
+}
+
+AFX_BENCHMARK(CamPath_EvalMany)
+{
+	// 1M increasing times over 500 key frames, like the campath drawer and
+	// mirv_campath export sampling a long path:
+
+	const size_t keys = 500;
+	const size_t samples = 1000 * 1000;
+
+	static char const * const variantNames[] = { "sCubic", "linear position", "sLinear rotation", "linear / sLinear" };
+
+	CAfxTestRandom random(1);
+
+	std::vector<double> times(samples);
+	std::vector<CamPathValue> values(samples);
+	std::vector<double> x(samples);
+	std::vector<double> y(samples);
+	std::vector<double> z(samples);
+	std::vector<double> fov(samples);
+
+	printf("%u samples, %u keys:\n", (unsigned int)samples, (unsigned int)keys);
+
+	for (int variant = 0; variant < 4; ++variant)
+	{
+		CamPath path;
+		CamPathTest_RandomPath(random, keys, path);
+		CamPathTest_SetMethods(path, variant);
+
+		AFX_CHECK(path.CanEval());
+
+		double lower = path.GetLowerBound();
+		double upper = path.GetUpperBound();
+		for (size_t i = 0; i < samples; ++i) times[i] = lower + (upper - lower) * i / (samples - 1);
+
+		// Make sure the path is baked before timing:
+		path.Eval(lower);
+
+		double t0 = AfxTest_Seconds();
+		for (size_t i = 0; i < samples; ++i) values[i] = path.Eval(times[i]);
+
+		double t1 = AfxTest_Seconds();
+		path.EvalMany(times.data(), samples, values.data());
+
+		double t2 = AfxTest_Seconds();
+		path.EvalMany(times.data(), samples, x.data(), y.data(), z.data(), nullptr, fov.data(), nullptr);
+
+		double t3 = AfxTest_Seconds();
+
+		double checkSum = 0;
+		for (size_t i = 0; i < samples; i += 1000) checkSum += values[i].X - x[i];
+		AFX_CHECK(0 == checkSum);
+
+		printf("%-17s Eval loop: %7.1f ms, EvalMany: %7.1f ms, EvalMany position and fov: %7.1f ms\n", variantNames[variant], 1000.0 * (t1 - t0), 1000.0 * (t2 - t1), 1000.0 * (t3 - t2));
+	}
+
+	return true;
+}
+
+// CamPathTrajectory ///////////////////////////////////////////////////////////
+
+struct CamPathTest_TempPoint
+{
+	double T;
+	double X, Y, Z;
+	CamPathTest_TempPoint * NextPt;
+};
+
+static double CamPathTest_ShortestDistanceToSegment(CamPathTest_TempPoint * pt, CamPathTest_TempPoint * start, CamPathTest_TempPoint * end)
+{
+	double ESx = end->X - start->X;
+	double ESy = end->Y - start->Y;
+	double ESz = end->Z - start->Z;
+	double dESdES = ESx*ESx + ESy*ESy + ESz*ESz;
+	double t = dESdES ? (
+		(pt->X - start->X)*ESx + (pt->Y - start->Y)*ESy + (pt->Z - start->Z)*ESz
+	) / dESdES : 0.0;
+
+	double Dx, Dy, Dz;
+
+	if(t <= 0.0)
+	{
+		Dx = start->X - pt->X;
+		Dy = start->Y - pt->Y;
+		Dz = start->Z - pt->Z;
+	}
+	else
+	if(1.0 <= t)
+	{
+		Dx = pt->X - end->X;
+		Dy = pt->Y - end->Y;
+		Dz = pt->Z - end->Z;
+	}
+	else
+	{
+		Dx = pt->X - (start->X + t*(end->X - start->X));
+		Dy = pt->Y - (start->Y + t*(end->Y - start->Y));
+		Dz = pt->Z - (start->Z + t*(end->Z - start->Z));
+	}
+
+	return sqrt(Dx*Dx + Dy*Dy + Dz*Dz);
+}
+
+static void CamPathTest_RamerDouglasPeucker(CamPathTest_TempPoint * start, CamPathTest_TempPoint * end, double epsilon)
+{
+	double dmax = 0;
+	CamPathTest_TempPoint * index = start;
+
+	for(CamPathTest_TempPoint * i = start->NextPt; i && i != end; i = i->NextPt)
+	{
+		double d = CamPathTest_ShortestDistanceToSegment(i, start, end);
+		if(d > dmax)
+		{
+			index = i;
+			dmax = d;
+		}
+	}
+
+	if(dmax > epsilon)
+	{
+		CamPathTest_RamerDouglasPeucker(start, index, epsilon);
+		CamPathTest_RamerDouglasPeucker(index, end, epsilon);
+	}
+	else
+	{
+		start->NextPt = end;
+	}
+}
+
+/// <summary>The trajectory rebuild CCampathDrawer did before CamPathTrajectory_Build: Eval per point and recursive reduction over a linked list.</summary>
+static void CamPathTest_BuildTrajectoryReference(CamPath & camPath, size_t pointsPerInterval, double epsilon, std::vector<double> & outTimes)
+{
+	outTimes.clear();
+
+	std::vector<CamPathTest_TempPoint> pts(pointsPerInterval);
+
+	CamPathIterator last = camPath.GetBegin();
+	CamPathIterator it = last;
+
+	for(++it; it != camPath.GetEnd(); ++it)
+	{
+		double delta = it.GetTime() - last.GetTime();
+
+		for(size_t i = 0; i < pointsPerInterval; ++i)
+		{
+			pts[i].T = last.GetTime() + delta*((double)i/(pointsPerInterval-1));
+			CamPathValue value = camPath.Eval(pts[i].T);
+			pts[i].X = value.X;
+			pts[i].Y = value.Y;
+			pts[i].Z = value.Z;
+			pts[i].NextPt = i+1 < pointsPerInterval ? &(pts[i+1]) : nullptr;
+		}
+
+		CamPathTest_RamerDouglasPeucker(&(pts[0]), &(pts[pointsPerInterval-1]), epsilon);
+
+		for(CamPathTest_TempPoint * pt = &(pts[0]); pt && pt->NextPt; pt = pt->NextPt)
+		{
+			outTimes.push_back(pt->T);
+		}
+
+		last = it;
+	}
+
+	outTimes.push_back(pts[pointsPerInterval-1].T);
+}
+
+AFX_TEST(CamPathTrajectory_WithinEpsilon)
+{
+	CAfxTestRandom random(21);
+
+	const size_t pointsPerInterval = 1024;
+
+	std::vector<double> times;
+	std::vector<double> sampleTimes(pointsPerInterval);
+
+	for (int iteration = 0; iteration < 40; ++iteration)
+	{
+		CamPath path;
+		CamPathTest_RandomPath(random, 2 + random.Next() % 30, path);
+		CamPathTest_SetMethods(path, iteration);
+
+		if (!path.CanEval())
+			continue;
+
+		double epsilon = 0.1 + 5.0 * random.NextDouble();
+
+		CamPathTrajectory_Build(path, pointsPerInterval, epsilon, times);
+
+		AFX_CHECK(path.GetLowerBound() == times.front() && path.GetUpperBound() == times.back());
+
+		// Every sampled point must be within epsilon of the line between the kept points around it:
+
+		size_t kept = 0;
+
+		CamPathIterator last = path.GetBegin();
+		CamPathIterator it = last;
+
+		for (++it; it != path.GetEnd(); ++it)
+		{
+			double delta = it.GetTime() - last.GetTime();
+
+			for (size_t i = 0; i < pointsPerInterval; ++i)
+				sampleTimes[i] = last.GetTime() + delta * ((double)i / (pointsPerInterval - 1));
+
+			AFX_CHECK(kept + 1 < times.size() && sampleTimes[0] == times[kept]);
+
+			for (size_t i = 1; i < pointsPerInterval; ++i)
+			{
+				if (sampleTimes[i] == times[kept + 1])
+				{
+					++kept;
+					continue;
+				}
+
+				AFX_CHECK(sampleTimes[i] < times[kept + 1]);
+
+				CamPathValue s = path.Eval(times[kept]);
+				CamPathValue e = path.Eval(times[kept + 1]);
+				CamPathValue p = path.Eval(sampleTimes[i]);
+
+				double ESx = e.X - s.X, ESy = e.Y - s.Y, ESz = e.Z - s.Z;
+				double dESdES = ESx*ESx + ESy*ESy + ESz*ESz;
+				double t = dESdES ? ((p.X - s.X)*ESx + (p.Y - s.Y)*ESy + (p.Z - s.Z)*ESz) / dESdES : 0.0;
+				if (t < 0.0) t = 0.0; else if (1.0 < t) t = 1.0;
+
+				double Dx = p.X - s.X - t*ESx, Dy = p.Y - s.Y - t*ESy, Dz = p.Z - s.Z - t*ESz;
+
+				AFX_CHECK(sqrt(Dx*Dx + Dy*Dy + Dz*Dz) <= epsilon * (1.0 + 1e-9));
+			}
+
+			last = it;
+		}
+
+		AFX_CHECK(kept + 1 == times.size());
+	}
+
+	return true;
+}
+
+AFX_TEST(CamPathTrajectory_CacheSameAsRebuild)
+{
+	const size_t pointsPerInterval = 256;
+	const double epsilon = 1.0;
+
+	CAfxTestRandom random(23);
+
+	for (int iteration = 0; iteration < 40; ++iteration)
+	{
+		CamPath path;
+		CamPathTest_RandomPath(random, 4 + random.Next() % 30, path);
+		CamPathTest_SetMethods(path, iteration);
+
+		CCamPathTrajectoryCache cache;
+		std::vector<double> times;
+		std::vector<double> expected;
+
+		CamPathTrajectory_Build(path, pointsPerInterval, epsilon, cache, times);
+		AFX_CHECK(path.GetSize() - 1 == cache.GetReducedCount());
+
+		// Nothing changed, nothing to reduce:
+		CamPathTrajectory_Build(path, pointsPerInterval, epsilon, cache, times);
+		AFX_CHECK(0 == cache.GetReducedCount());
+
+		CamPathTrajectory_Build(path, pointsPerInterval, epsilon, expected);
+		AFX_CHECK(expected == times);
+
+		for (int edit = 0; edit < 3; ++edit)
+		{
+			CamPathIterator it = path.GetBegin();
+			for (size_t j = random.Next() % path.GetSize(); 0 < j; --j) ++it;
+
+			CamPathValue value = it.GetValue();
+			value.X += 100.0;
+
+			switch (edit)
+			{
+			case 0: // Change one key:
+				path.Add(it.GetTime(), value);
+				break;
+			case 1: // Add one key:
+				path.Add(path.GetLowerBound() + (path.GetUpperBound() - path.GetLowerBound()) * random.NextDouble(), value);
+				break;
+			default: // Remove one key:
+				path.Remove(it.GetTime());
+				break;
+			}
+
+			if (path.GetSize() < 2 || !path.CanEval())
+				break;
+
+			CamPathTrajectory_Build(path, pointsPerInterval, epsilon, cache, times);
+			CamPathTrajectory_Build(path, pointsPerInterval, epsilon, expected);
+			AFX_CHECK(expected == times);
+
+			// Linear position only depends on the keys of the interval, but
+			// the first sample of the interval after the change is evaluated
+			// on the end of the baked segment before it, so can round differently:
+			if (CamPath::DI_LINEAR == path.PositionInterpMethod_get())
+				AFX_CHECK(cache.GetReducedCount() <= 3);
+		}
+
+		// Other parameters don't use the cached results:
+		if (2 <= path.GetSize() && path.CanEval())
+		{
+			CamPathTrajectory_Build(path, pointsPerInterval, 2.0 * epsilon, cache, times);
+			AFX_CHECK(path.GetSize() - 1 == cache.GetReducedCount());
+		}
+	}
+
+	return true;
+}
+
+AFX_BENCHMARK(CamPathTrajectory_Build)
+{
+	// What CCampathDrawer does after each change of a path with 200 key frames:
+
+	const size_t keys = 200;
+	const size_t pointsPerInterval = 1024;
+	const double epsilon = 1.0;
+
+	CAfxTestRandom random(1);
+
+	CamPath path;
+	CamPathTest_RandomPath(random, keys, path);
+	path.Eval(path.GetLowerBound());
+
+	std::vector<double> expected;
+	std::vector<double> times;
+
+	double t0 = AfxTest_Seconds();
+	CamPathTest_BuildTrajectoryReference(path, pointsPerInterval, epsilon, expected);
+
+	double t1 = AfxTest_Seconds();
+	CamPathTrajectory_Build(path, pointsPerInterval, epsilon, times);
+
+	double t2 = AfxTest_Seconds();
+
+	// Dragging one key frame, the drawer's cache is filled from the last change:
+
+	CCamPathTrajectoryCache cache;
+	CamPathTrajectory_Build(path, pointsPerInterval, epsilon, cache, times);
+
+	CamPathIterator it = path.GetBegin();
+	for (size_t i = keys / 2; 0 < i; --i) ++it;
+	CamPathValue value = it.GetValue();
+	value.X += 10.0;
+	path.Add(it.GetTime(), value);
+	path.Eval(path.GetLowerBound());
+
+	double t3 = AfxTest_Seconds();
+	CamPathTrajectory_Build(path, pointsPerInterval, epsilon, cache, times);
+
+	double t4 = AfxTest_Seconds();
+
+	// The kept points can differ where distances are (nearly) tied, since the old code rounds differently:
+	printf("%u keys, %u points per interval:\n", (unsigned int)keys, (unsigned int)pointsPerInterval);
+	printf("Eval and recursive list (old): %7.1f ms, %u points kept\n", 1000.0 * (t1 - t0), (unsigned int)expected.size());
+	printf("CamPathTrajectory_Build:       %7.1f ms, %u points kept\n", 1000.0 * (t2 - t1), (unsigned int)times.size());
+	printf("After changing one key, cached: %6.1f ms, %u intervals reduced\n", 1000.0 * (t4 - t3), (unsigned int)cache.GetReducedCount());
+
+	return true;
+}
+
+#endif
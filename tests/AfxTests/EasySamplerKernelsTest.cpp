@@ -0,0 +1,190 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+#include <shared/EasySamplerKernels.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+static void RandomBytes(CAfxTestRandom & random, std::vector<unsigned char> & out, size_t count)
+{
+	out.resize(count);
+	for (size_t i = 0; i < count; ++i) out[i] = (unsigned char)random.Next();
+}
+
+static void RandomFloats(CAfxTestRandom & random, std::vector<float> & out, size_t count, float scale)
+{
+	out.resize(count);
+	for (size_t i = 0; i < count; ++i) out[i] = (float)(scale * random.NextDouble());
+}
+
+static bool SameFloats(std::vector<float> const & a, std::vector<float> const & b)
+{
+	return a.size() == b.size() && 0 == memcmp(a.data(), b.data(), a.size() * sizeof(float));
+}
+
+/// <summary>Checks that kernels gives bit-identical results to the scalar kernels.</summary>
+static bool CheckKernels(EasySamplerKernels const * kernels, int width, int height, int pitch)
+{
+	EasySamplerKernels const * scalar = EasySamplerKernels::Get(EasySamplerKernels::EK_Scalar);
+
+	CAfxTestRandom random(width * 7919 + height * 31 + pitch);
+
+	size_t count = (size_t)width * height;
+	float w = (float)random.NextDouble();
+
+	std::vector<unsigned char> sampleA;
+	std::vector<unsigned char> sampleB;
+	RandomBytes(random, sampleA, (size_t)pitch * height);
+	RandomBytes(random, sampleB, (size_t)pitch * height);
+
+	std::vector<float> frameInit;
+	RandomFloats(random, frameInit, count, 1000.0f);
+
+	std::vector<float> expected;
+	std::vector<float> actual;
+
+	expected = frameInit; actual = frameInit;
+	scalar->Byte_Fn_1(expected.data(), sampleA.data(), width, height, pitch);
+	kernels->Byte_Fn_1(actual.data(), sampleA.data(), width, height, pitch);
+	AFX_CHECK(SameFloats(expected, actual));
+
+	expected = frameInit; actual = frameInit;
+	scalar->Byte_Fn_2(expected.data(), sampleA.data(), w, width, height, pitch);
+	kernels->Byte_Fn_2(actual.data(), sampleA.data(), w, width, height, pitch);
+	AFX_CHECK(SameFloats(expected, actual));
+
+	expected = frameInit; actual = frameInit;
+	scalar->Byte_Fn_4(expected.data(), sampleA.data(), sampleB.data(), w, width, height, pitch);
+	kernels->Byte_Fn_4(actual.data(), sampleA.data(), sampleB.data(), w, width, height, pitch);
+	AFX_CHECK(SameFloats(expected, actual));
+
+	{
+		// Also covers values that wrap around in the (unsigned char) cast.
+		std::vector<unsigned char> outExpected(sampleA);
+		std::vector<unsigned char> outActual(sampleA);
+		float printW = 0.37f;
+		scalar->Byte_Print(outExpected.data(), frameInit.data(), printW, width, height, pitch);
+		kernels->Byte_Print(outActual.data(), frameInit.data(), printW, width, height, pitch);
+		AFX_CHECK(outExpected == outActual);
+	}
+
+	std::vector<float> floatA;
+	std::vector<float> floatB;
+	RandomFloats(random, floatA, count, 1.0f);
+	RandomFloats(random, floatB, count, 1.0f);
+
+	expected = frameInit; actual = frameInit;
+	scalar->Float_Fn_1(expected.data(), floatA.data(), count);
+	kernels->Float_Fn_1(actual.data(), floatA.data(), count);
+	AFX_CHECK(SameFloats(expected, actual));
+
+	expected = frameInit; actual = frameInit;
+	scalar->Float_Fn_2(expected.data(), floatA.data(), w, count);
+	kernels->Float_Fn_2(actual.data(), floatA.data(), w, count);
+	AFX_CHECK(SameFloats(expected, actual));
+
+	expected = frameInit; actual = frameInit;
+	scalar->Float_Fn_4(expected.data(), floatA.data(), floatB.data(), w, count);
+	kernels->Float_Fn_4(actual.data(), floatA.data(), floatB.data(), w, count);
+	AFX_CHECK(SameFloats(expected, actual));
+
+	expected.assign(count, 0.0f); actual.assign(count, 0.0f);
+	scalar->Float_Print(expected.data(), frameInit.data(), w, count);
+	kernels->Float_Print(actual.data(), frameInit.data(), w, count);
+	AFX_CHECK(SameFloats(expected, actual));
+
+	expected = frameInit; actual = frameInit;
+	scalar->Scale(expected.data(), w, count);
+	kernels->Scale(actual.data(), w, count);
+	AFX_CHECK(SameFloats(expected, actual));
+
+	return true;
+}
+
+AFX_TEST(EasySamplerKernels_BitExact)
+{
+	static const int sizes[][3] = {
+		// width, height, pitch
+		{ 1, 1, 1 },
+		{ 15, 3, 16 },
+		{ 16, 2, 16 },
+		{ 17, 5, 20 },
+		{ 33, 7, 36 },
+		{ 1920 * 3, 4, 1920 * 3 },
+		{ 1279 * 3, 3, 1280 * 3 },
+	};
+
+	for (int kind = EasySamplerKernels::EK_Scalar; kind <= EasySamplerKernels::EK_Avx2; ++kind)
+	{
+		if (!EasySamplerKernels::IsSupported((EasySamplerKernels::Kind)kind))
+		{
+			printf("Skipping %s, not supported by CPU.\n", EasySamplerKernels::GetName((EasySamplerKernels::Kind)kind));
+			continue;
+		}
+
+		EasySamplerKernels const * kernels = EasySamplerKernels::Get((EasySamplerKernels::Kind)kind);
+		AFX_CHECK(kind == kernels->Type);
+
+		for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+		{
+			AFX_CHECK(CheckKernels(kernels, sizes[i][0], sizes[i][1], sizes[i][2]));
+		}
+	}
+
+	return true;
+}
+
+AFX_TEST(EasySamplerKernels_Get)
+{
+	AFX_CHECK(EasySamplerKernels::GetBestSupported() == EasySamplerKernels::Get(EasySamplerKernels::EK_Auto)->Type);
+	AFX_CHECK(EasySamplerKernels::EK_Scalar == EasySamplerKernels::Get(EasySamplerKernels::EK_Scalar)->Type);
+
+	// Invalid values resolve like EK_Auto:
+	AFX_CHECK(EasySamplerKernels::GetBestSupported() == EasySamplerKernels::Get((EasySamplerKernels::Kind)-1)->Type);
+
+	return true;
+}
+
+AFX_BENCHMARK(EasySamplerKernels)
+{
+	const int width = 1920 * 3;
+	const int height = 1080;
+	const int rounds = 20;
+	size_t count = (size_t)width * height;
+
+	CAfxTestRandom random;
+	std::vector<unsigned char> sampleA;
+	std::vector<unsigned char> sampleB;
+	RandomBytes(random, sampleA, count);
+	RandomBytes(random, sampleB, count);
+	std::vector<float> frame(count, 0.0f);
+
+	for (int kind = EasySamplerKernels::EK_Scalar; kind <= EasySamplerKernels::EK_Avx2; ++kind)
+	{
+		if (!EasySamplerKernels::IsSupported((EasySamplerKernels::Kind)kind)) continue;
+
+		EasySamplerKernels const * kernels = EasySamplerKernels::Get((EasySamplerKernels::Kind)kind);
+
+		double t0 = AfxTest_Seconds();
+		for (int i = 0; i < rounds; ++i)
+			kernels->Byte_Fn_2(frame.data(), sampleA.data(), 0.5f, width, height, width);
+		double t1 = AfxTest_Seconds();
+		for (int i = 0; i < rounds; ++i)
+			kernels->Byte_Fn_4(frame.data(), sampleA.data(), sampleB.data(), 0.25f, width, height, width);
+		double t2 = AfxTest_Seconds();
+		for (int i = 0; i < rounds; ++i)
+			kernels->Byte_Print(sampleB.data(), frame.data(), 0.01f, width, height, width);
+		double t3 = AfxTest_Seconds();
+
+		printf("%-6s 1080p BGR: Byte_Fn_2 %7.3f ms, Byte_Fn_4 %7.3f ms, Byte_Print %7.3f ms\n",
+			EasySamplerKernels::GetName((EasySamplerKernels::Kind)kind),
+			1000.0 * (t1 - t0) / rounds,
+			1000.0 * (t2 - t1) / rounds,
+			1000.0 * (t3 - t2) / rounds);
+	}
+
+	return true;
+}
@@ -0,0 +1,424 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+#include <shared/EasySampler.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// CRefSampler /////////////////////////////////////////////////////////////////
+
+/// <summary>
+///   Straight scalar copy of the sampling as it was before the kernels were
+///   added and before the weights of a sample were accumulated (each
+///   sub-interval is applied on its own, both samples every time), used as
+///   the reference the samplers have to match.
+/// </summary>
+/// <remarks>
+///   The samplers sum a sample's weights before applying it once, which
+///   rounds differently, so they only have to match within
+///   g_SamplerTestFloatTolerance (relative) and g_SamplerTestByteTolerance.
+/// </remarks>
+template<typename T> class CRefSampler
+{
+public:
+	CRefSampler(EasySamplerSettings const & settings, int pitch, float whitePointUnit)
+		: m_Settings(settings)
+		, m_Pitch(pitch)
+		, m_WhitePointUnit(whitePointUnit)
+		, m_Frame((size_t)settings.Width_get() * settings.Height_get(), 0.0f)
+		, m_Print((size_t)settings.Height_get() * pitch, T(0))
+	{
+		bool twoPoint = EasySamplerSettings::ESM_Trapezoid == settings.Method_get();
+		double exposure = settings.Exposure_get();
+
+		if (twoPoint) m_LastSample.resize((size_t)settings.Height_get() * pitch);
+
+		m_FrameDuration = settings.FrameDuration_get();
+		m_LastFrameTime = settings.StartTime_get();
+		m_LastSampleTime = settings.StartTime_get();
+		m_ShutterOpen = 0.0 < exposure;
+		m_ShutterOpenDuration = m_FrameDuration * (exposure < 0 ? 0 : (exposure > 1 ? 1 : exposure));
+		m_ShutterTime = m_LastFrameTime;
+	}
+
+	void Sample(T const * data, double time)
+	{
+		m_CurSample = data;
+
+		double subMin = m_LastSampleTime;
+
+		while (subMin < time)
+		{
+			double subMax = time;
+
+			double shutterEvent = m_ShutterTime + (m_ShutterOpen ? m_ShutterOpenDuration : m_FrameDuration);
+			double frameEnd = m_LastFrameTime + m_FrameDuration;
+
+			if (subMin < frameEnd && frameEnd <= subMax) subMax = frameEnd;
+			if (subMin < shutterEvent && shutterEvent <= subMax) subMax = shutterEvent;
+
+			if (m_ShutterOpen) Integrator_Fn(m_HasLastSample ? m_LastSample.data() : 0, m_CurSample, m_LastSampleTime, time, subMin, subMax);
+
+			if (subMin < frameEnd && frameEnd <= subMax)
+			{
+				PrintFrame();
+				ScaleFrame(1.0f - m_Settings.FrameStrength_get());
+				m_LastFrameTime = subMax;
+			}
+
+			if (subMin < shutterEvent && shutterEvent <= subMax)
+			{
+				if (0.0f < m_ShutterOpenDuration && m_ShutterOpenDuration < m_FrameDuration)
+				{
+					m_ShutterOpen = !m_ShutterOpen;
+					if (m_ShutterOpen) m_ShutterTime = subMax;
+				}
+			}
+
+			subMin = subMax;
+		}
+
+		m_LastSampleTime = time;
+
+		if (!m_LastSample.empty() && data)
+		{
+			memcpy(m_LastSample.data(), data, m_LastSample.size() * sizeof(T));
+			m_HasLastSample = true;
+		}
+		else
+			m_HasLastSample = false;
+	}
+
+	std::vector<std::vector<T>> Frames;
+
+private:
+	EasySamplerSettings m_Settings;
+	int m_Pitch;
+	float m_WhitePointUnit;
+	std::vector<float> m_Frame;
+	float m_WhitePoint = 0;
+	std::vector<T> m_Print;
+	std::vector<T> m_LastSample;
+	bool m_HasLastSample = false;
+	T const * m_CurSample = nullptr;
+
+	double m_FrameDuration;
+	double m_LastFrameTime;
+	double m_LastSampleTime;
+	bool m_ShutterOpen;
+	double m_ShutterOpenDuration;
+	double m_ShutterTime;
+
+	static unsigned int Sum(unsigned char a, unsigned char b) { return (unsigned int)a + (unsigned int)b; }
+	static float Sum(float a, float b) { return a + b; }
+	static unsigned char Out(unsigned char, float value) { return (unsigned char)value; }
+	static float Out(float, float value) { return value; }
+
+	void Fn_1(T const * s)
+	{
+		Apply([&](float f, size_t i) { return f + s[i]; });
+		m_WhitePoint += m_WhitePointUnit;
+	}
+
+	void Fn_2(T const * s, float w)
+	{
+		Apply([&](float f, size_t i) { return f + w * s[i]; });
+		m_WhitePoint += w * m_WhitePointUnit;
+	}
+
+	void Fn_4(T const * a, T const * b, float w)
+	{
+		Apply([&](float f, size_t i) { return f + w * Sum(a[i], b[i]); });
+		m_WhitePoint += w * 2.0f * m_WhitePointUnit;
+	}
+
+	template<typename F> void Apply(F fn)
+	{
+		int width = m_Settings.Width_get();
+
+		for (int iy = 0; iy < m_Settings.Height_get(); ++iy)
+			for (int ix = 0; ix < width; ++ix)
+				m_Frame[(size_t)iy * width + ix] = fn(m_Frame[(size_t)iy * width + ix], (size_t)iy * m_Pitch + ix);
+	}
+
+	void PrintFrame()
+	{
+		int width = m_Settings.Width_get();
+		float w = m_WhitePoint;
+
+		if (0 != w) w = m_WhitePointUnit / w;
+
+		for (int iy = 0; iy < m_Settings.Height_get(); ++iy)
+			for (int ix = 0; ix < width; ++ix)
+				m_Print[(size_t)iy * m_Pitch + ix] = 0 == m_WhitePoint ? T(0) : Out(T(0), w * m_Frame[(size_t)iy * width + ix]);
+
+		Frames.push_back(m_Print);
+	}
+
+	void ScaleFrame(float factor)
+	{
+		float w = m_WhitePoint;
+
+		if (w * factor == w) return;
+
+		if (0 == w * factor)
+		{
+			m_WhitePoint = 0;
+			for (size_t i = 0; i < m_Frame.size(); ++i) m_Frame[i] = 0;
+			return;
+		}
+
+		m_WhitePoint *= factor;
+
+		for (size_t i = 0; i < m_Frame.size(); ++i) m_Frame[i] = factor * m_Frame[i];
+	}
+
+	void Integrator_Fn(T const * sampleA, T const * sampleB, double timeA, double timeB, double subTimeA, double subTimeB)
+	{
+		double dAB = timeB - timeA;
+		double w1 = (subTimeB - subTimeA) / 2.0;
+		double w2 = dAB ? (subTimeA + subTimeB - 2.0 * timeA) / dAB : 0.0;
+		double weightA = w1 * (2 - w2);
+		double weightB = w1 * w2;
+
+		if (0 == weightA)
+		{
+			weightA = weightB;
+			weightB = 0;
+			sampleA = sampleB;
+			sampleB = 0;
+		}
+
+		if (0 == weightA) return;
+
+		if (0 == sampleA)
+		{
+			sampleA = sampleB;
+			sampleB = 0;
+			weightA = weightA + weightB;
+			weightB = 0;
+		}
+
+		if (0 == sampleA) return;
+
+		if (0 == sampleB || 0 == weightB)
+		{
+			if (1 == weightA) Fn_1(sampleA);
+			else Fn_2(sampleA, (float)weightA);
+		}
+		else if (weightA == weightB)
+		{
+			if (1 == weightA)
+			{
+				Fn_1(sampleA);
+				Fn_1(sampleB);
+			}
+			else
+				Fn_4(sampleA, sampleB, (float)weightA);
+		}
+		else
+		{
+			if (1 == weightB)
+			{
+				T const * tS = sampleA;
+				double tW = weightA;
+				sampleA = sampleB;
+				sampleB = tS;
+				weightA = weightB;
+				weightB = tW;
+			}
+
+			if (1 == weightA) Fn_1(sampleA);
+			else Fn_2(sampleA, (float)weightA);
+			Fn_2(sampleB, (float)weightB);
+		}
+	}
+};
+
+// Test ////////////////////////////////////////////////////////////////////////
+
+class CCollectBytes : public IFramePrinter
+{
+public:
+	CCollectBytes(int width, int height, int pitch) : m_Width(width), m_Height(height), m_Pitch(pitch) {}
+
+	virtual void Print(unsigned char const * data) override
+	{
+		// Only the bytes within width are defined.
+		std::vector<unsigned char> frame((size_t)m_Height * m_Pitch, 0);
+		for (int iy = 0; iy < m_Height; ++iy) memcpy(&frame[(size_t)iy * m_Pitch], data + (size_t)iy * m_Pitch, m_Width);
+		Frames.push_back(frame);
+	}
+
+	std::vector<std::vector<unsigned char>> Frames;
+
+private:
+	int m_Width;
+	int m_Height;
+	int m_Pitch;
+};
+
+class CCollectFloats : public IFloatFramePrinter
+{
+public:
+	CCollectFloats(size_t count) : m_Count(count) {}
+
+	virtual void Print(float const * data) override
+	{
+		Frames.push_back(std::vector<float>(data, data + m_Count));
+	}
+
+	std::vector<std::vector<float>> Frames;
+
+private:
+	size_t m_Count;
+};
+
+struct SamplerTestCase
+{
+	EasySamplerSettings::Method Method;
+	double InFps;
+	double OutFps;
+	double Exposure;
+	float FrameStrength;
+	bool Gaps;
+};
+
+static const SamplerTestCase g_SamplerTestCases[] = {
+	{ EasySamplerSettings::ESM_Trapezoid, 180, 60, 1.0, 1.0f, false },
+	{ EasySamplerSettings::ESM_Trapezoid, 240, 30, 1.0, 1.0f, false },
+	{ EasySamplerSettings::ESM_Trapezoid, 173, 30, 0.5, 1.0f, false },
+	{ EasySamplerSettings::ESM_Trapezoid, 300, 24, 0.37, 0.6f, false },
+	{ EasySamplerSettings::ESM_Trapezoid, 120, 60, 1.0, 0.25f, true },
+	{ EasySamplerSettings::ESM_Trapezoid, 47, 60, 1.0, 1.0f, false },
+	{ EasySamplerSettings::ESM_Rectangle, 180, 60, 1.0, 1.0f, false },
+	{ EasySamplerSettings::ESM_Rectangle, 173, 30, 0.5, 0.5f, true },
+	{ EasySamplerSettings::ESM_Rectangle, 61, 60, 0.9, 1.0f, false },
+};
+
+static const int g_SamplerTestInputs = 400;
+
+/// <summary>Relative to the value, float rounding of the summed weights (up to about 4 ulp seen).</summary>
+static const float g_SamplerTestFloatTolerance = 2e-6f;
+
+/// <summary>Truncation of a value that moved by a few ulp can give the next lower byte.</summary>
+static const int g_SamplerTestByteTolerance = 1;
+
+static bool CheckByteSampler(SamplerTestCase const & tc, EasySamplerKernels::Kind kernels)
+{
+	const int width = 37 * 3;
+	const int height = 5;
+	const int pitch = 116;
+
+	EasySamplerSettings settings(width, height, tc.Method, 1.0 / tc.OutFps, 0, tc.Exposure, tc.FrameStrength, kernels);
+
+	CCollectBytes printer(width, height, pitch);
+	EasyByteSampler sampler(settings, pitch, &printer);
+	CRefSampler<unsigned char> reference(settings, pitch, 255.0f);
+
+	CAfxTestRandom random(7);
+	std::vector<unsigned char> image((size_t)height * pitch);
+
+	for (int i = 1; i <= g_SamplerTestInputs; ++i)
+	{
+		for (size_t j = 0; j < image.size(); ++j) image[j] = (unsigned char)random.Next();
+
+		bool gap = tc.Gaps && 0 == (random.Next() % 7);
+		double time = i / tc.InFps;
+
+		sampler.Sample(gap ? nullptr : image.data(), time);
+		reference.Sample(gap ? nullptr : image.data(), time);
+	}
+
+	AFX_CHECK(0 < reference.Frames.size());
+	AFX_CHECK(reference.Frames.size() == printer.Frames.size());
+
+	for (size_t i = 0; i < reference.Frames.size(); ++i)
+	{
+		// Only compare the bytes within width:
+		for (int iy = 0; iy < height; ++iy)
+		{
+			for (int ix = 0; ix < width; ++ix)
+			{
+				int expected = reference.Frames[i][(size_t)iy * pitch + ix];
+				int value = printer.Frames[i][(size_t)iy * pitch + ix];
+
+				AFX_CHECK(abs(expected - value) <= g_SamplerTestByteTolerance);
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool CheckFloatSampler(SamplerTestCase const & tc, EasySamplerKernels::Kind kernels)
+{
+	const int width = 23;
+	const int height = 4;
+	size_t count = (size_t)width * height;
+
+	EasySamplerSettings settings(width, height, tc.Method, 1.0 / tc.OutFps, 0, tc.Exposure, tc.FrameStrength, kernels);
+
+	CCollectFloats printer(count);
+	EasyFloatSampler sampler(settings, &printer);
+	CRefSampler<float> reference(settings, width, 1.0f);
+
+	CAfxTestRandom random(11);
+	std::vector<float> image(count);
+
+	for (int i = 1; i <= g_SamplerTestInputs; ++i)
+	{
+		for (size_t j = 0; j < image.size(); ++j) image[j] = (float)random.NextDouble();
+
+		bool gap = tc.Gaps && 0 == (random.Next() % 7);
+		double time = i / tc.InFps;
+
+		sampler.Sample(gap ? nullptr : image.data(), time);
+		reference.Sample(gap ? nullptr : image.data(), time);
+	}
+
+	AFX_CHECK(0 < reference.Frames.size());
+	AFX_CHECK(reference.Frames.size() == printer.Frames.size());
+
+	for (size_t i = 0; i < reference.Frames.size(); ++i)
+	{
+		for (size_t j = 0; j < count; ++j)
+		{
+			float expected = reference.Frames[i][j];
+
+			AFX_CHECK(fabs(expected - printer.Frames[i][j]) <= g_SamplerTestFloatTolerance * (1.0f + fabs(expected)));
+		}
+	}
+
+	return true;
+}
+
+AFX_TEST(EasySampler_MatchesReference)
+{
+	for (int kind = EasySamplerKernels::EK_Scalar; kind <= EasySamplerKernels::EK_Avx2; ++kind)
+	{
+		if (!EasySamplerKernels::IsSupported((EasySamplerKernels::Kind)kind)) continue;
+
+		for (size_t i = 0; i < sizeof(g_SamplerTestCases) / sizeof(g_SamplerTestCases[0]); ++i)
+		{
+			if (!CheckByteSampler(g_SamplerTestCases[i], (EasySamplerKernels::Kind)kind))
+			{
+				printf("Byte sampler, kernels %s, case %i.\n", EasySamplerKernels::GetName((EasySamplerKernels::Kind)kind), (int)i);
+				return false;
+			}
+
+			if (!CheckFloatSampler(g_SamplerTestCases[i], (EasySamplerKernels::Kind)kind))
+			{
+				printf("Float sampler, kernels %s, case %i.\n", EasySamplerKernels::GetName((EasySamplerKernels::Kind)kind), (int)i);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
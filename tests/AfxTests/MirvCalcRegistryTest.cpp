@@ -0,0 +1,186 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+#include <AfxHookSource/MirvCalcRegistry.h>
+
+#include <windows.h>
+
+#include <stdio.h>
+#include <list>
+#include <string>
+#include <vector>
+
+class CMirvCalcRegistryTestCalc
+{
+public:
+	CMirvCalcRegistryTestCalc(char const * name) : m_Name(name)
+	{
+	}
+
+	char const * GetName(void)
+	{
+		return m_Name.c_str();
+	}
+
+private:
+	std::string m_Name;
+};
+
+/// <summary>Name like interop scripts use, in mixed case.</summary>
+static std::string MirvCalcRegistryTest_Name(int index)
+{
+	char name[64];
+	snprintf(name, sizeof(name), "Interop_Cam_%i_TargetOffset", index);
+	return name;
+}
+
+AFX_TEST(MirvCalcRegistry_StableIds)
+{
+	std::vector<CMirvCalcRegistryTestCalc *> calcs;
+	CMirvCalcRegistry<CMirvCalcRegistryTestCalc> registry;
+
+	for (int i = 0; i < 10; ++i)
+	{
+		calcs.push_back(new CMirvCalcRegistryTestCalc(MirvCalcRegistryTest_Name(i).c_str()));
+		registry.Add(calcs.back());
+	}
+
+	int ids[10];
+
+	for (int i = 0; i < 10; ++i)
+	{
+		ids[i] = registry.GetId(MirvCalcRegistryTest_Name(i).c_str());
+		AFX_CHECK(0 != ids[i]);
+		AFX_CHECK(calcs[i] == registry.GetById(ids[i]));
+		AFX_CHECK(calcs[i] == *registry.Find(MirvCalcRegistryTest_Name(i).c_str()));
+
+		for (int j = 0; j < i; ++j) AFX_CHECK(ids[j] != ids[i]);
+	}
+
+	// Case-insensitive:
+	AFX_CHECK(ids[3] == registry.GetId("interop_cam_3_targetoffset"));
+	AFX_CHECK(ids[3] == registry.GetId("INTEROP_CAM_3_TARGETOFFSET"));
+
+	AFX_CHECK(0 == registry.GetId("Interop_Cam_10_TargetOffset"));
+	AFX_CHECK(registry.end() == registry.Find("Interop_Cam_10_TargetOffset"));
+	AFX_CHECK(0 == registry.GetById(0));
+	AFX_CHECK(0 == registry.GetById(-1));
+	AFX_CHECK(0 == registry.GetById(1000));
+
+	// Remove some, the others keep their ids:
+
+	registry.Erase(registry.Find(MirvCalcRegistryTest_Name(3).c_str()));
+	registry.Erase(registry.Find(MirvCalcRegistryTest_Name(9).c_str()));
+
+	AFX_CHECK(0 == registry.GetId(MirvCalcRegistryTest_Name(3).c_str()));
+	AFX_CHECK(0 == registry.GetById(ids[3]));
+	AFX_CHECK(0 == registry.GetById(ids[9]));
+
+	for (int i = 0; i < 10; ++i)
+	{
+		if (3 == i || 9 == i) continue;
+
+		AFX_CHECK(ids[i] == registry.GetId(MirvCalcRegistryTest_Name(i).c_str()));
+		AFX_CHECK(calcs[i] == registry.GetById(ids[i]));
+	}
+
+	// Re-adding a removed name (and adding new ones) gives new ids, an id
+	// resolved before the removal must not find the new calc:
+
+	CMirvCalcRegistryTestCalc * readded = new CMirvCalcRegistryTestCalc(MirvCalcRegistryTest_Name(3).c_str());
+	calcs.push_back(readded);
+	registry.Add(readded);
+
+	int readdedId = registry.GetId(MirvCalcRegistryTest_Name(3).c_str());
+	AFX_CHECK(0 != readdedId);
+	AFX_CHECK(readded == registry.GetById(readdedId));
+	AFX_CHECK(0 == registry.GetById(ids[3]));
+
+	for (int i = 0; i < 10; ++i) AFX_CHECK(ids[i] != readdedId);
+
+	// Iteration sees the calcs in order of adding:
+
+	std::list<CMirvCalcRegistryTestCalc *> expected;
+	for (int i = 0; i < 10; ++i) if (3 != i && 9 != i) expected.push_back(calcs[i]);
+	expected.push_back(readded);
+
+	std::list<CMirvCalcRegistryTestCalc *> actual(registry.begin(), registry.end());
+	AFX_CHECK(expected == actual);
+
+	for (size_t i = 0; i < calcs.size(); ++i) delete calcs[i];
+
+	return true;
+}
+
+AFX_BENCHMARK(MirvCalcRegistry_Lookup)
+{
+	// Every registered calc is looked up once per round, like AfxInterop
+	// resolves the calcs of a frame:
+
+	const int lookups = 1000000;
+	const int counts[3] = { 10, 100, 1000 };
+
+	printf("%i lookups, ms:      list scan    by name      by id\n", lookups);
+
+	for (int c = 0; c < 3; ++c)
+	{
+		int count = counts[c];
+
+		std::vector<CMirvCalcRegistryTestCalc *> calcs;
+		std::vector<std::string> names;
+		std::list<CMirvCalcRegistryTestCalc *> list;
+		CMirvCalcRegistry<CMirvCalcRegistryTestCalc> registry;
+
+		for (int i = 0; i < count; ++i)
+		{
+			calcs.push_back(new CMirvCalcRegistryTestCalc(MirvCalcRegistryTest_Name(i).c_str()));
+			names.push_back(MirvCalcRegistryTest_Name(i));
+			list.push_back(calcs.back());
+			registry.Add(calcs.back());
+		}
+
+		std::vector<int> ids;
+		for (int i = 0; i < count; ++i) ids.push_back(registry.GetId(names[i].c_str()));
+
+		size_t found[3] = { 0, 0, 0 };
+
+		// Linear scan with case-insensitive compares, as GetByName did before:
+		double t0 = AfxTest_Seconds();
+		for (int i = 0; i < lookups; ++i)
+		{
+			char const * name = names[i % count].c_str();
+
+			for (std::list<CMirvCalcRegistryTestCalc *>::iterator it = list.begin(); it != list.end(); ++it)
+			{
+				if (0 == _stricmp(name, (*it)->GetName()))
+				{
+					++found[0];
+					break;
+				}
+			}
+		}
+
+		double t1 = AfxTest_Seconds();
+		for (int i = 0; i < lookups; ++i)
+		{
+			if (registry.end() != registry.Find(names[i % count].c_str())) ++found[1];
+		}
+
+		double t2 = AfxTest_Seconds();
+		for (int i = 0; i < lookups; ++i)
+		{
+			if (registry.GetById(ids[i % count])) ++found[2];
+		}
+
+		double t3 = AfxTest_Seconds();
+
+		for (size_t i = 0; i < calcs.size(); ++i) delete calcs[i];
+
+		for (int i = 0; i < 3; ++i) AFX_CHECK((size_t)lookups == found[i]);
+
+		printf("%4i calcs:            %9.1f  %9.1f  %9.1f\n", count, 1000.0 * (t1 - t0), 1000.0 * (t2 - t1), 1000.0 * (t3 - t2));
+	}
+
+	return true;
+}
@@ -0,0 +1,259 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+#include <AfxHookSource/MirvWav.h>
+
+#include <cmath>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define MIRV_WAV_TEST_FILE "AfxTests_MirvWav.wav"
+#define MIRV_WAV_TEST_FILE_W L"AfxTests_MirvWav.wav"
+
+/// <summary>The parts of a written file the tests look at.</summary>
+struct CWavFile
+{
+	bool Read(void)
+	{
+		FILE * file = fopen(MIRV_WAV_TEST_FILE, "rb");
+		if (!file) return false;
+
+		unsigned char header[44];
+		bool ok = 1 == fread(header, sizeof(header), 1, file);
+
+		if (ok)
+		{
+			ok = 0 == memcmp(header, "RIFF", 4)
+				&& 0 == memcmp(header + 8, "WAVE", 4)
+				&& 0 == memcmp(header + 12, "fmt ", 4)
+				&& 16 == GetDword(header + 16)
+				&& 0 == memcmp(header + 36, "data", 4);
+
+			RiffLen = GetDword(header + 4);
+			FormatTag = GetWord(header + 20);
+			Channels = GetWord(header + 22);
+			SamplesPerSec = GetDword(header + 24);
+			AvgBytesPerSec = GetDword(header + 28);
+			BlockAlign = GetWord(header + 32);
+			BitsPerSample = GetWord(header + 34);
+			DataLen = GetDword(header + 40);
+		}
+
+		if (ok)
+		{
+			fseek(file, 0, SEEK_END);
+			FileLen = (size_t)ftell(file);
+			fseek(file, 44, SEEK_SET);
+
+			Data.resize(FileLen - 44);
+			ok = Data.empty() || 1 == fread(Data.data(), Data.size(), 1, file);
+		}
+
+		fclose(file);
+		remove(MIRV_WAV_TEST_FILE);
+
+		return ok;
+	}
+
+	/// <returns>Sample value of the given block and channel, full scale is the range of the format.</returns>
+	double Get(size_t block, int channel) const
+	{
+		unsigned char const * p = &Data[block * BlockAlign + channel * (BitsPerSample / 8)];
+
+		switch (BitsPerSample)
+		{
+		case 16:
+			return (short)GetWord(p);
+		case 24:
+			return (int)((unsigned int)p[0] << 8 | (unsigned int)p[1] << 16 | (unsigned int)p[2] << 24) / 256;
+		case 32:
+			{
+				float value;
+				memcpy(&value, p, sizeof(value));
+				return value;
+			}
+		}
+
+		return 0;
+	}
+
+	DWORD RiffLen = 0;
+	WORD FormatTag = 0;
+	WORD Channels = 0;
+	DWORD SamplesPerSec = 0;
+	DWORD AvgBytesPerSec = 0;
+	WORD BlockAlign = 0;
+	WORD BitsPerSample = 0;
+	DWORD DataLen = 0;
+	size_t FileLen = 0;
+	std::vector<unsigned char> Data;
+
+private:
+	static WORD GetWord(unsigned char const * p)
+	{
+		return (WORD)(p[0] | p[1] << 8);
+	}
+
+	static DWORD GetDword(unsigned char const * p)
+	{
+		return (DWORD)p[0] | (DWORD)p[1] << 8 | (DWORD)p[2] << 16 | (DWORD)p[3] << 24;
+	}
+};
+
+static double MirvWavTest_Expected(CMirvWav::SampleFormat format, float value)
+{
+	switch (format)
+	{
+	case CMirvWav::SF_PCM16:
+		{
+			float fVal = value * 32768.0f;
+			return std::round(fVal < -32768.0f ? -32768.0f : (32767.0f < fVal ? 32767.0f : fVal));
+		}
+	case CMirvWav::SF_PCM24:
+		{
+			double dVal = value * 8388608.0;
+			return std::round(dVal < -8388608.0 ? -8388608.0 : (8388607.0 < dVal ? 8388607.0 : dVal));
+		}
+	case CMirvWav::SF_FLOAT:
+		break;
+	}
+
+	return value;
+}
+
+AFX_TEST(MirvWav_AppendPlanarRoundTrip)
+{
+	static const CMirvWav::SampleFormat formats[] = { CMirvWav::SF_PCM16, CMirvWav::SF_PCM24, CMirvWav::SF_FLOAT };
+	static const WORD formatTags[] = { 1, 1, 3 };
+	static const WORD bits[] = { 16, 24, 32 };
+
+	// More than the 64 KiB write buffer, with a block size that doesn't divide it:
+	const int channels = 6;
+	const int dataChannels = 5; // last channel is filled with silence
+	const size_t samples = 512;
+	const int appends = 20;
+
+	for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+	{
+		CAfxTestRandom random(7);
+		std::vector<float> data((size_t)appends * dataChannels * samples);
+
+		for (size_t i = 0; i < data.size(); ++i)
+		{
+			// Slightly beyond full scale, to test the clamping:
+			data[i] = (float)(2.2 * (random.NextDouble() - 0.5));
+		}
+
+		{
+			CMirvWav wav(MIRV_WAV_TEST_FILE_W, channels, 48000, formats[f]);
+
+			for (int i = 0; i < appends; ++i)
+				wav.AppendPlanar(dataChannels, &data[(size_t)i * dataChannels * samples], samples, 1.0f);
+		}
+
+		CWavFile file;
+		AFX_CHECK(file.Read());
+
+		size_t blocks = appends * samples;
+
+		AFX_CHECK(formatTags[f] == file.FormatTag);
+		AFX_CHECK(channels == file.Channels);
+		AFX_CHECK(48000 == file.SamplesPerSec);
+		AFX_CHECK(bits[f] == file.BitsPerSample);
+		AFX_CHECK(channels * bits[f] / 8 == file.BlockAlign);
+		AFX_CHECK(48000u * file.BlockAlign == file.AvgBytesPerSec);
+		AFX_CHECK(blocks * file.BlockAlign == file.DataLen);
+		AFX_CHECK(file.FileLen == 44 + file.DataLen);
+		AFX_CHECK(file.FileLen - 8 == file.RiffLen);
+
+		bool ok = true;
+
+		for (size_t j = 0; j < blocks && ok; ++j)
+		{
+			size_t append = j / samples;
+			size_t sample = j % samples;
+
+			for (int i = 0; i < channels && ok; ++i)
+			{
+				double expected = i < dataChannels ? MirvWavTest_Expected(formats[f], data[(append * dataChannels + i) * samples + sample]) : 0.0;
+				ok = expected == file.Get(j, i);
+			}
+		}
+
+		AFX_CHECK(ok);
+	}
+
+	return true;
+}
+
+AFX_TEST(MirvWav_AppendRoundTrip)
+{
+	static const CMirvWav::SampleFormat formats[] = { CMirvWav::SF_PCM16, CMirvWav::SF_PCM24, CMirvWav::SF_FLOAT };
+
+	static const short values[] = { 0, 1, -1, 1234, -1234, 32767, -32768 };
+	const int count = sizeof(values) / sizeof(values[0]);
+
+	for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); ++f)
+	{
+		{
+			CMirvWav wav(MIRV_WAV_TEST_FILE_W, 2, 44100, formats[f]);
+
+			for (int i = 0; i < count; ++i)
+			{
+				WORD data = (WORD)values[i];
+				wav.Append(1, &data); // second channel is filled with silence
+			}
+		}
+
+		CWavFile file;
+		AFX_CHECK(file.Read());
+		AFX_CHECK(2 == file.Channels);
+		AFX_CHECK(count * file.BlockAlign == file.DataLen);
+
+		for (int i = 0; i < count; ++i)
+		{
+			double expected;
+
+			switch (formats[f])
+			{
+			case CMirvWav::SF_PCM16:
+				expected = values[i]; // kept as is
+				break;
+			case CMirvWav::SF_PCM24:
+				expected = values[i] * 256.0;
+				break;
+			default:
+				expected = values[i] / 32768.0f;
+				break;
+			}
+
+			AFX_CHECK(expected == file.Get(i, 0));
+			AFX_CHECK(0 == file.Get(i, 1));
+		}
+	}
+
+	return true;
+}
+
+AFX_TEST(MirvWav_OddDataIsPadded)
+{
+	{
+		CMirvWav wav(MIRV_WAV_TEST_FILE_W, 1, 44100, CMirvWav::SF_PCM24);
+		WORD data = 1234;
+		wav.Append(1, &data);
+	}
+
+	CWavFile file;
+	AFX_CHECK(file.Read());
+
+	// RIFF chunks have to be of even size, the pad byte is not part of the data chunk:
+	AFX_CHECK(3 == file.DataLen);
+	AFX_CHECK(44 + 4 == file.FileLen);
+	AFX_CHECK(file.FileLen - 8 == file.RiffLen);
+	AFX_CHECK(1234 * 256 == file.Get(0, 0));
+	AFX_CHECK(0 == file.Data[3]);
+
+	return true;
+}
@@ -0,0 +1,262 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+#include <shared/PatternScanner.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace Afx::BinUtils;
+
+/// <summary>The byte by byte search FindPatternString did before the patterns were compiled.</summary>
+static unsigned char const * PatternScannerTest_FindReference(unsigned char const * first, unsigned char const * last, char const * hexBytePattern)
+{
+	size_t matchDepth = 0;
+	size_t patternPos = 0;
+
+	for (; first < last; ++first)
+	{
+		char cur = *(char const *)first;
+
+		char pat0;
+		do
+		{
+			pat0 = hexBytePattern[patternPos];
+			++patternPos;
+		}
+		while (' ' == pat0);
+
+		char pat1 = 0;
+		if (pat0)
+		{
+			do
+			{
+				pat1 = hexBytePattern[patternPos];
+				++patternPos;
+			} while (' ' == pat1);
+		}
+
+		bool endHi = !pat0;
+		bool endLo = !pat1;
+
+		if (endHi)
+			return first - matchDepth;
+
+		bool wildHi = '?' == pat0 || endHi;
+		bool wildLo = '?' == pat1 || endLo;
+
+		pat0 = ('0' <= pat0 && pat0 <= '9') ? pat0 - '0' : ('A' <= pat0 && pat0 <= 'Z' ? pat0 - 'A' + '\xa' : pat0 - 'a' + '\xa');
+		pat1 = ('0' <= pat1 && pat1 <= '9') ? pat1 - '0' : ('A' <= pat1 && pat1 <= 'Z' ? pat1 - 'A' + '\xa' : pat1 - 'a' + '\xa');
+
+		char matchval = ((pat0 & 0xf) << 4) | (pat1 & 0xF);
+
+		bool match = (wildHi || ((matchval & 0xf0) == (cur & 0xf0))) && (wildLo || ((matchval & 0xf) == (cur & 0xf)));
+
+		if (match)
+			++matchDepth;
+		else
+		{
+			first -= matchDepth;
+			matchDepth = 0;
+			patternPos = 0;
+			continue;
+		}
+
+		if (endHi || endLo || !hexBytePattern[patternPos])
+			return first - matchDepth + 1;
+	}
+
+	return nullptr;
+}
+
+/// <summary>Pattern with random wildcard nibbles, made of bytes from a small alphabet so there are many partial matches.</summary>
+static std::string PatternScannerTest_RandomPattern(CAfxTestRandom & random)
+{
+	static const char hex[] = "0123456789ABCDEF";
+
+	std::string result;
+	size_t length = 1 + random.Next() % 6;
+
+	for (size_t i = 0; i < length; ++i)
+	{
+		unsigned char value = (unsigned char)(0x50 + random.Next() % 3);
+
+		if (0 < i) result += ' ';
+		result += 0 == random.Next() % 6 ? '?' : hex[value >> 4];
+		result += 0 == random.Next() % 6 ? '?' : hex[value & 0xf];
+	}
+
+	return result;
+}
+
+static void PatternScannerTest_RandomData(CAfxTestRandom & random, std::vector<unsigned char> & outData)
+{
+	for (size_t i = 0; i < outData.size(); ++i)
+		outData[i] = (unsigned char)(0x50 + random.Next() % 3);
+}
+
+AFX_TEST(BytePattern_SameAsReference)
+{
+	CAfxTestRandom random(17);
+
+	std::vector<unsigned char> data(200);
+
+	for (int i = 0; i < 50000; ++i)
+	{
+		PatternScannerTest_RandomData(random, data);
+
+		std::string pattern = PatternScannerTest_RandomPattern(random);
+		BytePattern bytePattern(pattern.c_str());
+
+		// Random sub range, so matches at the ends are tested too:
+		size_t first = random.Next() % data.size();
+		size_t last = first + random.Next() % (data.size() - first + 1);
+
+		unsigned char const * expected = PatternScannerTest_FindReference(&data[first], &data[0] + last, pattern.c_str());
+		unsigned char const * result = bytePattern.Find(&data[first], &data[0] + last);
+
+		if (expected != result)
+		{
+			printf("pattern=\"%s\" first=%u last=%u expected=%i result=%i\n", pattern.c_str(), (unsigned int)first, (unsigned int)last
+				, expected ? (int)(expected - &data[0]) : -1, result ? (int)(result - &data[0]) : -1);
+			AFX_CHECK(false);
+		}
+	}
+
+	return true;
+}
+
+AFX_TEST(PatternScanner_SameAsBytePattern)
+{
+	CAfxTestRandom random(3);
+
+	// Bigger than the blocks the scanner processes the memory in:
+	std::vector<unsigned char> data(3 * 1024 * 1024 + 13);
+
+	for (int round = 0; round < 10; ++round)
+	{
+		for (size_t i = 0; i < data.size(); ++i) data[i] = (unsigned char)random.Next();
+
+		PatternScanner scanner;
+		std::vector<std::string> patterns;
+
+		for (int i = 0; i < 8; ++i)
+		{
+			// Plant a pattern at a random position (some get overwritten by later ones or are never planted):
+			std::vector<unsigned char> bytes(4 + random.Next() % 12);
+			for (size_t j = 0; j < bytes.size(); ++j) bytes[j] = (unsigned char)random.Next();
+
+			if (0 != i % 4)
+				memcpy(&data[random.Next() % (data.size() - bytes.size() + 1)], &bytes[0], bytes.size());
+
+			char hex[4];
+			std::string pattern;
+			for (size_t j = 0; j < bytes.size(); ++j)
+			{
+				snprintf(hex, sizeof(hex), "%02X ", bytes[j]);
+				pattern += 0 == random.Next() % 5 ? std::string("?? ") : std::string(hex);
+			}
+
+			patterns.push_back(pattern);
+			AFX_CHECK((size_t)i == scanner.Add(pattern.c_str()));
+		}
+
+		// The pattern at the very end:
+		patterns.push_back("?? ?? ?? ?? ?? ?? ?? ??");
+		scanner.Add(patterns.back().c_str());
+
+		scanner.Scan(&data[0], &data[0] + data.size());
+
+		for (size_t i = 0; i < patterns.size(); ++i)
+		{
+			BytePattern bytePattern(patterns[i].c_str());
+
+			AFX_CHECK(bytePattern.GetSize() == scanner.GetSize(i));
+			AFX_CHECK(bytePattern.Find(&data[0], &data[0] + data.size()) == scanner.GetResult(i));
+			AFX_CHECK((0 == i % 4 && i != patterns.size() - 1) || nullptr != scanner.GetResult(i));
+		}
+	}
+
+	return true;
+}
+
+AFX_BENCHMARK(PatternScanner_Signatures)
+{
+	// The patterns addresses.cpp searches for in whole .text sections, in
+	// 32 MiB of bytes distributed roughly like x86 code, found near the end:
+
+	static char const * const patterns[] = {
+		"0F 84 ?? ?? ?? ?? 8B 0D ?? ?? ?? ?? 8B 81 0C 10 00 00 89 44 24 40 85 C0 74 16 6A 04 6A 00 68 ?? ?? ?? ?? 6A 00 68 ?? ?? ?? ?? FF 15 ?? ?? ?? ?? E8 ?? ?? ?? ??",
+		"8B 0D ?? ?? ?? ?? 53 56 E8 ?? ?? ?? ?? 8B 15 ?? ?? ?? ??",
+		"55 8B EC 81 EC ?? ?? ?? ?? 83 3D ?? ?? ?? ?? 00 53 56 8B D9 57 89 5D ?? 74 ??",
+		"55 8B EC 83 E4 F8 83 EC 0C 53 8B D9 56 57 89 5C 24 0C 8D B3 9C 00 00 00 89 74 24 14 FF 15 ?? ?? ?? ??",
+		"6A 18 68 ?? ?? ?? ?? E8 ?? ?? ?? ?? 8B 7D 08 85 FF 75 08 33 C0 E8 ?? ?? ?? ?? C3"
+	};
+	const size_t count = sizeof(patterns) / sizeof(patterns[0]);
+
+	static const unsigned char common[] = { 0x00, 0x8B, 0xFF, 0x55, 0x89, 0xE8, 0x83, 0xC3, 0xCC, 0x85, 0x74, 0x75, 0x50, 0x56, 0x57, 0x53, 0x6A, 0x0F, 0xEC, 0x45, 0x08, 0x04, 0x01, 0xC0 };
+
+	CAfxTestRandom random(1);
+	std::vector<unsigned char> data(32 * 1024 * 1024);
+
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = 0 == random.Next() % 2 ? common[random.Next() % sizeof(common)] : (unsigned char)random.Next();
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		BytePattern bytePattern(patterns[i]);
+		std::vector<unsigned char> bytes(bytePattern.GetSize(), 0);
+
+		// Fill in the fixed bytes, the wildcards are left 0:
+		size_t pos = 0;
+		for (char const * p = patterns[i]; *p; ++p)
+		{
+			if (' ' == *p) continue;
+			if ('?' != p[0]) bytes[pos] = (unsigned char)strtoul(std::string(p, 2).c_str(), nullptr, 16);
+			++p;
+			++pos;
+		}
+
+		memcpy(&data[data.size() - 1024 * (i + 1)], &bytes[0], bytes.size());
+	}
+
+	unsigned char const * first = &data[0];
+	unsigned char const * last = first + data.size();
+
+	std::vector<unsigned char const *> results[3];
+
+	double t0 = AfxTest_Seconds();
+	for (size_t i = 0; i < count; ++i)
+		results[0].push_back(PatternScannerTest_FindReference(first, last, patterns[i]));
+
+	double t1 = AfxTest_Seconds();
+	for (size_t i = 0; i < count; ++i)
+		results[1].push_back(BytePattern(patterns[i]).Find(first, last));
+
+	double t2 = AfxTest_Seconds();
+	PatternScanner scanner;
+	for (size_t i = 0; i < count; ++i)
+		scanner.Add(patterns[i]);
+	scanner.Scan(first, last);
+	for (size_t i = 0; i < count; ++i)
+		results[2].push_back(scanner.GetResult(i));
+	double t3 = AfxTest_Seconds();
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		AFX_CHECK(&data[data.size() - 1024 * (i + 1)] == results[0][i]);
+		AFX_CHECK(results[0][i] == results[1][i]);
+		AFX_CHECK(results[0][i] == results[2][i]);
+	}
+
+	printf("%i patterns, %i MiB:\n", (int)count, (int)(data.size() / (1024 * 1024)));
+	printf("byte by byte (old FindPatternString): %8.1f ms\n", 1000.0 * (t1 - t0));
+	printf("BytePattern::Find per pattern:        %8.1f ms\n", 1000.0 * (t2 - t1));
+	printf("PatternScanner (FindPatternStrings):  %8.1f ms\n", 1000.0 * (t3 - t2));
+
+	return true;
+}
@@ -0,0 +1,316 @@
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+#include <shared/StringTools.h>
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+static std::string StringToolsTest_RandomString(CAfxTestRandom & random, bool mask)
+{
+	// Small alphabet, so the masks actually match something:
+	static const char chars[] = { 'a', 'b', '/', '_' };
+
+	std::string result;
+	unsigned int length = random.Next() % 8;
+
+	for (unsigned int i = 0; i < length; ++i)
+	{
+		if (mask && 0 == random.Next() % 4)
+			result += 0 == random.Next() % 8 ? "\\\\" : "\\*";
+		else
+			result += chars[random.Next() % sizeof(chars)];
+	}
+
+	return result;
+}
+
+AFX_TEST(StringWildCard1Matcher_SameAsMatched)
+{
+	CAfxTestRandom random(11);
+
+	for (int i = 0; i < 100000; ++i)
+	{
+		std::string mask = StringToolsTest_RandomString(random, true);
+		std::string target = StringToolsTest_RandomString(random, false);
+
+		StringWildCard1Matcher matcher(mask.c_str());
+
+		if (StringWildCard1Matched(mask.c_str(), target.c_str()) != matcher.Matches(target.c_str()))
+		{
+			printf("mask=\"%s\" target=\"%s\"\n", mask.c_str(), target.c_str());
+			AFX_CHECK(false);
+		}
+
+		// Every match starts with the literal prefix:
+		if (matcher.Matches(target.c_str()))
+			AFX_CHECK(StringBeginsWith(target.c_str(), matcher.GetLiteralPrefix().c_str()));
+	}
+
+	return true;
+}
+
+AFX_TEST(StringWildCard1Index_SameAsLinearScan)
+{
+	CAfxTestRandom random(5);
+
+	std::vector<size_t> indices;
+
+	for (int round = 0; round < 200; ++round)
+	{
+		std::vector<std::string> masks;
+		StringWildCard1Index index;
+
+		unsigned int count = random.Next() % 40;
+
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			masks.push_back(StringToolsTest_RandomString(random, true));
+			index.Add(StringWildCard1Matcher(masks.back().c_str()));
+		}
+
+		AFX_CHECK(count == index.GetCount());
+
+		for (int i = 0; i < 500; ++i)
+		{
+			std::string target = StringToolsTest_RandomString(random, false);
+
+			index.FindMatches(target.c_str(), indices);
+
+			// Same indices in the same order:
+			size_t pos = 0;
+			for (size_t j = 0; j < masks.size(); ++j)
+			{
+				if (StringWildCard1Matched(masks[j].c_str(), target.c_str()))
+				{
+					AFX_CHECK(pos < indices.size());
+					AFX_CHECK(j == indices[pos]);
+					++pos;
+				}
+			}
+			AFX_CHECK(pos == indices.size());
+		}
+	}
+
+	return true;
+}
+
+AFX_TEST(StringWildCard1Index_Clear)
+{
+	StringWildCard1Index index;
+	std::vector<size_t> indices;
+
+	index.Add(StringWildCard1Matcher("models/\\*"));
+	index.FindMatches("models/a", indices);
+	AFX_CHECK(1 == indices.size());
+
+	index.Clear();
+	AFX_CHECK(0 == index.GetCount());
+	index.FindMatches("models/a", indices);
+	AFX_CHECK(indices.empty());
+
+	index.Add(StringWildCard1Matcher(""));
+	index.FindMatches("", indices);
+	AFX_CHECK(1 == indices.size() && 0 == indices[0]);
+	index.FindMatches("a", indices);
+	AFX_CHECK(indices.empty());
+
+	return true;
+}
+
+// Action filter corpus ////////////////////////////////////////////////////////
+
+// There is no dump of real material names in the tree, so the corpus is made
+// up of names shaped like the ones CS:GO uses.
+
+static void StringToolsTest_MakeCorpus(std::vector<std::string> & outNames)
+{
+	static const char * const prefixes[] = {
+		"models/player/custom_player/legacy/",
+		"models/weapons/v_models/",
+		"models/weapons/w_models/",
+		"models/props/de_dust/",
+		"models/props_foliage/",
+		"maps/de_dust2/",
+		"maps/de_mirage/",
+		"particle/",
+		"effects/",
+		"decals/",
+		"tools/",
+		"dev/",
+		"vgui/",
+		"sprites/",
+		"debug/"
+	};
+	static const char * const words[] = { "ak47", "m4a1", "ctm_sas", "tm_phoenix", "glow", "smoke", "blood", "wall", "floor", "crate", "muzzleflash", "sticker", "stattrack", "shell", "skybox", "nodraw", "white" };
+
+	CAfxTestRandom random(1);
+
+	for (int i = 0; i < 20000; ++i)
+	{
+		std::string name(prefixes[random.Next() % (sizeof(prefixes) / sizeof(prefixes[0]))]);
+		name += words[random.Next() % (sizeof(words) / sizeof(words[0]))];
+		name += "_";
+		name += words[random.Next() % (sizeof(words) / sizeof(words[0]))];
+		if (0 == random.Next() % 3) name += "_detail";
+
+		outNames.push_back(name);
+	}
+}
+
+static const char * const g_StringToolsTest_ActionFilters[] = {
+	"models/player/\\*",
+	"models/weapons/v_models/\\*ak47\\*",
+	"models/weapons/v_models/\\*",
+	"models/weapons/w_models/\\*",
+	"models/props/\\*",
+	"models/props_foliage/\\*",
+	"maps/de_dust2/\\*wall\\*",
+	"maps/de_dust2/\\*floor\\*",
+	"maps/\\*",
+	"particle/\\*smoke\\*",
+	"particle/\\*blood\\*",
+	"particle/\\*",
+	"effects/\\*muzzleflash\\*",
+	"effects/\\*",
+	"decals/\\*blood\\*",
+	"decals/\\*",
+	"tools/\\*skybox\\*",
+	"tools/\\*nodraw\\*",
+	"dev/\\*",
+	"vgui/\\*",
+	"sprites/\\*",
+	"\\*sticker\\*",
+	"\\*stattrack\\*",
+	"\\*shell\\*",
+	"\\*glow\\*",
+	"debug/\\*",
+	"\\*"
+};
+
+AFX_TEST(StringWildCard1Index_ActionFilterCorpus)
+{
+	std::vector<std::string> names;
+	StringToolsTest_MakeCorpus(names);
+
+	const size_t count = sizeof(g_StringToolsTest_ActionFilters) / sizeof(g_StringToolsTest_ActionFilters[0]);
+
+	std::vector<StringWildCard1Matcher> matchers;
+	StringWildCard1Index index;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		matchers.push_back(StringWildCard1Matcher(g_StringToolsTest_ActionFilters[i]));
+		index.Add(matchers.back());
+	}
+
+	std::vector<size_t> indices;
+
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		size_t first = count;
+		for (size_t j = 0; j < count && count == first; ++j)
+			if (matchers[j].Matches(names[i].c_str())) first = j;
+
+		index.FindMatches(names[i].c_str(), indices);
+
+		AFX_CHECK(!indices.empty());
+		AFX_CHECK(first == indices[0]);
+
+		// First match in the candidates, like CAfxBaseFxStream::EvalActionFilter does:
+		index.FindCandidates(names[i].c_str(), indices);
+
+		size_t firstCandidate = count;
+		for (size_t j = 0; j < indices.size() && count == firstCandidate; ++j)
+			if (matchers[indices[j]].Matches(names[i].c_str())) firstCandidate = indices[j];
+
+		AFX_CHECK(first == firstCandidate);
+	}
+
+	return true;
+}
+
+AFX_BENCHMARK(StringWildCard1Index_ActionFilterCorpus)
+{
+	std::vector<std::string> names;
+	StringToolsTest_MakeCorpus(names);
+
+	const size_t count = sizeof(g_StringToolsTest_ActionFilters) / sizeof(g_StringToolsTest_ActionFilters[0]);
+
+	std::vector<StringWildCard1Matcher> matchers;
+	StringWildCard1Index index;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		matchers.push_back(StringWildCard1Matcher(g_StringToolsTest_ActionFilters[i]));
+		index.Add(matchers.back());
+	}
+
+	const int rounds = 20;
+	size_t checksum[3] = { 0, 0, 0 };
+
+	double t0 = AfxTest_Seconds();
+	for (int round = 0; round < rounds; ++round)
+	{
+		for (size_t i = 0; i < names.size(); ++i)
+		{
+			for (size_t j = 0; j < count; ++j)
+			{
+				if (StringWildCard1Matched(g_StringToolsTest_ActionFilters[j], names[i].c_str()))
+				{
+					checksum[0] += j;
+					break;
+				}
+			}
+		}
+	}
+
+	double t1 = AfxTest_Seconds();
+	for (int round = 0; round < rounds; ++round)
+	{
+		for (size_t i = 0; i < names.size(); ++i)
+		{
+			for (size_t j = 0; j < count; ++j)
+			{
+				if (matchers[j].Matches(names[i].c_str()))
+				{
+					checksum[1] += j;
+					break;
+				}
+			}
+		}
+	}
+
+	double t2 = AfxTest_Seconds();
+	std::vector<size_t> indices;
+	for (int round = 0; round < rounds; ++round)
+	{
+		for (size_t i = 0; i < names.size(); ++i)
+		{
+			index.FindCandidates(names[i].c_str(), indices);
+
+			for (size_t j = 0; j < indices.size(); ++j)
+			{
+				if (matchers[indices[j]].Matches(names[i].c_str()))
+				{
+					checksum[2] += indices[j];
+					break;
+				}
+			}
+		}
+	}
+	double t3 = AfxTest_Seconds();
+
+	AFX_CHECK(checksum[0] == checksum[1] && checksum[1] == checksum[2]);
+
+	double lookups = (double)rounds * names.size();
+
+	printf("%i filters, %i names:\n", (int)count, (int)names.size());
+	printf("StringWildCard1Matched scan: %7.1f ns per name\n", 1e9 * (t1 - t0) / lookups);
+	printf("StringWildCard1Matcher scan: %7.1f ns per name\n", 1e9 * (t2 - t1) / lookups);
+	printf("StringWildCard1Index:        %7.1f ns per name\n", 1e9 * (t3 - t2) / lookups);
+
+	return true;
+}
@@ -0,0 +1,89 @@
+// AfxTests.cpp : Unit tests and benchmarks for the code in shared/ and the
+// parts of AfxHookSource / AfxHookGoldSrc that don't need the game.
+//
+// Usage: AfxTests [-benchmark] [<filter>]
+//
+// The tests also build with g++ on Linux, run from this folder:
+// g++ -std=c++14 -O2 -I. -Iposix -I../.. -o AfxTests *.cpp ../../AfxHookSource/AfxWorkerPool.cpp ../../AfxHookSource/MirvWav.cpp ../../shared/AfxCaptureStage.cpp ../../shared/AfxFrameWriter.cpp ../../shared/AfxGameRecord.cpp ../../shared/AfxImageKernels.cpp ../../shared/AfxPipeProcess.cpp ../../shared/AfxPipeWriter.cpp ../../shared/EasySampler.cpp ../../shared/EasySamplerKernels.cpp ../../shared/PatternScanner.cpp ../../shared/StringTools.cpp ../../shared/vcpp/AfxAddr.cpp ../../shared/vcpp/AfxAddrCache.cpp ../../shared/vcpp/AfxPeImage.cpp -lpthread
+// Add -fsanitize=thread -g to check the threaded code for data races.
+// BvhImportTest.cpp, CamIOTest.cpp and CamPathTest.cpp need the prop submodule and MSVC, they are only built by AfxTests.vcxproj.
+
+#include "stdafx.h"
+
+#include "AfxTests.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// CAfxTest ////////////////////////////////////////////////////////////////////
+
+CAfxTest::CAfxTest(char const * name, bool benchmark, Fn_t fn)
+	: m_Name(name)
+	, m_Benchmark(benchmark)
+	, m_Fn(fn)
+	, m_Next(GetFirst())
+{
+	GetFirst() = this;
+}
+
+CAfxTest * & CAfxTest::GetFirst(void)
+{
+	static CAfxTest * first = nullptr;
+
+	return first;
+}
+
+int CAfxTest::RunAll(bool benchmarks, char const * filter)
+{
+	int failed = 0;
+	int run = 0;
+
+	for (CAfxTest * test = GetFirst(); test; test = test->m_Next)
+	{
+		if (test->m_Benchmark != benchmarks) continue;
+		if (filter && !strstr(test->m_Name, filter)) continue;
+
+		printf("%s %s ...\n", benchmarks ? "BENCHMARK" : "TEST", test->m_Name);
+		fflush(stdout);
+
+		++run;
+
+		if (test->m_Fn())
+		{
+			printf("OK %s\n", test->m_Name);
+		}
+		else
+		{
+			printf("FAILED %s\n", test->m_Name);
+			++failed;
+		}
+		fflush(stdout);
+	}
+
+	printf("%i run, %i failed.\n", run, failed);
+
+	return failed;
+}
+
+void AfxTest_Failed(char const * file, int line, char const * expr)
+{
+	printf("%s(%i): check failed: %s\n", file, line, expr);
+}
+
+// main ////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char * argv[])
+{
+	bool benchmarks = false;
+	char const * filter = nullptr;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (0 == strcmp("-benchmark", argv[i]))
+			benchmarks = true;
+		else
+			filter = argv[i];
+	}
+
+	return 0 == CAfxTest::RunAll(benchmarks, filter) ? 0 : 1;
+}
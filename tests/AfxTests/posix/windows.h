@@ -0,0 +1,70 @@
+#pragma once
+
+// Just enough of <windows.h> for the code under test to build with g++,
+// only on the include path of the Linux build (see main.cpp).
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <wchar.h>
+
+#include <string>
+
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t DWORD;
+typedef int BOOL;
+typedef char CHAR;
+typedef wchar_t WCHAR;
+typedef char * LPSTR;
+typedef wchar_t * LPWSTR;
+
+#define CP_ACP 0
+#define CP_UTF8 65001
+
+#define _stricmp strcasecmp
+#define wcsicmp wcscasecmp
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+/// <remarks>Only for ASCII file names.</remarks>
+inline FILE * _wfopen(wchar_t const * fileName, wchar_t const * mode)
+{
+	std::wstring wFileName(fileName);
+	std::wstring wMode(mode);
+
+	return fopen(std::string(wFileName.begin(), wFileName.end()).c_str(), std::string(wMode.begin(), wMode.end()).c_str());
+}
+
+/// <remarks>Only for ASCII, cbMultiByte must be -1.</remarks>
+inline int MultiByteToWideChar(unsigned int, DWORD, char const * multiByte, int, wchar_t * wideChar, int cchWideChar)
+{
+	int length = (int)strlen(multiByte) + 1;
+
+	if (0 == cchWideChar) return length;
+	if (cchWideChar < length) return 0;
+
+	for (int i = 0; i < length; ++i) wideChar[i] = (unsigned char)multiByte[i];
+
+	return length;
+}
+
+/// <remarks>Only for ASCII, cchWideChar must be -1.</remarks>
+inline int WideCharToMultiByte(unsigned int, DWORD, wchar_t const * wideChar, int, char * multiByte, int cbMultiByte, char const *, BOOL *)
+{
+	int length = (int)wcslen(wideChar) + 1;
+
+	if (0 == cbMultiByte) return length;
+	if (cbMultiByte < length) return 0;
+
+	for (int i = 0; i < length; ++i) multiByte[i] = (char)wideChar[i];
+
+	return length;
+}
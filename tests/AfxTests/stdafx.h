@@ -0,0 +1,13 @@
+#pragma once
+
+// Lets the code from shared/ and the hook projects compile outside of MSVC.
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#ifndef _MSC_VER
+
+#define __declspec(x)
+#define abstract
+
+#endif